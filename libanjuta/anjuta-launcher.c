@@ -66,6 +66,11 @@
 
 #define ANJUTA_PIXMAP_PASSWORD "password.png"
 #define FILE_BUFFER_SIZE 1024
+/* Size of the reads from the output pipes, doubled each time a read fills it */
+#define OUTPUT_READ_SIZE_MIN (4 * 1024)
+#define OUTPUT_READ_SIZE_MAX (64 * 1024)
+/* Maximum data read from one pipe before returning to the main loop */
+#define OUTPUT_DISPATCH_MAX (1024 * 1024)
 #define FILE_INPUT_BUFFER_SIZE  (1024 * 1024 * 4)
 #ifndef __MAX_BAUD
 #  if defined(B460800)
@@ -79,6 +84,19 @@
 #  endif
 #endif
 
+/* Output of a pipe. The data is read in place after the previous incomplete
+ * line and the complete lines are delivered from there, the incomplete line
+ * is moved back to the start of the buffer when there is no room left. */
+typedef struct
+{
+	gchar *data;
+	gsize size;			/* Allocated, keep one byte for a nul terminator */
+	gsize start;		/* First byte not delivered */
+	gsize end;			/* End of the data read */
+	gsize scanned;		/* No newline in the bytes between start and it */
+	gsize read_size;
+} AnjutaLauncherOutput;
+
 /*
 static gboolean
 anjuta_launcher_pty_check_child_exit_code (AnjutaLauncher *launcher,
@@ -108,8 +126,8 @@ struct _AnjutaLauncherPriv
 	guint pty_watch;
 	
 	/* Output line buffers */
-	gchar *stdout_buffer;
-	gchar *stderr_buffer;
+	AnjutaLauncherOutput *stdout_buffer;
+	AnjutaLauncherOutput *stderr_buffer;
 	
 	/* Output of the pty is constantly stored here.*/
 	gchar *pty_output_buffer;
@@ -135,11 +153,15 @@ struct _AnjutaLauncherPriv
 	/* Should the outputs be buffered */
 	gboolean buffered_output;
 	
+	/* Is stdout passed as is, without any conversion */
+	gboolean binary_output;
+	
 	/* Should we check for password prompts in stdout and pty */
 	gboolean check_for_passwd_prompt;
 	
 	/* Output callback */
 	AnjutaLauncherOutputCallback output_callback;
+	AnjutaLauncherSliceCallback slice_callback;
 	
 	/* Callback data */
 	gpointer callback_data;
@@ -212,10 +234,12 @@ anjuta_launcher_initialize (AnjutaLauncher *obj)
 	obj->priv->start_time = 0;
 	
 	obj->priv->buffered_output = TRUE;
+	obj->priv->binary_output = FALSE;
 	obj->priv->check_for_passwd_prompt = TRUE;
 	
 	/* Output callback */
 	obj->priv->output_callback = NULL;
+	obj->priv->slice_callback = NULL;
 	obj->priv->callback_data = NULL;
 	
 	/* Encoding */
@@ -681,119 +705,242 @@ is_password_prompt (const gchar* line)
 	return FALSE;
 }
 
+static AnjutaLauncherOutput *
+anjuta_launcher_output_new (void)
+{
+	AnjutaLauncherOutput *output = g_slice_new0 (AnjutaLauncherOutput);
+
+	output->read_size = OUTPUT_READ_SIZE_MIN;
+
+	return output;
+}
+
 static void
-anjuta_launcher_buffered_output (AnjutaLauncher *launcher,
-								 AnjutaLauncherOutputType output_type,
-								 const gchar *chars)
+anjuta_launcher_output_free (AnjutaLauncherOutput *output)
+{
+	g_free (output->data);
+	g_slice_free (AnjutaLauncherOutput, output);
+}
+
+/* Length of the characters without a multi-bytes character cut at the end */
+static gsize
+anjuta_launcher_complete_length (const gchar *chars, gsize len)
 {
-	gchar *all_lines;
-	gchar *incomplete_line;
-	gchar **buffer;
+	gsize i;
 
-	g_return_if_fail (chars != NULL);
-	g_return_if_fail (strlen (chars) > 0);
+	for (i = 1; i <= 4 && i <= len; i++)
+	{
+		guchar c = chars[len - i];
 
-	if (launcher->priv->output_callback == NULL)
-		return;
-	if (launcher->priv->buffered_output == FALSE)
+		if ((c & 0xC0) != 0x80)
+		{
+			gsize needed = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+
+			return needed > i ? len - i : len;
+		}
+	}
+
+	return len;
+}
+
+static void
+anjuta_launcher_deliver (AnjutaLauncher *launcher,
+						 AnjutaLauncherOutputType output_type,
+						 gchar *chars, gsize len)
+{
+	gchar *utf8_chars = NULL;
+	gchar last;
+
+	/* The output of the child is almost always valid UTF-8 already */
+	if ((output_type == ANJUTA_LAUNCHER_OUTPUT_STDERR ||
+		 (!launcher->priv->custom_encoding && !launcher->priv->binary_output)) &&
+		!g_utf8_validate (chars, len, NULL))
+	{
+		last = chars[len];
+		chars[len] = '\0';
+		if (*chars != '\0')
+			utf8_chars = anjuta_util_convert_to_utf8 (chars);
+		chars[len] = last;
+
+		/* Ignore illegal characters */
+		if (utf8_chars == NULL)
+			return;
+		chars = utf8_chars;
+		len = strlen (utf8_chars);
+	}
+
+	if (launcher->priv->slice_callback != NULL)
+	{
+		(launcher->priv->slice_callback)(launcher, output_type, chars, len,
+										 launcher->priv->callback_data);
+	}
+	else
 	{
+		/* Terminate the lines in place for the callback */
+		last = chars[len];
+		chars[len] = '\0';
 		(launcher->priv->output_callback)(launcher, output_type, chars,
 										  launcher->priv->callback_data);
+		chars[len] = last;
+	}
+	g_free (utf8_chars);
+}
+
+static void
+anjuta_launcher_buffered_output (AnjutaLauncher *launcher,
+								 AnjutaLauncherOutputType output_type,
+								 AnjutaLauncherOutput *output)
+{
+	gchar *chars = output->data + output->start;
+	gsize len = output->end - output->start;
+	gchar *newline;
+	gchar *last_newline = NULL;
+
+	if (launcher->priv->output_callback == NULL &&
+		launcher->priv->slice_callback == NULL)
+	{
+		output->start = output->end = output->scanned = 0;
 		return;
 	}
-	switch (output_type)
+	if (launcher->priv->buffered_output == FALSE)
 	{
-	case ANJUTA_LAUNCHER_OUTPUT_STDOUT:
-		buffer = &launcher->priv->stdout_buffer;
-		break;
-	case ANJUTA_LAUNCHER_OUTPUT_STDERR:
-		buffer = &launcher->priv->stderr_buffer;
-		break;
-	default:
-		g_warning ("Should not reach here");
+		/* Binary output is not cut at an incomplete character */
+		if (output_type == ANJUTA_LAUNCHER_OUTPUT_STDERR ||
+			!launcher->priv->binary_output)
+			len = anjuta_launcher_complete_length (chars, len);
+		output->start += len;
+		if (len > 0)
+			anjuta_launcher_deliver (launcher, output_type, chars, len);
 		return;
 	}
-	if (*buffer) 
-		all_lines = g_strconcat (*buffer, chars, NULL);
-	else
-		all_lines = g_strdup (chars);
-	
-	/* Buffer the last incomplete line */
-	incomplete_line = all_lines + strlen (all_lines);
-	while (incomplete_line > all_lines &&
-		   *incomplete_line != '\n')
+
+	/* Find the end of the last complete line */
+	newline = output->data + output->scanned;
+	while ((newline = memchr (newline, '\n',
+							  output->data + output->end - newline)) != NULL)
 	{
-		incomplete_line = g_utf8_prev_char (incomplete_line);
+		last_newline = newline;
+		newline++;
 	}
-	if (*incomplete_line == '\n')
-		incomplete_line++;
-	
-	/* Update line buffer */
-	g_free(*buffer);
-	*buffer = NULL;
-	if (strlen(incomplete_line))
+	output->scanned = output->end;
+	if (last_newline != NULL)
 	{
-		*buffer = g_strdup (incomplete_line);
-		/* DEBUG_PRINT ("Line buffer for %d: %s", output_type, incomplete_line); */
+		len = last_newline + 1 - chars;
+		output->start += len;
 	}
-	/* Check for password prompt */
-	if (launcher->priv->check_for_passwd_prompt)
-		anjuta_launcher_check_password (launcher, incomplete_line);
-	
+	else
+	{
+		len = 0;
+	}
+
 	/* Deliver complete lines */
-	*incomplete_line = '\0';
-	if (strlen (all_lines) > 0)
-		(launcher->priv->output_callback)(launcher, output_type, all_lines,
-										  launcher->priv->callback_data);
-	g_free (all_lines);
+	if (len > 0)
+		anjuta_launcher_deliver (launcher, output_type, chars, len);
+
+	/* Check for password prompt in the last incomplete line */
+	if (launcher->priv->check_for_passwd_prompt &&
+		output->start < output->end)
+	{
+		anjuta_launcher_check_password (launcher,
+										output->data + output->start);
+	}
+}
+
+/* Returns the room to read more output in place */
+static gchar *
+anjuta_launcher_output_reserve (AnjutaLauncherOutput *output)
+{
+	if (output->end + output->read_size + 1 > output->size)
+	{
+		gsize len = output->end - output->start;
+
+		/* Move the incomplete line back at the start */
+		if (output->start > 0)
+		{
+			memmove (output->data, output->data + output->start, len);
+			/* scanned is only kept up to date for buffered output */
+			output->scanned = output->scanned > output->start ?
+				output->scanned - output->start : 0;
+			output->start = 0;
+			output->end = len;
+		}
+		if (output->end + output->read_size + 1 > output->size)
+		{
+			output->size = MAX (output->size * 2,
+								output->end + output->read_size + 1);
+			output->data = g_realloc (output->data, output->size);
+		}
+	}
+
+	return output->data + output->end;
+}
+
+static gboolean
+anjuta_launcher_read_output (AnjutaLauncher *launcher, GIOChannel *channel,
+							 AnjutaLauncherOutputType output_type,
+							 AnjutaLauncherOutput *output)
+{
+	gsize n;
+	gsize requested;
+	gsize total = 0;
+	GError *err = NULL;
+	gboolean ret = TRUE;
+
+	do
+	{
+		gchar *buffer = anjuta_launcher_output_reserve (output);
+
+		requested = output->read_size;
+		g_io_channel_read_chars (channel, buffer, requested, &n, &err);
+		if (n > 0) /* There is output */
+		{
+			output->end += n;
+			output->data[output->end] = '\0';
+			total += n;
+
+			/* Read more at once while the pipe is full */
+			if (n == requested && output->read_size < OUTPUT_READ_SIZE_MAX)
+				output->read_size *= 2;
+
+			anjuta_launcher_buffered_output (launcher, output_type, output);
+		}
+		/* Ignore illegal characters */
+		if (err && err->domain == G_CONVERT_ERROR)
+		{
+			g_error_free (err);
+			err = NULL;
+		}
+		/* The pipe is closed on the other side */
+		/* if not related to non blocking read or interrupted syscall */
+		else if (err && errno != EAGAIN && errno != EINTR)
+		{
+			ret = FALSE;
+		}
+	/* Read next chars while the buffer is filled, the watch is called again
+	 * if there is still more output after OUTPUT_DISPATCH_MAX bytes */
+	} while (!err && n == requested && total < OUTPUT_DISPATCH_MAX);
+	if (err)
+		g_error_free (err);
+
+	return ret;
 }
 
 static gboolean
 anjuta_launcher_scan_output (GIOChannel *channel, GIOCondition condition,
 							 AnjutaLauncher *launcher)
 {
-	gsize n;
-	gchar buffer[FILE_BUFFER_SIZE];
 	gboolean ret = TRUE;
 
 	if (condition & G_IO_IN)
 	{
-		GError *err = NULL;
-		do
+		if (!anjuta_launcher_read_output (launcher, channel,
+										  ANJUTA_LAUNCHER_OUTPUT_STDOUT,
+										  launcher->priv->stdout_buffer))
 		{
-			g_io_channel_read_chars (channel, buffer, FILE_BUFFER_SIZE-1, &n, &err);
-			if (n > 0) /* There is output */
-			{
-				gchar *utf8_chars = NULL;
-				buffer[n] = '\0';
-				if (!launcher->priv->custom_encoding)
-					utf8_chars = anjuta_util_convert_to_utf8 (buffer);
-				else
-					utf8_chars = g_strdup(buffer);
-				anjuta_launcher_buffered_output (launcher,
-												 ANJUTA_LAUNCHER_OUTPUT_STDOUT,
-												 utf8_chars);
-				g_free (utf8_chars);
-			}
-			/* Ignore illegal characters */
-			if (err && err->domain == G_CONVERT_ERROR)
-			{
-				g_error_free (err);
-				err = NULL;
-			}
-			/* The pipe is closed on the other side */
-			/* if not related to non blocking read or interrupted syscall */
-			else if (err && errno != EAGAIN && errno != EINTR)
-			{
-				launcher->priv->stdout_is_done = TRUE;
-				anjuta_launcher_synchronize (launcher);
-				ret = FALSE;
-			}
-		/* Read next chars if buffer was too small
-		 * (the maximum length of one character is 6 bytes) */
-		} while (!err && (n > FILE_BUFFER_SIZE - 7));
-		if (err)
-			g_error_free (err);
+			launcher->priv->stdout_is_done = TRUE;
+			anjuta_launcher_synchronize (launcher);
+			ret = FALSE;
+		}
 	}
 	if ((condition & G_IO_ERR) || (condition & G_IO_HUP))
 	{
@@ -809,46 +956,18 @@ static gboolean
 anjuta_launcher_scan_error (GIOChannel *channel, GIOCondition condition,
 							AnjutaLauncher *launcher)
 {
-	gsize n;
-	gchar buffer[FILE_BUFFER_SIZE];
 	gboolean ret = TRUE;
 	
 	if (condition & G_IO_IN)
 	{
-		GError *err = NULL;
-		do
+		if (!anjuta_launcher_read_output (launcher, channel,
+										  ANJUTA_LAUNCHER_OUTPUT_STDERR,
+										  launcher->priv->stderr_buffer))
 		{
-			g_io_channel_read_chars (channel, buffer, FILE_BUFFER_SIZE-1, &n, &err);
-			if (n > 0) /* There is stderr output */
-			{
-				gchar *utf8_chars;
-				buffer[n] = '\0';
-				utf8_chars = anjuta_util_convert_to_utf8 (buffer);
-				anjuta_launcher_buffered_output (launcher,
-												 ANJUTA_LAUNCHER_OUTPUT_STDERR,
-												 utf8_chars);
-				g_free (utf8_chars);
-			}
-			/* Ignore illegal characters */
-			if (err && err->domain == G_CONVERT_ERROR)
-			{
-				g_error_free (err);
-				err = NULL;
-			}
-			/* The pipe is closed on the other side */
-			/* if not related to non blocking read or interrupted syscall */
-			else if (err && errno != EAGAIN && errno != EINTR)
-			{
-				
-				launcher->priv->stderr_is_done = TRUE;
-				anjuta_launcher_synchronize (launcher);
-				ret = FALSE;
-			}
-		/* Read next chars if buffer was too small
-		 * (the maximum length of one character is 6 bytes) */
-		} while (!err && (n > FILE_BUFFER_SIZE - 7));
-		if (err)
-			g_error_free (err);
+			launcher->priv->stderr_is_done = TRUE;
+			anjuta_launcher_synchronize (launcher);
+			ret = FALSE;
+		}
 	}
 	if ((condition & G_IO_ERR) || (condition & G_IO_HUP))
 	{
@@ -962,21 +1081,31 @@ anjuta_launcher_execution_done_cleanup (AnjutaLauncher *launcher,
 		g_free (launcher->priv->pty_output_buffer);
 	if (launcher->priv->stdout_buffer)
 	{
+		AnjutaLauncherOutput *output = launcher->priv->stdout_buffer;
+
 		/* Send remaining data if last line is not terminated with EOL */
-		(launcher->priv->output_callback)(launcher,
-			       ANJUTA_LAUNCHER_OUTPUT_STDOUT,
-			       launcher->priv->stdout_buffer,
-			       launcher->priv->callback_data);
-		g_free (launcher->priv->stdout_buffer);
+		if (output->start < output->end &&
+			(launcher->priv->output_callback || launcher->priv->slice_callback))
+		{
+			anjuta_launcher_deliver (launcher, ANJUTA_LAUNCHER_OUTPUT_STDOUT,
+									 output->data + output->start,
+									 output->end - output->start);
+		}
+		anjuta_launcher_output_free (output);
 	}
 	if (launcher->priv->stderr_buffer)
 	{
+		AnjutaLauncherOutput *output = launcher->priv->stderr_buffer;
+
 		/* Send remaining data if last line is not terminated with EOL */
-		(launcher->priv->output_callback)(launcher,
-			       ANJUTA_LAUNCHER_OUTPUT_STDERR,
-			       launcher->priv->stderr_buffer,
-			       launcher->priv->callback_data);
-		g_free (launcher->priv->stdout_buffer);
+		if (output->start < output->end &&
+			(launcher->priv->output_callback || launcher->priv->slice_callback))
+		{
+			anjuta_launcher_deliver (launcher, ANJUTA_LAUNCHER_OUTPUT_STDERR,
+									 output->data + output->start,
+									 output->end - output->start);
+		}
+		anjuta_launcher_output_free (output);
 	}
 	
 	/* Save them before we re-initialize */
@@ -1103,6 +1232,7 @@ anjuta_launcher_fork (AnjutaLauncher *launcher, const gchar *dir, gchar *const a
 	pid_t child_pid;
 	struct termios termios_flags;
 	gchar * const *env;
+	gboolean utf8_locale = FALSE;
 	
 	/* The pipes */
 	pipe (stderr_pipe);
@@ -1196,12 +1326,23 @@ anjuta_launcher_fork (AnjutaLauncher *launcher, const gchar *dir, gchar *const a
 	launcher->priv->stderr_channel = g_io_channel_unix_new (stderr_pipe[0]);
 	launcher->priv->stdout_channel = g_io_channel_unix_new (stdout_pipe[0]);
 	launcher->priv->pty_channel = g_io_channel_unix_new (pty_master_fd);
+	launcher->priv->stdout_buffer = anjuta_launcher_output_new ();
+	launcher->priv->stderr_buffer = anjuta_launcher_output_new ();
 
 	g_io_channel_set_buffer_size (launcher->priv->pty_channel, FILE_INPUT_BUFFER_SIZE);
 
 	if (!launcher->priv->custom_encoding)
-	  g_get_charset ((const gchar**)&launcher->priv->encoding);
+	  utf8_locale = g_get_charset ((const gchar**)&launcher->priv->encoding);
 	anjuta_launcher_set_encoding_real (launcher, launcher->priv->encoding);
+	if (utf8_locale)
+	{
+		/* Read the outputs directly in the line buffers, they are converted
+		 * on delivery only if they are not valid UTF-8 */
+		g_io_channel_set_encoding (launcher->priv->stdout_channel, NULL, NULL);
+		g_io_channel_set_buffered (launcher->priv->stdout_channel, FALSE);
+		g_io_channel_set_encoding (launcher->priv->stderr_channel, NULL, NULL);
+		g_io_channel_set_buffered (launcher->priv->stderr_channel, FALSE);
+	}
 	
 	tcgetattr(pty_master_fd, &termios_flags);
 	termios_flags.c_iflag &= ~(IGNPAR | INPCK | INLCR | IGNCR | ICRNL | IXON |
@@ -1349,6 +1490,45 @@ anjuta_launcher_set_buffered_output (AnjutaLauncher *launcher, gboolean buffered
 	return past_value;
 }
 
+/**
+ * anjuta_launcher_set_binary_output:
+ * @launcher: a #AnjutaLancher object.
+ * @binary: pass the standard output as is.
+ * 
+ * Sets if the standard output of the process is binary data. In this case,
+ * it is neither converted nor checked for UTF-8 characters, and unbuffered
+ * output is delivered as it is read. It is useful with
+ * anjuta_launcher_set_slice_callback() only, as the data can contain nul
+ * characters. By default, the output is text.
+ *
+ * Return value: Previous flag value
+ */
+gboolean
+anjuta_launcher_set_binary_output (AnjutaLauncher *launcher, gboolean binary)
+{
+	gboolean past_value = launcher->priv->binary_output;
+	launcher->priv->binary_output = binary;
+	return past_value;
+}
+
+/**
+ * anjuta_launcher_set_slice_callback:
+ * @launcher: a #AnjutaLancher object.
+ * @callback: The callback for delivering output from the process or NULL.
+ * 
+ * Delivers the output of the next execution to @callback instead of the
+ * callback given to anjuta_launcher_execute(), with the same callback data.
+ * The characters are passed as a slice of the launcher buffers, without a
+ * copy nor a nul terminator, and are valid during the call only. When the
+ * output is buffered, each slice contains complete lines only.
+ */
+void
+anjuta_launcher_set_slice_callback (AnjutaLauncher *launcher,
+									AnjutaLauncherSliceCallback callback)
+{
+	launcher->priv->slice_callback = callback;
+}
+
 /**
  * anjuta_launcher_set_check_passwd_prompt:
  * @launcher: a #AnjutaLancher object.
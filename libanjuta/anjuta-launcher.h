@@ -59,6 +59,23 @@ typedef void (*AnjutaLauncherOutputCallback) (AnjutaLauncher *launcher,
 											  const gchar *chars,
 											  gpointer user_data);
 
+/**
+* AnjutaLauncherSliceCallback:
+* @launcher: a #AnjutaLauncher object
+* @output_type: Type of the output
+* @chars: Characters being outputed, not nul terminated
+* @len: Length of @chars in bytes
+* @user_data: User data passed back to the user
+* 
+* This callback is called when new characters arrive from the launcher
+* execution, see anjuta_launcher_set_slice_callback().
+*/
+typedef void (*AnjutaLauncherSliceCallback) (AnjutaLauncher *launcher,
+											 AnjutaLauncherOutputType output_type,
+											 const gchar *chars,
+											 gsize len,
+											 gpointer user_data);
+
 struct _AnjutaLauncher
 {
     GObject parent;
@@ -103,6 +120,10 @@ void anjuta_launcher_reset (AnjutaLauncher *launcher);
 void anjuta_launcher_signal (AnjutaLauncher *launcher, int sig);
 gboolean anjuta_launcher_set_buffered_output (AnjutaLauncher *launcher,
 										  gboolean buffered);
+gboolean anjuta_launcher_set_binary_output (AnjutaLauncher *launcher,
+											gboolean binary);
+void anjuta_launcher_set_slice_callback (AnjutaLauncher *launcher,
+										 AnjutaLauncherSliceCallback callback);
 gboolean anjuta_launcher_set_check_passwd_prompt (AnjutaLauncher *launcher,
 											  gboolean check_passwd);
 /* Returns old value */
@@ -0,0 +1,665 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta-project-cache.c
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "anjuta-project-cache.h"
+
+#include "anjuta-debug.h"
+
+#include <string.h>
+
+/**
+ * SECTION:anjuta-project-cache
+ * @title: Anjuta project cache
+ * @short_description: Snapshot of a project tree
+ * @see_also: #AnjutaProjectNode
+ * @stability: Unstable
+ * @include: libanjuta/anjuta-project-cache.h
+ *
+ * A project cache keeps the node tree of a loaded project in a binary file,
+ * so the project can be displayed without parsing all its files when it is
+ * opened again. Properties are not saved, they are available only after a
+ * full load.
+ *
+ * Each project configuration file (a source having the %ANJUTA_PROJECT_FRAME
+ * flag) keeps its modification time, its size and a checksum of its content.
+ * The groups without such file keep the modification time of their
+ * directory. When the cache is loaded, the groups containing a changed file
+ * or directory are returned, the backend has to load them again.
+ *
+ * The file starts with a header followed by all nodes in pre-order. All
+ * integers are 32 bits little endian, strings are stored as their length
+ * followed by their bytes:
+ * <programlisting>
+ * header: magic version root_uri
+ * node:   type state name file stamp n_children
+ * file:   0 | 1 relative_path | 2 uri
+ * stamp:  0 | 1 seconds microseconds | 2 seconds microseconds size checksum
+ * </programlisting>
+ */
+
+#define CACHE_MAGIC			"ANJC"
+#define CACHE_VERSION		1
+
+#define CACHE_NULL_STRING	0xFFFFFFFF
+
+#define CACHE_CHECKSUM		G_CHECKSUM_MD5
+
+/* States kept in the cache, the other ones are only meaningful while the
+ * project is open */
+#define CACHE_STATE_MASK	(~(ANJUTA_PROJECT_MODIFIED | ANJUTA_PROJECT_LOADING | ANJUTA_PROJECT_REMOVED))
+
+typedef enum
+{
+	CACHE_FILE_NONE = 0,
+	CACHE_FILE_RELATIVE,
+	CACHE_FILE_URI
+} CacheFileKind;
+
+typedef enum
+{
+	CACHE_STAMP_NONE = 0,
+	CACHE_STAMP_DIRECTORY,
+	CACHE_STAMP_FILE
+} CacheStampKind;
+
+typedef struct
+{
+	const gchar *pos;
+	const gchar *end;
+	gboolean error;
+} CacheReader;
+
+typedef struct
+{
+	AnjutaProjectNode *root;
+	AnjutaProjectCacheNewNode new_node;
+	gpointer user_data;
+	GList *changed;
+} CacheLoad;
+
+/* Helper functions
+ *---------------------------------------------------------------------------*/
+
+static gchar *
+compute_checksum (GFile *file)
+{
+	gchar *content;
+	gsize length;
+	gchar *checksum;
+
+	if (!g_file_load_contents (file, NULL, &content, &length, NULL, NULL))
+		return NULL;
+
+	checksum = g_compute_checksum_for_data (CACHE_CHECKSUM, (const guchar *)content, length);
+	g_free (content);
+
+	return checksum;
+}
+
+static GFileInfo *
+query_stamp (GFile *file)
+{
+	return g_file_query_info (file,
+	                          G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+	                          G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+	                          G_FILE_ATTRIBUTE_STANDARD_SIZE,
+	                          G_FILE_QUERY_INFO_NONE,
+	                          NULL, NULL);
+}
+
+static CacheStampKind
+get_stamp_kind (AnjutaProjectNode *node)
+{
+	if (node->file == NULL) return CACHE_STAMP_NONE;
+
+	switch (node->type & ANJUTA_PROJECT_TYPE_MASK)
+	{
+	case ANJUTA_PROJECT_ROOT:
+	case ANJUTA_PROJECT_GROUP:
+		{
+			AnjutaProjectNode *child;
+
+			/* The configuration files describe the group content, the
+			 * directory can change when building the project */
+			for (child = node->children; child != NULL; child = child->next)
+			{
+				if ((child->type & (ANJUTA_PROJECT_TYPE_MASK | ANJUTA_PROJECT_FRAME)) == (ANJUTA_PROJECT_SOURCE | ANJUTA_PROJECT_FRAME))
+					return CACHE_STAMP_NONE;
+			}
+		}
+		return CACHE_STAMP_DIRECTORY;
+	case ANJUTA_PROJECT_SOURCE:
+		return node->type & ANJUTA_PROJECT_FRAME ? CACHE_STAMP_FILE : CACHE_STAMP_NONE;
+	default:
+		return CACHE_STAMP_NONE;
+	}
+}
+
+/* Write cache
+ *---------------------------------------------------------------------------*/
+
+static void
+cache_write_uint32 (GString *buffer, guint32 value)
+{
+	value = GUINT32_TO_LE (value);
+	g_string_append_len (buffer, (const gchar *)&value, sizeof (value));
+}
+
+static void
+cache_write_string (GString *buffer, const gchar *value)
+{
+	if (value == NULL)
+	{
+		cache_write_uint32 (buffer, CACHE_NULL_STRING);
+	}
+	else
+	{
+		guint32 length = strlen (value);
+
+		cache_write_uint32 (buffer, length);
+		g_string_append_len (buffer, value, length);
+	}
+}
+
+static void
+cache_write_file (GString *buffer, GFile *file, GFile *root)
+{
+	gchar *path;
+
+	if (file == NULL)
+	{
+		cache_write_uint32 (buffer, CACHE_FILE_NONE);
+		return;
+	}
+
+	path = root != NULL ? g_file_get_relative_path (root, file) : NULL;
+	if (path != NULL)
+	{
+		cache_write_uint32 (buffer, CACHE_FILE_RELATIVE);
+	}
+	else
+	{
+		cache_write_uint32 (buffer, CACHE_FILE_URI);
+		path = g_file_get_uri (file);
+	}
+	cache_write_string (buffer, path);
+	g_free (path);
+}
+
+static void
+cache_write_stamp (GString *buffer, AnjutaProjectNode *node)
+{
+	CacheStampKind kind;
+	GFileInfo *info;
+	gchar *checksum = NULL;
+
+	kind = get_stamp_kind (node);
+	info = kind != CACHE_STAMP_NONE ? query_stamp (node->file) : NULL;
+	if ((info != NULL) && (kind == CACHE_STAMP_FILE))
+	{
+		checksum = compute_checksum (node->file);
+		if (checksum == NULL) g_clear_object (&info);
+	}
+
+	if (info == NULL)
+	{
+		/* Missing file, always considered as changed */
+		cache_write_uint32 (buffer, kind == CACHE_STAMP_NONE ? CACHE_STAMP_NONE : CACHE_STAMP_FILE);
+		if (kind != CACHE_STAMP_NONE)
+		{
+			cache_write_uint32 (buffer, 0);
+			cache_write_uint32 (buffer, 0);
+			cache_write_uint32 (buffer, 0);
+			cache_write_string (buffer, NULL);
+		}
+		return;
+	}
+
+	cache_write_uint32 (buffer, kind);
+	cache_write_uint32 (buffer, g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED));
+	cache_write_uint32 (buffer, g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC));
+	if (kind == CACHE_STAMP_FILE)
+	{
+		cache_write_uint32 (buffer, g_file_info_get_size (info));
+		cache_write_string (buffer, checksum);
+	}
+
+	g_free (checksum);
+	g_object_unref (info);
+}
+
+static void
+cache_write_node (GString *buffer, AnjutaProjectNode *node, GFile *root)
+{
+	AnjutaProjectNode *child;
+	guint32 n_children = 0;
+
+	cache_write_uint32 (buffer, node->type);
+	cache_write_uint32 (buffer, node->state & CACHE_STATE_MASK);
+	cache_write_string (buffer, node->name);
+	cache_write_file (buffer, node->file, root);
+	cache_write_stamp (buffer, node);
+
+	for (child = node->children; child != NULL; child = child->next)
+	{
+		if (!(child->state & ANJUTA_PROJECT_REMOVED)) n_children++;
+	}
+	cache_write_uint32 (buffer, n_children);
+
+	for (child = node->children; child != NULL; child = child->next)
+	{
+		if (!(child->state & ANJUTA_PROJECT_REMOVED)) cache_write_node (buffer, child, root);
+	}
+}
+
+/* Read cache
+ *---------------------------------------------------------------------------*/
+
+static guint32
+cache_read_uint32 (CacheReader *reader)
+{
+	guint32 value;
+
+	if (reader->error || (reader->end - reader->pos < (gssize)sizeof (value)))
+	{
+		reader->error = TRUE;
+		return 0;
+	}
+	memcpy (&value, reader->pos, sizeof (value));
+	reader->pos += sizeof (value);
+
+	return GUINT32_FROM_LE (value);
+}
+
+/* Return a string pointing inside the cache, it is not nul terminated */
+static const gchar *
+cache_read_string (CacheReader *reader, guint32 *length)
+{
+	const gchar *value;
+
+	*length = cache_read_uint32 (reader);
+	if (reader->error || (*length == CACHE_NULL_STRING)) return NULL;
+
+	if (reader->end - reader->pos < (gssize)*length)
+	{
+		reader->error = TRUE;
+		return NULL;
+	}
+	value = reader->pos;
+	reader->pos += *length;
+
+	return value;
+}
+
+static gchar *
+cache_read_dup_string (CacheReader *reader)
+{
+	const gchar *value;
+	guint32 length;
+
+	value = cache_read_string (reader, &length);
+
+	return value != NULL ? g_strndup (value, length) : NULL;
+}
+
+static GFile *
+cache_read_file (CacheReader *reader, GFile *root)
+{
+	CacheFileKind kind;
+	gchar *path;
+	GFile *file = NULL;
+
+	kind = cache_read_uint32 (reader);
+	if (kind == CACHE_FILE_NONE) return NULL;
+
+	path = cache_read_dup_string (reader);
+	if (path == NULL)
+	{
+		reader->error = TRUE;
+		return NULL;
+	}
+	switch (kind)
+	{
+	case CACHE_FILE_RELATIVE:
+		file = root != NULL ? g_file_resolve_relative_path (root, path) : NULL;
+		break;
+	case CACHE_FILE_URI:
+		file = g_file_new_for_uri (path);
+		break;
+	default:
+		break;
+	}
+	g_free (path);
+	if (file == NULL) reader->error = TRUE;
+
+	return file;
+}
+
+/* Read the stamp of a file and return TRUE if it has changed */
+static gboolean
+cache_read_stamp (CacheReader *reader, GFile *file)
+{
+	CacheStampKind kind;
+	guint64 mtime;
+	guint32 usec;
+	guint32 size = 0;
+	const gchar *checksum = NULL;
+	guint32 checksum_length = 0;
+	GFileInfo *info;
+	gboolean changed;
+
+	kind = cache_read_uint32 (reader);
+	if (kind == CACHE_STAMP_NONE) return FALSE;
+
+	mtime = cache_read_uint32 (reader);
+	usec = cache_read_uint32 (reader);
+	if (kind == CACHE_STAMP_FILE)
+	{
+		size = cache_read_uint32 (reader);
+		checksum = cache_read_string (reader, &checksum_length);
+	}
+	if (reader->error || (file == NULL)) return TRUE;
+
+	info = query_stamp (file);
+	if (info == NULL) return TRUE;
+
+	changed = (g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) != mtime) ||
+		(g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC) != usec);
+
+	if (kind == CACHE_STAMP_FILE)
+	{
+		if ((checksum == NULL) || (g_file_info_get_size (info) != size))
+		{
+			changed = TRUE;
+		}
+		else if (changed)
+		{
+			gchar *current;
+
+			/* Touched only, the content is the same */
+			current = compute_checksum (file);
+			changed = (current == NULL) ||
+				(strlen (current) != checksum_length) ||
+				(memcmp (current, checksum, checksum_length) != 0);
+			g_free (current);
+		}
+	}
+	g_object_unref (info);
+
+	return changed;
+}
+
+static void
+cache_mark_changed (CacheLoad *load, AnjutaProjectNode *node)
+{
+	AnjutaProjectNode *group;
+
+	switch (node->type & ANJUTA_PROJECT_TYPE_MASK)
+	{
+	case ANJUTA_PROJECT_ROOT:
+	case ANJUTA_PROJECT_GROUP:
+		group = node;
+		break;
+	default:
+		group = anjuta_project_node_parent_type (node, ANJUTA_PROJECT_GROUP);
+		if (group == NULL) group = load->root;
+		break;
+	}
+
+	if (g_list_find (load->changed, group) == NULL)
+	{
+		load->changed = g_list_prepend (load->changed, group);
+	}
+}
+
+static gboolean
+cache_read_children (CacheReader *reader, CacheLoad *load, AnjutaProjectNode *parent, GFile *root);
+
+static gboolean
+cache_read_node (CacheReader *reader, CacheLoad *load, AnjutaProjectNode *parent, AnjutaProjectNode **last, GFile *root)
+{
+	AnjutaProjectNodeType type;
+	AnjutaProjectNodeState state;
+	gchar *name;
+	GFile *file;
+	AnjutaProjectNode *node;
+	gboolean changed;
+
+	type = cache_read_uint32 (reader);
+	state = cache_read_uint32 (reader);
+	name = cache_read_dup_string (reader);
+	file = cache_read_file (reader, root);
+	changed = cache_read_stamp (reader, file);
+	if (reader->error)
+	{
+		g_free (name);
+		if (file != NULL) g_object_unref (file);
+		return FALSE;
+	}
+
+	/* Without parent, the node and its children are skipped */
+	node = parent != NULL ? load->new_node (parent, type, file, name, load->user_data) : NULL;
+	g_free (name);
+	if (file != NULL) g_object_unref (file);
+	if (node != NULL)
+	{
+		node->type = type;
+		node->state = state;
+		anjuta_project_node_insert_after (parent, *last, node);
+		*last = node;
+		if (changed) cache_mark_changed (load, node);
+	}
+
+	return cache_read_children (reader, load, node, root);
+}
+
+static gboolean
+cache_read_children (CacheReader *reader, CacheLoad *load, AnjutaProjectNode *parent, GFile *root)
+{
+	guint32 n_children;
+	AnjutaProjectNode *last = NULL;
+
+	n_children = cache_read_uint32 (reader);
+	for (; n_children > 0; n_children--)
+	{
+		if (!cache_read_node (reader, load, parent, &last, root)) return FALSE;
+	}
+
+	return !reader->error;
+}
+
+/* Public functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * anjuta_project_cache_get_file:
+ * @root: root directory of the project
+ * @backend: name of the backend
+ *
+ * Get the file used to cache the project tree. It is in the .anjuta
+ * directory of the project, the backend name allows several backends to
+ * use the same project.
+ *
+ * Returns: (transfer full): the cache file
+ */
+GFile *
+anjuta_project_cache_get_file (GFile *root, const gchar *backend)
+{
+	gchar *name;
+	GFile *file;
+
+	g_return_val_if_fail (G_IS_FILE (root), NULL);
+	g_return_val_if_fail (backend != NULL, NULL);
+
+	name = g_strconcat (".anjuta" G_DIR_SEPARATOR_S, backend, ".cache", NULL);
+	file = g_file_resolve_relative_path (root, name);
+	g_free (name);
+
+	return file;
+}
+
+/**
+ * anjuta_project_cache_save:
+ * @root: root node of the project
+ * @cache: cache file
+ * @error: Error propagation and reporting
+ *
+ * Save the tree under @root with the current stamps of its groups and
+ * project configuration files.
+ *
+ * Returns: %TRUE if the cache has been written
+ */
+gboolean
+anjuta_project_cache_save (AnjutaProjectNode *root, GFile *cache, GError **error)
+{
+	GString *buffer;
+	GFile *directory;
+	gchar *uri;
+	gboolean ok;
+
+	g_return_val_if_fail (ANJUTA_IS_PROJECT_NODE (root), FALSE);
+	g_return_val_if_fail (G_IS_FILE (cache), FALSE);
+
+	/* Create the directory first, it can change the stamp of the root */
+	directory = g_file_get_parent (cache);
+	if (directory != NULL)
+	{
+		g_file_make_directory_with_parents (directory, NULL, NULL);
+		g_object_unref (directory);
+	}
+
+	buffer = g_string_sized_new (64 * 1024);
+	g_string_append_len (buffer, CACHE_MAGIC, 4);
+	cache_write_uint32 (buffer, CACHE_VERSION);
+	uri = root->file != NULL ? g_file_get_uri (root->file) : NULL;
+	cache_write_string (buffer, uri);
+	g_free (uri);
+	cache_write_node (buffer, root, root->file);
+
+	ok = g_file_replace_contents (cache, buffer->str, buffer->len, NULL, FALSE, G_FILE_CREATE_NONE, NULL, NULL, error);
+	DEBUG_PRINT ("save project cache %s, %" G_GSIZE_FORMAT " bytes", ok ? "done" : "failed", buffer->len);
+	g_string_free (buffer, TRUE);
+
+	return ok;
+}
+
+/**
+ * anjuta_project_cache_load:
+ * @root: root node of the project, without children
+ * @cache: cache file
+ * @new_node: (scope call): function creating the nodes
+ * @user_data: (closure): data passed to @new_node
+ * @changed: (out) (transfer container) (element-type Anjuta.ProjectNode): groups which have changed
+ * @error: Error propagation and reporting
+ *
+ * Recreate the tree saved in @cache under @root. The type and the state of
+ * the created nodes are restored as they were saved.
+ *
+ * @changed receives the groups whose directory or configuration files have
+ * changed since the cache has been saved, a group always comes before its
+ * children.
+ *
+ * Returns: %TRUE if the cache has been loaded, else @root has no children.
+ */
+gboolean
+anjuta_project_cache_load (AnjutaProjectNode *root, GFile *cache, AnjutaProjectCacheNewNode new_node, gpointer user_data, GList **changed, GError **error)
+{
+	gchar *content;
+	gsize length;
+	CacheReader reader;
+	CacheLoad load;
+	gchar *uri;
+	gchar *root_uri;
+	gboolean ok;
+
+	g_return_val_if_fail (ANJUTA_IS_PROJECT_NODE (root), FALSE);
+	g_return_val_if_fail (root->children == NULL, FALSE);
+	g_return_val_if_fail (G_IS_FILE (cache), FALSE);
+	g_return_val_if_fail (new_node != NULL, FALSE);
+
+	if (!g_file_load_contents (cache, NULL, &content, &length, NULL, error)) return FALSE;
+
+	reader.pos = content;
+	reader.end = content + length;
+	reader.error = FALSE;
+
+	load.root = root;
+	load.new_node = new_node;
+	load.user_data = user_data;
+	load.changed = NULL;
+
+	/* Check header */
+	ok = (length >= 4) && (memcmp (content, CACHE_MAGIC, 4) == 0);
+	if (ok)
+	{
+		reader.pos += 4;
+		ok = cache_read_uint32 (&reader) == CACHE_VERSION;
+	}
+	if (ok)
+	{
+		uri = cache_read_dup_string (&reader);
+		root_uri = root->file != NULL ? g_file_get_uri (root->file) : NULL;
+		ok = g_strcmp0 (uri, root_uri) == 0;
+		g_free (root_uri);
+		g_free (uri);
+	}
+
+	/* Root node, only its stamp is used */
+	if (ok)
+	{
+		GFile *file;
+
+		cache_read_uint32 (&reader);
+		cache_read_uint32 (&reader);
+		g_free (cache_read_dup_string (&reader));
+		file = cache_read_file (&reader, root->file);
+		if (file != NULL) g_object_unref (file);
+		if (cache_read_stamp (&reader, root->file)) cache_mark_changed (&load, root);
+		ok = !reader.error;
+	}
+
+	if (ok) ok = cache_read_children (&reader, &load, root, root->file);
+	g_free (content);
+
+	if (!ok)
+	{
+		AnjutaProjectNode *child;
+
+		while ((child = root->children) != NULL)
+		{
+			anjuta_project_node_remove (child);
+			g_object_unref (child);
+		}
+		g_list_free (load.changed);
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Invalid project cache");
+
+		return FALSE;
+	}
+
+	DEBUG_PRINT ("load project cache with %d changed groups", g_list_length (load.changed));
+	if (changed != NULL)
+	{
+		*changed = g_list_reverse (load.changed);
+	}
+	else
+	{
+		g_list_free (load.changed);
+	}
+
+	return TRUE;
+}
@@ -0,0 +1,50 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta-project-cache.h
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _ANJUTA_PROJECT_CACHE_H_
+#define _ANJUTA_PROJECT_CACHE_H_
+
+#include <gio/gio.h>
+#include <glib.h>
+
+#include <libanjuta/anjuta-project.h>
+
+G_BEGIN_DECLS
+
+/**
+ * AnjutaProjectCacheNewNode:
+ * @parent: parent of the new node
+ * @type: full type of the new node
+ * @file: (allow-none): file of the new node
+ * @name: (allow-none): name of the new node
+ * @user_data: (closure): data passed to anjuta_project_cache_load()
+ *
+ * Create a node of the backend without adding it in the tree.
+ *
+ * Returns: (transfer full): the new node or %NULL to skip it and its children
+ */
+typedef AnjutaProjectNode *(*AnjutaProjectCacheNewNode) (AnjutaProjectNode *parent, AnjutaProjectNodeType type, GFile *file, const gchar *name, gpointer user_data);
+
+GFile *anjuta_project_cache_get_file (GFile *root, const gchar *backend);
+
+gboolean anjuta_project_cache_save (AnjutaProjectNode *root, GFile *cache, GError **error);
+gboolean anjuta_project_cache_load (AnjutaProjectNode *root, GFile *cache, AnjutaProjectCacheNewNode new_node, gpointer user_data, GList **changed, GError **error);
+
+G_END_DECLS
+
+#endif /* _ANJUTA_PROJECT_CACHE_H_ */
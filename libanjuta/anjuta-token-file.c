@@ -39,6 +39,8 @@ struct _AnjutaTokenFile
 
 	AnjutaToken *save;			/* List of memory block used */
 
+	AnjutaTokenArena *arena;	/* Memory used by the tokens parsed from the file */
+
 	gboolean dirty;					/* Set when the file has been modified */
 };
 
@@ -122,6 +124,7 @@ anjuta_token_file_load (AnjutaTokenFile *file, GError **error)
 		
 		token =	anjuta_token_new_static (ANJUTA_TOKEN_FILE, content);
 		anjuta_token_prepend_child (file->content, token);
+		file->arena = anjuta_token_arena_new ();
 		file->dirty = FALSE;
 	}
 	
@@ -137,6 +140,9 @@ anjuta_token_file_unload (AnjutaTokenFile *file)
 	if (file->save != NULL) anjuta_token_free (file->save);
 	file->save = NULL;
 
+	anjuta_token_arena_free (file->arena);
+	file->arena = NULL;
+
 	return TRUE;
 }
 
@@ -509,6 +515,14 @@ anjuta_token_file_is_dirty (AnjutaTokenFile *file)
 	return file->dirty;
 }
 
+/* The tokens parsed from the file content can be allocated in this arena,
+ * they are released with the content when the file is unloaded. */
+AnjutaTokenArena *
+anjuta_token_file_get_arena (AnjutaTokenFile *file)
+{
+	return file->arena;
+}
+
 /* GObject functions
  *---------------------------------------------------------------------------*/
 
@@ -539,6 +553,7 @@ anjuta_token_file_instance_init (AnjutaTokenFile *file)
 	file->file = NULL;
 	file->content = NULL;
 	file->save = NULL;
+	file->arena = NULL;
 }
 
 /* class_init intialize the class itself not the instance */
@@ -61,6 +61,7 @@ gsize anjuta_token_file_get_token_position (AnjutaTokenFile *file, AnjutaToken *
 GFile *anjuta_token_file_get_file (AnjutaTokenFile *file);
 AnjutaToken *anjuta_token_file_get_content (AnjutaTokenFile *file);
 gboolean anjuta_token_file_is_dirty (AnjutaTokenFile *file);
+AnjutaTokenArena *anjuta_token_file_get_arena (AnjutaTokenFile *file);
 
 
 G_END_DECLS
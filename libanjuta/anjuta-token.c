@@ -42,6 +42,10 @@
  * The token can own the string or has only a pointer on some data allocated
  * somewhere else with a length.
  *
+ * The tokens created while parsing a file can be allocated in an arena owned
+ * by the file, see anjuta_token_arena_set_current(). They point to the file
+ * content anyway, so they are released all together with it.
+ *
  * A token is linked with other tokens using three double linked lists.
  *
  * The first list using next and prev fields is used to keep the token in the
@@ -108,12 +112,13 @@
 
 typedef struct _AnjutaTokenData AnjutaTokenData;
 
+/* The type and the flags share the same 32 bits like in the type argument
+ * of the constructors, so a token fits in 64 bytes */
 struct _AnjutaTokenData
 {
-	AnjutaTokenType type;
-	gint flags;
+	guint32 type;
+	guint32 length;
 	gchar *pos;
-	gsize length;
 };
 
 struct _AnjutaToken
@@ -127,12 +132,51 @@ struct _AnjutaToken
 	AnjutaTokenData data;
 };
 
+#define TOKEN_TYPE(token)	((token)->data.type & ANJUTA_TOKEN_TYPE)
+#define TOKEN_FLAGS(token)	((token)->data.type & ANJUTA_TOKEN_FLAGS)
+
+/* Private flag of the tokens allocated in an arena */
+#define ANJUTA_TOKEN_IN_ARENA	(1 << 28)
+
+/* Number of tokens allocated at once in an arena */
+#define ANJUTA_TOKEN_ARENA_BLOCK	1024
+
+struct _AnjutaTokenArena
+{
+	GSList *blocks;		/* The current block is the first one */
+	guint used;			/* Number of tokens used in the current block */
+};
+
+/* Arena used by the tokens created in the current thread */
+static GPrivate current_arena = G_PRIVATE_INIT (NULL);
+
 /* Helpers functions
  *---------------------------------------------------------------------------*/
 
 /* Private functions
  *---------------------------------------------------------------------------*/
 
+static AnjutaToken *
+anjuta_token_alloc (void)
+{
+	AnjutaTokenArena *arena;
+	AnjutaToken *token;
+
+	arena = (AnjutaTokenArena *)g_private_get (&current_arena);
+	if (arena == NULL) return g_slice_new0 (AnjutaToken);
+
+	if ((arena->blocks == NULL) || (arena->used == ANJUTA_TOKEN_ARENA_BLOCK))
+	{
+		arena->blocks = g_slist_prepend (arena->blocks, g_new (AnjutaToken, ANJUTA_TOKEN_ARENA_BLOCK));
+		arena->used = 0;
+	}
+	token = (AnjutaToken *)arena->blocks->data + arena->used++;
+	memset (token, 0, sizeof (AnjutaToken));
+	token->data.type = ANJUTA_TOKEN_IN_ARENA;
+
+	return token;
+}
+
 static AnjutaToken *
 anjuta_token_next_child (AnjutaToken *child, AnjutaToken **last)
 {
@@ -189,10 +233,9 @@ anjuta_token_copy (AnjutaToken *token)
 
 	if (token != NULL)
 	{
-		copy = g_slice_new0 (AnjutaToken);
-		copy->data.type = token->data.type;
-		copy->data.flags = token->data.flags;
-		if ((copy->data.flags & ANJUTA_TOKEN_STATIC) || (token->data.pos == NULL))
+		copy = anjuta_token_alloc ();
+		copy->data.type |= token->data.type & ~ANJUTA_TOKEN_IN_ARENA;
+		if ((copy->data.type & ANJUTA_TOKEN_STATIC) || (token->data.pos == NULL))
 		{
 			copy->data.pos = token->data.pos;
 		}
@@ -427,13 +470,13 @@ anjuta_token_check_child (AnjutaToken *token, AnjutaToken *parent)
 void
 anjuta_token_set_type (AnjutaToken *token, gint type)
 {
-	token->data.type = type;
+	token->data.type = TOKEN_FLAGS (token) | (type & ANJUTA_TOKEN_TYPE);
 }
 
 gint
 anjuta_token_get_type (AnjutaToken *token)
 {
-	return token->data.type;
+	return TOKEN_TYPE (token);
 }
 
 void
@@ -444,29 +487,29 @@ anjuta_token_set_flags (AnjutaToken *token, gint flags)
 
 	for (child = token; child != NULL; child = anjuta_token_next_child (child, &last))
 	{
-		child->data.flags |= flags;
+		child->data.type |= flags & ANJUTA_TOKEN_FLAGS & ~ANJUTA_TOKEN_IN_ARENA;
 	}
 }
 
 void
 anjuta_token_clear_flags (AnjutaToken *token, gint flags)
 {
-	token->data.flags &= ~flags;
+	token->data.type &= ~(flags & ANJUTA_TOKEN_FLAGS & ~ANJUTA_TOKEN_IN_ARENA);
 }
 
 gint
 anjuta_token_get_flags (AnjutaToken *token)
 {
-	return token->data.flags;
+	return TOKEN_FLAGS (token);
 }
 
 void
 anjuta_token_set_string (AnjutaToken *token, const gchar *data, gsize length)
 {
-	if (!(token->data.flags & ANJUTA_TOKEN_STATIC))
+	if (!(token->data.type & ANJUTA_TOKEN_STATIC))
 	{
 		g_free (token->data.pos);
-		token->data.flags |= ANJUTA_TOKEN_STATIC;
+		token->data.type |= ANJUTA_TOKEN_STATIC;
 	}
 	token->data.pos = (gchar *)data;
 	token->data.length = length;
@@ -1139,7 +1182,7 @@ AnjutaToken *anjuta_token_split (AnjutaToken *token, guint size)
 		anjuta_token_insert_before (token, copy);
 
 		copy->data.length = size;
-		if (token->data.flags & ANJUTA_TOKEN_STATIC)
+		if (token->data.type & ANJUTA_TOKEN_STATIC)
 		{
 			token->data.pos += size;
 			token->data.length -= size;
@@ -1166,7 +1209,7 @@ anjuta_token_cut (AnjutaToken *token, guint pos, guint size)
 
 	if (pos >= token->data.length)
 	{
-		if (!(copy->data.flags & ANJUTA_TOKEN_STATIC))
+		if (!(copy->data.type & ANJUTA_TOKEN_STATIC))
 		{
 			g_free (copy->data.pos);
 		}
@@ -1178,7 +1221,7 @@ anjuta_token_cut (AnjutaToken *token, guint pos, guint size)
 		size = token->data.length - pos;
 	}
 
-	if (copy->data.flags & ANJUTA_TOKEN_STATIC)
+	if (copy->data.type & ANJUTA_TOKEN_STATIC)
 	{
 		copy->data.pos += pos;
 	}
@@ -1584,18 +1627,18 @@ anjuta_token_is_empty (AnjutaToken *token)
 gboolean
 anjuta_token_compare (AnjutaToken *toka, AnjutaToken *tokb)
 {
-	if (tokb->data.type)
+	if (TOKEN_TYPE (tokb))
 	{
-		if (tokb->data.type != toka->data.type) return FALSE;
+		if (TOKEN_TYPE (tokb) != TOKEN_TYPE (toka)) return FALSE;
 	}
 
-	if (tokb->data.type != ANJUTA_TOKEN_NONE)
+	if (TOKEN_TYPE (tokb) != ANJUTA_TOKEN_NONE)
 	{
 		if (tokb->data.length != 0)
 		{
 			if (toka->data.length != tokb->data.length) return FALSE;
 
-			if ((toka->data.flags & ANJUTA_TOKEN_CASE_INSENSITIVE)  && (tokb->data.flags & ANJUTA_TOKEN_CASE_INSENSITIVE))
+			if ((toka->data.type & ANJUTA_TOKEN_CASE_INSENSITIVE)  && (tokb->data.type & ANJUTA_TOKEN_CASE_INSENSITIVE))
 			{
 				if (g_ascii_strncasecmp (toka->data.pos, tokb->data.pos, toka->data.length) != 0) return FALSE;
 			}
@@ -1606,9 +1649,9 @@ anjuta_token_compare (AnjutaToken *toka, AnjutaToken *tokb)
 		}
 	}
 
-	if (tokb->data.flags & ANJUTA_TOKEN_PUBLIC_FLAGS)
+	if (tokb->data.type & ANJUTA_TOKEN_PUBLIC_FLAGS)
 	{
-		if ((toka->data.flags & tokb->data.flags & ANJUTA_TOKEN_PUBLIC_FLAGS) == 0)
+		if ((toka->data.type & tokb->data.type & ANJUTA_TOKEN_PUBLIC_FLAGS) == 0)
 			return FALSE;
 	}
 
@@ -1684,9 +1727,8 @@ AnjutaToken *anjuta_token_new_string (AnjutaTokenType type, const gchar *value)
 	}
 	else
 	{
-		token = g_slice_new0 (AnjutaToken);
-		token->data.type = type  & ANJUTA_TOKEN_TYPE;
-		token->data.flags = type & ANJUTA_TOKEN_FLAGS;
+		token = anjuta_token_alloc ();
+		token->data.type |= type & (ANJUTA_TOKEN_TYPE | ANJUTA_TOKEN_FLAGS) & ~ANJUTA_TOKEN_IN_ARENA;
 		token->data.pos = g_strdup (value);
 		token->data.length = strlen (value);
 	}
@@ -1705,9 +1747,8 @@ anjuta_token_new_string_len (AnjutaTokenType type, gchar *value, gsize length)
 	}
 	else
 	{
-		token = g_slice_new0 (AnjutaToken);
-		token->data.type = type  & ANJUTA_TOKEN_TYPE;
-		token->data.flags = type & ANJUTA_TOKEN_FLAGS;
+		token = anjuta_token_alloc ();
+		token->data.type |= type & (ANJUTA_TOKEN_TYPE | ANJUTA_TOKEN_FLAGS) & ~ANJUTA_TOKEN_IN_ARENA;
 		token->data.pos = value;
 		token->data.length = length;
 	}
@@ -1720,9 +1761,8 @@ anjuta_token_new_static_len (gint type, const gchar *pos, gsize length)
 {
 	AnjutaToken *token;
 
-	token = g_slice_new0 (AnjutaToken);
-	token->data.type = type  & ANJUTA_TOKEN_TYPE;
-	token->data.flags = (type & ANJUTA_TOKEN_FLAGS) | ANJUTA_TOKEN_STATIC;
+	token = anjuta_token_alloc ();
+	token->data.type |= (type & (ANJUTA_TOKEN_TYPE | ANJUTA_TOKEN_FLAGS) & ~ANJUTA_TOKEN_IN_ARENA) | ANJUTA_TOKEN_STATIC;
 	token->data.pos = (gchar *)pos;
 	token->data.length = length;
 
@@ -1766,11 +1806,19 @@ static void
 free_token (AnjutaToken *token, gpointer user_data)
 {
 	anjuta_token_unlink_token (token);
-	if ((token->data.pos != NULL) && !(token->data.flags & ANJUTA_TOKEN_STATIC))
+	if ((token->data.pos != NULL) && !(token->data.type & ANJUTA_TOKEN_STATIC))
 	{
 		g_free (token->data.pos);
 	}
-	g_slice_free (AnjutaToken, token);
+	if (token->data.type & ANJUTA_TOKEN_IN_ARENA)
+	{
+		/* The memory is released with the arena */
+		token->data.pos = NULL;
+	}
+	else
+	{
+		g_slice_free (AnjutaToken, token);
+	}
 }
 
 
@@ -1785,3 +1833,74 @@ anjuta_token_free (AnjutaToken *token)
 
 	return next;
 }
+
+/**
+ * anjuta_token_arena_new:
+ *
+ * Create an arena, a memory pool for the tokens of one file.
+ *
+ * Return value: A new #AnjutaTokenArena.
+ */
+AnjutaTokenArena *
+anjuta_token_arena_new (void)
+{
+	return g_slice_new0 (AnjutaTokenArena);
+}
+
+/**
+ * anjuta_token_arena_free:
+ * @arena: a #AnjutaTokenArena object.
+ *
+ * Release all the tokens allocated in the arena at once, without unlinking
+ * them. None of these tokens can be used after.
+ */
+void
+anjuta_token_arena_free (AnjutaTokenArena *arena)
+{
+	GSList *block;
+	guint used;
+
+	if (arena == NULL) return;
+
+	/* Only the strings owned by the tokens have to be freed one by one */
+	used = arena->used;
+	for (block = arena->blocks; block != NULL; block = g_slist_next (block))
+	{
+		AnjutaToken *token;
+		AnjutaToken *end;
+
+		end = (AnjutaToken *)block->data + used;
+		for (token = (AnjutaToken *)block->data; token != end; token++)
+		{
+			if ((token->data.pos != NULL) && !(token->data.type & ANJUTA_TOKEN_STATIC))
+			{
+				g_free (token->data.pos);
+			}
+		}
+		g_free (block->data);
+		used = ANJUTA_TOKEN_ARENA_BLOCK;
+	}
+	g_slist_free (arena->blocks);
+	g_slice_free (AnjutaTokenArena, arena);
+}
+
+/**
+ * anjuta_token_arena_set_current:
+ * @arena: (allow-none): a #AnjutaTokenArena object or %NULL
+ *
+ * Allocate all tokens created afterward by the calling thread in @arena.
+ * If @arena is %NULL, the tokens are allocated one by one and have to be
+ * freed with anjuta_token_free().
+ *
+ * Return value: The previous arena of the thread, to be restored when done.
+ */
+AnjutaTokenArena *
+anjuta_token_arena_set_current (AnjutaTokenArena *arena)
+{
+	AnjutaTokenArena *previous;
+
+	previous = (AnjutaTokenArena *)g_private_get (&current_arena);
+	g_private_set (&current_arena, arena);
+
+	return previous;
+}
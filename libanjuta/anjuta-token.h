@@ -86,6 +86,8 @@ typedef enum
 
 typedef struct _AnjutaToken AnjutaToken;
 
+typedef struct _AnjutaTokenArena AnjutaTokenArena;
+
 typedef void (*AnjutaTokenForeachFunc) (AnjutaToken *token, gpointer data);
 
 
@@ -97,6 +99,10 @@ AnjutaToken *anjuta_token_new_static_len (gint type, const gchar *pos, gsize len
 AnjutaToken* anjuta_token_free_children (AnjutaToken *token);
 AnjutaToken* anjuta_token_free (AnjutaToken *token);
 
+AnjutaTokenArena *anjuta_token_arena_new (void);
+void anjuta_token_arena_free (AnjutaTokenArena *arena);
+AnjutaTokenArena *anjuta_token_arena_set_current (AnjutaTokenArena *arena);
+
 void anjuta_token_set_type (AnjutaToken *token, gint type);
 gint anjuta_token_get_type (AnjutaToken *token);
 void anjuta_token_set_flags (AnjutaToken *token, gint flags);
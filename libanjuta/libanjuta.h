@@ -50,6 +50,7 @@
 #include <libanjuta/anjuta-async-notify.h>
 #include <libanjuta/anjuta-sync-command.h>
 #include <libanjuta/anjuta-project.h>
+#include <libanjuta/anjuta-project-cache.h>
 #include <libanjuta/anjuta-command-queue.h>
 #include <libanjuta/anjuta-command-bar.h>
 #include <libanjuta/anjuta-dock.h>
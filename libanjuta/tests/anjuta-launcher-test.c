@@ -0,0 +1,160 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta-launcher-test.c
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the throughput of the launcher output path: a child writes
+ * lines of LINE_LENGTH characters on its standard output, the test checks
+ * that every line arrives complete and reports the speed. */
+
+#include <libanjuta/anjuta-launcher.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_LENGTH 79
+/* Kept small for make check, give a bigger size as argument to measure the
+ * throughput */
+#define DEFAULT_MEGABYTES 16
+
+typedef struct
+{
+	GMainLoop *loop;
+	guint64 bytes;
+	guint64 lines;
+	gboolean ok;
+} LauncherTest;
+
+static void
+on_output_slice (AnjutaLauncher *launcher, AnjutaLauncherOutputType output_type,
+				 const gchar *chars, gsize len, gpointer user_data)
+{
+	LauncherTest *test = user_data;
+	const gchar *line = chars;
+	const gchar *end = chars + len;
+
+	if (output_type != ANJUTA_LAUNCHER_OUTPUT_STDOUT)
+		return;
+
+	test->bytes += len;
+	while (line < end)
+	{
+		const gchar *newline = memchr (line, '\n', end - line);
+
+		/* Buffered output contains complete lines only */
+		if (newline == NULL || newline - line != LINE_LENGTH)
+		{
+			test->ok = FALSE;
+			break;
+		}
+		test->lines++;
+		line = newline + 1;
+	}
+}
+
+static void
+on_output (AnjutaLauncher *launcher, AnjutaLauncherOutputType output_type,
+		   const gchar *chars, gpointer user_data)
+{
+	on_output_slice (launcher, output_type, chars, strlen (chars), user_data);
+}
+
+static void
+on_child_exited (AnjutaLauncher *launcher, gint child_pid, gint status,
+				 gulong time, gpointer user_data)
+{
+	LauncherTest *test = user_data;
+
+	g_main_loop_quit (test->loop);
+}
+
+static gboolean
+run_test (AnjutaLauncher *launcher, guint64 megabytes, gboolean slices)
+{
+	LauncherTest test;
+	guint64 expected;
+	gchar *line;
+	gchar *command;
+	GTimer *timer;
+	gdouble elapsed;
+
+	expected = megabytes * 1024 * 1024 / (LINE_LENGTH + 1);
+
+	test.loop = g_main_loop_new (NULL, FALSE);
+	test.bytes = 0;
+	test.lines = 0;
+	test.ok = TRUE;
+
+	line = g_strnfill (LINE_LENGTH, 'x');
+	command = g_strdup_printf ("sh -c \"yes %s | head -n %" G_GUINT64_FORMAT "\"",
+							   line, expected);
+	g_free (line);
+
+	anjuta_launcher_set_check_passwd_prompt (launcher, FALSE);
+	if (slices)
+		anjuta_launcher_set_slice_callback (launcher, on_output_slice);
+	g_signal_connect (launcher, "child-exited",
+					  G_CALLBACK (on_child_exited), &test);
+
+	timer = g_timer_new ();
+	if (!anjuta_launcher_execute (launcher, command, on_output, &test))
+	{
+		fprintf (stderr, "Unable to execute %s\n", command);
+		test.ok = FALSE;
+	}
+	else
+	{
+		g_main_loop_run (test.loop);
+	}
+	elapsed = g_timer_elapsed (timer, NULL);
+
+	g_signal_handlers_disconnect_by_func (launcher,
+										  G_CALLBACK (on_child_exited), &test);
+	test.ok = test.ok && test.lines == expected;
+
+	fprintf (stdout, "%s: %" G_GUINT64_FORMAT " lines, %" G_GUINT64_FORMAT
+			 " bytes in %.2f s, %.1f MB/s %s\n",
+			 slices ? "slices" : "strings", test.lines, test.bytes, elapsed,
+			 elapsed > 0 ? test.bytes / elapsed / (1024 * 1024) : 0.0,
+			 test.ok ? "OK" : "FAILED");
+
+	g_timer_destroy (timer);
+	g_free (command);
+	g_main_loop_unref (test.loop);
+
+	return test.ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+	AnjutaLauncher *launcher;
+	guint64 megabytes = DEFAULT_MEGABYTES;
+	gboolean ok;
+
+	g_type_init ();
+
+	if (argc > 1)
+		megabytes = g_ascii_strtoull (argv[1], NULL, 10);
+
+	launcher = anjuta_launcher_new ();
+	ok = run_test (launcher, megabytes, FALSE);
+	ok = run_test (launcher, megabytes, TRUE) && ok;
+	g_object_unref (launcher);
+
+	return ok ? 0 : 1;
+}
@@ -85,6 +85,11 @@ struct _AmpProject {
 	/* Command queue */
 	PmCommandQueue *queue;
 
+	/* Threads parsing makefiles while loading */
+	GThreadPool *loader;
+	GMutex lock;
+	GCond loaded;
+
 	/* Language Manager */
 	IAnjutaLanguage *lang_manager;
 };
@@ -40,7 +40,9 @@
 #include <libanjuta/anjuta-debug.h>
 #include <libanjuta/anjuta-utils.h>
 #include <libanjuta/anjuta-pkg-config.h>
+#include <libanjuta/anjuta-project-cache.h>
 
+#include <stdlib.h>
 #include <string.h>
 #include <memory.h>
 #include <errno.h>
@@ -70,6 +72,15 @@
 
 const gchar *valid_am_makefiles[] = {"GNUmakefile.am", "makefile.am", "Makefile.am", NULL};
 
+/* Threads parsing makefiles while the project is loading, GLib 2.32 has no
+ * g_get_num_processors(), the environment variable can change it, 0 loads
+ * the makefiles one after the other */
+#define AMP_LOAD_THREADS 4
+#define AMP_LOAD_THREADS_ENV "ANJUTA_AMP_LOAD_THREADS"
+
+/* Name of the snapshot of the project tree in the .anjuta directory */
+#define AMP_CACHE_NAME "am-project"
+
 
 #define STR_REPLACE(target, source) \
 	{ g_free (target); target = source == NULL ? NULL : g_strdup (source);}
@@ -504,10 +515,11 @@ amp_config_file_free (AmpConfigFile *config)
 static void
 amp_project_clear (AmpProject *project)
 {
-	if (project->configure_file != NULL) anjuta_token_file_free (project->configure_file);
-	project->configure_file = NULL;
+	/* The configure tokens can be allocated in the token file */
 	if (project->configure_token) anjuta_token_free (project->configure_token);
 	project->configure_token = NULL;
+	if (project->configure_file != NULL) anjuta_token_file_free (project->configure_file);
+	project->configure_file = NULL;
 }
 
 static void
@@ -594,7 +606,9 @@ remove_config_file (gpointer data, GObject *object)
 
 	g_return_if_fail (project->files != NULL);
 
+	g_mutex_lock (&project->lock);
 	project->files = g_list_remove (project->files, object);
+	g_mutex_unlock (&project->lock);
 }
 
 void
@@ -1355,10 +1369,137 @@ find_group (AnjutaProjectNode *node, gpointer data)
 	return FALSE;
 }
 
+/* Makefile of a new group parsed by the loader threads. The project thread
+ * loads the groups in order and parses itself the makefiles not taken yet
+ * by a loader thread. */
+typedef enum
+{
+	AMP_GROUP_LOAD_QUEUED,
+	AMP_GROUP_LOAD_RUNNING,
+	AMP_GROUP_LOAD_DONE
+} AmpGroupLoadState;
+
+typedef struct _AmpGroupLoad AmpGroupLoad;
+
+struct _AmpGroupLoad
+{
+	AnjutaToken *arg;
+	AmpGroupNode *group;
+	AmpGroupLoadState state;
+	gint ref_count;
+};
+
+static AmpGroupLoad *
+amp_group_load_new (AnjutaToken *arg, AmpGroupNode *group)
+{
+	AmpGroupLoad *load;
+
+	load = g_slice_new (AmpGroupLoad);
+	load->arg = arg;
+	load->group = g_object_ref (group);
+	load->state = AMP_GROUP_LOAD_QUEUED;
+	load->ref_count = 2;	/* Loader thread and project thread */
+
+	return load;
+}
+
+static void
+amp_group_load_unref (AmpGroupLoad *load)
+{
+	if (g_atomic_int_dec_and_test (&load->ref_count))
+	{
+		g_object_unref (load->group);
+		g_slice_free (AmpGroupLoad, load);
+	}
+}
+
+/* Take a queued makefile, return FALSE if it is already taken */
+static gboolean
+amp_group_load_take (AmpProject *project, AmpGroupLoad *load)
+{
+	gboolean queued;
+
+	g_mutex_lock (&project->lock);
+	queued = load->state == AMP_GROUP_LOAD_QUEUED;
+	if (queued) load->state = AMP_GROUP_LOAD_RUNNING;
+	g_mutex_unlock (&project->lock);
+
+	return queued;
+}
+
+static void
+amp_group_load_thread (AmpGroupLoad *load, AmpProject *project)
+{
+	if (amp_group_load_take (project, load))
+	{
+		amp_group_node_prefetch (load->group, project);
+
+		g_mutex_lock (&project->lock);
+		load->state = AMP_GROUP_LOAD_DONE;
+		g_cond_broadcast (&project->loaded);
+		g_mutex_unlock (&project->lock);
+	}
+	amp_group_load_unref (load);
+}
+
+/* Wait for a makefile parsed by a loader thread, if it is still queued the
+ * group will parse it when loaded */
+static void
+amp_group_load_wait (AmpProject *project, AmpGroupLoad *load)
+{
+	if (amp_group_load_take (project, load)) return;
+
+	g_mutex_lock (&project->lock);
+	while (load->state != AMP_GROUP_LOAD_DONE)
+	{
+		g_cond_wait (&project->loaded, &project->lock);
+	}
+	g_mutex_unlock (&project->lock);
+}
+
 static void
 project_load_subdirs (AmpProject *project, AnjutaToken *list, AnjutaProjectNode *parent, gboolean dist_only)
 {
 	AnjutaToken *arg;
+	GQueue loads = G_QUEUE_INIT;
+
+	if (project->loader != NULL)
+	{
+		/* Create all new groups first to parse their makefiles in the loader
+		 * threads while the previous groups are loading. They are appended
+		 * in the same order, loading a group changes only its children. */
+		for (arg = anjuta_token_first_word (list); arg != NULL; arg = anjuta_token_next_word (arg))
+		{
+			gchar *value;
+
+			value = anjuta_token_evaluate (arg);
+			if (value == NULL) continue;
+
+			if (strcmp (value, ".") != 0)
+			{
+				GFile *subdir;
+
+				subdir = g_file_resolve_relative_path (anjuta_project_node_get_file (parent), value);
+				if (anjuta_project_node_children_traverse (parent, find_group, subdir) == NULL)
+				{
+					AmpGroupNode *group;
+
+					group = amp_group_node_new (subdir, value, dist_only);
+					if (group != NULL)
+					{
+						AmpGroupLoad *load;
+
+						anjuta_project_node_append (parent, ANJUTA_PROJECT_NODE (group));
+						load = amp_group_load_new (arg, group);
+						g_queue_push_tail (&loads, load);
+						g_thread_pool_push (project->loader, load, NULL);
+					}
+				}
+				g_object_unref (subdir);
+			}
+			g_free (value);
+		}
+	}
 
 	for (arg = anjuta_token_first_word (list); arg != NULL; arg = anjuta_token_next_word (arg))
 	{
@@ -1372,29 +1513,45 @@ project_load_subdirs (AmpProject *project, AnjutaToken *list, AnjutaProjectNode
 		{
 			GFile *subdir;
 			AmpGroupNode *group;
+			AmpGroupLoad *load;
 
 			subdir = g_file_resolve_relative_path (anjuta_project_node_get_file (parent), value);
 
-			/* Look for already existing group */
-			group = AMP_GROUP_NODE (anjuta_project_node_children_traverse (parent, find_group, subdir));
-
-			if (group != NULL)
+			load = (AmpGroupLoad *)g_queue_peek_head (&loads);
+			if ((load != NULL) && (load->arg == arg))
 			{
-				/* Already existing group, mark for built if needed */
-				if (!dist_only) amp_group_node_set_dist_only (group, FALSE);
+				/* New group created above, load it */
+				g_queue_pop_head (&loads);
+				group = load->group;
+				g_hash_table_insert (project->groups, g_file_get_uri (subdir), group);
+
+				amp_group_load_wait (project, load);
+				amp_node_load (AMP_NODE (group), NULL, project, NULL);
+				amp_group_load_unref (load);
 			}
 			else
 			{
-				/* Create new group */
-				group = amp_group_node_new (subdir, value, dist_only);
+				/* Look for already existing group */
+				group = AMP_GROUP_NODE (anjuta_project_node_children_traverse (parent, find_group, subdir));
 
-				/* Group can be NULL if the name is not valid */
 				if (group != NULL)
 				{
-					g_hash_table_insert (project->groups, g_file_get_uri (subdir), group);
-					anjuta_project_node_append (parent, ANJUTA_PROJECT_NODE (group));
+					/* Already existing group, mark for built if needed */
+					if (!dist_only) amp_group_node_set_dist_only (group, FALSE);
+				}
+				else
+				{
+					/* Create new group */
+					group = amp_group_node_new (subdir, value, dist_only);
+
+					/* Group can be NULL if the name is not valid */
+					if (group != NULL)
+					{
+						g_hash_table_insert (project->groups, g_file_get_uri (subdir), group);
+						anjuta_project_node_append (parent, ANJUTA_PROJECT_NODE (group));
 
-					amp_node_load (AMP_NODE (group), NULL, project, NULL);
+						amp_node_load (AMP_NODE (group), NULL, project, NULL);
+					}
 				}
 			}
 			if (group) amp_group_node_add_token (group, arg, dist_only ? AM_GROUP_TOKEN_DIST_SUBDIRS : AM_GROUP_TOKEN_SUBDIRS);
@@ -1641,6 +1798,19 @@ amp_project_get_type_info (AmpProject *project, AnjutaProjectNodeType type)
 	return (AnjutaProjectNodeInfo *)info;
 }
 
+static GThreadPool *
+amp_project_new_loader (AmpProject *project)
+{
+	const gchar *value;
+	gint threads = AMP_LOAD_THREADS;
+
+	value = g_getenv (AMP_LOAD_THREADS_ENV);
+	if (value != NULL) threads = atoi (value);
+	if (threads <= 0) return NULL;
+
+	return g_thread_pool_new ((GFunc)amp_group_load_thread, project, threads, FALSE, NULL);
+}
+
 static gboolean
 amp_project_load_root (AmpProject *project, GError **error)
 {
@@ -1649,7 +1819,9 @@ amp_project_load_root (AmpProject *project, GError **error)
 	GFile *root_file;
 	GFile *configure_file;
 	AnjutaTokenFile *configure_token_file;
+	AnjutaTokenArena *arena;
 	AnjutaProjectNode *source;
+	gboolean loaded;
 	GError *err = NULL;
 
 	root_file = anjuta_project_node_get_file (ANJUTA_PROJECT_NODE (project));
@@ -1689,7 +1861,9 @@ amp_project_load_root (AmpProject *project, GError **error)
 	arg = anjuta_token_file_load (configure_token_file, NULL);
 	g_hash_table_remove_all (project->ac_variables);
 	scanner = amp_ac_scanner_new (project);
+	arena = anjuta_token_arena_set_current (anjuta_token_file_get_arena (configure_token_file));
 	project->configure_token = amp_ac_scanner_parse_token (scanner, NULL, arg, 0, configure_file, &err);
+	anjuta_token_arena_set_current (arena);
 	amp_ac_scanner_free (scanner);
 
 	if (project->configure_token == NULL)
@@ -1713,7 +1887,14 @@ amp_project_load_root (AmpProject *project, GError **error)
 	}
 
 	/* Load all makefiles recursively */
-	if (!AMP_NODE_CLASS (parent_class)->load (AMP_NODE (project), NULL, project, NULL))
+	project->loader = amp_project_new_loader (project);
+	loaded = AMP_NODE_CLASS (parent_class)->load (AMP_NODE (project), NULL, project, NULL);
+	if (project->loader != NULL)
+	{
+		g_thread_pool_free (project->loader, FALSE, TRUE);
+		project->loader = NULL;
+	}
+	if (!loaded)
 	{
 		g_set_error (error, IANJUTA_PROJECT_ERROR,
 					IANJUTA_PROJECT_ERROR_DOESNT_EXIST,
@@ -1802,16 +1983,21 @@ gboolean
 amp_project_get_token_location (AmpProject *project, AnjutaTokenFileLocation *location, AnjutaToken *token)
 {
 	GList *list;
+	gboolean found = FALSE;
 
+	/* Makefiles can be parsed in loader threads */
+	g_mutex_lock (&project->lock);
 	for (list = project->files; list != NULL; list = g_list_next (list))
 	{
 		if (anjuta_token_file_get_token_location ((AnjutaTokenFile *)list->data, location, token))
 		{
-			return TRUE;
+			found = TRUE;
+			break;
 		}
 	}
+	g_mutex_unlock (&project->lock);
 
-	return FALSE;
+	return found;
 }
 
 void
@@ -2071,7 +2257,9 @@ amp_project_get_file (AmpProject *project)
 void
 amp_project_add_file (AmpProject *project, GFile *file, AnjutaTokenFile* token)
 {
+	g_mutex_lock (&project->lock);
 	project->files = g_list_prepend (project->files, token);
+	g_mutex_unlock (&project->lock);
 	g_object_weak_ref (G_OBJECT (token), remove_config_file, project);
 }
 
@@ -2112,7 +2300,21 @@ amp_load_setup (PmJob *job)
 static gboolean
 amp_load_work (PmJob *job)
 {
-	return amp_node_load (AMP_NODE (job->proxy), AMP_NODE (job->parent), AMP_PROJECT (job->user_data), &job->error);
+	gboolean ok;
+
+	ok = amp_node_load (AMP_NODE (job->proxy), AMP_NODE (job->parent), AMP_PROJECT (job->user_data), &job->error);
+
+	if (ok && (anjuta_project_node_get_node_type (job->proxy) == ANJUTA_PROJECT_ROOT))
+	{
+		GFile *cache;
+
+		/* Keep a snapshot of the whole tree for the next time */
+		cache = anjuta_project_cache_get_file (anjuta_project_node_get_file (job->proxy), AMP_CACHE_NAME);
+		anjuta_project_cache_save (job->proxy, cache, NULL);
+		g_object_unref (cache);
+	}
+
+	return ok;
 }
 
 static gboolean
@@ -2151,6 +2353,89 @@ amp_load_complete (PmJob *job)
 
 static PmCommandWork amp_load_job = {amp_load_setup, amp_load_work, amp_load_complete};
 
+static AnjutaProjectNode *
+amp_cache_new_node (AnjutaProjectNode *parent, AnjutaProjectNodeType type, GFile *file, const gchar *name, gpointer user_data)
+{
+	AmpProject *project = AMP_PROJECT (user_data);
+	AnjutaProjectNode *node;
+
+	switch (type & ANJUTA_PROJECT_TYPE_MASK)
+	{
+	case ANJUTA_PROJECT_GROUP:
+		if (file == NULL) return NULL;
+		node = ANJUTA_PROJECT_NODE (amp_group_node_new (file, name, FALSE));
+		g_hash_table_insert (project->groups, g_file_get_uri (file), node);
+		return node;
+	case ANJUTA_PROJECT_TARGET:
+		return name != NULL ? ANJUTA_PROJECT_NODE (amp_target_node_new (name, type, NULL, 0)) : NULL;
+	case ANJUTA_PROJECT_SOURCE:
+		return file != NULL ? amp_source_node_new (file, type) : NULL;
+	case ANJUTA_PROJECT_OBJECT:
+		return file != NULL ? amp_object_node_new (file, type) : NULL;
+	case ANJUTA_PROJECT_MODULE:
+		return name != NULL ? ANJUTA_PROJECT_NODE (amp_module_node_new (name)) : NULL;
+	case ANJUTA_PROJECT_PACKAGE:
+		return name != NULL ? ANJUTA_PROJECT_NODE (amp_package_node_new (name)) : NULL;
+	default:
+		return NULL;
+	}
+}
+
+static gboolean
+amp_load_cache_setup (PmJob *job)
+{
+	job->proxy = ANJUTA_PROJECT_NODE (amp_node_copy (AMP_NODE (job->node)));
+
+	return TRUE;
+}
+
+static gboolean
+amp_load_cache_work (PmJob *job)
+{
+	GFile *cache;
+	GList *changed = NULL;
+	gboolean ok;
+
+	cache = anjuta_project_cache_get_file (anjuta_project_node_get_file (job->proxy), AMP_CACHE_NAME);
+	ok = anjuta_project_cache_load (job->proxy, cache, amp_cache_new_node, job->proxy, &changed, &job->error);
+	g_object_unref (cache);
+
+	/* Use only an up to date snapshot, the full load following it will
+	 * update an outdated one anyway but it is better to display nothing
+	 * than wrong data meanwhile. */
+	if (ok && (changed != NULL))
+	{
+		g_set_error_literal (&job->error, G_IO_ERROR, G_IO_ERROR_FAILED, "Project cache is out of date");
+		ok = FALSE;
+	}
+	g_list_free (changed);
+
+	return ok;
+}
+
+static gboolean
+amp_load_cache_complete (PmJob *job)
+{
+	g_return_val_if_fail (job->proxy != NULL, FALSE);
+
+	if (job->error != NULL)
+	{
+		/* Wait for the full load */
+		DEBUG_PRINT ("Project cache not used: %s", job->error->message);
+		g_object_unref (job->proxy);
+		job->proxy = NULL;
+		AMP_PROJECT (job->user_data)->loading--;
+
+		return TRUE;
+	}
+
+	return amp_load_complete (job);
+}
+
+/* Display the project saved in the cache, the nodes have no tokens nor
+ * properties, they will be updated by the full load queued after it */
+static PmCommandWork amp_load_cache_job = {amp_load_cache_setup, amp_load_cache_work, amp_load_cache_complete};
+
 static gboolean
 amp_save_setup (PmJob *job)
 {
@@ -2364,6 +2649,14 @@ iproject_load_node (IAnjutaProject *obj, AnjutaProjectNode *node, GError **error
 	if (node == NULL) node = ANJUTA_PROJECT_NODE (obj);
 	if (AMP_PROJECT (obj)->queue == NULL) AMP_PROJECT (obj)->queue = pm_command_queue_new ();
 
+	if ((node == ANJUTA_PROJECT_NODE (obj)) && (anjuta_project_node_first_child (node) == NULL))
+	{
+		/* Opening the project, display it from the cache if possible */
+		AMP_PROJECT (obj)->loading++;
+		load_job = pm_job_new (&amp_load_cache_job, node, NULL, NULL, ANJUTA_PROJECT_UNKNOWN, NULL, NULL, obj);
+		pm_command_queue_push (AMP_PROJECT (obj)->queue, load_job);
+	}
+
 	AMP_PROJECT (obj)->loading++;
 	load_job = pm_job_new (&amp_load_job, node, NULL, NULL, ANJUTA_PROJECT_UNKNOWN, NULL, NULL, obj);
 
@@ -2592,6 +2885,17 @@ amp_project_dispose (GObject *object)
 	G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static void
+amp_project_finalize (GObject *object)
+{
+	AmpProject *project = AMP_PROJECT (object);
+
+	g_mutex_clear (&project->lock);
+	g_cond_clear (&project->loaded);
+
+	G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 amp_project_init (AmpProject *project)
 {
@@ -2615,6 +2919,10 @@ amp_project_init (AmpProject *project)
 
 	project->queue = NULL;
 	project->loading = 0;
+
+	project->loader = NULL;
+	g_mutex_init (&project->lock);
+	g_cond_init (&project->loaded);
 }
 
 static void
@@ -2627,6 +2935,7 @@ amp_project_class_init (AmpProjectClass *klass)
 
 	object_class = G_OBJECT_CLASS (klass);
 	object_class->dispose = amp_project_dispose;
+	object_class->finalize = amp_project_finalize;
 
 	node_class = AMP_NODE_CLASS (klass);
 	node_class->load = amp_project_load;
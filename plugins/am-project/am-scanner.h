@@ -40,6 +40,8 @@ AmpAmScanner *amp_am_scanner_new (AmpProject *project, AmpGroupNode *group);
 void amp_am_scanner_free (AmpAmScanner *scanner);
 
 AnjutaToken *amp_am_scanner_parse_token (AmpAmScanner *scanner, AnjutaToken *root, AnjutaToken *content, GFile *filename, GError **error);
+void amp_am_scanner_set_deferred (AmpAmScanner *scanner, gboolean deferred);
+void amp_am_scanner_evaluate (AmpAmScanner *scanner);
 
 void amp_am_scanner_set_am_variable (AmpAmScanner *scanner, AnjutaToken *variable);
 void amp_am_scanner_include (AmpAmScanner *scanner, AnjutaToken *name);
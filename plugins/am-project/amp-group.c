@@ -48,6 +48,7 @@
 
 G_DEFINE_DYNAMIC_TYPE (AmpGroupNode, amp_group_node, AMP_TYPE_NODE);
 
+static void amp_group_node_evaluate_makefile (AmpGroupNode *group, AmpAmScanner *scanner, AmpProject *project);
 
 /* Helper functions
  *---------------------------------------------------------------------------*/
@@ -184,19 +185,16 @@ project_load_group_module (AmpProject *project, AmpGroupNode *group)
 
 extern const gchar *valid_am_makefiles[];
 
-static AmpGroupNode*
-project_load_makefile (AmpProject *project, AmpGroupNode *group)
+static GFile*
+project_find_makefile (AmpProject *project, AmpGroupNode *group)
 {
 	const gchar **filename;
-	AnjutaTokenFile *tfile;
-	GFile *makefile = NULL;
 	GFile *file = anjuta_project_node_get_file ((AnjutaProjectNode *)group);
 
 	/* Find makefile name
 	 * It has to be in the config_files list with .am extension */
 	for (filename = valid_am_makefiles; *filename != NULL; filename++)
 	{
-		makefile = g_file_get_child (file, *filename);
 		if (file_type (file, *filename) == G_FILE_TYPE_REGULAR)
 		{
 			gchar *final_filename = g_strdup (*filename);
@@ -214,21 +212,33 @@ project_load_makefile (AmpProject *project, AmpGroupNode *group)
 			if (token != NULL)
 			{
 				amp_group_node_add_token (group, token, AM_GROUP_TOKEN_CONFIGURE);
-				break;
+				return g_file_get_child (file, *filename);
 			}
 		}
-		g_object_unref (makefile);
 	}
 
-	if (*filename == NULL)
+	/* Unable to find automake file */
+	return NULL;
+}
+
+static AmpGroupNode*
+project_load_makefile (AmpProject *project, AmpGroupNode *group)
+{
+	AmpAmScanner *scanner;
+
+	/* Parse makefile.am if not already done in another thread */
+	if (!group->prefetched) amp_group_node_prefetch (group, project);
+	group->prefetched = FALSE;
+	scanner = group->scanner;
+	group->scanner = NULL;
+
+	if (scanner == NULL)
 	{
 		/* Unable to find automake file */
 		return group;
 	}
 
-	/* Parse makefile.am */
-	DEBUG_PRINT ("Parse: %s", g_file_get_uri (makefile));
-	tfile = amp_group_node_set_makefile (group, makefile, project);
+	amp_group_node_evaluate_makefile (group, scanner, project);
 
 	project_load_group_module (project, group);
 
@@ -416,6 +426,57 @@ amp_group_node_update_preset_variable (AmpGroupNode *group)
 	g_hash_table_insert (group->variables, var->name, var);
 }
 
+/* Parse the makefile keeping the autotools variables in the returned scanner,
+ * it changes only the group so it can run in another thread */
+static AmpAmScanner *
+amp_group_node_parse_makefile (AmpGroupNode *group, GFile *makefile, AmpProject *project)
+{
+	AnjutaToken *token;
+	AmpAmScanner *scanner;
+	AnjutaProjectNode *source;
+	AnjutaTokenArena *arena;
+
+	group->makefile = g_object_ref (makefile);
+	group->tfile = anjuta_token_file_new (makefile);
+	source = amp_source_node_new (makefile, ANJUTA_PROJECT_PROJECT | ANJUTA_PROJECT_FRAME | ANJUTA_PROJECT_READ_ONLY);
+	anjuta_project_node_append (ANJUTA_PROJECT_NODE (group), source);
+
+	token = anjuta_token_file_load (group->tfile, NULL);
+
+	amp_group_node_update_preset_variable (group);
+
+	scanner = amp_am_scanner_new (project, group);
+	amp_am_scanner_set_deferred (scanner, TRUE);
+	/* The makefile tokens are released with the token file */
+	arena = anjuta_token_arena_set_current (anjuta_token_file_get_arena (group->tfile));
+	group->make_token = amp_am_scanner_parse_token (scanner, anjuta_token_new_static (ANJUTA_TOKEN_FILE, NULL), token, makefile, NULL);
+	anjuta_token_arena_set_current (arena);
+
+	return scanner;
+}
+
+/* Add the makefile to the project and evaluate its autotools variables */
+static void
+amp_group_node_evaluate_makefile (AmpGroupNode *group, AmpAmScanner *scanner, AmpProject *project)
+{
+	amp_project_add_file (project, group->makefile, group->tfile);
+
+	amp_am_scanner_evaluate (scanner);
+	amp_am_scanner_free (scanner);
+
+	group->monitor = g_file_monitor_file (group->makefile,
+					      									G_FILE_MONITOR_NONE,
+					       									NULL,
+					       									NULL);
+	if (group->monitor != NULL)
+	{
+		g_signal_connect (G_OBJECT (group->monitor),
+				  "changed",
+				  G_CALLBACK (on_group_monitor_changed),
+				  group);
+	}
+}
+
 AnjutaTokenFile*
 amp_group_node_set_makefile (AmpGroupNode *group, GFile *makefile, AmpProject *project)
 {
@@ -423,35 +484,10 @@ amp_group_node_set_makefile (AmpGroupNode *group, GFile *makefile, AmpProject *p
 	if (group->tfile != NULL) anjuta_token_file_free (group->tfile);
 	if (makefile != NULL)
 	{
-		AnjutaToken *token;
 		AmpAmScanner *scanner;
-		AnjutaProjectNode *source;
-
-		group->makefile = g_object_ref (makefile);
-		group->tfile = anjuta_token_file_new (makefile);
-		source = amp_source_node_new (makefile, ANJUTA_PROJECT_PROJECT | ANJUTA_PROJECT_FRAME | ANJUTA_PROJECT_READ_ONLY);
-		anjuta_project_node_append (ANJUTA_PROJECT_NODE (group), source);
-
-		token = anjuta_token_file_load (group->tfile, NULL);
-		amp_project_add_file (project, makefile, group->tfile);
-
-		amp_group_node_update_preset_variable (group);
 
-		scanner = amp_am_scanner_new (project, group);
-		group->make_token = amp_am_scanner_parse_token (scanner, anjuta_token_new_static (ANJUTA_TOKEN_FILE, NULL), token, makefile, NULL);
-		amp_am_scanner_free (scanner);
-
-		group->monitor = g_file_monitor_file (makefile,
-						      									G_FILE_MONITOR_NONE,
-						       									NULL,
-						       									NULL);
-		if (group->monitor != NULL)
-		{
-			g_signal_connect (G_OBJECT (group->monitor),
-					  "changed",
-					  G_CALLBACK (on_group_monitor_changed),
-					  group);
-		}
+		scanner = amp_group_node_parse_makefile (group, makefile, project);
+		amp_group_node_evaluate_makefile (group, scanner, project);
 	}
 	else
 	{
@@ -465,6 +501,28 @@ amp_group_node_set_makefile (AmpGroupNode *group, GFile *makefile, AmpProject *p
 	return group->tfile;
 }
 
+/* Find and parse the makefile of a group before loading it. The group has to
+ * be in the project tree, but nothing else can use it until it is loaded, so
+ * it can be called in another thread. */
+void
+amp_group_node_prefetch (AmpGroupNode *group, AmpProject *project)
+{
+	GFile *makefile;
+
+	makefile = project_find_makefile (project, group);
+	if (makefile != NULL)
+	{
+		if (group->makefile != NULL) g_object_unref (group->makefile);
+		if (group->tfile != NULL) anjuta_token_file_free (group->tfile);
+
+		/* Parse makefile.am */
+		DEBUG_PRINT ("Parse: %s", g_file_get_uri (makefile));
+		group->scanner = amp_group_node_parse_makefile (group, makefile, project);
+		g_object_unref (makefile);
+	}
+	group->prefetched = TRUE;
+}
+
 AnjutaToken*
 amp_group_node_get_makefile_token (AmpGroupNode *group)
 {
@@ -765,6 +823,8 @@ amp_group_node_init (AmpGroupNode *node)
 	node->monitor = NULL;
 	memset (node->tokens, 0, sizeof (node->tokens));
 	node->preset_token = NULL;
+	node->scanner = NULL;
+	node->prefetched = FALSE;
 }
 
 static void
@@ -778,6 +838,9 @@ amp_group_node_dispose (GObject *object)
 	if (node->preset_token) anjuta_token_free (node->preset_token);
 	node->preset_token = NULL;
 
+	if (node->scanner) amp_am_scanner_free (node->scanner);
+	node->scanner = NULL;
+
 	G_OBJECT_CLASS (amp_group_node_parent_class)->dispose (object);
 }
 
@@ -53,6 +53,8 @@ struct _AmpGroupNode {
 	AnjutaToken *preset_token;
 	GHashTable *variables;
 	GFileMonitor *monitor;							/* File monitor */
+	struct _AmpAmScanner *scanner;					/* Makefile parsed but not evaluated */
+	gboolean prefetched;							/* TRUE if the makefile is already parsed */
 };
 
 struct _AmpGroupNodeClass {
@@ -82,6 +84,7 @@ GList * amp_group_node_get_all_token (AmpGroupNode *group);
 AnjutaToken* amp_group_node_get_first_token (AmpGroupNode *group, AmpGroupNodeTokenCategory category);
 void amp_group_node_set_dist_only (AmpGroupNode *group, gboolean dist_only);
 AnjutaTokenFile* amp_group_node_set_makefile (AmpGroupNode *group, GFile *makefile, AmpProject *project);
+void amp_group_node_prefetch (AmpGroupNode *group, AmpProject *project);
 AnjutaToken* amp_group_node_get_makefile_token (AmpGroupNode *group);
 AnjutaTokenFile *amp_group_node_get_make_token_file (AmpGroupNode *group);
 gchar *amp_group_node_get_makefile_name (AmpGroupNode *group);
@@ -0,0 +1,197 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * amp-load-bench.c
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Loads and destroys autotools projects several times and reports the time
+ * spent and the memory used, by example with the test projects:
+ *
+ *   cd tests && sh gnucash.shar && sh nemiver.shar
+ *   ../amp-load-bench -n 10 gnucash nemiver
+ */
+
+#include "config.h"
+
+#include "am-project.h"
+#include "libanjuta/interfaces/ianjuta-project.h"
+
+#include <gio/gio.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static gint repeat = 5;
+
+static GOptionEntry entries[] =
+{
+  { "repeat", 'n', 0, G_OPTION_ARG_INT, &repeat, "Number of loads of each project (default 5)", "count" },
+  { NULL }
+};
+
+/* Dummy type module
+ *---------------------------------------------------------------------------*/
+
+typedef struct
+{
+	GTypeModuleClass parent;
+} DummyTypeModuleClass;
+
+typedef struct
+{
+	GTypeModule parent;
+} DummyTypeModule;
+
+static GType dummy_type_module_get_type (void);
+
+G_DEFINE_TYPE (DummyTypeModule, dummy_type_module, G_TYPE_TYPE_MODULE)
+
+static gboolean
+dummy_type_module_load (GTypeModule *gmodule)
+{
+	return TRUE;
+}
+
+static void
+dummy_type_module_unload (GTypeModule *gmodule)
+{
+}
+
+static void
+dummy_type_module_class_init (DummyTypeModuleClass *klass)
+{
+	GTypeModuleClass *gmodule_class = (GTypeModuleClass *)klass;
+
+	gmodule_class->load = dummy_type_module_load;
+	gmodule_class->unload = dummy_type_module_unload;
+}
+
+static void
+dummy_type_module_init (DummyTypeModule *module)
+{
+}
+
+/* Helper functions
+ *---------------------------------------------------------------------------*/
+
+/* Return a memory size of the process in kB, 0 if it is not available */
+static gulong
+get_memory (const gchar *name)
+{
+	gchar *status;
+	gchar *line;
+	gulong size = 0;
+
+	if (!g_file_get_contents ("/proc/self/status", &status, NULL, NULL)) return 0;
+
+	line = strstr (status, name);
+	if (line != NULL) size = strtoul (line + strlen (name) + 1, NULL, 10);
+	g_free (status);
+
+	return size;
+}
+
+static void
+wait_ready (IAnjutaProject *project)
+{
+	while (!ianjuta_project_is_loaded (project, NULL) || amp_project_is_busy (AMP_PROJECT (project)))
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+}
+
+static gboolean
+bench_project (const gchar *path)
+{
+	GFile *file;
+	GTimer *timer;
+	gdouble load = 0.0;
+	gdouble unload = 0.0;
+	gulong loaded = 0;
+	gulong unloaded = 0;
+	gint i;
+
+	file = g_file_new_for_commandline_arg (path);
+	if (amp_project_probe (file, NULL) == 0)
+	{
+		fprintf (stderr, "No autotools project in %s\n", path);
+		g_object_unref (file);
+		return FALSE;
+	}
+
+	timer = g_timer_new ();
+	for (i = 0; i < repeat; i++)
+	{
+		IAnjutaProject *project;
+		AnjutaProjectNode *root;
+
+		g_timer_start (timer);
+		project = IANJUTA_PROJECT (amp_project_new (file, NULL, NULL));
+		root = ianjuta_project_get_root (project, NULL);
+		ianjuta_project_load_node (project, root, NULL);
+		wait_ready (project);
+		load += g_timer_elapsed (timer, NULL);
+		loaded = MAX (loaded, get_memory ("VmRSS:"));
+
+		g_timer_start (timer);
+		g_object_unref (project);
+		unload += g_timer_elapsed (timer, NULL);
+		unloaded = get_memory ("VmRSS:");
+	}
+
+	printf ("%s: load %.1f ms, unload %.1f ms, %lu kB loaded, %lu kB after unload\n",
+	        path, load * 1000.0 / repeat, unload * 1000.0 / repeat, loaded, unloaded);
+
+	g_timer_destroy (timer);
+	g_object_unref (file);
+
+	return TRUE;
+}
+
+/* Main function
+ *---------------------------------------------------------------------------*/
+
+int
+main (int argc, char *argv[])
+{
+	GOptionContext *context;
+	GTypeModule *module;
+	gint i;
+
+	g_type_init ();
+
+	context = g_option_context_new ("directory...");
+	g_option_context_add_main_entries (context, entries, NULL);
+	g_option_context_set_summary (context, "Measure the load of autotools projects");
+	if (!g_option_context_parse (context, &argc, &argv, NULL) || (argc < 2))
+	{
+		printf ("%s", g_option_context_get_help (context, TRUE, NULL));
+		return 1;
+	}
+	g_option_context_free (context);
+	repeat = MAX (repeat, 1);
+
+	module = g_object_new (dummy_type_module_get_type (), NULL);
+	amp_project_register (module);
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!bench_project (argv[i])) return 1;
+	}
+	printf ("peak %lu kB\n", get_memory ("VmHWM:"));
+
+	return 0;
+}
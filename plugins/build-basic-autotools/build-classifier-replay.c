@@ -0,0 +1,184 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+    build-classifier-replay.c
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/* Replays captured build logs, e.g. the output of a make -j of a large
+ * project, through the build output classifier and reports its speed:
+ *
+ *   build-classifier-replay [-f automake-c.filters] [-n repeat] make.log...
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "build-classifier.h"
+
+#define DEFAULT_FILTERS PACKAGE_DATA_DIR "/build/automake-c.filters"
+
+typedef struct
+{
+	guint64 bytes;
+	guint64 lines;
+	guint64 directories;
+	guint64 locations;
+	guint64 warnings;
+	guint64 errors;
+	guint64 summaries;
+} ReplayStats;
+
+static void
+replay_line (BuildClassifier *classifier, const gchar *line,
+			 ReplayStats *stats)
+{
+	BuildLine build_line;
+
+	build_classifier_classify (classifier, line, &build_line);
+
+	if (build_line.kind != BUILD_LINE_OUTPUT)
+		stats->directories++;
+	if (build_line.severity != BUILD_LINE_NO_LOCATION)
+	{
+		gchar *summary;
+
+		stats->locations++;
+		if (build_line.severity == BUILD_LINE_WARNING)
+			stats->warnings++;
+		else if (build_line.severity == BUILD_LINE_ERROR)
+			stats->errors++;
+
+		/* The build plugin summarizes these messages after rewriting
+		 * their file name */
+		summary = build_classifier_get_summary (classifier, build_line.text,
+												build_line.length);
+		if (summary != NULL)
+			stats->summaries++;
+		g_free (summary);
+	}
+	else if (build_line.summary != NULL)
+	{
+		stats->summaries++;
+	}
+	build_line_clear (&build_line);
+}
+
+static gboolean
+replay_file (BuildClassifier *classifier, const gchar *filename,
+			 ReplayStats *stats)
+{
+	GMappedFile *file;
+	GError *error = NULL;
+	GString *line;
+	const gchar *pos;
+	const gchar *end;
+
+	file = g_mapped_file_new (filename, FALSE, &error);
+	if (file == NULL)
+	{
+		fprintf (stderr, "Unable to read %s: %s\n", filename, error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	/* The message view passes each line as a string */
+	line = g_string_sized_new (1024);
+	pos = g_mapped_file_get_contents (file);
+	end = pos + g_mapped_file_get_length (file);
+	while (pos < end)
+	{
+		const gchar *next = memchr (pos, '\n', end - pos);
+
+		if (next == NULL)
+			next = end;
+		g_string_truncate (line, 0);
+		g_string_append_len (line, pos, next - pos);
+		replay_line (classifier, line->str, stats);
+		stats->lines++;
+		pos = next + 1;
+	}
+	stats->bytes += g_mapped_file_get_length (file);
+
+	g_string_free (line, TRUE);
+	g_mapped_file_unref (file);
+
+	return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+	BuildClassifier *classifier;
+	const gchar *filters = DEFAULT_FILTERS;
+	ReplayStats stats;
+	GTimer *timer;
+	gdouble elapsed;
+	gint repeat = 1;
+	gint i;
+	gint r;
+
+	for (i = 1; i < argc - 1 && argv[i][0] == '-'; i += 2)
+	{
+		if (strcmp (argv[i], "-f") == 0)
+			filters = argv[i + 1];
+		else if (strcmp (argv[i], "-n") == 0)
+			repeat = MAX (atoi (argv[i + 1]), 1);
+		else
+			break;
+	}
+	if (i >= argc)
+	{
+		fprintf (stderr, "Usage: %s [-f filters] [-n repeat] log...\n", argv[0]);
+		return 1;
+	}
+
+	classifier = build_classifier_new (filters);
+
+	memset (&stats, 0, sizeof (stats));
+	timer = g_timer_new ();
+	for (r = 0; r < repeat; r++)
+	{
+		gint j;
+
+		for (j = i; j < argc; j++)
+		{
+			if (!replay_file (classifier, argv[j], &stats))
+				return 1;
+		}
+	}
+	elapsed = g_timer_elapsed (timer, NULL);
+
+	printf ("%" G_GUINT64_FORMAT " lines, %" G_GUINT64_FORMAT " bytes in %.2f s\n",
+			stats.lines, stats.bytes, elapsed);
+	printf ("%.0f lines/s, %.1f MB/s\n",
+			elapsed > 0 ? stats.lines / elapsed : 0.0,
+			elapsed > 0 ? stats.bytes / elapsed / (1024 * 1024) : 0.0);
+	printf ("%" G_GUINT64_FORMAT " directories, %" G_GUINT64_FORMAT " locations "
+			"(%" G_GUINT64_FORMAT " warnings, %" G_GUINT64_FORMAT " errors), "
+			"%" G_GUINT64_FORMAT " summaries\n",
+			stats.directories, stats.locations, stats.warnings, stats.errors,
+			stats.summaries);
+
+	g_timer_destroy (timer);
+	build_classifier_free (classifier);
+
+	return 0;
+}
@@ -0,0 +1,663 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+    build-classifier.c
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <config.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib/gi18n.h>
+#include <libanjuta/anjuta-debug.h>
+
+#include "build-classifier.h"
+
+/*
+ * The make directory patterns and the filters are tried in order on each
+ * line, the first one matching gives the kind of the line and its summary.
+ * Most lines match none of them, so each pattern keeps the longest literal
+ * that any match has to contain and its regular expression is run only if
+ * the line contains it.
+ */
+
+/* The location of a message is looked for in the first bytes only */
+#define LOCATION_SCAN_MAX 512
+
+typedef enum
+{
+	PATTERN_FILTER,
+	PATTERN_ENTERING,
+	PATTERN_LEAVING
+} PatternKind;
+
+typedef struct
+{
+	PatternKind kind;
+	GRegex *regex;
+	gchar *replace;
+
+	/* Literal required in the matching lines, at their start if anchored */
+	gchar *literal;
+	gsize literal_length;
+	gboolean literal_anchored;
+} BuildPattern;
+
+struct _BuildClassifier
+{
+	GPtrArray *patterns;
+
+	/* Translated gcc keywords different from the untranslated ones */
+	GPtrArray *warnings;
+	GPtrArray *errors;
+};
+
+/* The translations should match that of 'make' program. Both strings uses
+ * pearl regular expression
+ * 2 similar strings are used in order to parse the output of 2 different
+ * version of make if necessary. If you update one string, move the first
+ * string into the second slot and then replace the first string only. */
+static const gchar *patterns_make_entering[] = {N_("make(\\[\\d+\\])?:\\s+Entering\\s+directory\\s+`(.+)'"),
+												N_("make(\\[\\d+\\])?:\\s+Entering\\s+directory\\s+'(.+)'"),
+												NULL};
+
+/* The translations should match that of 'make' program. Both strings uses
+ * pearl regular expression
+ * 2 similar strings are used in order to parse the output of 2 different
+ * version of make if necessary. If you update one string, move the first
+ * string into the second slot and then replace the first string only. */
+static const gchar *patterns_make_leaving[] = {N_("make(\\[\\d+\\])?:\\s+Leaving\\s+directory\\s+`(.+)'"),
+											   N_("make(\\[\\d+\\])?:\\s+Leaving\\s+directory\\s+'(.+)'"),
+											   NULL};
+
+/* Group of the directory in the make patterns */
+#define MAKE_DIRECTORY_GROUP 2
+
+static void
+build_pattern_free (BuildPattern *pattern)
+{
+	g_regex_unref (pattern->regex);
+	g_free (pattern->replace);
+	g_free (pattern->literal);
+	g_slice_free (BuildPattern, pattern);
+}
+
+static const gchar *
+skip_class (const gchar *c)
+{
+	c++;
+	if (*c == '^')
+		c++;
+	if (*c == ']')
+		c++;
+	for (; *c != ']'; c++)
+	{
+		if (*c == '\0')
+			return c;
+		if (*c == '\\' && c[1] != '\0')
+			c++;
+	}
+
+	return c + 1;
+}
+
+static const gchar *
+skip_group (const gchar *c)
+{
+	gint depth = 0;
+
+	while (*c != '\0')
+	{
+		if (*c == '\\')
+		{
+			if (c[1] == '\0')
+				return c + 1;
+			c += 2;
+			continue;
+		}
+		if (*c == '[')
+		{
+			c = skip_class (c);
+			continue;
+		}
+		if (*c == '(')
+			depth++;
+		else if (*c == ')' && --depth == 0)
+			return c + 1;
+		c++;
+	}
+
+	return c;
+}
+
+/* Find the longest literal in the sequence at the top level of the
+ * pattern. Groups, classes and quantified characters are skipped, patterns
+ * with alternatives at their top level or inline options have none. */
+static void
+build_pattern_set_literal (BuildPattern *pattern, const gchar *source)
+{
+	GString *run;
+	const gchar *run_start = NULL;
+	const gchar *c;
+	gboolean last_literal = FALSE;
+
+	for (c = strstr (source, "(?"); c != NULL; c = strstr (c + 2, "(?"))
+	{
+		if (g_ascii_isalpha (c[2]) || c[2] == '-' || c[2] == '^')
+			return;
+	}
+
+	run = g_string_new (NULL);
+	for (c = source;;)
+	{
+		gboolean end_run = TRUE;
+
+		if (*c == '|')
+		{
+			g_free (pattern->literal);
+			pattern->literal = NULL;
+			pattern->literal_length = 0;
+			break;
+		}
+		else if (*c == '(')
+		{
+			c = skip_group (c);
+		}
+		else if (*c == '[')
+		{
+			c = skip_class (c);
+		}
+		else if (*c == '*' || *c == '?' || *c == '+' || *c == '{')
+		{
+			/* The last character can be missing or repeated */
+			if (last_literal)
+				g_string_truncate (run, run->len - 1);
+			if (*c == '{')
+			{
+				while (*c != '}' && *c != '\0')
+					c++;
+			}
+			if (*c != '\0')
+				c++;
+		}
+		else if (*c == '.' || *c == '^' || *c == '$')
+		{
+			c++;
+		}
+		else if (*c == '\\' && (c[1] == '\0' || g_ascii_isalnum (c[1])))
+		{
+			/* Skip character types and assertions, stop at the other
+			 * escapes as they can be longer than one character */
+			if (c[1] != '\0' && strchr ("dDsSwWbBAzZGhHvVR", c[1]) != NULL)
+				c += 2;
+			else
+				c = "";
+		}
+		else if (*c != '\0')
+		{
+			if (run->len == 0)
+				run_start = c;
+			if (*c == '\\')
+				c++;
+			g_string_append_c (run, *c);
+			c++;
+			end_run = FALSE;
+		}
+
+		last_literal = !end_run;
+		if (end_run && run->len > 0)
+		{
+			if (run->len > pattern->literal_length)
+			{
+				g_free (pattern->literal);
+				pattern->literal_length = run->len;
+				pattern->literal = g_strndup (run->str, run->len);
+				pattern->literal_anchored = run_start == source + 1 &&
+					*source == '^';
+			}
+			g_string_truncate (run, 0);
+		}
+		if (*c == '\0')
+			break;
+	}
+	g_string_free (run, TRUE);
+}
+
+static void
+build_classifier_add_pattern (BuildClassifier *classifier, PatternKind kind,
+                              const gchar *source, const gchar *replace,
+                              GRegexCompileFlags options)
+{
+	BuildPattern *pattern;
+	GRegex *regex;
+	GError *error = NULL;
+
+	regex = g_regex_new (source, options, 0, &error);
+	if (error != NULL)
+	{
+		DEBUG_PRINT ("GRegex compilation failed: pattern \"%s\": error %s",
+		             source, error->message);
+		g_error_free (error);
+		return;
+	}
+
+	pattern = g_slice_new0 (BuildPattern);
+	pattern->kind = kind;
+	pattern->regex = regex;
+	pattern->replace = g_strdup (replace);
+
+	/* Options can change the meaning of the characters */
+	if ((options & ~G_REGEX_OPTIMIZE) == 0)
+		build_pattern_set_literal (pattern, source);
+
+	g_ptr_array_add (classifier->patterns, pattern);
+}
+
+static void
+build_classifier_add_make_patterns (BuildClassifier *classifier,
+                                    PatternKind kind, const gchar **patterns)
+{
+	for (; *patterns != NULL; patterns++)
+	{
+		/* Untranslated string */
+		build_classifier_add_pattern (classifier, kind, *patterns, NULL, 0);
+
+		/* Translated string */
+		if (strcmp (_(*patterns), *patterns) != 0)
+		{
+			build_classifier_add_pattern (classifier, kind, _(*patterns),
+			                              NULL, 0);
+		}
+	}
+}
+
+static void
+build_classifier_load_filters (BuildClassifier *classifier,
+                               const gchar *filters)
+{
+	FILE *fp;
+
+	fp = fopen (filters, "r");
+	if (fp == NULL)
+	{
+		DEBUG_PRINT ("Failed to load filters: %s", filters);
+		return;
+	}
+	while (!feof (fp) && !ferror (fp))
+	{
+		char buffer[1024];
+		gchar **tokens;
+
+		if (!fgets (buffer, 1024, fp))
+			break;
+		tokens = g_strsplit (buffer, "|||", 3);
+
+		if (!tokens[0] || !tokens[1])
+		{
+			DEBUG_PRINT ("Cannot parse regex: %s", buffer);
+			g_strfreev (tokens);
+			continue;
+		}
+		build_classifier_add_pattern (classifier, PATTERN_FILTER,
+		                              tokens[0], tokens[1],
+		                              tokens[2] ? atoi (tokens[2]) : 0);
+		g_strfreev (tokens);
+	}
+	fclose (fp);
+}
+
+static void
+add_keyword (GPtrArray *keywords, const gchar *untranslated,
+             const gchar *translated)
+{
+	if (strcmp (translated, untranslated) != 0)
+		g_ptr_array_add (keywords, (gpointer) translated);
+}
+
+/**
+ * build_classifier_new:
+ * @filters: Path of the file containing the output filters.
+ *
+ * Returns: A classifier for the lines of the output of make
+ */
+BuildClassifier *
+build_classifier_new (const gchar *filters)
+{
+	BuildClassifier *classifier;
+
+	classifier = g_slice_new0 (BuildClassifier);
+	classifier->patterns = g_ptr_array_new_with_free_func ((GDestroyNotify) build_pattern_free);
+
+	build_classifier_add_make_patterns (classifier, PATTERN_ENTERING,
+	                                    patterns_make_entering);
+	build_classifier_add_make_patterns (classifier, PATTERN_LEAVING,
+	                                    patterns_make_leaving);
+	if (filters != NULL)
+		build_classifier_load_filters (classifier, filters);
+
+	/* The translations should match that of 'gcc' program.
+	 * The second string with -old should be used for an older
+	 * version of 'gcc' if necessary. If you update one string,
+	 * move the first one to translate the -old string and then
+	 * replace the first string only. */
+	classifier->warnings = g_ptr_array_new ();
+	add_keyword (classifier->warnings, "warning:", _("warning:"));
+	add_keyword (classifier->warnings, "warning:-old", _("warning:-old"));
+	classifier->errors = g_ptr_array_new ();
+	add_keyword (classifier->errors, "error:", _("error:"));
+	add_keyword (classifier->errors, "error:-old", _("error:-old"));
+
+	return classifier;
+}
+
+void
+build_classifier_free (BuildClassifier *classifier)
+{
+	g_ptr_array_free (classifier->patterns, TRUE);
+	g_ptr_array_free (classifier->warnings, TRUE);
+	g_ptr_array_free (classifier->errors, TRUE);
+	g_slice_free (BuildClassifier, classifier);
+}
+
+static gboolean
+contains (const gchar *text, gsize length, const gchar *literal,
+          gsize literal_length)
+{
+	const gchar *c;
+	const gchar *last;
+
+	if (literal_length > length)
+		return FALSE;
+
+	last = text + length - literal_length;
+	for (c = text; c <= last; c++)
+	{
+		c = memchr (c, *literal, last - c + 1);
+		if (c == NULL)
+			return FALSE;
+		if (memcmp (c + 1, literal + 1, literal_length - 1) == 0)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Find the first pattern matching the text */
+static const BuildPattern *
+build_classifier_match (BuildClassifier *classifier, const gchar *text,
+                        gsize length, GMatchInfo **match_info)
+{
+	guint i;
+
+	for (i = 0; i < classifier->patterns->len; i++)
+	{
+		BuildPattern *pattern = g_ptr_array_index (classifier->patterns, i);
+
+		if (pattern->literal != NULL)
+		{
+			if (pattern->literal_anchored ?
+			    length < pattern->literal_length ||
+			    memcmp (text, pattern->literal, pattern->literal_length) != 0 :
+			    !contains (text, length, pattern->literal,
+			               pattern->literal_length))
+			{
+				continue;
+			}
+		}
+
+		if (g_regex_match_full (pattern->regex, text, length, 0, 0,
+		                        match_info, NULL))
+		{
+			return pattern;
+		}
+		g_match_info_free (*match_info);
+	}
+	*match_info = NULL;
+
+	return NULL;
+}
+
+static gchar *
+build_classifier_expand (const BuildPattern *pattern, const gchar *text,
+                         GMatchInfo *match_info)
+{
+	const gchar *iter;
+	GString *ret;
+
+	ret = g_string_new (NULL);
+	for (iter = pattern->replace; *iter != '\0';)
+	{
+		if (*iter == '\\' && isdigit (*(iter + 1)))
+		{
+			gint start_pos, end_pos;
+
+			if (g_match_info_fetch_pos (match_info, *(iter + 1) - '0',
+			                            &start_pos, &end_pos) &&
+			    start_pos >= 0)
+			{
+				g_string_append_len (ret, text + start_pos,
+				                     end_pos - start_pos);
+			}
+			iter += 2;
+		}
+		else
+		{
+			const gchar *start = iter;
+
+			iter = g_utf8_next_char (iter);
+			g_string_append_len (ret, start, iter - start);
+		}
+	}
+
+	if (ret->len == 0)
+	{
+		g_string_free (ret, TRUE);
+		return NULL;
+	}
+
+	return g_string_free (ret, FALSE);
+}
+
+/**
+ * build_classifier_get_summary:
+ * @classifier: a #BuildClassifier
+ * @text: a message
+ * @length: the length of @text or -1 if it is nul terminated
+ *
+ * Returns: The summary of the message given by the first matching filter or
+ * NULL if none matches.
+ */
+gchar *
+build_classifier_get_summary (BuildClassifier *classifier, const gchar *text,
+                              gssize length)
+{
+	const BuildPattern *pattern;
+	GMatchInfo *match_info;
+	gchar *summary = NULL;
+
+	if (length < 0)
+		length = strlen (text);
+
+	pattern = build_classifier_match (classifier, text, length, &match_info);
+	if (pattern == NULL)
+		return NULL;
+
+	if (pattern->kind == PATTERN_FILTER)
+		summary = build_classifier_expand (pattern, text, match_info);
+	g_match_info_free (match_info);
+
+	return summary;
+}
+
+/* Find the part of the line before a line number, first at the start of
+ * the line then in its last word, like "file.c:12: error" or
+ * "In file included from file.c:12" */
+static gboolean
+parse_location (const gchar *line, gsize length, gsize *file_start,
+                gsize *file_length, gint *lineno)
+{
+	gsize first;
+	gsize i;
+	gsize j;
+
+	for (first = 0;; first = i + 1)
+	{
+		/* Look for the colon */
+		for (i = first; line[i] != ':'; i++)
+		{
+			if (i + 1 >= length || i + 1 >= LOCATION_SCAN_MAX || line[i] == ' ')
+				break;
+		}
+		if (i < length && line[i] == ':' && i + 1 < length &&
+		    isdigit (line[i + 1]))
+		{
+			break;
+		}
+
+		/* Then try after the last space */
+		if (first != 0)
+			return FALSE;
+		for (i = length; i > 0 && !isspace (line[i - 1]); i--);
+		if (i == 0)
+			return FALSE;
+		i--;
+	}
+
+	/* Skip leading and trailing spaces */
+	for (j = i; j > first && isspace (line[j - 1]); j--);
+	for (; first < j && isspace (line[first]); first++);
+
+	*file_start = first;
+	*file_length = j - first;
+	for (*lineno = 0, i++; i < length && isdigit (line[i]); i++)
+		*lineno = *lineno * 10 + line[i] - '0';
+
+	return TRUE;
+}
+
+static gboolean
+has_keyword (const gchar *text, gsize length, const gchar *keyword,
+             gsize keyword_length, GPtrArray *translations)
+{
+	const gchar *colon;
+	const gchar *end = text + length;
+	guint i;
+
+	/* The untranslated keywords end with a colon */
+	for (colon = text + keyword_length - 1;
+	     colon < end && (colon = memchr (colon, ':', end - colon)) != NULL;
+	     colon++)
+	{
+		if (memcmp (colon - keyword_length + 1, keyword, keyword_length - 1) == 0)
+			return TRUE;
+	}
+
+	for (i = 0; i < translations->len; i++)
+	{
+		if (g_strstr_len (text, length, g_ptr_array_index (translations, i)) != NULL)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/**
+ * build_classifier_classify:
+ * @classifier: a #BuildClassifier
+ * @line: a line of make output
+ * @result: the classification of the line, to clear with build_line_clear()
+ *
+ * Classifies the line in a single pass over the patterns. The summary
+ * is not computed for messages having a location because their file name
+ * is usually rewritten, use build_classifier_get_summary() then.
+ */
+void
+build_classifier_classify (BuildClassifier *classifier, const gchar *line,
+                           BuildLine *result)
+{
+	const BuildPattern *pattern;
+	GMatchInfo *match_info;
+
+	memset (result, 0, sizeof (BuildLine));
+
+	/* Remove leading whitespace */
+	while (g_ascii_isspace (*line))
+		line++;
+	result->text = line;
+	result->length = strlen (line);
+	if (g_str_has_prefix (line, "if "))
+	{
+		const gchar *end;
+
+		result->text += 3;
+		result->length -= 3;
+
+		/* Find the first occurence of ';' (ignoring nesting in quotations) */
+		end = memchr (result->text, ';', result->length);
+		if (end)
+			result->length = end - result->text;
+	}
+
+	if (parse_location (result->text, result->length, &result->file_start,
+	                    &result->file_length, &result->lineno))
+	{
+		if (has_keyword (result->text, result->length,
+		                 "warning:", strlen ("warning:"), classifier->warnings))
+			result->severity = BUILD_LINE_WARNING;
+		else if (has_keyword (result->text, result->length,
+		                      "error:", strlen ("error:"), classifier->errors))
+			result->severity = BUILD_LINE_ERROR;
+		else
+			result->severity = BUILD_LINE_NOTE;
+	}
+
+	pattern = build_classifier_match (classifier, result->text,
+	                                  result->length, &match_info);
+	if (pattern == NULL)
+		return;
+
+	switch (pattern->kind)
+	{
+	case PATTERN_ENTERING:
+	case PATTERN_LEAVING:
+		result->kind = pattern->kind == PATTERN_ENTERING ?
+			BUILD_LINE_ENTERING : BUILD_LINE_LEAVING;
+		result->directory = g_match_info_fetch (match_info,
+		                                        MAKE_DIRECTORY_GROUP);
+		break;
+	case PATTERN_FILTER:
+		if (result->severity == BUILD_LINE_NO_LOCATION)
+		{
+			result->summary = build_classifier_expand (pattern,
+			                                           result->text,
+			                                           match_info);
+		}
+		break;
+	}
+	g_match_info_free (match_info);
+}
+
+void
+build_line_clear (BuildLine *line)
+{
+	g_free (line->directory);
+	g_free (line->summary);
+	line->directory = NULL;
+	line->summary = NULL;
+}
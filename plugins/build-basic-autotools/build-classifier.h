@@ -0,0 +1,75 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+    build-classifier.h
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __BUILD_CLASSIFIER_H__
+#define __BUILD_CLASSIFIER_H__
+
+#include <glib.h>
+
+typedef struct _BuildClassifier BuildClassifier;
+
+typedef enum
+{
+	BUILD_LINE_OUTPUT,
+	BUILD_LINE_ENTERING,
+	BUILD_LINE_LEAVING
+} BuildLineKind;
+
+typedef enum
+{
+	BUILD_LINE_NO_LOCATION,
+	BUILD_LINE_NOTE,
+	BUILD_LINE_WARNING,
+	BUILD_LINE_ERROR
+} BuildLineSeverity;
+
+typedef struct
+{
+	BuildLineKind kind;
+	BuildLineSeverity severity;
+
+	/* Message without leading spaces nor shell if, not nul terminated */
+	const gchar *text;
+	gsize length;
+
+	/* Location of the message in text, if any */
+	gsize file_start;
+	gsize file_length;
+	gint lineno;
+
+	/* Directory entered or left by make */
+	gchar *directory;
+
+	/* Summary given by the filters, only for messages without location */
+	gchar *summary;
+} BuildLine;
+
+BuildClassifier *build_classifier_new (const gchar *filters);
+void build_classifier_free (BuildClassifier *classifier);
+
+void build_classifier_classify (BuildClassifier *classifier,
+                                const gchar *line,
+                                BuildLine *result);
+gchar *build_classifier_get_summary (BuildClassifier *classifier,
+                                     const gchar *text,
+                                     gssize length);
+
+void build_line_clear (BuildLine *line);
+
+#endif /* __BUILD_CLASSIFIER_H__ */
@@ -49,6 +49,7 @@
 #include "executer.h"
 #include "program.h"
 #include "build.h"
+#include "build-classifier.h"
 
 #include <sys/wait.h>
 #if defined(__FreeBSD__)
@@ -77,21 +78,6 @@
 
 static gpointer parent_class;
 
-typedef struct
-{
-	gchar *pattern;
-	int options;
-	gchar *replace;
-	GRegex *regex;
-} BuildPattern;
-
-typedef struct
-{
-	gchar *pattern;
-	GRegex *regex;
-	GRegex *local_regex;
-} MessagePattern;
-
 typedef struct
 {
 	GFile *file;
@@ -113,6 +99,9 @@ struct _BuildContext
 	IAnjutaMessageView *message_view;
 	GHashTable *build_dir_stack;
 
+	/* Full path of the files named in the messages */
+	GHashTable *resolved_paths;
+
 	/* Indicator locations */
 	GSList *locations;
 
@@ -129,25 +118,7 @@ struct _BuildContext
 /* Declarations */
 static void update_project_ui (BasicAutotoolsPlugin *bb_plugin);
 
-static GList *patterns_list = NULL;
-
-/* The translations should match that of 'make' program. Both strings uses
- * pearl regular expression
- * 2 similar strings are used in order to parse the output of 2 different
- * version of make if necessary. If you update one string, move the first
- * string into the second slot and then replace the first string only. */
-static MessagePattern patterns_make_entering[] = {{N_("make(\\[\\d+\\])?:\\s+Entering\\s+directory\\s+`(.+)'"), NULL, NULL},
-												{N_("make(\\[\\d+\\])?:\\s+Entering\\s+directory\\s+'(.+)'"), NULL, NULL},
-												{NULL, NULL, NULL}};
-
-/* The translations should match that of 'make' program. Both strings uses
- * pearl regular expression
- * 2 similar strings are used in order to parse the output of 2 different
- * version of make if necessary. If you update one string, move the first
- * string into the second slot and then replace the first string only. */
-static MessagePattern patterns_make_leaving[] = {{N_("make(\\[\\d+\\])?:\\s+Leaving\\s+directory\\s+`(.+)'"), NULL, NULL},
-												{N_("make(\\[\\d+\\])?:\\s+Leaving\\s+directory\\s+'(.+)'"), NULL, NULL},
-												{NULL, NULL, NULL}};
+static BuildClassifier *classifier = NULL;
 
 /* Helper functions
  *---------------------------------------------------------------------------*/
@@ -395,6 +366,11 @@ build_context_destroy_view (BuildContext *context)
 		g_hash_table_destroy (context->build_dir_stack);
 		context->build_dir_stack = NULL;
 	}
+	if (context->resolved_paths)
+	{
+		g_hash_table_destroy (context->resolved_paths);
+		context->resolved_paths = NULL;
+	}
 	if (context->indicators_updated_editors)
 	{
 		g_hash_table_destroy (context->indicators_updated_editors);
@@ -443,6 +419,10 @@ build_context_reset (BuildContext *context)
 		g_hash_table_destroy (context->build_dir_stack);
 	context->build_dir_stack = NULL;
 
+	if (context->resolved_paths)
+		g_hash_table_destroy (context->resolved_paths);
+	context->resolved_paths = NULL;
+
 	g_slist_foreach (context->locations,
 					 (GFunc) build_indicator_location_free, NULL);
 	g_slist_free (context->locations);
@@ -450,174 +430,74 @@ build_context_reset (BuildContext *context)
 }
 
 static void
-build_regex_load (void)
+build_regex_init (void)
 {
-	FILE *fp;
-
-	if (patterns_list)
-		return;
-
-	fp = fopen (PACKAGE_DATA_DIR "/build/automake-c.filters", "r");
-	if (fp == NULL)
-	{
-		DEBUG_PRINT ("Failed to load filters: %s",
-				   PACKAGE_DATA_DIR "/build/automake-c.filters");
+	if (classifier != NULL)
 		return;
-	}
-	while (!feof (fp) && !ferror (fp))
-	{
-		char buffer[1024];
-		gchar **tokens;
-		BuildPattern *pattern;
-
-		if (!fgets (buffer, 1024, fp))
-			break;
-		tokens = g_strsplit (buffer, "|||", 3);
 
-		if (!tokens[0] || !tokens[1])
-		{
-			DEBUG_PRINT ("Cannot parse regex: %s", buffer);
-			g_strfreev (tokens);
-			continue;
-		}
-		pattern = g_new0 (BuildPattern, 1);
-		pattern->pattern = g_strdup (tokens[0]);
-		pattern->replace = g_strdup (tokens[1]);
-		if (tokens[2])
-			pattern->options = atoi (tokens[2]);
-		g_strfreev (tokens);
-
-		patterns_list = g_list_prepend (patterns_list, pattern);
-	}
-	fclose (fp);
-	patterns_list = g_list_reverse (patterns_list);
+	classifier = build_classifier_new (PACKAGE_DATA_DIR "/build/automake-c.filters");
 }
 
-static void
-build_regex_init_message (MessagePattern *patterns)
+/* Returns the full path of a file named in a message. A relative file is
+ * looked for in the current make directory and if it does not exist in the
+ * corresponding source directory, the result is cached for the following
+ * messages about the same file. */
+static gchar *
+build_context_resolve_path (BuildContext *context, const gchar *filename)
 {
-	g_return_if_fail (patterns != NULL);
+	BasicAutotoolsPlugin *p = ANJUTA_PLUGIN_BASIC_AUTOTOOLS (context->plugin);
+	gchar *build_path;
+	gchar *path;
 
-	if (patterns->regex != NULL)
-		return;		/* Already done */
+	if (g_path_is_absolute (filename))
+		return g_strdup (filename);
 
-	for (;patterns->pattern != NULL; patterns++)
+	build_path = g_build_filename (build_context_get_dir (context, "default"),
+								   filename, NULL);
+	if (context->resolved_paths == NULL)
 	{
-		/* Untranslated string */
-		patterns->regex = g_regex_new(
-			   patterns->pattern,
-			   0,
-			   0,
-			   NULL);
-
-		/* Translated string */
-		patterns->local_regex = g_regex_new(
-			   _(patterns->pattern),
-			   0,
-			   0,
-			   NULL);
+		context->resolved_paths = g_hash_table_new_full (g_str_hash,
+														 g_str_equal,
+														 g_free, g_free);
 	}
-}
-
-static void
-build_regex_init (void)
-{
-	GList *node;
-	GError *error = NULL;
-
-	build_regex_init_message (patterns_make_entering);
-
-	build_regex_init_message (patterns_make_leaving);
-
-	build_regex_load ();
-	if (!patterns_list)
-		return;
-
-	if (((BuildPattern*)(patterns_list->data))->regex)
-		return;
-
-	node = patterns_list;
-	while (node)
-	{
-		BuildPattern *pattern;
-
-		pattern = node->data;
-		pattern->regex =
-			g_regex_new(
-			   pattern->pattern,
-			   pattern->options,
-			   0,
-			   &error);           /* for error message */
-		if (error != NULL) {
-			DEBUG_PRINT ("GRegex compilation failed: pattern \"%s\": error %s",
-						pattern->pattern, error->message);
-			g_error_free (error);
-		}
-		node = g_list_next (node);
+	path = g_hash_table_lookup (context->resolved_paths, build_path);
+	if (path != NULL)
+	{
+		g_free (build_path);
+		return g_strdup (path);
 	}
-}
 
-/* Regex processing */
-static gchar*
-build_get_summary (const gchar *details, BuildPattern* bp)
-{
-	gboolean matched;
-	GMatchInfo *match_info;
-	const gchar *iter;
-	GString *ret;
-	gchar *final = NULL;
-
-	if (!bp || !bp->regex)
-		return NULL;
-
-	matched = g_regex_match(
-			  bp->regex,       /* result of g_regex_new() */
-			  details,         /* the subject string */
-			  0,
-			  &match_info);
+	path = g_strdup (build_path);
 
-	if (matched)
+	/* If the file does not exist, try to replace the build directory by
+	 * the source directory. This is needed by the Vala compiler which
+	 * does not output absolute paths. */
+	if (!g_file_test (path, G_FILE_TEST_IS_REGULAR))
 	{
-		ret = g_string_new ("");
-		iter = bp->replace;
-		while (*iter != '\0')
-		{
-			if (*iter == '\\' && isdigit(*(iter + 1)))
-			{
-				char temp[2] = {0, 0};
-				gint start_pos, end_pos;
-
-				temp[0] = *(iter + 1);
-				int idx = atoi (temp);
+		GFile *file = g_file_new_for_path (path);
 
-				g_match_info_fetch_pos (match_info, idx, &start_pos, &end_pos);
-
-				ret = g_string_append_len (ret, details + start_pos,
-									   end_pos - start_pos);
-				iter += 2;
-			}
-			else
-			{
-				const gchar *start;
-				const gchar *end;
-
-				start = iter;
-				iter = g_utf8_next_char (iter);
-				end = iter;
+		if ((p->project_build_dir != NULL) && g_file_has_prefix (file, p->project_build_dir))
+		{
+			/* Try using the source directory */
+			gchar *relative;
 
-				ret = g_string_append_len (ret, start, end - start);
-			}
-		}
+			relative = g_file_get_relative_path (p->project_build_dir, file);
+			g_object_unref (file);
+			file = g_file_get_child (p->project_root_dir, relative);
+			g_free (relative);
 
-		final = g_string_free (ret, FALSE);
-		if (strlen (final) <= 0) {
-			g_free (final);
-			final = NULL;
+			g_free (path);
+			path = g_file_get_path (file);
 		}
+		g_object_unref (file);
 	}
-	g_match_info_free (match_info);
 
-	return final;
+	if (path != NULL)
+		g_hash_table_insert (context->resolved_paths, build_path, g_strdup (path));
+	else
+		g_free (build_path);
+
+	return path;
 }
 
 static void
@@ -706,196 +586,90 @@ static void
 on_build_mesg_format (IAnjutaMessageView *view, const gchar *one_line,
 					  BuildContext *context)
 {
-	gchar *dummy_fn, *line;
-	gint dummy_int;
-	IAnjutaMessageViewType type;
-	GList *node;
-	gchar *summary = NULL;
+	BuildLine build_line;
+	const gchar *line;
 	gchar *freeptr = NULL;
+	gchar *located = NULL;
+	gchar *summary = NULL;
+	IAnjutaMessageViewType type;
 	BasicAutotoolsPlugin *p = ANJUTA_PLUGIN_BASIC_AUTOTOOLS (context->plugin);
-	gboolean matched;
-	GMatchInfo *match_info;
-	MessagePattern *pat;
 
 	g_return_if_fail (one_line != NULL);
 
-	/* Check if make enter a new directory */
-	matched = FALSE;
-	for (pat = patterns_make_entering; pat->pattern != NULL; pat++)
-	{
-		matched = g_regex_match(
-						pat->regex,
-				  		one_line,
-			  			0,
-			  			&match_info);
-		if (matched) break;
-		g_match_info_free (match_info);
-		matched = g_regex_match(
-						pat->local_regex,
-				  		one_line,
-			  			0,
-			  			&match_info);
-		if (matched) break;
-		g_match_info_free (match_info);
-	}
-	if (matched)
-	{
-		gchar *dir;
-		gchar *summary;
+	build_classifier_classify (classifier, one_line, &build_line);
 
-		dir = g_match_info_fetch (match_info, 2);
-		dir = context->environment ? ianjuta_environment_get_real_directory(context->environment, dir, NULL)
-								: dir;
-		build_context_push_dir (context, "default", dir);
-		summary = g_strdup_printf(_("Entering: %s"), dir);
-		ianjuta_message_view_append (view, IANJUTA_MESSAGE_VIEW_TYPE_NORMAL,
-									 summary, one_line, NULL);
-		g_free (dir);
-		g_free(summary);
-		g_match_info_free (match_info);
-	}
-
-	/* Check if make leave a directory */
-	matched = FALSE;
-	for (pat = patterns_make_leaving; pat->pattern != NULL; pat++)
-	{
-		matched = g_regex_match(
-						pat->regex,
-				  		one_line,
-			  			0,
-			  			&match_info);
-		if (matched) break;
-		g_match_info_free (match_info);
-		matched = g_regex_match(
-						pat->local_regex,
-				  		one_line,
-			  			0,
-			  			&match_info);
-		if (matched) break;
-		g_match_info_free (match_info);
-	}
-	if (matched)
+	/* Check if make enter or leave a directory */
+	if (build_line.kind != BUILD_LINE_OUTPUT)
 	{
 		gchar *dir;
 		gchar *summary;
 
-		dir = g_match_info_fetch (match_info, 2);
+		dir = build_line.directory;
+		build_line.directory = NULL;
 		dir = context->environment ? ianjuta_environment_get_real_directory(context->environment, dir, NULL)
 								: dir;
-		build_context_pop_dir (context, "default", dir);
-		summary = g_strdup_printf(_("Leaving: %s"), dir);
+		if (build_line.kind == BUILD_LINE_ENTERING)
+		{
+			build_context_push_dir (context, "default", dir);
+			summary = g_strdup_printf(_("Entering: %s"), dir);
+		}
+		else
+		{
+			build_context_pop_dir (context, "default", dir);
+			summary = g_strdup_printf(_("Leaving: %s"), dir);
+		}
 		ianjuta_message_view_append (view, IANJUTA_MESSAGE_VIEW_TYPE_NORMAL,
 									 summary, one_line, NULL);
 		g_free (dir);
 		g_free(summary);
-		g_match_info_free (match_info);
 	}
 
-	/* Save freeptr so that we can free the copied string */
-	line = freeptr = g_strdup (one_line);
-
-	g_strchug(line); /* Remove leading whitespace */
-	if (g_str_has_prefix(line, "if ") == TRUE)
-	{
-		char *end;
-		line = line + 3;
-
-		/* Find the first occurence of ';' (ignoring nesting in quotations) */
-		end = strchr(line, ';');
-		if (end)
-		{
-			*end = '\0';
-		}
-	}
+	/* The message is only copied when it is a part of a shell if */
+	if (build_line.text[build_line.length] == '\0')
+		line = build_line.text;
+	else
+		line = freeptr = g_strndup (build_line.text, build_line.length);
 
 	type = IANJUTA_MESSAGE_VIEW_TYPE_NORMAL;
-	if (parse_error_line(line, &dummy_fn, &dummy_int))
+	if (build_line.severity != BUILD_LINE_NO_LOCATION)
 	{
-		gchar *start_str, *end_str, *mid_str;
+		const gchar *end_str;
+		gchar *filename;
+		gchar *path;
 		BuildIndicatorLocation *loc;
 		IAnjutaIndicableIndicator indicator;
 
-		if ((strstr (line, "warning:") != NULL) ||
-		/* The translations should match that of 'gcc' program.
-		 * The second string with -old should be used for an older
-		 * version of 'gcc' if necessary. If you update one string,
-		 * move the first one to translate the -old string and then
-		 * replace the first string only. */
-			(strstr (line, _("warning:")) != NULL) ||
-			(strstr (line, _("warning:-old")) != NULL))
+		switch (build_line.severity)
 		{
+		case BUILD_LINE_WARNING:
 			type = IANJUTA_MESSAGE_VIEW_TYPE_WARNING;
 			indicator = IANJUTA_INDICABLE_WARNING;
-		}
-		else if ((strstr (line, "error:") != NULL) ||
-		/* The translations should match that of 'gcc' program.
-		 * The second string with -old should be used for an older
-		 * version of 'gcc' if necessary. If you update one string,
-		 * move the first one to translate the -old string and then
-		 * replace the first string only. */
-		          (strstr (line, _("error:")) != NULL) ||
-			  (strstr (line, _("error:-old")) != NULL))
-		{
+			break;
+		case BUILD_LINE_ERROR:
 			type = IANJUTA_MESSAGE_VIEW_TYPE_ERROR;
 			indicator = IANJUTA_INDICABLE_CRITICAL;
-		}
-		else
-		{
+			break;
+		default:
 			type = IANJUTA_MESSAGE_VIEW_TYPE_NORMAL;
 			indicator = IANJUTA_INDICABLE_IMPORTANT;
+			break;
 		}
 
-		mid_str = strstr (line, dummy_fn);
-		DEBUG_PRINT ("mid_str = %s, line = %s", mid_str, line);
-		start_str = g_strndup (line, mid_str - line);
-		end_str = line + strlen (start_str) + strlen (dummy_fn);
-		DEBUG_PRINT("dummy_fn: %s", dummy_fn);
-		if (g_path_is_absolute(dummy_fn))
-		{
-			mid_str = g_strdup(dummy_fn);
-		}
-		else
-		{
-			mid_str = g_build_filename (build_context_get_dir (context, "default"),
-										dummy_fn, NULL);
-
-			/* If the file does not exist, try to replace the build directory by
-			 * the source directory. This is needed by the Vala compiler which
-			 * does not output absolute paths. */
-			if (!g_file_test (mid_str,G_FILE_TEST_IS_REGULAR))
-			{
-				GFile *file = g_file_new_for_path (mid_str);
-
-				if ((p->project_build_dir != NULL) && g_file_has_prefix (file, p->project_build_dir))
-				{
-					/* Try using the source directory */
-					gchar *relative;
-
-					relative = g_file_get_relative_path (p->project_build_dir, file);
-					g_object_unref (file);
-					file = g_file_get_child (p->project_root_dir, relative);
-					g_free (relative);
-
-					g_free (mid_str);
-					mid_str = g_file_get_path (file);
-				}
-				g_object_unref (file);
-			}
-		}
-		DEBUG_PRINT ("mid_str: %s", mid_str);
-
-		if (mid_str)
+		filename = g_strndup (line + build_line.file_start,
+							  build_line.file_length);
+		end_str = line + build_line.file_start + build_line.file_length;
+		path = build_context_resolve_path (context, filename);
+		if (path)
 		{
-			line = g_strconcat (start_str, mid_str, end_str, NULL);
+			located = g_strdup_printf ("%.*s%s%s", (gint) build_line.file_start,
+									   line, path, end_str);
 
-			/* We sucessfully build an absolute path of the file (mid_str),
+			/* We sucessfully build an absolute path of the file,
 			 * so we create an indicator location for it and save it.
 			 * Additionally, check of current editor holds this file and if
 			 * so, set the indicator.
 			 */
-			DEBUG_PRINT ("dummy int: %d", dummy_int);
-
-			loc = build_indicator_location_new (mid_str, dummy_int,
+			loc = build_indicator_location_new (path, build_line.lineno,
 												indicator, end_str);
 			context->locations = g_slist_prepend (context->locations, loc);
 
@@ -905,34 +679,30 @@ on_build_mesg_format (IAnjutaMessageView *view, const gchar *one_line,
 				build_indicator_location_set (loc, p->current_editor,
 											  p->current_editor_file);
 			}
+			line = located;
 		}
-		else
-		{
-			line = g_strconcat (start_str, dummy_fn, end_str, NULL);
-		}
-		g_free (start_str);
-		g_free (mid_str);
-		g_free (dummy_fn);
-	}
+		g_free (path);
+		g_free (filename);
 
-	node = patterns_list;
-	while (node)
+		/* Summarize the message with its full file name */
+		summary = build_classifier_get_summary (classifier, line, -1);
+	}
+	else
 	{
-		BuildPattern *pattern = node->data;
-		summary = build_get_summary (line, pattern);
-		if (summary)
-			break;
-		node = g_list_next (node);
+		summary = build_line.summary;
+		build_line.summary = NULL;
 	}
 
 	if (summary)
 	{
-		ianjuta_message_view_append (view, type, summary, line, NULL);
+		ianjuta_message_view_append_batched (view, type, summary, line, NULL);
 		g_free (summary);
 	}
 	else
-		ianjuta_message_view_append (view, type, line, "", NULL);
-	g_free(freeptr);
+		ianjuta_message_view_append_batched (view, type, line, "", NULL);
+	g_free (located);
+	g_free (freeptr);
+	build_line_clear (&build_line);
 }
 
 static void
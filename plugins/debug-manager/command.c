@@ -128,13 +128,13 @@ typedef enum
 		USER_COMMAND |
 	    NEED_DEBUGGER_STARTED | NEED_PROGRAM_LOADED | NEED_PROGRAM_STOPPED  | NEED_PROGRAM_RUNNING,
 	DMA_INSPECT_MEMORY_COMMAND =
-		INSPECT_MEMORY_COMMAND |
+		INSPECT_MEMORY_COMMAND | PIPELINE |
 		NEED_DEBUGGER_STARTED | NEED_PROGRAM_LOADED | NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_DISASSEMBLE_COMMAND =
-		DISASSEMBLE_COMMAND |
+		DISASSEMBLE_COMMAND | PIPELINE |
 		NEED_DEBUGGER_STARTED | NEED_PROGRAM_LOADED | NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_LIST_REGISTER_COMMAND =
-		LIST_REGISTER_COMMAND |
+		LIST_REGISTER_COMMAND | PIPELINE |
 		NEED_DEBUGGER_STARTED | NEED_PROGRAM_LOADED | NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_SET_WORKING_DIRECTORY_COMMAND =
 		SET_WORKING_DIRECTORY_COMMAND |
@@ -173,7 +173,7 @@ typedef enum
 		REMOVE_BREAK_COMMAND |
 		NEED_PROGRAM_LOADED | NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_LIST_BREAK_COMMAND =
-		LIST_BREAK_COMMAND |
+		LIST_BREAK_COMMAND | PIPELINE |
 		NEED_PROGRAM_LOADED | NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_INFO_SHAREDLIB_COMMAND =
 		INFO_SHAREDLIB_COMMAND |
@@ -215,19 +215,19 @@ typedef enum
 		HANDLE_SIGNAL_COMMAND |
 		NEED_PROGRAM_STOPPED,
 	DMA_LIST_LOCAL_COMMAND =
-		LIST_LOCAL_COMMAND |
+		LIST_LOCAL_COMMAND | PIPELINE |
 		NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_LIST_ARG_COMMAND =
-		LIST_ARG_COMMAND |
+		LIST_ARG_COMMAND | PIPELINE |
 		NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_LIST_THREAD_COMMAND =
-		LIST_THREAD_COMMAND |
+		LIST_THREAD_COMMAND | PIPELINE |
 		NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_SET_THREAD_COMMAND =
 		SET_THREAD_COMMAND |
 		NEED_PROGRAM_STOPPED,
 	DMA_INFO_THREAD_COMMAND =
-		INFO_THREAD_COMMAND |
+		INFO_THREAD_COMMAND | PIPELINE |
 		NEED_PROGRAM_STOPPED,
 	DMA_INFO_SIGNAL_COMMAND =
 		INFO_SIGNAL_COMMAND |
@@ -236,13 +236,13 @@ typedef enum
 		SET_FRAME_COMMAND |
 		NEED_PROGRAM_STOPPED,
 	DMA_LIST_FRAME_COMMAND =
-		LIST_FRAME_COMMAND |
+		LIST_FRAME_COMMAND | PIPELINE |
 		NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_DUMP_STACK_TRACE_COMMAND =
 		DUMP_STACK_TRACE_COMMAND |
 		NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_UPDATE_REGISTER_COMMAND =
-		UPDATE_REGISTER_COMMAND |
+		UPDATE_REGISTER_COMMAND | PIPELINE |
 		NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_WRITE_REGISTER_COMMAND =
 		WRITE_REGISTER_COMMAND |
@@ -260,10 +260,10 @@ typedef enum
 	   CREATE_VARIABLE |
 		NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	DMA_EVALUATE_VARIABLE_COMMAND =
-	    EVALUATE_VARIABLE | CANCEL_IF_PROGRAM_RUNNING |
+	    EVALUATE_VARIABLE | CANCEL_IF_PROGRAM_RUNNING | PIPELINE |
 	    NEED_PROGRAM_STOPPED,
 	DMA_LIST_VARIABLE_CHILDREN_COMMAND =
-	    LIST_VARIABLE_CHILDREN |
+	    LIST_VARIABLE_CHILDREN | PIPELINE |
 		NEED_PROGRAM_STOPPED,
 	DMA_DELETE_VARIABLE_COMMAND =
 		DELETE_VARIABLE |
@@ -272,7 +272,7 @@ typedef enum
 		ASSIGN_VARIABLE |
 		NEED_PROGRAM_STOPPED,
 	DMA_UPDATE_VARIABLE_COMMAND =
-	    UPDATE_VARIABLE | CANCEL_IF_PROGRAM_RUNNING |
+	    UPDATE_VARIABLE | CANCEL_IF_PROGRAM_RUNNING | PIPELINE |
 		NEED_PROGRAM_STOPPED | NEED_PROGRAM_RUNNING,
 	/* DMA_INTERRUPT_COMMAND doesn't automatically go in stop-program state
 	 * because sometimes it doesn't work. I don't know if it comes from anjuta,
@@ -617,6 +617,9 @@ dma_command_new (DmaDebuggerCommand cmd_type,...)
 	}
 	va_end (args);
 
+	/* A read only command is completed when its callback is called */
+	if (cmd->callback == NULL) cmd->type &= ~PIPELINE;
+
 	return cmd;
 }
 
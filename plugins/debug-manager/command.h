@@ -53,7 +53,8 @@ typedef enum
 	CANCEL_IF_PROGRAM_RUNNING = 1 << 21,
 	CANCEL_ALL_COMMAND = 1 << 22,
 	ASYNCHRONOUS = 1 << 23,
-	HIGH_PRIORITY = 1 << 24
+	HIGH_PRIORITY = 1 << 24,
+	PIPELINE = 1 << 25
 } DmaCommandFlag;
 
 /* Create a new command structure and append to command queue */
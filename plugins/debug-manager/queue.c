@@ -55,6 +55,8 @@ struct _DmaDebuggerQueue {
 	/* Command queue */
 	GQueue *queue;
 	DmaQueueCommand *last;
+	GQueue *pipeline;			/* Read only commands sent to the debugger */
+	gboolean pipeline_ready;	/* Wait for ready signal after read only commands */
 	GList *insert_command;		/* Insert command at the head of the list */
 	
 	IAnjutaDebuggerState debugger_state;
@@ -129,6 +131,9 @@ dma_debugger_queue_clear (DmaDebuggerQueue *self)
 		dma_command_free (self->last);
 		self->last = NULL;
 	}
+	g_queue_foreach (self->pipeline, (GFunc)dma_command_free, NULL);
+	while (g_queue_pop_head(self->pipeline) != NULL);
+	self->pipeline_ready = FALSE;
 	
 	/* Queue is empty so has the same state than debugger */
 	self->queue_state = self->debugger_state;
@@ -315,7 +320,7 @@ dma_queue_emit_debugger_ready (DmaDebuggerQueue *self)
 {
 	gboolean busy;
 	
-	if (g_queue_is_empty(self->queue) && (self->last == NULL))
+	if (g_queue_is_empty(self->queue) && (self->last == NULL) && g_queue_is_empty(self->pipeline))
 	{
 		busy = FALSE;
 	}
@@ -359,6 +364,11 @@ dma_debugger_queue_complete (DmaDebuggerQueue *self, IAnjutaDebuggerState state)
 			self->last = NULL;
 		}
 
+		/* All read only commands are completed */
+		if (g_queue_is_empty (self->pipeline))
+		{
+			self->pipeline_ready = FALSE;
+		}
 	
 		/* Emit new state if necessary */
 		dma_queue_emit_debugger_state (self, state, NULL);
@@ -394,6 +404,41 @@ dma_debugger_queue_execute (DmaDebuggerQueue *self)
 		GError *err = NULL;
 		gboolean ok;
 		
+		cmd = (DmaQueueCommand *)g_queue_peek_head(self->queue);
+
+		if (dma_command_has_flag (cmd, PIPELINE))
+		{
+			/* Read only command, send it without waiting for the previous
+			 * ones, the debugger answers them in the same order */
+			g_queue_pop_head (self->queue);
+			g_queue_push_tail (self->pipeline, cmd);
+			self->pipeline_ready = TRUE;
+			DEBUG_PRINT("pipeline command %x", dma_command_get_type (cmd));
+			ok = dma_command_run (cmd, self->debugger, self, &err);
+
+			if (!ok || (err != NULL))
+			{
+				/* Something fail, remove command */
+				DEBUG_PRINT("cancel command %x", dma_command_get_type (cmd));
+				if (g_queue_remove (self->pipeline, cmd)) dma_command_free (cmd);
+
+				if (err != NULL)
+				{
+					if (err->message != NULL)
+					{
+						anjuta_util_dialog_error (GTK_WINDOW (ANJUTA_PLUGIN (self->plugin)->shell), err->message);
+					}
+					g_error_free (err);
+				}
+			}
+			continue;
+		}
+		else if (self->pipeline_ready && !dma_command_has_flag (cmd, ASYNCHRONOUS))
+		{
+			/* Wait until the debugger has completed the read only commands */
+			break;
+		}
+		
 		cmd = (DmaQueueCommand *)g_queue_pop_head(self->queue);
 
 		/* Start command */
@@ -669,6 +714,24 @@ dma_debugger_queue_command_callback (const gpointer data, gpointer user_data, GE
 {
 	DmaDebuggerQueue *self = (DmaDebuggerQueue *)user_data;
 
+	if (!g_queue_is_empty (self->pipeline))
+	{
+		/* Read only commands are answered in the order they have been sent
+		 * and only them can be running at the same time */
+		DmaQueueCommand *cmd = (DmaQueueCommand *)g_queue_pop_head (self->pipeline);
+
+		self->insert_command = g_list_prepend (self->insert_command, g_queue_peek_head_link (self->queue));
+		if (self->queue_state != IANJUTA_DEBUGGER_STOPPED)
+		{
+			dma_command_callback (cmd, data, err);
+		}
+		self->insert_command = g_list_delete_link (self->insert_command, self->insert_command);
+		DEBUG_PRINT("end command %x", dma_command_get_type (cmd));
+		dma_command_free (cmd);
+
+		return;
+	}
+
 	g_return_if_fail (self->last != NULL);
 	
 	self->insert_command = g_list_prepend (self->insert_command, g_queue_peek_head_link (self->queue));
@@ -889,6 +952,7 @@ dma_debugger_queue_finalize (GObject *obj)
 	DmaDebuggerQueue *self = DMA_DEBUGGER_QUEUE (obj);
 
 	g_queue_free (self->queue);
+	g_queue_free (self->pipeline);
 
 	G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -904,6 +968,8 @@ dma_debugger_queue_instance_init (DmaDebuggerQueue *self)
 	self->support = 0;
 	self->queue = g_queue_new ();
 	self->last = NULL;
+	self->pipeline = g_queue_new ();
+	self->pipeline_ready = FALSE;
 	self->busy = FALSE;
 	self->insert_command = NULL;
 	self->debugger_state = IANJUTA_DEBUGGER_STOPPED;
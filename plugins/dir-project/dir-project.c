@@ -31,6 +31,7 @@
 #include <libanjuta/interfaces/ianjuta-project.h>
 #include <libanjuta/anjuta-debug.h>
 #include <libanjuta/anjuta-utils.h>
+#include <libanjuta/anjuta-project-cache.h>
 
 #include <string.h>
 #include <memory.h>
@@ -46,6 +47,8 @@
 
 #define SOURCES_FILE	PACKAGE_DATA_DIR "/sources.list"
 
+#define CACHE_NAME		"dir-project"
+
 struct _DirProject {
 	AnjutaDirRootNode         parent;
 
@@ -85,6 +88,16 @@ struct _DirPattern
 	gboolean directory;
 	GRegex *source;
 	gchar *object;
+	gchar *alternative;		/* Source without capture matching the whole path */
+};
+
+/* Several patterns combined in one regular expression */
+typedef struct _DirMatcher DirMatcher;
+
+struct _DirMatcher
+{
+	GRegex *regex;
+	GPtrArray *patterns;	/* Pattern of each alternative */
 };
 
 /* A list of pattern found in one file */
@@ -94,6 +107,9 @@ struct _DirPatternList
 {
 	GList *pattern;
 	GFile *directory;
+	DirMatcher *directories;	/* All patterns */
+	DirMatcher *files;			/* Patterns matching files */
+	DirMatcher *objects;		/* Patterns matching files and having an object */
 };
 
 /* ----- Standard GObject types and variables ----- */
@@ -205,10 +221,53 @@ dir_pattern_free (DirPattern *pat)
 {
 	if (pat->source != NULL) g_regex_unref (pat->source);
 	g_free (pat->object);
+	g_free (pat->alternative);
 
     g_slice_free (DirPattern, pat);
 }
 
+/* Get a regular expression matching the whole path from its beginning and
+ * without capturing anything, so it can be combined with others */
+
+static gchar *
+dir_pattern_get_alternative (const gchar *regex)
+{
+	static const gchar *any_directory = "(?:^|\\" G_DIR_SEPARATOR_S ")";
+	GString *alternative = g_string_new (NULL);
+	const gchar *ptr = regex;
+
+	if (g_str_has_prefix (ptr, any_directory))
+	{
+		g_string_append (alternative, "(?:.*\\" G_DIR_SEPARATOR_S ")?");
+		ptr += strlen (any_directory);
+	}
+	else if (*ptr == '^')
+	{
+		ptr++;
+	}
+
+	for (; *ptr != '\0'; ptr++)
+	{
+		if (*ptr == '\\')
+		{
+			/* Keep escaped character */
+			g_string_append_c (alternative, *ptr);
+			if (*(ptr + 1) == '\0') break;
+			g_string_append_c (alternative, *++ptr);
+		}
+		else if ((*ptr == '(') && (*(ptr + 1) != '?'))
+		{
+			g_string_append (alternative, "(?:");
+		}
+		else
+		{
+			g_string_append_c (alternative, *ptr);
+		}
+	}
+
+	return g_string_free (alternative, FALSE);
+}
+
 /* Create a new pattern matching a directory of a file name in a path */
 
 static DirPattern*
@@ -304,6 +363,10 @@ dir_pattern_new (const gchar *pattern, gboolean reverse)
 		dir_pattern_free (pat);
 		pat = NULL;
 	}
+	else
+	{
+		pat->alternative = dir_pattern_get_alternative (regex->str);
+	}
 
 	if ((pat != NULL) && (*ptr == ':'))
 	{
@@ -352,6 +415,85 @@ dir_pattern_new (const gchar *pattern, gboolean reverse)
 	return pat;
 }
 
+/* Matcher objects
+ *---------------------------------------------------------------------------*/
+
+static void
+dir_matcher_free (DirMatcher *matcher)
+{
+	if (matcher->regex != NULL) g_regex_unref (matcher->regex);
+	g_ptr_array_free (matcher->patterns, TRUE);
+
+	g_slice_free (DirMatcher, matcher);
+}
+
+/* Combine all patterns in one regular expression. The alternatives are
+ * written from the last pattern, so the first matching alternative is the
+ * last matching pattern. Each alternative ends with an empty group, the number
+ * of groups found gives the alternative. */
+
+static DirMatcher *
+dir_matcher_new (GList *patterns, gboolean directory, gboolean object)
+{
+	DirMatcher *matcher;
+	GString *regex;
+	GList *node;
+
+	matcher = g_slice_new0 (DirMatcher);
+	matcher->patterns = g_ptr_array_new ();
+
+	regex = g_string_new ("(?:");
+	for (node = g_list_last (patterns); node != NULL; node = g_list_previous (node))
+	{
+		DirPattern *pat = (DirPattern *)node->data;
+
+		if (pat->directory && !directory) continue;
+		if (object && (!pat->match || (pat->object == NULL))) continue;
+
+		if (matcher->patterns->len != 0) g_string_append_c (regex, '|');
+		g_string_append (regex, pat->alternative);
+		g_string_append (regex, "()");
+		g_ptr_array_add (matcher->patterns, pat);
+	}
+	g_string_append_c (regex, ')');
+
+	if (matcher->patterns->len != 0)
+	{
+		matcher->regex = g_regex_new (regex->str, G_REGEX_ANCHORED | G_REGEX_OPTIMIZE, 0, NULL);
+		if (matcher->regex == NULL)
+		{
+			g_warning ("Unable to combine %d patterns", matcher->patterns->len);
+		}
+	}
+	g_string_free (regex, TRUE);
+
+	return matcher;
+}
+
+/* Return the last pattern matching the path or NULL */
+
+static DirPattern *
+dir_matcher_match (DirMatcher *matcher, const gchar *filename)
+{
+	DirPattern *pat = NULL;
+	GMatchInfo *info;
+
+	if (matcher->regex == NULL) return NULL;
+
+	if (g_regex_match (matcher->regex, filename, 0, &info))
+	{
+		gint alternative = g_match_info_get_match_count (info) - 2;
+
+		if ((alternative >= 0) && (alternative < (gint)matcher->patterns->len))
+		{
+			pat = (DirPattern *)g_ptr_array_index (matcher->patterns, alternative);
+		}
+	}
+	g_match_info_free (info);
+
+	return pat;
+}
+
 /* Read a file containing pattern, the syntax is similar to .gitignore file.
  *
  * It is not a regular expression, only * and ? are used as joker.
@@ -423,6 +565,9 @@ dir_push_pattern_list (GList *stack, GFile *dir, GFile *file, gboolean ignore, G
 	g_free (content);
 
 	list->pattern = g_list_reverse (list->pattern);
+	list->directories = dir_matcher_new (list->pattern, TRUE, FALSE);
+	list->files = dir_matcher_new (list->pattern, FALSE, FALSE);
+	list->objects = dir_matcher_new (list->pattern, FALSE, TRUE);
 
 	return g_list_prepend (stack, list);
 }
@@ -434,6 +579,9 @@ dir_pop_pattern_list (GList *stack)
 
 	stack = g_list_remove_link (stack, stack);
 
+	dir_matcher_free (top->directories);
+	dir_matcher_free (top->files);
+	dir_matcher_free (top->objects);
 	g_list_foreach (top->pattern, (GFunc)dir_pattern_free, NULL);
 	g_list_free (top->pattern);
 	g_object_unref (top->directory);
@@ -442,95 +590,90 @@ dir_pop_pattern_list (GList *stack)
 	return stack;
 }
 
+/* filename is the path relative to the project directory */
 static gboolean
-dir_pattern_stack_is_match (GFile *root, GList *stack, GFile *file)
+dir_pattern_stack_is_match (GList *stack, const gchar *filename, gboolean directory)
 {
-	gboolean match;
 	GList *list;
-	gchar *filename;
-	gboolean directory;
-
-	/* Create name from file */
-	filename = g_file_get_relative_path (root, file);
-
-	directory = g_file_query_file_type (file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL) == G_FILE_TYPE_DIRECTORY;
-	/* Include directories by default */
-	match = directory;
 
-	/* Check all valid patterns */
-	for (list = g_list_last (stack); list != NULL; list = g_list_previous (list))
+	/* The last matching pattern is used, so check the last pushed list first */
+	for (list = g_list_first (stack); list != NULL; list = g_list_next (list))
 	{
 		DirPatternList *pat_list = (DirPatternList *)list->data;
-		GList *node;
+		DirPattern *pat;
 
-		for (node = g_list_first (pat_list->pattern); node != NULL; node = g_list_next (node))
-		{
-			DirPattern *pat = (DirPattern *)node->data;
-
-			if (pat->directory && !directory)
-				continue;
-
-			if (g_regex_match (pat->source, filename,  0, NULL))
-			{
-				match = pat->match;
-			}
-		}
+		pat = dir_matcher_match (directory ? pat_list->directories : pat_list->files, filename);
+		if (pat != NULL) return pat->match;
 	}
-	g_free (filename);
 
-	return match;
+	/* Include directories by default */
+	return directory;
 }
 
+/* filename is the path of a file, not a directory, relative to root */
 static GFile *
-dir_pattern_find_file_object (GFile *root, GList *stack, GFile *file)
+dir_pattern_find_file_object (GFile *root, GList *stack, const gchar *filename)
 {
-	GFile *object = NULL;
+	GList *list;
 
-	if (g_file_query_file_type (file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL) != G_FILE_TYPE_DIRECTORY)
+	for (list = g_list_first (stack); list != NULL; list = g_list_next (list))
 	{
-		GList *list;
-		gchar *filename;
-
-		/* Create name from file */
-		filename = g_file_get_relative_path (root, file);
+		DirPatternList *pat_list = (DirPatternList *)list->data;
+		DirPattern *pat;
 
-		/* Check all valid patterns */
-		for (list = g_list_last (stack); list != NULL; list = g_list_previous (list))
+		pat = dir_matcher_match (pat_list->objects, filename);
+		if (pat != NULL)
 		{
-			DirPatternList *pat_list = (DirPatternList *)list->data;
-			GList *node;
-
-			for (node = g_list_first (pat_list->pattern); node != NULL; node = g_list_next (node))
-			{
-				DirPattern *pat = (DirPattern *)node->data;
+			GFile *object;
+			gchar *objname;
 
-				if (pat->directory  || !pat->match || (pat->object == NULL) )
-					continue;
-
-				if (g_regex_match (pat->source, filename,  0, NULL))
-				{
-					gchar *objname;
+			objname = g_regex_replace (pat->source, filename, -1, 0, pat->object, 0, NULL);
+			object = g_file_get_child (root, objname);
+			g_free (objname);
 
-					objname = g_regex_replace (pat->source, filename, -1, 0, pat->object, 0, NULL);
-					object = g_file_get_child (root, objname);
-					g_free (objname);
-				}
-			}
+			return object;
 		}
-		g_free (filename);
 	}
 
-	return object;
+	return NULL;
 }
 
 
 typedef struct {
 	DirProject *proj;
 	AnjutaProjectNode *parent;
+	gchar *path;				/* Parent path relative to the project */
+	GHashTable *children;		/* Existing children by source file */
 } DirData;
 
-/* the number of files to enumerate each time */
-#define NUM_FILES 10
+typedef struct {
+	DirProject *proj;
+	GList *changed;
+} DirCacheData;
+
+static gboolean dir_project_is_loaded (DirProject *project);
+
+static void
+dir_project_save_cache (DirProject *project)
+{
+	AnjutaProjectNode *root = ANJUTA_PROJECT_NODE (project);
+	GFile *cache;
+	GError *error = NULL;
+
+	if (anjuta_project_node_get_state (root) & (ANJUTA_PROJECT_LOADING | ANJUTA_PROJECT_INCOMPLETE)) return;
+
+	cache = anjuta_project_cache_get_file (anjuta_project_node_get_file (root), CACHE_NAME);
+	if (!anjuta_project_cache_save (root, cache, &error))
+	{
+		DEBUG_PRINT ("Unable to save project cache: %s", error->message);
+		g_error_free (error);
+	}
+	g_object_unref (cache);
+}
+
+/* the number of files to enumerate each time, the enumeration is done in
+ * the GIO thread pool, so several directories are read at the same time */
+#define NUM_FILES 256
 
 static void
 dir_project_load_directory_callback (GObject      *source_object,
@@ -573,9 +716,13 @@ dir_project_load_directory_callback (GObject      *source_object,
 				}
 			}
 			g_signal_emit_by_name (data->proj, "node-loaded", data->parent, NULL);
+
+			if (dir_project_is_loaded (data->proj)) dir_project_save_cache (data->proj);
 		}
 		g_list_foreach (removed, (GFunc)g_object_unref, NULL);
 		g_list_free (removed);
+		g_hash_table_destroy (data->children);
+		g_free (data->path);
 		g_object_unref (data->parent);
 		g_slice_free (DirData, data);
 		g_object_unref (enumerator);
@@ -588,18 +735,34 @@ dir_project_load_directory_callback (GObject      *source_object,
 	{
 		GFileInfo *info;
 		const gchar *name;
+		gchar *filename;
+		GFileType type;
 		GFile *file;
 
 		info = G_FILE_INFO(l->data);
 
 		name = g_file_info_get_name (info);
+		type = g_file_info_get_file_type (info);
+		filename = data->path == NULL ? g_strdup (name) : g_build_filename (data->path, name, NULL);
+
+		/* Check if file is a source */
+		if (!dir_pattern_stack_is_match (data->proj->sources, filename, type == G_FILE_TYPE_DIRECTORY))
+		{
+			g_free (filename);
+			g_object_unref (info);
+			continue;
+		}
+
 		file = g_file_get_child (data->parent->file, name);
 		g_object_unref (info);
 
-		/* Check if file is a source */
-		if (!dir_pattern_stack_is_match (root, data->proj->sources, file)) continue;
+		/* Symbolic links to a directory are groups too */
+		if (type == G_FILE_TYPE_SYMBOLIC_LINK)
+		{
+			type = g_file_query_file_type (file, G_FILE_QUERY_INFO_NONE, NULL);
+		}
 
-		if (g_file_query_file_type (file, G_FILE_QUERY_INFO_NONE, NULL) == G_FILE_TYPE_DIRECTORY)
+		if (type == G_FILE_TYPE_DIRECTORY)
 		{
 			AnjutaProjectNode *group;
 			gchar *uri;
@@ -622,31 +785,21 @@ dir_project_load_directory_callback (GObject      *source_object,
 		}
 		else
 		{
-			AnjutaProjectNode *source = NULL;
-
 			AnjutaProjectNode *node;
-			for (node = anjuta_project_node_first_child (data->parent);
-			     node != NULL;
-			     node = anjuta_project_node_next_sibling (node))
+
+			node = g_hash_table_lookup (data->children, file);
+			if (node != NULL)
 			{
-				source = (anjuta_project_node_get_node_type (node) == ANJUTA_PROJECT_OBJECT) ?
-					anjuta_project_node_first_child (node) :
-					node;
-				if (g_file_equal (file, anjuta_project_node_get_file (source)))
-				{
-					anjuta_project_node_clear_state (node, ANJUTA_PROJECT_LOADING);
-					break;
-				}
-				source = NULL;
+				anjuta_project_node_clear_state (node, ANJUTA_PROJECT_LOADING);
 			}
-
-			if (source == NULL)
+			else
 			{
 				GFile *object;
 				AnjutaProjectNode *parent;
+				AnjutaProjectNode *source;
 
 				/* Create object if possible */
-				object = dir_pattern_find_file_object (root, data->proj->sources, file);
+				object = dir_pattern_find_file_object (root, data->proj->sources, filename);
 				if (object != NULL)
 				{
 					parent = project_node_new (data->proj, NULL, ANJUTA_PROJECT_OBJECT | ANJUTA_PROJECT_PROJECT, object, NULL, NULL);
@@ -663,6 +816,8 @@ dir_project_load_directory_callback (GObject      *source_object,
 				anjuta_project_node_append (parent, source);
 			}
 		}
+		g_object_unref (file);
+		g_free (filename);
 	}
 	g_list_free (infos);
 
@@ -677,9 +832,10 @@ static AnjutaProjectNode *
 dir_project_load_directory (DirProject *project, AnjutaProjectNode *parent, GError **error)
 {
 	GFileEnumerator *enumerator;
+	GFile *root;
 
 	enumerator = g_file_enumerate_children (parent->file,
-	    G_FILE_ATTRIBUTE_STANDARD_NAME,
+	    G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE,
 	    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
 	    NULL,
 	    error);
@@ -687,6 +843,13 @@ dir_project_load_directory (DirProject *project, AnjutaProjectNode *parent, GErr
 	if (enumerator == NULL)
 		return parent;
 
+	DirData *data = g_slice_new (DirData);
+	data->proj = project;
+	data->parent = g_object_ref (parent);
+	root = anjuta_project_node_get_file (ANJUTA_PROJECT_NODE (project));
+	data->path = g_file_get_relative_path (root, parent->file);
+	data->children = g_hash_table_new (g_file_hash, (GEqualFunc)g_file_equal);
+
 	/* mark all children as loading so we can remove them if no longer relevant */
 	AnjutaProjectNode *node;
 	for (node = anjuta_project_node_first_child (parent);
@@ -694,11 +857,19 @@ dir_project_load_directory (DirProject *project, AnjutaProjectNode *parent, GErr
 	     node = anjuta_project_node_next_sibling (node))
 	{
 		anjuta_project_node_set_state (node, ANJUTA_PROJECT_LOADING);
-	}
 
-	DirData *data = g_slice_new (DirData);
-	data->proj = project;
-	data->parent = g_object_ref (parent);
+		/* Existing source files, the groups are found by uri */
+		if (anjuta_project_node_get_node_type (node) == ANJUTA_PROJECT_OBJECT)
+		{
+			AnjutaProjectNode *source = anjuta_project_node_first_child (node);
+
+			if (source != NULL) g_hash_table_insert (data->children, anjuta_project_node_get_file (source), node);
+		}
+		else if (anjuta_project_node_get_node_type (node) == ANJUTA_PROJECT_SOURCE)
+		{
+			g_hash_table_insert (data->children, anjuta_project_node_get_file (node), node);
+		}
+	}
 
 	g_file_enumerator_next_files_async (enumerator, NUM_FILES, G_PRIORITY_DEFAULT, NULL,
 	                                    dir_project_load_directory_callback, data);
@@ -707,6 +878,76 @@ dir_project_load_directory (DirProject *project, AnjutaProjectNode *parent, GErr
 	return parent;
 }
 
+static AnjutaProjectNode *
+dir_project_cache_new_node (AnjutaProjectNode *parent, AnjutaProjectNodeType type, GFile *file, const gchar *name, gpointer user_data)
+{
+	DirProject *project = DIR_PROJECT (user_data);
+	AnjutaProjectNode *node;
+
+	switch (type & ANJUTA_PROJECT_TYPE_MASK)
+	{
+	case ANJUTA_PROJECT_GROUP:
+		if (file == NULL) return NULL;
+		node = project_node_new (project, parent, type, file, name, NULL);
+		g_hash_table_insert (project->groups, g_file_get_uri (file), node);
+		return node;
+	case ANJUTA_PROJECT_OBJECT:
+	case ANJUTA_PROJECT_SOURCE:
+		return project_node_new (project, parent, type, file, name, NULL);
+	default:
+		return NULL;
+	}
+}
+
+static gboolean
+dir_project_load_cache_idle (gpointer user_data)
+{
+	DirCacheData *data = (DirCacheData *)user_data;
+	GList *item;
+
+	g_signal_emit_by_name (data->proj, "node-loaded", ANJUTA_PROJECT_NODE (data->proj), NULL);
+
+	/* Reload only the changed directories */
+	for (item = g_list_first (data->changed); item != NULL; item = g_list_next (item))
+	{
+		dir_project_load_directory (data->proj, (AnjutaProjectNode *)item->data, NULL);
+	}
+
+	g_list_free (data->changed);
+	g_object_unref (data->proj);
+	g_slice_free (DirCacheData, data);
+
+	return FALSE;
+}
+
+/* Display the project saved in the cache and reload only the directories
+ * changed since then */
+static gboolean
+dir_project_load_cache (DirProject *project)
+{
+	AnjutaProjectNode *root = ANJUTA_PROJECT_NODE (project);
+	GFile *cache;
+	GList *changed = NULL;
+	DirCacheData *data;
+	gboolean ok;
+
+	cache = anjuta_project_cache_get_file (anjuta_project_node_get_file (root), CACHE_NAME);
+	ok = anjuta_project_cache_load (root, cache, dir_project_cache_new_node, project, &changed, NULL);
+	g_object_unref (cache);
+	if (!ok)
+	{
+		g_hash_table_remove_all (project->groups);
+		return FALSE;
+	}
+
+	data = g_slice_new (DirCacheData);
+	data->proj = g_object_ref (project);
+	data->changed = changed;
+	g_idle_add (dir_project_load_cache_idle, data);
+
+	return TRUE;
+}
+
 static AnjutaProjectNode *
 dir_project_load_root (DirProject *project, GError **error)
 {
@@ -737,7 +978,11 @@ dir_project_load_root (DirProject *project, GError **error)
 	g_object_unref (source_file);
 
 	dir_group_node_set_file (ANJUTA_DIR_GROUP_NODE (project), root_file, G_OBJECT (project));
-	dir_project_load_directory (project, ANJUTA_PROJECT_NODE (project), NULL);
+	if ((anjuta_project_node_first_child (ANJUTA_PROJECT_NODE (project)) != NULL) ||
+		!dir_project_load_cache (project))
+	{
+		dir_project_load_directory (project, ANJUTA_PROJECT_NODE (project), NULL);
+	}
 
 	return ANJUTA_PROJECT_NODE (project);
 }
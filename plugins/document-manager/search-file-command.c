@@ -23,28 +23,45 @@
 struct _SearchFileCommandPrivate
 {
 	GFile* file;
-	gchar* pattern;
+	GRegex* regex;
+	gchar* literal;
 	gchar* replace;
-	gboolean regex;
 	gboolean case_sensitive;
 
 	gint n_matches;
+
+	/* Matches not yet taken by the main thread, guarded by the command lock */
+	GQueue* matches;
 };
 
 enum
 {
 	PROP_0,
 	PROP_FILE,
-	PROP_PATTERN,
+	PROP_REGEX,
+	PROP_LITERAL,
 	PROP_REPLACE,
-	PROP_CASE_SENSITIVE,
-	PROP_REGEX
+	PROP_CASE_SENSITIVE
 };
 
-#define BUFFER_SIZE 1024
+/* Matches of a file reported with their line, the others are only counted */
+#define MATCHES_MAX 1000
+
+/* Matches queued before notifying the main thread */
+#define MATCHES_BATCH 64
+
+/* Bytes of the line kept as context of a match */
+#define CONTEXT_MAX 256
 
 G_DEFINE_TYPE (SearchFileCommand, search_file_command, ANJUTA_TYPE_ASYNC_COMMAND);
 
+void
+search_file_match_free (SearchFileMatch* match)
+{
+	g_free (match->context);
+	g_slice_free (SearchFileMatch, match);
+}
+
 static void
 search_file_command_save (SearchFileCommand* cmd, const gchar* new_content, GError **error)
 {
@@ -70,40 +87,120 @@ search_file_command_save (SearchFileCommand* cmd, const gchar* new_content, GErr
 	g_object_unref (ostream);
 }
 
-static gchar*
-search_file_command_load (SearchFileCommand* cmd, GError **error)
+/* Returns the first occurrence of the literal in the content or NULL. The
+ * case insensitive search folds ASCII letters only, see
+ * search_file_command_get_literal(). */
+static const gchar*
+search_file_command_find_literal (SearchFileCommand* cmd,
+                                  const gchar* content, gsize length)
 {
-	GString* content;
-	GFileInputStream* istream;
-	gchar buffer[BUFFER_SIZE];
-	gssize bytes_read;
-	
-	istream = g_file_read (cmd->priv->file, NULL, error);
-	if (*error)
-	{
+	const gchar* literal = cmd->priv->literal;
+	gsize literal_len = strlen (literal);
+	const gchar* last;
+	const gchar* pos;
+	const gchar* next_first = NULL;
+	gchar first = literal[0];
+	gchar other = first;
+
+	if (literal_len > length)
 		return NULL;
-	}
-	
-	/* Read file into buffer */
-	content = g_string_new (NULL);
-	while ((bytes_read = g_input_stream_read (G_INPUT_STREAM (istream),
-	                                          buffer,
-	                                          BUFFER_SIZE - 1,
-	                                          NULL,
-	                                          error)))
+	last = content + length - literal_len;
+
+	if (!cmd->priv->case_sensitive && g_ascii_isalpha (first))
+		other = g_ascii_isupper (first) ? g_ascii_tolower (first) : g_ascii_toupper (first);
+
+	for (pos = content; pos <= last; pos++)
 	{
-		if (*error)
+		const gchar* hit;
+
+		/* The next occurrence of the first byte is kept while the
+		 * occurrences of its other case are checked before it */
+		if (next_first == NULL || next_first < pos)
 		{
-			g_string_free (content, TRUE);
-			g_object_unref (istream);
-			return NULL;
+			next_first = memchr (pos, first, last - pos + 1);
+			if (next_first == NULL)
+				next_first = last + 1;
+		}
+		hit = next_first;
+		if (other != first)
+		{
+			const gchar* hit_other = memchr (pos, other, hit - pos);
+			if (hit_other != NULL)
+				hit = hit_other;
 		}
-		/* TODO: Non-UTF8 files... */
-		g_string_append_len (content, buffer, bytes_read);
+		if (hit > last)
+			return NULL;
+
+		if (cmd->priv->case_sensitive ?
+		    memcmp (hit + 1, literal + 1, literal_len - 1) == 0 :
+		    g_ascii_strncasecmp (hit + 1, literal + 1, literal_len - 1) == 0)
+			return hit;
+
+		pos = hit;
+	}
+
+	return NULL;
+}
+
+/* Moves line_start to the start of the line containing pos */
+static void
+search_file_command_skip_lines (const gchar** line_start, gint* line,
+                                const gchar* pos)
+{
+	const gchar* eol;
+
+	while ((eol = memchr (*line_start, '\n', pos - *line_start)) != NULL)
+	{
+		*line_start = eol + 1;
+		(*line)++;
 	}
-	g_object_unref (istream);
+}
+
+static SearchFileMatch*
+search_file_command_new_match (const gchar* line_start, gint line,
+                               const gchar* match, const gchar* end)
+{
+	SearchFileMatch* result = g_slice_new (SearchFileMatch);
+	const gchar* line_end;
+	gsize context_len;
+
+	line_end = memchr (match, '\n', end - match);
+	if (line_end == NULL)
+		line_end = end;
+	if (line_end > line_start && line_end[-1] == '\r')
+		line_end--;
+
+	/* Cut the context on a character boundary, the content has been
+	 * validated by the regex */
+	context_len = line_end - line_start;
+	if (context_len > CONTEXT_MAX)
+	{
+		context_len = CONTEXT_MAX;
+		while (context_len > 0 && (line_start[context_len] & 0xC0) == 0x80)
+			context_len--;
+	}
+
+	result->line = line;
+	result->column = g_utf8_strlen (line_start, match - line_start) + 1;
+	result->context = g_strstrip (g_strndup (line_start, context_len));
+
+	return result;
+}
+
+static void
+search_file_command_push_matches (SearchFileCommand* cmd, GQueue* matches)
+{
+	SearchFileMatch* match;
+
+	if (g_queue_is_empty (matches))
+		return;
+
+	anjuta_async_command_lock (ANJUTA_ASYNC_COMMAND (cmd));
+	while ((match = g_queue_pop_head (matches)) != NULL)
+		g_queue_push_tail (cmd->priv->matches, match);
+	anjuta_async_command_unlock (ANJUTA_ASYNC_COMMAND (cmd));
 
-	return g_string_free (content, FALSE);
+	anjuta_command_notify_data_arrived (ANJUTA_COMMAND (cmd));
 }
 
 static guint
@@ -111,66 +208,75 @@ search_file_command_run (AnjutaCommand* anjuta_cmd)
 {
 	SearchFileCommand* cmd = SEARCH_FILE_COMMAND(anjuta_cmd);
 	GError* error = NULL;
-	gchar* pattern;
-	gchar* replace;
-	gchar* content;
-	GRegexCompileFlags flags = G_REGEX_MULTILINE;
-	GRegex *regex;
+	gchar* content = NULL;
+	const gchar* end;
+	const gchar* line_start;
+	gsize length = 0;
+	gint line = 1;
 	GMatchInfo *match_info;
-	
+	GQueue matches = G_QUEUE_INIT;
+
 	g_return_val_if_fail (cmd->priv->file != NULL && G_IS_FILE (cmd->priv->file), 1);
-	g_return_val_if_fail (cmd->priv->pattern != NULL, 1);
+	g_return_val_if_fail (cmd->priv->regex != NULL, 1);
 	cmd->priv->n_matches = 0;
-	
-	content = search_file_command_load (cmd, &error);
-	if (error)
+
+	/* The file is copied rather than mapped: a mapping would fault if the
+	 * file were truncated during the search.
+	 * TODO: Non-UTF8 files... */
+	if (!g_file_load_contents (cmd->priv->file, NULL, &content, &length,
+	                           NULL, &error))
 	{
 		int code = error->code;
 		g_error_free (error);
 		return code;
 	}
-	
-	if (!cmd->priv->regex)
-	{
-		pattern = g_regex_escape_string (cmd->priv->pattern, -1);
-		if (cmd->priv->replace)
-			replace = g_regex_escape_string (cmd->priv->replace, -1);
-		else
-			replace = NULL;
-	}
-	else
-	{
-		pattern = g_strdup (cmd->priv->pattern);
-		if (cmd->priv->replace)
-			replace = g_strdup (cmd->priv->replace);
-		else
-			replace = NULL;
-	}
+	end = content + length;
+	line_start = content;
 
-	if (!cmd->priv->case_sensitive)
-		flags |= G_REGEX_CASELESS;
-
-	regex = g_regex_new (pattern, flags, 0, &error);
-	if (error)
+	/* No match can start before the first occurrence of the literal part of
+	 * the pattern, so the regex starts at its line or isn't run at all */
+	if (cmd->priv->literal)
 	{
-		anjuta_command_set_error_message(anjuta_cmd, error->message);
-		g_error_free (error);
-		g_free (content);
-		return 1;
+		const gchar* first = search_file_command_find_literal (cmd, content, length);
+
+		if (first == NULL)
+		{
+			g_free (content);
+			return 0;
+		}
+		search_file_command_skip_lines (&line_start, &line, first);
 	}
-	g_regex_match (regex, content, 0, &match_info);
+
+	g_regex_match_full (cmd->priv->regex, content, length,
+	                    line_start - content, 0, &match_info, NULL);
 	while (g_match_info_matches (match_info))
 	{
+		gint match_pos;
+
 		cmd->priv->n_matches++;
+		if (cmd->priv->n_matches <= MATCHES_MAX)
+		{
+			g_match_info_fetch_pos (match_info, 0, &match_pos, NULL);
+			search_file_command_skip_lines (&line_start, &line,
+			                                content + match_pos);
+			g_queue_push_tail (&matches,
+			                   search_file_command_new_match (line_start, line,
+			                                                  content + match_pos,
+			                                                  end));
+			if (matches.length >= MATCHES_BATCH)
+				search_file_command_push_matches (cmd, &matches);
+		}
 		g_match_info_next (match_info, NULL);
 	}
 	g_match_info_free (match_info);
-	
-	if (replace && cmd->priv->n_matches)
+	search_file_command_push_matches (cmd, &matches);
+
+	if (cmd->priv->replace && cmd->priv->n_matches)
 	{
 		gchar* new_content;
-		
-		new_content = g_regex_replace (regex, content, -1, 0, replace, 0, NULL);
+
+		new_content = g_regex_replace (cmd->priv->regex, content, length, 0,
+		                               cmd->priv->replace, 0, NULL);
 
 		search_file_command_save (cmd, new_content, &error);
 		g_free (new_content);
@@ -178,14 +284,13 @@ search_file_command_run (AnjutaCommand* anjuta_cmd)
 		if (error)
 		{
 			anjuta_async_command_set_error_message (anjuta_cmd, error->message);
+			g_error_free (error);
+			g_free (content);
 			return 1;
 		}
 	}
 
-	g_regex_unref (regex);
 	g_free (content);
-	g_free (pattern);
-	g_free (replace);
 
 	return 0;
 }
@@ -194,6 +299,7 @@ static void
 search_file_command_init (SearchFileCommand *cmd)
 {
 	cmd->priv = G_TYPE_INSTANCE_GET_PRIVATE (cmd, SEARCH_TYPE_FILE_COMMAND, SearchFileCommandPrivate);
+	cmd->priv->matches = g_queue_new ();
 }
 
 static void
@@ -203,8 +309,12 @@ search_file_command_finalize (GObject *object)
 	
 	if (cmd->priv->file)
 		g_object_unref (cmd->priv->file);
-	g_free (cmd->priv->pattern);
+	if (cmd->priv->regex)
+		g_regex_unref (cmd->priv->regex);
+	g_free (cmd->priv->literal);
 	g_free (cmd->priv->replace);
+	g_queue_foreach (cmd->priv->matches, (GFunc) search_file_match_free, NULL);
+	g_queue_free (cmd->priv->matches);
 
 	G_OBJECT_CLASS (search_file_command_parent_class)->finalize (object);
 }
@@ -225,9 +335,14 @@ search_file_command_set_property (GObject *object, guint prop_id, const GValue *
 			g_object_unref (cmd->priv->file);
 		cmd->priv->file = g_value_dup_object (value);
 		break;
-	case PROP_PATTERN:
-		g_free (cmd->priv->pattern);
-		cmd->priv->pattern = g_value_dup_string (value);
+	case PROP_REGEX:
+		if (cmd->priv->regex)
+			g_regex_unref (cmd->priv->regex);
+		cmd->priv->regex = g_value_dup_boxed (value);
+		break;
+	case PROP_LITERAL:
+		g_free (cmd->priv->literal);
+		cmd->priv->literal = g_value_dup_string (value);
 		break;
 	case PROP_REPLACE:
 		g_free (cmd->priv->replace);
@@ -236,9 +351,6 @@ search_file_command_set_property (GObject *object, guint prop_id, const GValue *
 	case PROP_CASE_SENSITIVE:
 		cmd->priv->case_sensitive = g_value_get_boolean (value);
 		break;			
-	case PROP_REGEX:
-		cmd->priv->regex = g_value_get_boolean (value);
-		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -259,8 +371,11 @@ search_file_command_get_property (GObject *object, guint prop_id, GValue *value,
 	case PROP_FILE:
 		g_value_set_object (value, cmd->priv->file);
 		break;
-	case PROP_PATTERN:
-		g_value_set_string (value, cmd->priv->pattern);
+	case PROP_REGEX:
+		g_value_set_boxed (value, cmd->priv->regex);
+		break;
+	case PROP_LITERAL:
+		g_value_set_string (value, cmd->priv->literal);
 		break;
 	case PROP_REPLACE:
 		g_value_set_string (value, cmd->priv->replace);
@@ -268,9 +383,6 @@ search_file_command_get_property (GObject *object, guint prop_id, GValue *value,
 	case PROP_CASE_SENSITIVE:
 		g_value_set_boolean (value, cmd->priv->case_sensitive);
 		break;
-	case PROP_REGEX:
-		g_value_set_boolean (value, cmd->priv->regex);
-		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -296,10 +408,19 @@ search_file_command_class_init (SearchFileCommandClass *klass)
 	                                                      G_PARAM_WRITABLE | G_PARAM_READABLE | G_PARAM_CONSTRUCT_ONLY));
 
 	g_object_class_install_property (object_class,
-	                                 PROP_PATTERN,
-	                                 g_param_spec_string ("pattern", "", "",
+	                                 PROP_REGEX,
+	                                 g_param_spec_boxed ("regex", "",
+	                                                     "Compiled pattern, shared by the commands of a search",
+	                                                     G_TYPE_REGEX,
+	                                                     G_PARAM_WRITABLE | G_PARAM_READABLE | G_PARAM_CONSTRUCT_ONLY));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_LITERAL,
+	                                 g_param_spec_string ("literal", "",
+	                                                      "Text contained by all the matches or NULL",
 	                                                       NULL,
 	                                                       G_PARAM_WRITABLE | G_PARAM_READABLE | G_PARAM_CONSTRUCT_ONLY));
+
 	g_object_class_install_property (object_class,
 	                                 PROP_REPLACE,
 	                                 g_param_spec_string ("replace", "", "",
@@ -311,31 +432,83 @@ search_file_command_class_init (SearchFileCommandClass *klass)
 	                                 g_param_spec_boolean ("case-sensitive", "", "",
 	                                                       TRUE,
 	                                                       G_PARAM_WRITABLE | G_PARAM_READABLE | G_PARAM_CONSTRUCT_ONLY));
-	
-	g_object_class_install_property (object_class,
-	                                 PROP_REGEX,
-	                                 g_param_spec_boolean ("regex", "", "",
-	                                                       FALSE,
-	                                                      G_PARAM_WRITABLE | G_PARAM_READABLE | G_PARAM_CONSTRUCT_ONLY));
 
 	command_class->run = search_file_command_run;
 
 	g_type_class_add_private (klass, sizeof(SearchFileCommandPrivate));
 }
 
+GRegex*
+search_file_command_compile (const gchar* pattern, gboolean case_sensitive,
+                             gboolean regex, GError** error)
+{
+	GRegexCompileFlags flags = G_REGEX_MULTILINE | G_REGEX_OPTIMIZE;
+	GRegex* compiled;
+	gchar* escaped = NULL;
+
+	g_return_val_if_fail (pattern != NULL, NULL);
+
+	if (!regex)
+		pattern = escaped = g_regex_escape_string (pattern, -1);
+	if (!case_sensitive)
+		flags |= G_REGEX_CASELESS;
+
+	compiled = g_regex_new (pattern, flags, 0, error);
+	g_free (escaped);
+
+	return compiled;
+}
+
+gchar*
+search_file_command_get_literal (const gchar* pattern, gboolean case_sensitive,
+                                 gboolean regex)
+{
+	const gchar* c;
+
+	g_return_val_if_fail (pattern != NULL, NULL);
+
+	if (*pattern == '\0')
+		return NULL;
+
+	if (regex)
+	{
+		/* Only regular expressions without any special character are
+		 * plain text */
+		gchar* escaped = g_regex_escape_string (pattern, -1);
+		gboolean plain = strcmp (escaped, pattern) == 0;
+
+		g_free (escaped);
+		if (!plain)
+			return NULL;
+	}
+
+	if (!case_sensitive)
+	{
+		/* ASCII folding misses the non-ASCII characters matching a letter,
+		 * like the Kelvin sign or the long s */
+		for (c = pattern; *c != '\0'; c++)
+		{
+			if ((guchar) *c >= 0x80 || g_ascii_tolower (*c) == 'k' ||
+			    g_ascii_tolower (*c) == 's')
+				return NULL;
+		}
+	}
+
+	return g_strdup (pattern);
+}
 
 SearchFileCommand*
-search_file_command_new (GFile* file, const gchar* pattern, 
-                         const gchar* replace, gboolean case_sensitive, gboolean regex)
+search_file_command_new (GFile* file, GRegex* regex, const gchar* literal,
+                         gboolean case_sensitive, const gchar* replace)
 {
 	SearchFileCommand* command;
 
 	command = SEARCH_FILE_COMMAND (g_object_new (SEARCH_TYPE_FILE_COMMAND,
 	                                             "file", file,
-	                                             "pattern", pattern,
-	                                             "replace", replace,
+	                                             "regex", regex,
+	                                             "literal", literal,
 	                                             "case-sensitive", case_sensitive,
-	                                             "regex", regex, NULL));
+	                                             "replace", replace, NULL));
 	return command;
 }
 
@@ -345,4 +518,19 @@ search_file_command_get_n_matches (SearchFileCommand* cmd)
 	g_return_val_if_fail (cmd != NULL && SEARCH_IS_FILE_COMMAND (cmd), 0);
 
 	return cmd->priv->n_matches;
-}
\ No newline at end of file
+}
+
+GList*
+search_file_command_take_matches (SearchFileCommand* cmd)
+{
+	GList* matches;
+
+	g_return_val_if_fail (cmd != NULL && SEARCH_IS_FILE_COMMAND (cmd), NULL);
+
+	anjuta_async_command_lock (ANJUTA_ASYNC_COMMAND (cmd));
+	matches = cmd->priv->matches->head;
+	g_queue_init (cmd->priv->matches);
+	anjuta_async_command_unlock (ANJUTA_ASYNC_COMMAND (cmd));
+
+	return matches;
+}
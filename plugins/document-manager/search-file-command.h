@@ -48,13 +48,33 @@ struct _SearchFileCommand
 	SearchFileCommandPrivate* priv;
 };
 
+/* Match reported by a search, line and column start at 1 */
+typedef struct _SearchFileMatch SearchFileMatch;
+
+struct _SearchFileMatch
+{
+	gint line;
+	gint column;
+	gchar* context;
+};
+
+void search_file_match_free (SearchFileMatch* match);
+
 GType search_file_command_get_type (void) G_GNUC_CONST;
+GRegex* search_file_command_compile (const gchar* pattern,
+                                     gboolean case_sensitive,
+                                     gboolean regex,
+                                     GError** error);
+gchar* search_file_command_get_literal (const gchar* pattern,
+                                       gboolean case_sensitive,
+                                       gboolean regex);
 SearchFileCommand* search_file_command_new (GFile* file, 
-                                            const gchar* pattern, 
-                                            const gchar* replace,
+                                            GRegex* regex,
+                                            const gchar* literal,
                                             gboolean case_sensitive,
-                                            gboolean regex);
+                                            const gchar* replace);
 gint search_file_command_get_n_matches (SearchFileCommand* cmd);
+GList* search_file_command_take_matches (SearchFileCommand* cmd);
 
 G_END_DECLS
 
@@ -29,6 +29,10 @@
 
 #define TEXT_MIME_TYPE "text/*"
 
+/* Commands are spread over several queues run at the same time, each
+ * running command has a thread of its own */
+#define SEARCH_FILES_QUEUES 4
+
 struct _SearchFilesPrivate
 {
 	GtkBuilder* builder;
@@ -89,9 +93,23 @@ enum
 	COLUMN_FILE,
 	COLUMN_ERROR_TOOLTIP,
 	COLUMN_ERROR_CODE,
+	COLUMN_LINE,
+	COLUMN_COLUMN,
 	N_COLUMNS
 };
 
+/* Rows of the files are at the top level, with their matches as children
+ * having a non zero COLUMN_LINE */
+
+typedef struct
+{
+	SearchFiles* sf;
+	AnjutaCommandQueue* queues[SEARCH_FILES_QUEUES];
+	guint next_queue;
+	guint n_running;
+	void (*finished) (SearchFiles* sf);
+} SearchFilesPool;
+
 G_DEFINE_TYPE (SearchFiles, search_files, G_TYPE_OBJECT);
 
 G_MODULE_EXPORT void search_files_search_clicked (SearchFiles* sf);
@@ -100,6 +118,60 @@ G_MODULE_EXPORT void search_files_update_ui (SearchFiles* sf);
 G_MODULE_EXPORT gboolean search_files_key_pressed (GtkWidget *widget, GdkEventKey *event, gpointer user_data);
 
 
+static SearchFilesPool*
+search_files_pool_new (SearchFiles* sf, void (*finished) (SearchFiles* sf))
+{
+	SearchFilesPool* pool = g_slice_new0 (SearchFilesPool);
+	gint i;
+
+	pool->sf = sf;
+	pool->finished = finished;
+	for (i = 0; i < SEARCH_FILES_QUEUES; i++)
+		pool->queues[i] = anjuta_command_queue_new (ANJUTA_COMMAND_QUEUE_EXECUTE_MANUAL);
+
+	return pool;
+}
+
+static void
+search_files_pool_push (SearchFilesPool* pool, AnjutaCommand* command)
+{
+	anjuta_command_queue_push (pool->queues[pool->next_queue], command);
+	pool->next_queue = (pool->next_queue + 1) % SEARCH_FILES_QUEUES;
+}
+
+static void
+search_files_pool_queue_finished (SearchFilesPool* pool)
+{
+	gint i;
+
+	if (--pool->n_running > 0)
+		return;
+
+	for (i = 0; i < SEARCH_FILES_QUEUES; i++)
+		g_object_unref (pool->queues[i]);
+	pool->finished (pool->sf);
+	g_slice_free (SearchFilesPool, pool);
+}
+
+/* The pool is freed once all its queues are finished, possibly before
+ * returning if there's nothing to run */
+static void
+search_files_pool_start (SearchFilesPool* pool)
+{
+	gint i;
+
+	pool->n_running = 1;
+	for (i = 0; i < SEARCH_FILES_QUEUES; i++)
+	{
+		g_signal_connect_swapped (pool->queues[i], "finished",
+		                          G_CALLBACK (search_files_pool_queue_finished),
+		                          pool);
+		if (anjuta_command_queue_start (pool->queues[i]))
+			pool->n_running++;
+	}
+	search_files_pool_queue_finished (pool);
+}
+
 void
 search_files_update_ui (SearchFiles* sf)
 {
@@ -151,6 +223,7 @@ search_files_check_column_toggled (GtkCellRendererToggle* renderer,
 	GtkTreePath* tree_path;
 	GtkTreeIter iter;
 	gboolean state;
+	gint line;
 
 	if (sf->priv->busy)
 		return;
@@ -161,20 +234,22 @@ search_files_check_column_toggled (GtkCellRendererToggle* renderer,
 	gtk_tree_path_free(tree_path);
 
 	gtk_tree_model_get (sf->priv->files_model, &iter,
-	                    COLUMN_SELECTED, &state, -1);
+	                    COLUMN_SELECTED, &state,
+	                    COLUMN_LINE, &line, -1);
+	if (line)
+		return;
 
-	gtk_list_store_set (GTK_LIST_STORE (sf->priv->files_model), &iter,
+	gtk_tree_store_set (GTK_TREE_STORE (sf->priv->files_model), &iter,
 	                    COLUMN_SELECTED, !state,
 	                    -1);
 }
 
 static void
-search_files_finished (SearchFiles* sf, AnjutaCommandQueue* queue)
+search_files_finished (SearchFiles* sf)
 {
 	GtkAdjustment* h_adj;
 	GtkAdjustment* v_adj;
 
-	g_object_unref (queue);
 	sf->priv->busy = FALSE;
 
 	/* Scroll to first item */
@@ -188,6 +263,63 @@ search_files_finished (SearchFiles* sf, AnjutaCommandQueue* queue)
 	search_files_update_ui(sf);
 }
 
+static void
+search_files_command_data_arrived (SearchFileCommand* cmd,
+                                   SearchFiles* sf)
+{
+	GtkTreeStore* store = GTK_TREE_STORE (sf->priv->files_model);
+	GtkTreeIter parent;
+	GtkTreeIter iter;
+	GtkTreeRowReference* tree_ref;
+	GtkTreePath* path;
+	GFile* file;
+	GList* matches;
+	GList* node;
+
+	tree_ref = g_object_get_data (G_OBJECT (cmd),
+	                              "__tree_ref");
+	matches = search_file_command_take_matches (cmd);
+	if (tree_ref == NULL || matches == NULL)
+	{
+		g_list_free_full (matches, (GDestroyNotify) search_file_match_free);
+		return;
+	}
+
+	path = gtk_tree_row_reference_get_path(tree_ref);
+	gtk_tree_model_get_iter(sf->priv->files_model, &parent, path);
+	gtk_tree_path_free(path);
+	gtk_tree_model_get (sf->priv->files_model, &parent,
+	                    COLUMN_FILE, &file, -1);
+
+	for (node = matches; node != NULL; node = g_list_next (node))
+	{
+		SearchFileMatch* match = node->data;
+
+		gtk_tree_store_append (store, &iter, &parent);
+		gtk_tree_store_set (store, &iter,
+		                    COLUMN_SELECTED, FALSE,
+		                    COLUMN_FILENAME, match->context,
+		                    COLUMN_FILE, file,
+		                    COLUMN_COUNT, 1,
+		                    COLUMN_SPINNER, FALSE,
+		                    COLUMN_PULSE, FALSE,
+		                    COLUMN_ERROR_CODE, 0,
+		                    COLUMN_LINE, match->line,
+		                    COLUMN_COLUMN, match->column,
+		                    -1);
+	}
+
+	/* Show the matches found so far */
+	gtk_tree_store_set (store, &parent,
+	                    COLUMN_COUNT,
+	                    gtk_tree_model_iter_n_children (sf->priv->files_model,
+	                                                    &parent),
+	                    -1);
+
+	g_object_unref (file);
+	g_list_free_full (matches, (GDestroyNotify) search_file_match_free);
+}
+
 static void
 search_files_command_finished (SearchFileCommand* cmd,
                                guint return_code,
@@ -197,12 +329,16 @@ search_files_command_finished (SearchFileCommand* cmd,
 	GtkTreeRowReference* tree_ref;
 	GtkTreePath* path;
 
+	/* Take the matches not notified yet */
+	search_files_command_data_arrived (cmd, sf);
+
 	tree_ref = g_object_get_data (G_OBJECT (cmd),
 	                              "__tree_ref");
+	g_object_set_data (G_OBJECT (cmd), "__tree_ref", NULL);
 	path = gtk_tree_row_reference_get_path(tree_ref);
 
 	gtk_tree_model_get_iter(sf->priv->files_model, &iter, path);
-	gtk_list_store_set (GTK_LIST_STORE (sf->priv->files_model),
+	gtk_tree_store_set (GTK_TREE_STORE (sf->priv->files_model),
 	                    &iter,
 	                    COLUMN_COUNT, search_file_command_get_n_matches(cmd),
 	                    COLUMN_ERROR_CODE, return_code,
@@ -213,7 +349,7 @@ search_files_command_finished (SearchFileCommand* cmd,
 
 	if (return_code)
 	{
-		gtk_list_store_set (GTK_LIST_STORE (sf->priv->files_model),
+		gtk_tree_store_set (GTK_TREE_STORE (sf->priv->files_model),
 		                    &iter,
 		                    COLUMN_ERROR_CODE, return_code,
 		                    COLUMN_ERROR_TOOLTIP,
@@ -224,146 +360,135 @@ search_files_command_finished (SearchFileCommand* cmd,
 	g_object_unref (cmd);
 }
 
+/* Searches the selected files, replacing the matches if replace is not NULL */
 static void
-search_files_search (SearchFiles* sf)
+search_files_run (SearchFiles* sf, const gchar* replace)
 {
+	GtkTreeStore* store = GTK_TREE_STORE (sf->priv->files_model);
 	GtkTreeIter iter;
+	const gchar* pattern =
+		gtk_entry_get_text (GTK_ENTRY (sf->priv->search_entry));
+	SearchFilesPool* pool;
+	GRegex* regex;
+	gchar* literal;
+	gchar* escaped_replace = NULL;
+	GError* error = NULL;
 
-	if (gtk_tree_model_get_iter_first(sf->priv->files_model, &iter))
+	if (!gtk_tree_model_get_iter_first(sf->priv->files_model, &iter))
 	{
-		AnjutaCommandQueue* queue = anjuta_command_queue_new(ANJUTA_COMMAND_QUEUE_EXECUTE_MANUAL);
-		const gchar* pattern =
-			gtk_entry_get_text (GTK_ENTRY (sf->priv->search_entry));
-		do
-		{
-			GFile* file;
-			gboolean selected;
-
-			/* Save the current values */
-			sf->priv->regex =
-				gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON (sf->priv->regex_check));
-			sf->priv->case_sensitive =
-				gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON (sf->priv->case_check));
-
-			g_free (sf->priv->last_search_string);
-			sf->priv->last_search_string = g_strdup(pattern);
-			g_free (sf->priv->last_replace_string);
-			sf->priv->last_replace_string = NULL;
-
-			gtk_tree_model_get (sf->priv->files_model, &iter,
-			                    COLUMN_FILE, &file,
-			                    COLUMN_SELECTED, &selected, -1);
-			if (selected)
-			{
-				GtkTreePath* path;
-				GtkTreeRowReference* ref;
+		search_files_finished (sf);
+		return;
+	}
 
-				path = gtk_tree_model_get_path(sf->priv->files_model, &iter);
-				ref = gtk_tree_row_reference_new(sf->priv->files_model,
-				                                 path);
-				gtk_tree_path_free(path);
+	/* Save the current values */
+	sf->priv->regex =
+		gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON (sf->priv->regex_check));
+	sf->priv->case_sensitive =
+		gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON (sf->priv->case_check));
 
+	g_free (sf->priv->last_search_string);
+	sf->priv->last_search_string = g_strdup(pattern);
+	g_free (sf->priv->last_replace_string);
+	sf->priv->last_replace_string = g_strdup(replace);
+
+	/* The pattern is compiled once and shared by all the commands */
+	regex = search_file_command_compile (pattern,
+	                                     sf->priv->case_sensitive,
+	                                     sf->priv->regex,
+	                                     &error);
+	literal = search_file_command_get_literal (pattern,
+	                                           sf->priv->case_sensitive,
+	                                           sf->priv->regex);
+	if (replace && !sf->priv->regex)
+		replace = escaped_replace = g_regex_escape_string (replace, -1);
+
+	/* Rows must not move while they are updated */
+	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE (sf->priv->files_model),
+	                                     GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID,
+	                                     GTK_SORT_DESCENDING);
 
-				SearchFileCommand* cmd = search_file_command_new(file,
-				                                                 pattern,
-				                                                 NULL,
-				                                                 sf->priv->case_sensitive,
-				                                                 sf->priv->regex);
-				g_object_set_data (G_OBJECT (cmd), "__tree_ref",
-				                   ref);
+	pool = search_files_pool_new (sf, search_files_finished);
+	do
+	{
+		GFile* file;
+		gboolean selected;
+		GtkTreeIter child;
 
-				g_signal_connect (cmd, "command-finished",
-				                  G_CALLBACK(search_files_command_finished), sf);
+		gtk_tree_model_get (sf->priv->files_model, &iter,
+		                    COLUMN_FILE, &file,
+		                    COLUMN_SELECTED, &selected, -1);
 
-				anjuta_command_queue_push(queue,
-				                          ANJUTA_COMMAND(cmd));
-			}
-			g_object_unref (file);
+		/* Drop the matches of the previous search */
+		while (gtk_tree_model_iter_children (sf->priv->files_model, &child, &iter))
+			gtk_tree_store_remove (store, &child);
+
+		if (selected && error)
+		{
+			gtk_tree_store_set (store, &iter,
+			                    COLUMN_COUNT, 0,
+			                    COLUMN_ERROR_CODE, error->code ? error->code : 1,
+			                    COLUMN_ERROR_TOOLTIP, error->message,
+			                    -1);
 		}
-		while (gtk_tree_model_iter_next(sf->priv->files_model, &iter));
+		else if (selected)
+		{
+			GtkTreePath* path;
+			GtkTreeRowReference* ref;
+
+			path = gtk_tree_model_get_path(sf->priv->files_model, &iter);
+			ref = gtk_tree_row_reference_new(sf->priv->files_model,
+			                                 path);
+			gtk_tree_path_free(path);
+
+			gtk_tree_store_set (store, &iter,
+			                    COLUMN_COUNT, 0, -1);
+
+			SearchFileCommand* cmd = search_file_command_new(file,
+			                                                 regex,
+			                                                 literal,
+			                                                 sf->priv->case_sensitive,
+			                                                 replace);
+			g_object_set_data (G_OBJECT (cmd), "__tree_ref",
+			                   ref);
+
+			g_signal_connect (cmd, "data-arrived",
+			                  G_CALLBACK(search_files_command_data_arrived), sf);
+			g_signal_connect (cmd, "command-finished",
+			                  G_CALLBACK(search_files_command_finished), sf);
 
-		g_signal_connect_swapped (queue, "finished", G_CALLBACK (search_files_finished), sf);
+			search_files_pool_push (pool, ANJUTA_COMMAND(cmd));
+		}
+		g_object_unref (file);
+	}
+	while (gtk_tree_model_iter_next(sf->priv->files_model, &iter));
 
-		anjuta_command_queue_start (queue);
-		gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE (sf->priv->files_model),
-		                                     COLUMN_COUNT,
-		                                     GTK_SORT_DESCENDING);
+	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE (sf->priv->files_model),
+	                                     COLUMN_COUNT,
+	                                     GTK_SORT_DESCENDING);
 
-		sf->priv->busy = TRUE;
-		search_files_update_ui(sf);
-	}
+	sf->priv->busy = TRUE;
+	search_files_update_ui(sf);
+	search_files_pool_start (pool);
+
+	if (regex)
+		g_regex_unref (regex);
+	else
+		g_error_free (error);
+	g_free (literal);
+	g_free (escaped_replace);
+}
+
+static void
+search_files_search (SearchFiles* sf)
+{
+	search_files_run (sf, NULL);
 }
 
 void
 search_files_replace_clicked (SearchFiles* sf)
 {
-	GtkTreeIter iter;
-
-	if (gtk_tree_model_get_iter_first(sf->priv->files_model, &iter))
-	{
-		AnjutaCommandQueue* queue = anjuta_command_queue_new(ANJUTA_COMMAND_QUEUE_EXECUTE_MANUAL);
-		const gchar* pattern =
-			gtk_entry_get_text (GTK_ENTRY (sf->priv->search_entry));
-		const gchar* replace =
-			gtk_entry_get_text (GTK_ENTRY (sf->priv->replace_entry));
-		do
-		{
-			GFile* file;
-			gboolean selected;
-
-			/* Save the current values */
-			sf->priv->regex =
-				gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON (sf->priv->regex_check));
-			sf->priv->case_sensitive =
-				gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON (sf->priv->case_check));
-
-			g_free (sf->priv->last_search_string);
-			sf->priv->last_search_string = g_strdup(pattern);
-			g_free (sf->priv->last_replace_string);
-			sf->priv->last_replace_string = g_strdup(replace);
-
-			gtk_tree_model_get (sf->priv->files_model, &iter,
-			                    COLUMN_FILE, &file,
-			                    COLUMN_SELECTED, &selected, -1);
-			if (selected)
-			{
-				GtkTreePath* path;
-				GtkTreeRowReference* ref;
-
-				path = gtk_tree_model_get_path(sf->priv->files_model, &iter);
-				ref = gtk_tree_row_reference_new(sf->priv->files_model,
-				                                 path);
-				gtk_tree_path_free(path);
-
-
-				SearchFileCommand* cmd = search_file_command_new(file,
-				                                                 pattern,
-				                                                 replace,
-				                                                 sf->priv->case_sensitive,
-				                                                 sf->priv->regex);
-				g_object_set_data (G_OBJECT (cmd), "__tree_ref",
-				                   ref);
-
-				g_signal_connect (cmd, "command-finished",
-				                  G_CALLBACK(search_files_command_finished), sf);
-
-				anjuta_command_queue_push(queue,
-				                          ANJUTA_COMMAND(cmd));
-			}
-			g_object_unref (file);
-		}
-		while (gtk_tree_model_iter_next(sf->priv->files_model, &iter));
-
-		g_signal_connect_swapped (queue, "finished", G_CALLBACK (search_files_finished), sf);
-
-		anjuta_command_queue_start (queue);
-		gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE (sf->priv->files_model),
-		                                     COLUMN_COUNT,
-		                                     GTK_SORT_DESCENDING);
-
-		sf->priv->busy = TRUE;
-		search_files_update_ui(sf);
-	}
+	search_files_run (sf,
+	                  gtk_entry_get_text (GTK_ENTRY (sf->priv->replace_entry)));
 }
 
 static void
@@ -388,25 +513,24 @@ search_files_filter_command_finished (SearchFilterFileCommand* cmd,
 	if (!display_name)
 		display_name = g_file_get_path (G_FILE(file));
 
-	gtk_list_store_append(GTK_LIST_STORE (sf->priv->files_model),
-	                      &iter);
-	gtk_list_store_set (GTK_LIST_STORE (sf->priv->files_model), &iter,
+	gtk_tree_store_append(GTK_TREE_STORE (sf->priv->files_model),
+	                      &iter, NULL);
+	gtk_tree_store_set (GTK_TREE_STORE (sf->priv->files_model), &iter,
 	                    COLUMN_SELECTED, TRUE,
 	                    COLUMN_FILENAME, display_name,
 	                    COLUMN_FILE, file,
 	                    COLUMN_COUNT, 0,
 	                    COLUMN_SPINNER, FALSE,
-	                    COLUMN_PULSE, FALSE, -1);
+	                    COLUMN_PULSE, FALSE,
+	                    COLUMN_LINE, 0, -1);
 
 	g_object_unref (file);
 	g_free (display_name);
 }
 
 static void
-search_files_filter_finished (AnjutaCommandQueue* queue,
-                              SearchFiles* sf)
+search_files_filter_finished (SearchFiles* sf)
 {
-	g_object_unref (queue);
 	search_files_search (sf);
 }
 
@@ -418,7 +542,7 @@ search_files_search_clicked (SearchFiles* sf)
 	GList* files = NULL;
 	GList* file;
 	gchar* project_uri;
-	AnjutaCommandQueue* queue;
+	SearchFilesPool* pool;
 	gchar* mime_types;
 	GtkComboBox* type_combo;
 	GtkTreeIter iter;
@@ -426,7 +550,7 @@ search_files_search_clicked (SearchFiles* sf)
 	g_return_if_fail (sf != NULL && SEARCH_IS_FILES (sf));
 
 	/* Clear store */
-	gtk_list_store_clear(GTK_LIST_STORE (sf->priv->files_model));
+	gtk_tree_store_clear(GTK_TREE_STORE (sf->priv->files_model));
 	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE (sf->priv->files_model),
 	                                     COLUMN_FILENAME,
 	                                     GTK_SORT_DESCENDING);
@@ -467,9 +591,7 @@ search_files_search_clicked (SearchFiles* sf)
 	if (files != NULL)
 	{
 		/* Queue file filtering */
-		queue = anjuta_command_queue_new(ANJUTA_COMMAND_QUEUE_EXECUTE_MANUAL);
-		g_signal_connect (queue, "finished",
-	    	              G_CALLBACK (search_files_filter_finished), sf);
+		pool = search_files_pool_new (sf, search_files_filter_finished);
 		for (file = files; file != NULL; file = g_list_next (file))
 		{	
 			SearchFilterFileCommand* cmd =
@@ -482,11 +604,11 @@ search_files_search_clicked (SearchFiles* sf)
 			
 			g_signal_connect (cmd, "command-finished",
 		    	              G_CALLBACK (search_files_filter_command_finished), sf);
-			anjuta_command_queue_push(queue, ANJUTA_COMMAND(cmd));
+			search_files_pool_push (pool, ANJUTA_COMMAND(cmd));
 		}
 		sf->priv->busy = TRUE;
 		search_files_update_ui(sf);
-		anjuta_command_queue_start (queue);
+		search_files_pool_start (pool);
 
 		g_list_foreach (files, (GFunc) g_object_unref, NULL);
 		g_list_free (files);
@@ -503,16 +625,89 @@ search_files_render_count (GtkTreeViewColumn *tree_column,
                            gpointer data)
 {
 	int count;
+	int line;
+	int column;
 	gchar* count_str;
 
 	gtk_tree_model_get (tree_model, iter,
 	                    COLUMN_COUNT, &count,
+	                    COLUMN_LINE, &line,
+	                    COLUMN_COLUMN, &column,
 	                    -1);
-	count_str = g_strdup_printf("%d", count);
+	/* Matches show their position instead */
+	if (line)
+		count_str = g_strdup_printf("%d:%d", line, column);
+	else
+		count_str = g_strdup_printf("%d", count);
 	g_object_set (cell, "text", count_str, NULL);
 	g_free (count_str);
 }
 
+static void
+search_files_render_selected (GtkTreeViewColumn *tree_column,
+                              GtkCellRenderer *cell,
+                              GtkTreeModel *tree_model,
+                              GtkTreeIter *iter,
+                              gpointer data)
+{
+	int line;
+
+	gtk_tree_model_get (tree_model, iter,
+	                    COLUMN_LINE, &line,
+	                    -1);
+	g_object_set (cell, "visible", line == 0, NULL);
+}
+
+static gint
+search_files_sort_func (GtkTreeModel *model,
+                        GtkTreeIter *a,
+                        GtkTreeIter *b,
+                        gpointer data)
+{
+	gint column = GPOINTER_TO_INT (data);
+	gint line_a;
+	gint line_b;
+	gint result;
+
+	gtk_tree_model_get (model, a, COLUMN_LINE, &line_a, -1);
+	gtk_tree_model_get (model, b, COLUMN_LINE, &line_b, -1);
+
+	if (line_a || line_b)
+	{
+		GtkSortType order;
+
+		/* Matches stay in file order whatever the sorting */
+		gtk_tree_sortable_get_sort_column_id (GTK_TREE_SORTABLE (model),
+		                                      NULL, &order);
+		result = line_a - line_b;
+		return order == GTK_SORT_DESCENDING ? -result : result;
+	}
+
+	if (column == COLUMN_FILENAME)
+	{
+		gchar* name_a;
+		gchar* name_b;
+
+		gtk_tree_model_get (model, a, COLUMN_FILENAME, &name_a, -1);
+		gtk_tree_model_get (model, b, COLUMN_FILENAME, &name_b, -1);
+		result = g_utf8_collate (name_a ? name_a : "", name_b ? name_b : "");
+		g_free (name_a);
+		g_free (name_b);
+	}
+	else
+	{
+		gint value_a;
+		gint value_b;
+
+		/* COLUMN_SELECTED and COLUMN_COUNT */
+		gtk_tree_model_get (model, a, column, &value_a, -1);
+		gtk_tree_model_get (model, b, column, &value_b, -1);
+		result = value_a - value_b;
+	}
+
+	return result;
+}
+
 static void
 search_files_editor_loaded (SearchFiles* sf, IAnjutaEditor* editor)
 {
@@ -552,10 +747,12 @@ search_files_result_activated (GtkTreeView* files_tree,
 	IAnjutaDocument* editor;
 	GFile* file;
 	GtkTreeIter iter;
+	gint line;
 
 	gtk_tree_model_get_iter (sf->priv->files_model, &iter, path);
 	gtk_tree_model_get (sf->priv->files_model, &iter,
-	                    COLUMN_FILE, &file, -1);
+	                    COLUMN_FILE, &file,
+	                    COLUMN_LINE, &line, -1);
 
 	/* Check if document is open */
 	editor = anjuta_docman_get_document_for_file(sf->priv->docman, file);
@@ -564,12 +761,14 @@ search_files_result_activated (GtkTreeView* files_tree,
 	{
 		anjuta_docman_present_notebook_page(sf->priv->docman,
 		                                    editor);
+		if (line)
+			ianjuta_editor_goto_line (IANJUTA_EDITOR(editor), line, NULL);
 		search_files_editor_loaded (sf, IANJUTA_EDITOR(editor));
 	}
 	else
 	{
 		IAnjutaEditor* real_editor =
-			anjuta_docman_goto_file_line(sf->priv->docman, file, 0);
+			anjuta_docman_goto_file_line(sf->priv->docman, file, line);
 		if (real_editor)
 			g_signal_connect_swapped (real_editor, "opened",
 			                          G_CALLBACK (search_files_editor_loaded), sf);
@@ -605,6 +804,11 @@ search_files_init_tree (SearchFiles* sf)
 	                                   selection_renderer,
 	                                   "active",
 	                                   COLUMN_SELECTED);
+	gtk_tree_view_column_set_cell_data_func(column_select,
+	                                        selection_renderer,
+	                                        search_files_render_selected,
+	                                        NULL,
+	                                        NULL);
 	g_signal_connect (selection_renderer, "toggled",
 	                  G_CALLBACK(search_files_check_column_toggled), sf);
 	gtk_tree_view_column_set_sort_column_id(column_select,
@@ -656,7 +860,7 @@ search_files_init_tree (SearchFiles* sf)
 	gtk_tree_view_column_set_sort_column_id(column_count,
 	                                        COLUMN_COUNT);
 
-	sf->priv->files_model = GTK_TREE_MODEL (gtk_list_store_new (N_COLUMNS,
+	sf->priv->files_model = GTK_TREE_MODEL (gtk_tree_store_new (N_COLUMNS,
 	                                                            G_TYPE_BOOLEAN,
 	                                                            G_TYPE_STRING,
 	                                                            G_TYPE_INT,
@@ -664,7 +868,18 @@ search_files_init_tree (SearchFiles* sf)
 	                                                            G_TYPE_BOOLEAN,
 	                                                            G_TYPE_FILE,
 	                                                            G_TYPE_STRING,
+	                                                            G_TYPE_INT,
+	                                                            G_TYPE_INT,
 	                                                            G_TYPE_INT));
+	gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (sf->priv->files_model),
+	                                 COLUMN_SELECTED, search_files_sort_func,
+	                                 GINT_TO_POINTER (COLUMN_SELECTED), NULL);
+	gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (sf->priv->files_model),
+	                                 COLUMN_FILENAME, search_files_sort_func,
+	                                 GINT_TO_POINTER (COLUMN_FILENAME), NULL);
+	gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (sf->priv->files_model),
+	                                 COLUMN_COUNT, search_files_sort_func,
+	                                 GINT_TO_POINTER (COLUMN_COUNT), NULL);
 	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE (sf->priv->files_model),
 	                                     COLUMN_FILENAME,
 	                                     GTK_SORT_DESCENDING);
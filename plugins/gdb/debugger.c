@@ -117,6 +117,8 @@ struct _DebuggerPriv
 	/* GDB command queue */
 	GList *cmd_queqe;
 	DebuggerCommand current_cmd;
+	GQueue *pipeline;			/* Commands sent after the current one */
+	guint last_token;
 	gboolean skip_next_prompt;
 	gboolean command_output_sent;
 	
@@ -292,6 +294,8 @@ debugger_initialize (Debugger *debugger)
 	debugger->priv->current_cmd.parser = NULL;
 	
 	debugger->priv->cmd_queqe = NULL;
+	debugger->priv->pipeline = g_queue_new ();
+	debugger->priv->last_token = 0;
 	debugger->priv->cli_lines = NULL;
 	debugger->priv->solib_event = FALSE;
 	
@@ -590,6 +594,21 @@ debugger_queue_get_next_command (Debugger *debugger)
 	return dc;
 }
 
+/* Make dc the command whose answer is expected */
+static void
+debugger_queue_set_current_command (Debugger *debugger, DebuggerCommand *dc)
+{
+	g_free (debugger->priv->current_cmd.cmd);
+	debugger->priv->current_cmd.cmd = dc->cmd;
+	debugger->priv->current_cmd.parser = dc->parser;
+	debugger->priv->current_cmd.callback = dc->callback;
+	debugger->priv->current_cmd.user_data = dc->user_data;
+	debugger->priv->current_cmd.flags = dc->flags;
+	debugger->priv->current_cmd.token = dc->token;
+	debugger->priv->command_output_sent = FALSE;
+	g_free (dc);
+}
+
 static gboolean
 debugger_queue_set_next_command (Debugger *debugger)
 {
@@ -605,16 +624,11 @@ debugger_queue_set_next_command (Debugger *debugger)
 		debugger->priv->current_cmd.callback = NULL;
 		debugger->priv->current_cmd.user_data = NULL;
 		debugger->priv->current_cmd.flags = 0;
+		debugger->priv->current_cmd.token = 0;
 
 		return FALSE;
 	}
-	g_free (debugger->priv->current_cmd.cmd);
-	debugger->priv->current_cmd.cmd = dc->cmd;
-	debugger->priv->current_cmd.parser = dc->parser;
-	debugger->priv->current_cmd.callback = dc->callback;
-	debugger->priv->current_cmd.user_data = dc->user_data;
-	debugger->priv->current_cmd.flags = dc->flags;
-	g_free (dc);
+	debugger_queue_set_current_command (debugger, dc);
 
 	return TRUE;
 }
@@ -638,6 +652,7 @@ debugger_queue_command (Debugger *debugger, const gchar *cmd,
 		dc->callback = callback;
 		dc->user_data = user_data;
 		dc->flags = flags;
+		dc->token = 0;
 	}
 	if (flags & DEBUGGER_COMMAND_PREPEND)
 	{
@@ -666,29 +681,69 @@ debugger_queue_clear (Debugger *debugger)
 	}
 	g_list_free (debugger->priv->cmd_queqe);
 	debugger->priv->cmd_queqe = NULL;
+	while (!g_queue_is_empty (debugger->priv->pipeline))
+	{
+		DebuggerCommand *dc = g_queue_pop_head (debugger->priv->pipeline);
+
+		g_free (dc->cmd);
+		g_free (dc);
+	}
 	g_free (debugger->priv->current_cmd.cmd);
 	debugger->priv->current_cmd.cmd = NULL;
 	debugger->priv->current_cmd.parser = NULL;
 	debugger->priv->current_cmd.callback = NULL;
 	debugger->priv->current_cmd.user_data = NULL;
 	debugger->priv->current_cmd.flags = 0;
+	debugger->priv->current_cmd.token = 0;
 	debugger_clear_buffers (debugger);
 }
 
 static void
-debugger_execute_command (Debugger *debugger, const gchar *command)
+debugger_execute_command (Debugger *debugger, DebuggerCommand *dc)
 {
 	gchar *cmd;
 	
-	DEBUG_PRINT ("In function: debugger_execute_command(%s) %d\n",command, debugger->priv->debugger_is_busy);
+	DEBUG_PRINT ("In function: debugger_execute_command(%s) %d\n",dc->cmd, debugger->priv->debugger_is_busy);
 	debugger->priv->debugger_is_busy++;
-	debugger->priv->command_output_sent = FALSE;
-	cmd = g_strconcat (command, "\n", NULL);
-	debugger_log_command (debugger, cmd);
+	debugger_log_command (debugger, dc->cmd);
+
+	/* Tag MI commands, gdb writes the token back in front of the answer */
+	if (*dc->cmd == '-')
+	{
+		if (++debugger->priv->last_token == 0) debugger->priv->last_token++;
+		dc->token = debugger->priv->last_token;
+		cmd = g_strdup_printf ("%u%s\n", dc->token, dc->cmd);
+	}
+	else
+	{
+		dc->token = 0;
+		cmd = g_strconcat (dc->cmd, "\n", NULL);
+	}
 	anjuta_launcher_send_stdin (debugger->priv->launcher, cmd);
 	g_free (cmd);
 }
 
+/* Read only commands can be sent while the current command is read only too,
+ * their answers come back in the same order */
+static gboolean
+debugger_queue_can_pipeline (Debugger *debugger)
+{
+	DebuggerCommand *dc;
+
+	if ((debugger->priv->current_cmd.cmd == NULL) ||
+		!gdbmi_command_is_read_only (debugger->priv->current_cmd.cmd))
+		return FALSE;
+
+	if (g_queue_get_length (debugger->priv->pipeline) >= MAX_PIPELINED_COMMANDS)
+		return FALSE;
+
+	if (debugger->priv->cmd_queqe == NULL)
+		return FALSE;
+	dc = (DebuggerCommand *)debugger->priv->cmd_queqe->data;
+
+	return gdbmi_command_is_read_only (dc->cmd);
+}
+
 static void
 debugger_queue_execute_command (Debugger *debugger)
 {
@@ -699,7 +754,17 @@ debugger_queue_execute_command (Debugger *debugger)
 	{
 		debugger_clear_buffers (debugger);
 		if (debugger_queue_set_next_command (debugger))
-		debugger_execute_command (debugger, debugger->priv->current_cmd.cmd);
+		debugger_execute_command (debugger, &debugger->priv->current_cmd);
+	}
+
+	/* Do not wait for the answer of the previous command */
+	while (debugger->priv->debugger_is_busy && debugger_queue_can_pipeline (debugger))
+	{
+		DebuggerCommand *dc;
+
+		dc = debugger_queue_get_next_command (debugger);
+		g_queue_push_tail (debugger->priv->pipeline, dc);
+		debugger_execute_command (debugger, dc);
 	}
 }
 
@@ -1080,13 +1145,16 @@ debugger_start (Debugger *debugger,
 	debugger->priv->loading = prog != NULL ? TRUE : FALSE;
 	debugger->priv->debugger_is_busy = 1;
 
-	/* Get environment */
-	plugin_manager = anjuta_shell_get_plugin_manager (ANJUTA_PLUGIN (debugger->priv->instance)->shell, NULL);
+	/* Get environment, the instance is not a plugin in gdbmi-test */
+	plugin_manager = NULL;
+	if (ANJUTA_IS_PLUGIN (debugger->priv->instance))
+		plugin_manager = anjuta_shell_get_plugin_manager (ANJUTA_PLUGIN (debugger->priv->instance)->shell, NULL);
 	if (debugger->priv->environment != NULL)
 	{
 		g_object_unref (debugger->priv->environment);
 	}
-	if (anjuta_plugin_manager_is_active_plugin (plugin_manager, "IAnjutaEnvironment"))
+	if ((plugin_manager != NULL) &&
+		anjuta_plugin_manager_is_active_plugin (plugin_manager, "IAnjutaEnvironment"))
 	{
 		IAnjutaEnvironment *env = IANJUTA_ENVIRONMENT (anjuta_shell_get_object (ANJUTA_PLUGIN (debugger->priv->instance)->shell,
 					"IAnjutaEnvironment", NULL));
@@ -1175,34 +1243,30 @@ debugger_start (Debugger *debugger,
 static void
 gdb_stdout_line_arrived (Debugger *debugger, const gchar * chars)
 {
-	gint i = 0;
+	const gchar *eol;
 
-	while (chars[i])
+	/* Append complete lines at once, the output can be very large */
+	while ((eol = strchr (chars, '\n')) != NULL)
 	{
-		if (chars[i] == '\n')
-		{
-			debugger_stdo_flush (debugger);
-		}
-		else
-		{
-			g_string_append_c (debugger->priv->stdo_line, chars[i]);
-		}
-		i++;
+		g_string_append_len (debugger->priv->stdo_line, chars, eol - chars);
+		debugger_stdo_flush (debugger);
+		chars = eol + 1;
 	}
+	g_string_append (debugger->priv->stdo_line, chars);
 }
 
 static void
 gdb_stderr_line_arrived (Debugger *debugger, const gchar * chars)
 {
-	gint i;
+	const gchar *eol;
 
-	for (i = 0; i < strlen (chars); i++)
+	while ((eol = strchr (chars, '\n')) != NULL)
 	{
-		if (chars[i] == '\n')
-			debugger_stde_flush (debugger);
-		else
-			g_string_append_c (debugger->priv->stde_line, chars[i]);
+		g_string_append_len (debugger->priv->stde_line, chars, eol - chars);
+		debugger_stde_flush (debugger);
+		chars = eol + 1;
 	}
+	g_string_append (debugger->priv->stde_line, chars);
 }
 
 static void
@@ -1560,6 +1624,54 @@ debugger_parse_stopped (Debugger *debugger)
 	}
 }
 
+/* Returns TRUE if a command tagged with token is waiting for its answer
+ * after the current one */
+static gboolean
+debugger_queue_is_pipelined (Debugger *debugger, guint token)
+{
+	GList *node;
+
+	for (node = debugger->priv->pipeline->head; node != NULL; node = g_list_next (node))
+	{
+		if (((DebuggerCommand *)node->data)->token == token)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* The answer of the current command has been lost, report an error to its
+ * parser and wait for the answer of the next command already sent */
+static void
+debugger_queue_fail_current (Debugger *debugger)
+{
+	if (debugger->priv->command_output_sent == FALSE &&
+		debugger->priv->current_cmd.parser)
+	{
+		GError *error;
+
+		error = g_error_new (IANJUTA_DEBUGGER_ERROR,
+		                     IANJUTA_DEBUGGER_OTHER_ERROR,
+		                     "No answer from gdb for command %u",
+		                     debugger->priv->current_cmd.token);
+		debugger->priv->current_cmd.parser (debugger, NULL, NULL, error);
+		debugger->priv->command_output_sent = TRUE;
+		g_error_free (error);
+	}
+
+	debugger->priv->debugger_is_busy--;
+
+	/* Keep the line being parsed */
+	if (!(debugger->priv->current_cmd.flags & DEBUGGER_COMMAND_KEEP_RESULT))
+		g_string_assign (debugger->priv->stdo_acc, "");
+	g_list_foreach (debugger->priv->cli_lines, (GFunc)g_free, NULL);
+	g_list_free (debugger->priv->cli_lines);
+	debugger->priv->cli_lines = NULL;
+
+	debugger_queue_set_current_command (debugger,
+	                                    g_queue_pop_head (debugger->priv->pipeline));
+}
+
 static void
 debugger_parse_prompt (Debugger *debugger)
 {
@@ -1573,6 +1685,15 @@ debugger_parse_prompt (Debugger *debugger)
 	}
 	
 	debugger->priv->debugger_is_busy--;
+
+	/* Wait for the answer of the next command already sent */
+	if (!g_queue_is_empty (debugger->priv->pipeline))
+	{
+		debugger_clear_buffers (debugger);
+		debugger_queue_set_current_command (debugger,
+		                                    g_queue_pop_head (debugger->priv->pipeline));
+	}
+
 	debugger_queue_execute_command (debugger);	/* Next command. Go. */
 	debugger_emit_ready (debugger);
 }
@@ -1697,6 +1818,8 @@ static void
 debugger_stdo_flush (Debugger *debugger)
 {
 	gchar *line;
+	const gchar *record;
+	guint token;
 
 	line = debugger->priv->stdo_line->str;
 
@@ -1705,6 +1828,38 @@ debugger_stdo_flush (Debugger *debugger)
 	#else
 		if (debugger->priv->gdb_log) g_message ("GDB:< %s", line);
 	#endif
+
+	/* Remove the token, the output is always for the current command */
+	token = gdbmi_get_token (line, &record);
+	if (token != 0)
+	{
+		g_string_erase (debugger->priv->stdo_line, 0, record - line);
+		line = debugger->priv->stdo_line->str;
+
+		if ((*line == '^') && (token != debugger->priv->current_cmd.token))
+		{
+			if (debugger_queue_is_pipelined (debugger, token))
+			{
+				/* The answers of the commands sent before are lost, fail
+				 * them so that the queue goes on */
+				g_warning ("Unexpected answer for command %u, waiting for command %u",
+				           token, debugger->priv->current_cmd.token);
+				while (debugger->priv->current_cmd.token != token)
+					debugger_queue_fail_current (debugger);
+			}
+			else
+			{
+				/* Do not give the result to the wrong command, nor its
+				 * prompt */
+				g_warning ("Unexpected answer for unknown command %u, waiting for command %u",
+				           token, debugger->priv->current_cmd.token);
+				debugger->priv->skip_next_prompt = TRUE;
+				g_string_assign (debugger->priv->stdo_line, "");
+				return;
+			}
+		}
+	}
+
 	debugger_log_output (debugger, line);	
 	if (strlen (line) == 0)
 	{
@@ -1827,7 +1982,10 @@ debugger_stdo_flush (Debugger *debugger)
 	}
 	else if (strncasecmp (line, GDB_PROMPT, strlen (GDB_PROMPT)) == 0)
 	{
-		debugger_parse_prompt (debugger);
+		if (debugger->priv->skip_next_prompt)
+			debugger->priv->skip_next_prompt = FALSE;
+		else
+			debugger_parse_prompt (debugger);
 	}
 	else
 	{
@@ -2769,9 +2927,11 @@ debugger_list_breakpoint_finish (Debugger *debugger, const GDBMIValue *mi_result
 	if ((error != NULL) || (mi_results == NULL))
 	{
 		/* Call callback in all case (useful for enable that doesn't return
- 		* anything */
+ 		* anything. The callback must be called only once, a pipelined
+ 		* command is completed by it */
 		if (callback != NULL)
 			callback (NULL, user_data, error);
+		return;
 	}
 
 	table = gdbmi_value_hash_lookup (mi_results, "BreakpointTable");
@@ -3364,7 +3524,11 @@ debugger_stack_finish (Debugger *debugger, const GDBMIValue *mi_results, const G
 	gpointer user_data = debugger->priv->current_cmd.user_data;
 
 	if (!mi_results)
+	{
+		if (callback != NULL)
+			callback (NULL, user_data, error);
 		return;
+	}
 	
 	stack_list = gdbmi_value_hash_lookup (mi_results, "stack");
 	if (stack_list)
@@ -3679,7 +3843,11 @@ debugger_register_name_finish (Debugger *debugger, const GDBMIValue *mi_results,
 	gpointer user_data = debugger->priv->current_cmd.user_data;
 	
 	if (!mi_results)
+	{
+		if (callback != NULL)
+			callback (NULL, user_data, error);
 		return;
+	}
 	
 	reg_list = gdbmi_value_hash_lookup (mi_results, "register-names");
 	if (reg_list)
@@ -3709,7 +3877,11 @@ debugger_register_value_finish (Debugger *debugger, const GDBMIValue *mi_results
 	gpointer user_data = debugger->priv->current_cmd.user_data;
 	
 	if (!mi_results)
+	{
+		if (callback != NULL)
+			callback (NULL, user_data, error);
 		return;
+	}
 	
 	reg_list = gdbmi_value_hash_lookup (mi_results, "register-values");
 	if (reg_list)
@@ -4133,6 +4305,7 @@ debugger_finalize (GObject *obj)
 	g_string_free (debugger->priv->stde_line, TRUE);
 	g_free (debugger->priv->remote_server);
 	g_free (debugger->priv->load_pretty_printer);
+	g_queue_free (debugger->priv->pipeline);
 	g_free (debugger->priv);
 	G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -57,6 +57,10 @@ typedef void (*DebuggerParserFunc) (Debugger *debugger,
 									const GList *cli_result,
 									GError* error);
 
+/* Read only commands sent without waiting for the answer of the previous
+ * ones */
+#define MAX_PIPELINED_COMMANDS 8
+
 typedef enum
 {
 	DEBUGGER_COMMAND_NO_ERROR = 1 << 0,
@@ -72,6 +76,7 @@ struct _DebuggerCommand
 	DebuggerParserFunc parser;
 	IAnjutaDebuggerCallback callback;
 	gpointer user_data;
+	guint token;
 };
 
 struct _Debugger
@@ -23,7 +23,11 @@
 
 /* MI parser */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 
 #include "gdbmi.h"
@@ -32,6 +36,729 @@
 static gchar *gdb_test_line = 
 "^done,BreakpointTable={nr_rows=\"2\",nr_cols=\"6\",hdr=[{width=\"3\",alignment=\"-1\",col_name=\"number\",colhdr=\"Num\"},{width=\"14\",alignment=\"-1\",col_name=\"type\",colhdr=\"Type\"},{width=\"4\",alignment=\"-1\",col_name=\"disp\",colhdr=\"Disp\"},{width=\"3\",alignment=\"-1\",col_name=\"enabled\",colhdr=\"Enb\"},{width=\"10\",alignment=\"-1\",col_name=\"addr\",colhdr=\"Address\"},{width=\"40\",alignment=\"2\",col_name=\"what\",colhdr=\"What\"}],body=[bkpt={number=\"1\",type=\"breakpoint\",disp=\"keep\",enabled=\"y\",addr=\"0x08050f5d\",func=\"main\",file=\"main.c\",line=\"122\",times=\"1\"},bkpt={number=\"2\",type=\"breakpoint\",disp=\"keep\",enabled=\"y\",addr=\"0x0096fbae\",func=\"anjuta_plugin_activate\",file=\"anjuta-plugin.c\",line=\"395\",times=\"1\"}]}";
 
+/* Simulated replay of a recorded MI transcript
+ *
+ * The transcript is a gdb log, as written by the gdb plugin with
+ * debugging enabled: a line containing "GDB:> " for each command sent and
+ * "GDB:< " for each line received. Each group of read only commands
+ * following a *stopped record is replayed against a simulated gdb, which
+ * answers in order with the recorded result records tagged with the
+ * command token. The answers are parsed, but neither gdb nor the
+ * Debugger command queue is involved: this only counts the round trips
+ * needed, one command at a time and with up to MAX_PIPELINED_COMMANDS
+ * commands in flight, and checks that the tokens match the commands.
+ *---------------------------------------------------------------------------*/
+
+typedef struct
+{
+	gchar *command;
+	gchar *answer;		/* Result record */
+} ReplayCommand;
+
+typedef struct
+{
+	GPtrArray *commands;
+} ReplayStop;
+
+static gchar *
+replay_skip_token (gchar *line)
+{
+	while (g_ascii_isdigit (*line)) line++;
+
+	return line;
+}
+
+static void
+replay_stop_free (ReplayStop *stop)
+{
+	guint i;
+
+	for (i = 0; i < stop->commands->len; i++)
+	{
+		ReplayCommand *cmd = g_ptr_array_index (stop->commands, i);
+
+		g_free (cmd->command);
+		g_free (cmd->answer);
+		g_free (cmd);
+	}
+	g_ptr_array_free (stop->commands, TRUE);
+	g_free (stop);
+}
+
+/* Return a list of ReplayStop */
+static GList *
+replay_read_transcript (const gchar *filename)
+{
+	gchar *content;
+	gchar **lines;
+	gchar **line;
+	GList *stops = NULL;
+	ReplayStop *stop = NULL;
+	ReplayCommand *cmd = NULL;
+	GError *err = NULL;
+
+	if (!g_file_get_contents (filename, &content, NULL, &err))
+	{
+		fprintf (stderr, "Unable to read %s: %s\n", filename, err->message);
+		g_error_free (err);
+		return NULL;
+	}
+	lines = g_strsplit (content, "\n", -1);
+	g_free (content);
+
+	for (line = lines; *line != NULL; line++)
+	{
+		gchar *ptr;
+
+		if ((ptr = strstr (*line, "GDB:> ")) != NULL)
+		{
+			ptr = replay_skip_token (ptr + 6);
+			cmd = NULL;
+			if (stop == NULL)
+			{
+				/* Ignore commands before the first stop */
+			}
+			else if (gdbmi_command_is_read_only (ptr))
+			{
+				cmd = g_new0 (ReplayCommand, 1);
+				cmd->command = g_strdup (ptr);
+				g_ptr_array_add (stop->commands, cmd);
+			}
+			else
+			{
+				/* A command changing the state ends the group */
+				stop = NULL;
+			}
+		}
+		else if ((ptr = strstr (*line, "GDB:< ")) != NULL)
+		{
+			const gchar *record;
+
+			gdbmi_get_token (ptr + 6, &record);
+			if (strncmp (record, "*stopped", 8) == 0)
+			{
+				stop = g_new0 (ReplayStop, 1);
+				stop->commands = g_ptr_array_new ();
+				stops = g_list_prepend (stops, stop);
+				cmd = NULL;
+			}
+			else if ((*record == '^') && (cmd != NULL) && (cmd->answer == NULL))
+			{
+				cmd->answer = g_strdup (record);
+			}
+		}
+	}
+	g_strfreev (lines);
+
+	return g_list_reverse (stops);
+}
+
+/* Parse the simulated answer, returns FALSE if the token does not match */
+static gboolean
+replay_receive (ReplayCommand *cmd, guint token)
+{
+	gchar *line;
+	const gchar *record;
+	GDBMIValue *val;
+	gboolean ok;
+
+	line = g_strdup_printf ("%u%s", token, cmd->answer != NULL ? cmd->answer : "^done");
+	ok = gdbmi_get_token (line, &record) == token;
+	if (ok)
+	{
+		val = gdbmi_value_parse (record);
+		if (val != NULL) gdbmi_value_free (val);
+	}
+	g_free (line);
+
+	return ok;
+}
+
+/* Returns the number of round trips needed to get all answers, when up to
+ * window commands are sent without waiting */
+static guint
+replay_stop (ReplayStop *stop, guint window)
+{
+	guint sent = 0;
+	guint received = 0;
+	guint round_trips = 0;
+
+	while (received < stop->commands->len)
+	{
+		/* Send commands while the window is not full, their answers come
+		 * back together */
+		while ((sent < stop->commands->len) && (sent - received < window))
+			sent++;
+		round_trips++;
+
+		/* gdb answers in order */
+		for (; received < sent; received++)
+		{
+			if (!replay_receive (g_ptr_array_index (stop->commands, received),
+			                     received + 1))
+			{
+				fprintf (stderr, "Unexpected answer for command %u\n", received + 1);
+			}
+		}
+	}
+
+	return round_trips;
+}
+
+static int
+replay_transcript (const gchar *filename)
+{
+	GList *stops;
+	GList *node;
+	guint serial_total = 0;
+	guint pipeline_total = 0;
+	guint count = 0;
+
+	stops = replay_read_transcript (filename);
+	if (stops == NULL)
+	{
+		fprintf (stderr, "No stop found in %s\n", filename);
+		return 1;
+	}
+
+	printf ("Simulated replay of %s, in gdb round trips\n", filename);
+	printf ("stop commands serial pipelined\n");
+	for (node = stops; node != NULL; node = g_list_next (node))
+	{
+		ReplayStop *stop = (ReplayStop *)node->data;
+		guint serial;
+		guint pipeline;
+
+		serial = replay_stop (stop, 1);
+		pipeline = replay_stop (stop, MAX_PIPELINED_COMMANDS);
+		serial_total += serial;
+		pipeline_total += pipeline;
+		count++;
+		printf ("%4u %8u %6u %9u\n", count, stop->commands->len,
+		        serial, pipeline);
+	}
+	printf ("total %13u %9u\n", serial_total, pipeline_total);
+
+	g_list_foreach (stops, (GFunc)replay_stop_free, NULL);
+	g_list_free (stops);
+
+	return 0;
+}
+
+/* Replay through the Debugger
+ *
+ * gdbmi-test runs itself as a fake gdb: a program named gdb in a temporary
+ * directory put first in PATH. The fake gdb answers each command with the
+ * lines recorded after the same command in the transcript, tagged with the
+ * token of the command. A command changing the state, like -exec-run or
+ * -exec-next, replays the next command changing the state of the
+ * transcript, so the program stops where it was stopped in the recording.
+ *
+ * The real Debugger drives it. On each stop, the stack frames, the
+ * arguments and the local variables are requested at once, as the debug
+ * manager queue does when the program moves, and the time is measured from
+ * the stop to the callback of the last of these commands. The debug
+ * manager queue itself needs the Anjuta shell, so the Debugger functions
+ * are called directly. debugger_start() needs an installed gdb.init.
+ *---------------------------------------------------------------------------*/
+
+#define FAKE_GDB_TRANSCRIPT_ENV "GDBMI_TEST_TRANSCRIPT"
+#define FAKE_GDB_MAX_COMMAND 4096
+
+typedef struct
+{
+	gchar *command;
+	GPtrArray *output;		/* Lines received, without token */
+} FakeCommand;
+
+typedef struct
+{
+	FakeCommand *resume;	/* Command changing the state, NULL at start */
+	GPtrArray *commands;	/* Read only commands following it */
+} FakeSection;
+
+static FakeSection *
+fake_section_new (FakeCommand *resume)
+{
+	FakeSection *section;
+
+	section = g_new0 (FakeSection, 1);
+	section->resume = resume;
+	section->commands = g_ptr_array_new ();
+
+	return section;
+}
+
+/* Return an array of FakeSection, the first one contains the commands
+ * sent before running the program. The fake gdb exits with the program, it
+ * is never freed. */
+static GPtrArray *
+fake_read_transcript (const gchar *filename)
+{
+	gchar *content;
+	gchar **lines;
+	gchar **line;
+	GPtrArray *sections;
+	FakeSection *section;
+	FakeCommand *cmd = NULL;
+	GError *err = NULL;
+
+	if (!g_file_get_contents (filename, &content, NULL, &err))
+	{
+		fprintf (stderr, "Unable to read %s: %s\n", filename, err->message);
+		g_error_free (err);
+		return NULL;
+	}
+	lines = g_strsplit (content, "\n", -1);
+	g_free (content);
+
+	sections = g_ptr_array_new ();
+	section = fake_section_new (NULL);
+	g_ptr_array_add (sections, section);
+	for (line = lines; *line != NULL; line++)
+	{
+		gchar *ptr;
+
+		if ((ptr = strstr (*line, "GDB:> ")) != NULL)
+		{
+			ptr = replay_skip_token (ptr + 6);
+			cmd = g_new0 (FakeCommand, 1);
+			cmd->command = g_strdup (ptr);
+			cmd->output = g_ptr_array_new ();
+			if (gdbmi_command_is_read_only (ptr))
+			{
+				g_ptr_array_add (section->commands, cmd);
+			}
+			else
+			{
+				section = fake_section_new (cmd);
+				g_ptr_array_add (sections, section);
+			}
+		}
+		else if (((ptr = strstr (*line, "GDB:< ")) != NULL) && (cmd != NULL))
+		{
+			const gchar *record;
+
+			gdbmi_get_token (ptr + 6, &record);
+			g_ptr_array_add (cmd->output, g_strdup (record));
+		}
+	}
+	g_strfreev (lines);
+
+	return sections;
+}
+
+/* Compare the MI operations only, without their arguments */
+static gboolean
+fake_same_operation (const gchar *a, const gchar *b)
+{
+	gsize len = strcspn (a, " ");
+
+	return (len == strcspn (b, " ")) && (strncmp (a, b, len) == 0);
+}
+
+/* Look for the command in the current section, then for a command with the
+ * same operation, by example -stack-list-arguments with other frames */
+static FakeCommand *
+fake_find_command (FakeSection *section, const gchar *command)
+{
+	guint i;
+
+	for (i = 0; i < section->commands->len; i++)
+	{
+		FakeCommand *cmd = g_ptr_array_index (section->commands, i);
+
+		if (strcmp (cmd->command, command) == 0) return cmd;
+	}
+	for (i = 0; i < section->commands->len; i++)
+	{
+		FakeCommand *cmd = g_ptr_array_index (section->commands, i);
+
+		if (fake_same_operation (cmd->command, command)) return cmd;
+	}
+
+	return NULL;
+}
+
+static void
+fake_write_answer (FakeCommand *cmd, const gchar *token)
+{
+	guint i;
+
+	for (i = 0; i < cmd->output->len; i++)
+	{
+		const gchar *line = g_ptr_array_index (cmd->output, i);
+
+		/* Only result records carry the token */
+		printf ("%s%s\n", *line == '^' ? token : "", line);
+	}
+}
+
+static int
+fake_gdb (const gchar *filename)
+{
+	GPtrArray *sections;
+	guint current = 0;
+	gchar buffer[FAKE_GDB_MAX_COMMAND];
+
+	sections = fake_read_transcript (filename);
+	if (sections == NULL) return 1;
+
+	printf ("(gdb) \n");
+	fflush (stdout);
+	while (fgets (buffer, sizeof (buffer), stdin) != NULL)
+	{
+		gchar *command;
+		gchar *token;
+		FakeCommand *cmd = NULL;
+
+		g_strchomp (buffer);
+		command = replay_skip_token (buffer);
+		token = g_strndup (buffer, command - buffer);
+
+		if (strcmp (command, "-gdb-exit") == 0)
+		{
+			printf ("%s^exit\n", token);
+			fflush (stdout);
+			g_free (token);
+			break;
+		}
+		else if ((*command != '-') || gdbmi_command_is_read_only (command))
+		{
+			/* CLI commands are not recorded */
+			if (*command == '-')
+				cmd = fake_find_command (g_ptr_array_index (sections, current), command);
+		}
+		else if (current + 1 < sections->len)
+		{
+			current++;
+			cmd = ((FakeSection *)g_ptr_array_index (sections, current))->resume;
+		}
+
+		if (cmd != NULL)
+		{
+			fake_write_answer (cmd, token);
+		}
+		else
+		{
+			printf ("%s^done\n(gdb) \n", token);
+		}
+		fflush (stdout);
+		g_free (token);
+	}
+
+	return 0;
+}
+
+typedef GObject ReplayInstance;
+typedef GObjectClass ReplayInstanceClass;
+
+static void replay_instance_debugger_iface_init (IAnjutaDebuggerIface *iface);
+
+/* Receive the Debugger signals, they are defined by IAnjutaDebugger */
+G_DEFINE_TYPE_WITH_CODE (ReplayInstance, replay_instance, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (IANJUTA_TYPE_DEBUGGER,
+                                                replay_instance_debugger_iface_init))
+
+static void
+replay_instance_init (ReplayInstance *instance)
+{
+}
+
+static void
+replay_instance_class_init (ReplayInstanceClass *klass)
+{
+}
+
+static void
+replay_instance_debugger_iface_init (IAnjutaDebuggerIface *iface)
+{
+}
+
+typedef struct
+{
+	GMainLoop *loop;
+	Debugger *debugger;
+	gboolean started;
+	guint stops;		/* Number of stops in the transcript */
+	guint count;		/* Number of stops done */
+	guint pending;		/* Callbacks still expected for this stop */
+	gint64 stop_time;
+	gint64 total;
+} ReplayRun;
+
+static gboolean
+replay_run_next (gpointer user_data)
+{
+	ReplayRun *run = (ReplayRun *)user_data;
+
+	if (run->count < run->stops)
+	{
+		debugger_step_over (run->debugger);
+	}
+	else
+	{
+		/* Emit debugger-stopped */
+		debugger_abort (run->debugger);
+	}
+
+	return FALSE;
+}
+
+static void
+on_replay_list (const GList *list, gpointer user_data, GError *err)
+{
+	ReplayRun *run = (ReplayRun *)user_data;
+	gint64 elapsed;
+
+	if (err != NULL)
+		fprintf (stderr, "Stop %u: %s\n", run->count + 1, err->message);
+
+	if (--run->pending > 0) return;
+
+	elapsed = g_get_monotonic_time () - run->stop_time;
+	run->total += elapsed;
+	run->count++;
+	printf ("%4u %10" G_GINT64_FORMAT "\n", run->count, elapsed);
+
+	/* Do not change the queue in the middle of an answer */
+	g_idle_add (replay_run_next, run);
+}
+
+static void
+on_replay_program_moved (GObject *instance, gint pid, gint tid, gulong address,
+                         const gchar *file, guint line, ReplayRun *run)
+{
+	if (run->pending > 0)
+	{
+		fprintf (stderr, "Stop %u before the end of the previous one\n", run->count + 1);
+	}
+
+	/* The debug manager updates the stack and the locals views, its queue
+	 * sends these read only commands without waiting */
+	run->stop_time = g_get_monotonic_time ();
+	run->pending = 3;
+	debugger_list_frame (run->debugger, on_replay_list, run);
+	debugger_list_argument (run->debugger, on_replay_list, run);
+	debugger_list_local (run->debugger, on_replay_list, run);
+}
+
+static void
+on_replay_debugger_ready (GObject *instance, IAnjutaDebuggerState state,
+                          ReplayRun *run)
+{
+	if ((state == IANJUTA_DEBUGGER_STARTED) && !run->started)
+	{
+		run->started = TRUE;
+		debugger_start_program (run->debugger, NULL, NULL, NULL, FALSE);
+	}
+}
+
+static void
+on_replay_debugger_stopped (GObject *instance, GError *err, ReplayRun *run)
+{
+	g_main_loop_quit (run->loop);
+}
+
+/* Put a link named gdb to this program first in PATH */
+static gchar *
+replay_install_fake_gdb (const gchar *argv0)
+{
+	gchar *dir;
+	gchar *self;
+	gchar *gdb;
+	gchar *path;
+	gboolean ok;
+
+	dir = g_dir_make_tmp ("gdbmi-test-XXXXXX", NULL);
+	if (dir == NULL) return NULL;
+
+	/* argv[0] can be the libtool wrapper */
+	self = g_file_read_link ("/proc/self/exe", NULL);
+	if (self == NULL) self = g_find_program_in_path (argv0);
+
+	gdb = g_build_filename (dir, "gdb", NULL);
+	ok = (self != NULL) && (symlink (self, gdb) == 0);
+	g_free (self);
+	g_free (gdb);
+	if (!ok)
+	{
+		g_free (dir);
+		return NULL;
+	}
+
+	path = g_strconcat (dir, G_SEARCHPATH_SEPARATOR_S, g_getenv ("PATH"), NULL);
+	g_setenv ("PATH", path, TRUE);
+	g_free (path);
+
+	return dir;
+}
+
+static void
+replay_remove_fake_gdb (gchar *dir)
+{
+	gchar *gdb;
+
+	gdb = g_build_filename (dir, "gdb", NULL);
+	g_unlink (gdb);
+	g_rmdir (dir);
+	g_free (gdb);
+	g_free (dir);
+}
+
+static int
+replay_debugger (const gchar *argv0, const gchar *filename)
+{
+	ReplayRun run = {0};
+	GObject *instance;
+	GList *stops;
+	gchar *transcript;
+	gchar *dir;
+
+	stops = replay_read_transcript (filename);
+	if (stops == NULL)
+	{
+		fprintf (stderr, "No stop found in %s\n", filename);
+		return 1;
+	}
+	run.stops = g_list_length (stops);
+	g_list_foreach (stops, (GFunc)replay_stop_free, NULL);
+	g_list_free (stops);
+
+	dir = replay_install_fake_gdb (argv0);
+	if (dir == NULL)
+	{
+		fprintf (stderr, "Unable to install the fake gdb\n");
+		return 1;
+	}
+	if (g_path_is_absolute (filename))
+	{
+		transcript = g_strdup (filename);
+	}
+	else
+	{
+		gchar *cwd = g_get_current_dir ();
+
+		transcript = g_build_filename (cwd, filename, NULL);
+		g_free (cwd);
+	}
+	g_setenv (FAKE_GDB_TRANSCRIPT_ENV, transcript, TRUE);
+	g_free (transcript);
+
+	instance = g_object_new (replay_instance_get_type (), NULL);
+	g_signal_connect (instance, "program-moved", G_CALLBACK (on_replay_program_moved), &run);
+	g_signal_connect (instance, "debugger-ready", G_CALLBACK (on_replay_debugger_ready), &run);
+	g_signal_connect (instance, "debugger-stopped", G_CALLBACK (on_replay_debugger_stopped), &run);
+
+	run.loop = g_main_loop_new (NULL, FALSE);
+	run.debugger = debugger_new (NULL, instance);
+	printf ("Replay of %s through the Debugger, in microseconds\n", filename);
+	printf ("stop stack+locals\n");
+	if (debugger_start (run.debugger, NULL, NULL, FALSE))
+		g_main_loop_run (run.loop);
+	if (run.count > 0)
+	{
+		printf ("mean %10" G_GINT64_FORMAT "\n", run.total / run.count);
+	}
+
+	debugger_free (run.debugger);
+	g_main_loop_unref (run.loop);
+	g_object_unref (instance);
+	replay_remove_fake_gdb (dir);
+
+	return run.count == run.stops ? 0 : 1;
+}
+
+/* Parse throughput
+ *
+ * All result records of a transcript, by example the output of
+ * -stack-list-* or -var-list-children commands, are parsed several times.
+ *---------------------------------------------------------------------------*/
+
+#define DEFAULT_ITERATIONS 1000
+
+static void
+benchmark_count_values (const GDBMIValue *val, guint *count)
+{
+	(*count)++;
+	if (gdbmi_value_get_type (val) != GDBMI_DATA_LITERAL)
+		gdbmi_value_foreach (val, (GFunc)benchmark_count_values, count);
+}
+
+static int
+benchmark_parse (const gchar *filename, guint iterations)
+{
+	gchar *content;
+	gchar **lines;
+	gchar **line;
+	GPtrArray *records;
+	gsize bytes = 0;
+	guint values = 0;
+	guint i, j;
+	gint64 start;
+	gdouble elapsed;
+	GError *err = NULL;
+
+	if (!g_file_get_contents (filename, &content, NULL, &err))
+	{
+		fprintf (stderr, "Unable to read %s: %s\n", filename, err->message);
+		g_error_free (err);
+		return 1;
+	}
+	lines = g_strsplit (content, "\n", -1);
+	g_free (content);
+
+	records = g_ptr_array_new ();
+	for (line = lines; *line != NULL; line++)
+	{
+		gchar *ptr;
+		const gchar *record;
+
+		if ((ptr = strstr (*line, "GDB:< ")) == NULL) continue;
+		gdbmi_get_token (ptr + 6, &record);
+		if (strncmp (record, "^done,", 6) == 0)
+		{
+			GDBMIValue *val = gdbmi_value_parse (record);
+
+			if (val == NULL)
+			{
+				fprintf (stderr, "Unable to parse %s\n", record);
+				continue;
+			}
+			benchmark_count_values (val, &values);
+			gdbmi_value_free (val);
+			g_ptr_array_add (records, (gpointer)record);
+			bytes += strlen (record);
+		}
+	}
+
+	start = g_get_monotonic_time ();
+	for (i = 0; i < iterations; i++)
+	{
+		for (j = 0; j < records->len; j++)
+		{
+			GDBMIValue *val = gdbmi_value_parse (g_ptr_array_index (records, j));
+
+			gdbmi_value_free (val);
+		}
+	}
+	elapsed = (g_get_monotonic_time () - start) / 1000000.0;
+
+	printf ("Parse %u records, %" G_GSIZE_FORMAT " bytes, %u values, %u times\n",
+	        records->len, bytes, values, iterations);
+	if (elapsed > 0)
+	{
+		printf ("%.3f s, %.1f MB/s, %.0f values/s\n", elapsed,
+		        bytes * (gdouble)iterations / elapsed / (1024 * 1024),
+		        values * (gdouble)iterations / elapsed);
+	}
+
+	g_ptr_array_free (records, TRUE);
+	g_strfreev (lines);
+
+	return 0;
+}
+
 #if 0
 static void
 output_callback (Debugger *debugger, DebuggerOutputType type,
@@ -86,7 +813,35 @@ main(int argc, char **argv)
 	gchar *ptr;
 	/* Debugger *debugger; */
 	/* GtkWidget *win, *entry; */
-	
+	gchar *name;
+
+	/* Started by the Debugger as gdb */
+	name = g_path_get_basename (argv[0]);
+	if ((strcmp (name, "gdb") == 0) && (g_getenv (FAKE_GDB_TRANSCRIPT_ENV) != NULL))
+	{
+		g_free (name);
+		return fake_gdb (g_getenv (FAKE_GDB_TRANSCRIPT_ENV));
+	}
+	g_free (name);
+
+	if ((argc > 2) && (strcmp (argv[1], "-d") == 0))
+	{
+		/* gdbmi-test -d TRANSCRIPT */
+		gtk_init (&argc, &argv);
+		return replay_debugger (argv[0], argv[2]);
+	}
+	else if ((argc > 2) && (strcmp (argv[1], "-p") == 0))
+	{
+		/* gdbmi-test -p TRANSCRIPT [ITERATIONS] */
+		return benchmark_parse (argv[2],
+		                        argc > 3 ? atoi (argv[3]) : DEFAULT_ITERATIONS);
+	}
+	else if (argc > 1)
+	{
+		/* gdbmi-test TRANSCRIPT */
+		return replay_transcript (argv[1]);
+	}
+
 	printf("Test GDB MI interface.\n");
 	ptr = gdb_test_line;
 	val = gdbmi_value_parse (ptr);
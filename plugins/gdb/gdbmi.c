@@ -29,25 +29,80 @@
 #include "gdbmi.h"
 
 #define GDBMI_DUMP_INDENT_SIZE 4
+#define GDBMI_INLINE_CHILDREN 4		/* Most tuples and lists are small */
+
+/* Name and literal of parsed values point in the parsed message, they
+ * belong to the value only when set by the functions below */
+enum {
+	GDBMI_NAME_OWNED = 1 << 0,
+	GDBMI_LITERAL_OWNED = 1 << 1
+};
 
 struct _GDBMIValue
 {
 	GDBMIDataType type;
-	gchar *name;
+	guint flags;
+	const gchar *name;
+	gchar *buffer;			/* Parsed message, kept by the root value */
 	union {
-		GHashTable *hash;
-		GQueue *list;
-		GString *literal;
+		const gchar *literal;
+		struct {
+			GDBMIValue **items;
+			guint len;
+			guint size;
+			GDBMIValue *inline_items[GDBMI_INLINE_CHILDREN];
+		} children;			/* Hash and list elements in order */
 	} data;
 };
 
-struct _GDBMIForeachHashData
+static GDBMIValue *
+gdbmi_value_alloc (GDBMIDataType data_type)
 {
-	GFunc user_callback;
-	gpointer user_data;
-};
+	GDBMIValue *val = g_slice_new0 (GDBMIValue);
+
+	val->type = data_type;
+	if (data_type == GDBMI_DATA_LITERAL)
+	{
+		val->data.literal = "";
+	}
+	else
+	{
+		val->data.children.items = val->data.children.inline_items;
+		val->data.children.size = GDBMI_INLINE_CHILDREN;
+	}
 
-static guint GDBMI_deleted_hash_value = 0;
+	return val;
+}
+
+static void
+gdbmi_value_children_append (GDBMIValue *val, GDBMIValue *child)
+{
+	if (val->data.children.len == val->data.children.size)
+	{
+		val->data.children.size *= 2;
+		if (val->data.children.items == val->data.children.inline_items)
+		{
+			val->data.children.items = g_new (GDBMIValue *, val->data.children.size);
+			memcpy (val->data.children.items, val->data.children.inline_items,
+					sizeof (val->data.children.inline_items));
+		}
+		else
+		{
+			val->data.children.items = g_renew (GDBMIValue *, val->data.children.items,
+												val->data.children.size);
+		}
+	}
+	val->data.children.items[val->data.children.len++] = child;
+}
+
+static void
+gdbmi_value_set_name_static (GDBMIValue *val, const gchar *name)
+{
+	if (val->flags & GDBMI_NAME_OWNED)
+		g_free ((gchar *)val->name);
+	val->flags &= ~GDBMI_NAME_OWNED;
+	val->name = name;
+}
 
 void
 gdbmi_value_free (GDBMIValue *val)
@@ -56,48 +111,44 @@ gdbmi_value_free (GDBMIValue *val)
 	
 	if (val->type == GDBMI_DATA_LITERAL)
 	{
-		g_string_free (val->data.literal, TRUE);
-	}
-	else if (val->type == GDBMI_DATA_LIST)
-	{
-		gdbmi_value_foreach (val, (GFunc)gdbmi_value_free, NULL);
-		g_queue_free (val->data.list);
+		if (val->flags & GDBMI_LITERAL_OWNED)
+			g_free ((gchar *)val->data.literal);
 	}
 	else
 	{
-		g_hash_table_destroy (val->data.hash);
+		guint i;
+
+		for (i = 0; i < val->data.children.len; i++)
+			gdbmi_value_free (val->data.children.items[i]);
+		if (val->data.children.items != val->data.children.inline_items)
+			g_free (val->data.children.items);
 	}
-	g_free (val->name);
-	g_free (val);
+	if (val->flags & GDBMI_NAME_OWNED)
+		g_free ((gchar *)val->name);
+	g_free (val->buffer);
+	g_slice_free (GDBMIValue, val);
 }
 
 GDBMIValue *
 gdbmi_value_new (GDBMIDataType data_type, const gchar *name)
 {
-	GDBMIValue *val = g_new0 (GDBMIValue, 1);
-	
-	val->type = data_type;
-	if (name)
-		val->name = g_strdup (name);
+	GDBMIValue *val;
 	
 	switch (data_type)
 	{
 		case GDBMI_DATA_HASH:
-			val->data.hash =
-				g_hash_table_new_full (g_str_hash, g_str_equal,
-									   (GDestroyNotify)g_free,
-									   (GDestroyNotify)gdbmi_value_free);
-			break;
 		case GDBMI_DATA_LIST:
-			val->data.list = g_queue_new ();
-			break;
 		case GDBMI_DATA_LITERAL:
-			val->data.literal = g_string_new (NULL);
 			break;
 		default:
 			g_warning ("Unknow MI data type. Should not reach here");
 			return NULL;
 	}
+
+	val = gdbmi_value_alloc (data_type);
+	if (name)
+		gdbmi_value_set_name (val, name);
+
 	return val;
 }
 
@@ -128,8 +179,8 @@ gdbmi_value_set_name (GDBMIValue *val, const gchar *name)
 {
 	g_return_if_fail (val != NULL);
 	g_return_if_fail (name != NULL);
-	g_free (val->name);
-	val->name = g_strdup (name);
+	gdbmi_value_set_name_static (val, g_strdup (name));
+	val->flags |= GDBMI_NAME_OWNED;
 }
 
 gint
@@ -139,44 +190,29 @@ gdbmi_value_get_size (const GDBMIValue* val)
 	
 	if (val->type == GDBMI_DATA_LITERAL)
 	{
-		if (val->data.literal->str)
+		if (val->data.literal)
 			return 1;
 		else
 			return 0;
 	}
-	else if (val->type == GDBMI_DATA_LIST)
-		return g_queue_get_length (val->data.list);
-	else if (val->type == GDBMI_DATA_HASH)
-		return g_hash_table_size (val->data.hash);
+	else if ((val->type == GDBMI_DATA_LIST) || (val->type == GDBMI_DATA_HASH))
+		return val->data.children.len;
 	else
 		return 0;
 }
 
-static void
-gdbmi_value_hash_foreach (const gchar *key, GDBMIValue* val,
-						  struct _GDBMIForeachHashData *hash_data)
-{
-	hash_data->user_callback (val, hash_data->user_data);
-}
-
 void
 gdbmi_value_foreach (const GDBMIValue* val, GFunc func, gpointer user_data)
 {
 	g_return_if_fail (val != NULL);
 	g_return_if_fail (func != NULL);
 	
-	if (val->type == GDBMI_DATA_LIST)
+	if ((val->type == GDBMI_DATA_LIST) || (val->type == GDBMI_DATA_HASH))
 	{
-		g_queue_foreach (val->data.list, func, user_data);
-	}
-	else if (val->type == GDBMI_DATA_HASH)
-	{
-		struct _GDBMIForeachHashData hash_data = {NULL, NULL};
-		
-		hash_data.user_callback = func;
-		hash_data.user_data = user_data;
-		g_hash_table_foreach (val->data.hash, (GHFunc)gdbmi_value_hash_foreach,
-							  &hash_data);
+		guint i;
+
+		for (i = 0; i < val->data.children.len; i++)
+			func (val->data.children.items[i], user_data);
 	}
 	else
 	{
@@ -190,7 +226,10 @@ gdbmi_value_literal_set (GDBMIValue* val, const gchar *data)
 {
 	g_return_if_fail (val != NULL);
 	g_return_if_fail (val->type == GDBMI_DATA_LITERAL);
-	g_string_assign (val->data.literal, data);
+	if (val->flags & GDBMI_LITERAL_OWNED)
+		g_free ((gchar *)val->data.literal);
+	val->data.literal = g_strdup (data);
+	val->flags |= GDBMI_LITERAL_OWNED;
 }
 
 const gchar*
@@ -198,16 +237,13 @@ gdbmi_value_literal_get (const GDBMIValue* val)
 {
 	g_return_val_if_fail (val != NULL, NULL);
 	g_return_val_if_fail (val->type == GDBMI_DATA_LITERAL, NULL);
-	return val->data.literal->str;
+	return val->data.literal;
 }
 
 /* Hash operations */
 void
 gdbmi_value_hash_insert (GDBMIValue* val, const gchar *key, GDBMIValue *value)
 {
-	gpointer orig_key;
-	gpointer orig_value;
-
 	g_return_if_fail (val != NULL);
 	g_return_if_fail (key != NULL);
 	g_return_if_fail (value != NULL);
@@ -215,29 +251,32 @@ gdbmi_value_hash_insert (GDBMIValue* val, const gchar *key, GDBMIValue *value)
 
 	/* GDBMI hash table could contains several data with the same
 	 * key (output of -thread-list-ids)
-	 * Keep old value under a random name, we get them using
-	 * foreach function */
-	if (g_hash_table_lookup_extended (val->data.hash, key, &orig_key, &orig_value))
-	{
-		/* Key already exist, remove it and insert value with
-		 * another name */
-		g_hash_table_steal (val->data.hash, key);
-		g_free (orig_key);
-		gchar *new_key = g_strdup_printf("[%d]", GDBMI_deleted_hash_value++);
-		g_hash_table_insert (val->data.hash, new_key, orig_value);
-
-	}
-	g_hash_table_insert (val->data.hash, g_strdup (key), value);
+	 * All are kept, lookup returns the last one, we get the others
+	 * using foreach function */
+	if ((value->name == NULL) || (strcmp (value->name, key) != 0))
+		gdbmi_value_set_name (value, key);
+	gdbmi_value_children_append (val, value);
 }
 
 const GDBMIValue*
 gdbmi_value_hash_lookup (const GDBMIValue* val, const gchar *key)
 {
+	guint i;
+
 	g_return_val_if_fail (val != NULL, NULL);
 	g_return_val_if_fail (key != NULL, NULL);
 	g_return_val_if_fail (val->type == GDBMI_DATA_HASH, NULL);
 	
-	return g_hash_table_lookup (val->data.hash, key);
+	/* Tuples are small, a linear search is faster than hashing */
+	for (i = val->data.children.len; i > 0; i--)
+	{
+		GDBMIValue *element = val->data.children.items[i - 1];
+
+		if (strcmp (element->name, key) == 0)
+			return element;
+	}
+
+	return NULL;
 }
 
 /* List operations */
@@ -248,7 +287,7 @@ gdbmi_value_list_append (GDBMIValue* val, GDBMIValue *value)
 	g_return_if_fail (value != NULL);
 	g_return_if_fail (val->type == GDBMI_DATA_LIST);
 	
-	g_queue_push_tail (val->data.list, value);
+	gdbmi_value_children_append (val, value);
 }
 
 const GDBMIValue*
@@ -257,10 +296,14 @@ gdbmi_value_list_get_nth (const GDBMIValue* val, gint idx)
 	g_return_val_if_fail (val != NULL, NULL);
 	g_return_val_if_fail (val->type == GDBMI_DATA_LIST, NULL);
 	
-	if (idx >= 0)
-		return g_queue_peek_nth (val->data.list, idx);
+	if (val->data.children.len == 0)
+		return NULL;
+	else if (idx < 0)
+		return val->data.children.items[val->data.children.len - 1];
+	else if ((guint)idx < val->data.children.len)
+		return val->data.children.items[idx];
 	else
-		return g_queue_peek_tail (val->data.list);
+		return NULL;
 }
 
 static void
@@ -284,7 +327,7 @@ gdbmi_value_dump (const GDBMIValue *val, gint indent_level)
 	{
 		gchar *v;
 		
-		v = g_strescape (val->data.literal->str, NULL);
+		v = g_strescape (val->data.literal, NULL);
 		if (val->name)
 			printf ("%s = \"%s\",\n", val->name, v);
 		else
@@ -317,6 +360,8 @@ gdbmi_value_dump (const GDBMIValue *val, gint indent_level)
 	}
 }
 
+/* Parse the message in place: names and literals are terminated and
+ * unescaped inside the message, values point to them */
 static GDBMIValue*
 gdbmi_value_parse_real (gchar **ptr)
 {
@@ -329,87 +374,107 @@ gdbmi_value_parse_real (gchar **ptr)
 	}
 	else if (**ptr == '"')
 	{
-		/* Value is literal */
-		gboolean escaped;
-		GString *buff;
-		gchar *p;
-		gchar *value, *compressed_value;
+		/* Value is literal, the unescaped value is never longer */
+		gchar *src;
+		gchar *dst;
 		gint i;
 		
-		*ptr = g_utf8_next_char (*ptr);
-		escaped = FALSE;
-		buff = g_string_new ("");
-		while (escaped || **ptr != '"')
+		src = *ptr + 1;
+		dst = src;
+		val = gdbmi_value_alloc (GDBMI_DATA_LITERAL);
+		val->data.literal = dst;
+		while (*src != '"')
 		{
-			if (**ptr == '\0')
+			if ((*src == '\0') || ((*src == '\\') && (src[1] == '\0')))
 			{
 				g_warning ("Parse error: Invalid literal value");
+				gdbmi_value_free (val);
 				return NULL;
 			}
-			if (escaped)
+			if (*src != '\\')
 			{
-				escaped = FALSE;
+				*dst++ = *src++;
+				continue;
 			}
-			else if (**ptr == '\\')
+			
+			/* Same escape sequences than g_strcompress */
+			src++;
+			switch (*src)
 			{
-				escaped = TRUE;
+			case 'b':
+				*dst++ = '\b';
+				break;
+			case 'f':
+				*dst++ = '\f';
+				break;
+			case 'n':
+				*dst++ = '\n';
+				break;
+			case 'r':
+				*dst++ = '\r';
+				break;
+			case 't':
+				*dst++ = '\t';
+				break;
+			case 'v':
+				*dst++ = '\v';
+				break;
+			case '0': case '1': case '2': case '3':
+			case '4': case '5': case '6': case '7':
+				*dst = 0;
+				for (i = 0; (i < 3) && (*src >= '0') && (*src <= '7'); i++)
+					*dst = (*dst * 8) + (*src++ - '0');
+				dst++;
+				continue;
+			default:
+				*dst++ = *src;
+				break;
 			}
-			p = g_utf8_next_char (*ptr);
-			for (i = 0; i < (p - *ptr); i++)
-				g_string_append_c (buff, *(*ptr + i));
-			*ptr = p;
+			src++;
 		}
 		/* Get pass the closing quote */
-		*ptr = g_utf8_next_char (*ptr);
-		
-		value = g_string_free (buff, FALSE);
-		compressed_value = g_strcompress (value);
-		val = gdbmi_value_literal_new (NULL, compressed_value);
-		g_free (value);
-		g_free (compressed_value);
+		*dst = '\0';
+		*ptr = src + 1;
 	}
 	else if (isalpha (**ptr))
 	{
 		/* Value is assignment */
 		gchar *name;
-		gchar *p;
 		
 		/* Get assignment name */
-		p = *ptr;
-		while (**ptr != '=')
+		name = *ptr;
+		*ptr = strchr (name, '=');
+		if (*ptr == NULL)
 		{
-			if (**ptr == '\0')
-			{
-				g_warning ("Parse error: Invalid assignment name");
-				return NULL;
-			}
-			*ptr = g_utf8_next_char (*ptr);
+			g_warning ("Parse error: Invalid assignment name");
+			return NULL;
 		}
-		name = g_strndup (p, *ptr - p);
 		
 		/* Skip pass assignment operator */
-		*ptr = g_utf8_next_char (*ptr);
+		**ptr = '\0';
+		(*ptr)++;
 		
 		/* Retrieve assignment value */
 		val = gdbmi_value_parse_real (ptr);
 		if (val)
 		{
-			gdbmi_value_set_name (val, name);
+			gdbmi_value_set_name_static (val, name);
 		}
 		else
 		{
 			g_warning ("Parse error: From parent");
 		}
-		g_free (name);
 	}
-	else if (**ptr == '{')
+	else if ((**ptr == '{') || (**ptr == '['))
 	{
-		/* Value is hash */
+		/* Value is hash or list */
 		gboolean error = FALSE;
+		gboolean hash = **ptr == '{';
+		gchar close = hash ? '}' : ']';
 		
-		*ptr = g_utf8_next_char (*ptr);
-		val = gdbmi_value_new (GDBMI_DATA_HASH, NULL);
-		while (**ptr != '}')
+		(*ptr)++;
+		val = gdbmi_value_alloc (hash ? GDBMI_DATA_HASH : GDBMI_DATA_LIST);
+		while (**ptr != close)
 		{
 			GDBMIValue *element;
 			element = gdbmi_value_parse_real (ptr);
@@ -419,7 +484,7 @@ gdbmi_value_parse_real (gchar **ptr)
 				error = TRUE;
 				break;
 			}
-			if (gdbmi_value_get_name(element) == NULL)
+			if (hash && (gdbmi_value_get_name(element) == NULL))
 			{
 				g_warning ("Parse error: Hash element has no name => '%s'",
 						   *ptr);
@@ -427,7 +492,7 @@ gdbmi_value_parse_real (gchar **ptr)
 				gdbmi_value_free (element);
 				break;
 			}
-			if (**ptr != ',' && **ptr != '}')
+			if (**ptr != ',' && **ptr != close)
 			{
 				g_warning ("Parse error: Invalid element separator => '%s'",
 						   *ptr);
@@ -435,59 +500,22 @@ gdbmi_value_parse_real (gchar **ptr)
 				gdbmi_value_free (element);
 				break;
 			}
-			gdbmi_value_hash_insert (val, gdbmi_value_get_name (element),
-									 element);
+			gdbmi_value_children_append (val, element);
 			
 			/* Get pass the comma separator */
 			if (**ptr == ',')
-				*ptr = g_utf8_next_char (*ptr);
+				(*ptr)++;
 		}
 		if (error)
 		{
 			gdbmi_value_free (val);
 			val = NULL;
 		}
-		/* Get pass the closing hash */
-		*ptr = g_utf8_next_char (*ptr);
-	}
-	else if (**ptr == '[')
-	{
-		/* Value is list */
-		gboolean error = FALSE;
-		
-		*ptr = g_utf8_next_char (*ptr);
-		val = gdbmi_value_new (GDBMI_DATA_LIST, NULL);
-		while (**ptr != ']')
-		{
-			GDBMIValue *element;
-			element = gdbmi_value_parse_real (ptr);
-			if (element == NULL)
-			{
-				g_warning ("Parse error: From parent");
-				error = TRUE;
-				break;
-			}
-			if (**ptr != ',' && **ptr != ']')
-			{
-				g_warning ("Parse error: Invalid element separator => '%s'",
-						   *ptr);
-				error = TRUE;
-				gdbmi_value_free (element);
-				break;
-			}
-			gdbmi_value_list_append (val, element);
-			
-			/* Get pass the comma separator */
-			if (**ptr == ',')
-				*ptr = g_utf8_next_char (*ptr);
-		}
-		if (error)
+		/* Get pass the closing hash or list */
+		else
 		{
-			gdbmi_value_free (val);
-			val = NULL;
+			(*ptr)++;
 		}
-		/* Get pass the closing list */
-		*ptr = g_utf8_next_char (*ptr);
 	}
 	else
 	{
@@ -497,6 +525,8 @@ gdbmi_value_parse_real (gchar **ptr)
 	return val;
 }
 
+/* The message is copied once, all values of the result point in this copy
+ * which is freed with the returned value */
 G_MODULE_EXPORT GDBMIValue*
 gdbmi_value_parse (const gchar *message)
 {
@@ -517,7 +547,72 @@ gdbmi_value_parse (const gchar *message)
 		msg = g_strconcat ("{", strchr (message, ',') + 1, "}", NULL);
 		ptr = msg;
 		val = gdbmi_value_parse_real (&ptr);
-		g_free (msg);
+		if (val != NULL)
+			val->buffer = msg;
+		else
+			g_free (msg);
 	}
 	return val;
 }
+
+/* Commands sent with a token get it back in front of their result and
+ * async records. Returns the token of the line or 0 if it has none,
+ * record points after the token. */
+G_MODULE_EXPORT guint
+gdbmi_get_token (const gchar *line, const gchar **record)
+{
+	const gchar *ptr;
+	guint token = 0;
+
+	g_return_val_if_fail (line != NULL, 0);
+
+	for (ptr = line; isdigit (*ptr); ptr++)
+	{
+		token = token * 10 + (*ptr - '0');
+	}
+
+	/* Output of the program can start with digits too */
+	if ((ptr == line) || (*ptr == '\0') || (strchr ("^*+=", *ptr) == NULL))
+	{
+		token = 0;
+		ptr = line;
+	}
+	if (record != NULL) *record = ptr;
+
+	return token;
+}
+
+/* MI commands which read the debugger state without changing it. gdb
+ * executes commands in order, so these ones can be sent without waiting
+ * for the answer of the previous ones. */
+static const gchar *gdbmi_read_only_commands[] = {
+	"-stack-list-",
+	"-stack-info-",
+	"-var-update ",
+	"-var-evaluate-expression ",
+	"-var-list-children ",
+	"-var-info-",
+	"-data-list-",
+	"-data-read-memory ",
+	"-data-disassemble ",
+	"-thread-list-ids",
+	"-thread-info",
+	"-break-list",
+	NULL
+};
+
+G_MODULE_EXPORT gboolean
+gdbmi_command_is_read_only (const gchar *command)
+{
+	const gchar **prefix;
+
+	g_return_val_if_fail (command != NULL, FALSE);
+
+	for (prefix = gdbmi_read_only_commands; *prefix != NULL; prefix++)
+	{
+		if (strncmp (command, *prefix, strlen (*prefix)) == 0)
+			return TRUE;
+	}
+
+	return FALSE;
+}
@@ -65,6 +65,10 @@ const GDBMIValue* gdbmi_value_list_get_nth (const GDBMIValue* val, gint idx);
 GDBMIValue* gdbmi_value_parse (const gchar *message);
 void gdbmi_value_dump (const GDBMIValue *val, gint indent_level);
 
+/* Command tokens */
+guint gdbmi_get_token (const gchar *line, const gchar **record);
+gboolean gdbmi_command_is_read_only (const gchar *command);
+
 G_END_DECLS
 
 #endif
@@ -38,16 +38,35 @@ typedef struct GiggleGraphRendererPrivate GiggleGraphRendererPrivate;
 
 struct GiggleGraphRendererPrivate {
 	gint            n_paths;
-	GHashTable     *paths_info;
+	gint            n_color;
+	GArray         *paths;
 	GitRevision *revision;
 };
 
+/* Path going down from the last added revision, the first one is unused */
+typedef struct GiggleGraphRendererPath GiggleGraphRendererPath;
+
+struct GiggleGraphRendererPath {
+	GitRevision *revision;	/* next revision expected on this path */
+	gint         n_color;
+};
+
 typedef struct GiggleGraphRendererPathState GiggleGraphRendererPathState;
 
 struct GiggleGraphRendererPathState {
 	gushort upper_n_color : 8;
 	gushort lower_n_color : 8;
-	gushort n_path;
+	gushort n_path : 14;
+	gushort upper_link : 1;	/* path ends on the revision */
+	gushort lower_link : 1;	/* path starts from the revision */
+};
+
+typedef struct GiggleGraphRendererRevisionState GiggleGraphRendererRevisionState;
+
+struct GiggleGraphRendererRevisionState {
+	gint    n_path;
+	gint    n_color;
+	GArray *paths_state;
 };
 
 enum {
@@ -154,7 +173,29 @@ giggle_graph_renderer_class_init (GiggleGraphRendererClass *class)
 static void
 giggle_graph_renderer_init (GiggleGraphRenderer *instance)
 {
-	instance->_priv = GET_PRIV (instance);
+	GiggleGraphRendererPrivate *priv;
+
+	instance->_priv = priv = GET_PRIV (instance);
+
+	priv->paths = g_array_new (FALSE, TRUE, sizeof (GiggleGraphRendererPath));
+	g_array_set_size (priv->paths, 1);
+}
+
+static void
+free_paths (GArray *paths)
+{
+	gint i;
+
+	for (i = 1; i < paths->len; i++) {
+		GiggleGraphRendererPath *path;
+
+		path = &g_array_index (paths, GiggleGraphRendererPath, i);
+		if (path->revision) {
+			g_object_unref (path->revision);
+			path->revision = NULL;
+		}
+	}
+	g_array_set_size (paths, 1);
 }
 
 static void
@@ -164,8 +205,11 @@ giggle_graph_renderer_finalize (GObject *object)
 
 	priv = GET_PRIV (object);
 
-	if (priv->paths_info) {
-		g_hash_table_destroy (priv->paths_info);
+	free_paths (priv->paths);
+	g_array_free (priv->paths, TRUE);
+
+	if (priv->revision) {
+		g_object_unref (priv->revision);
 	}
 
 	G_OBJECT_CLASS (giggle_graph_renderer_parent_class)->finalize (object);
@@ -249,15 +293,12 @@ giggle_graph_renderer_render (GtkCellRenderer *cell,
 			      const GdkRectangle    *cell_area,
 			      GtkCellRendererState flags)
 {
-	GiggleGraphRendererPrivate   *priv;
-	GiggleGraphRendererPathState *path_state;
-	GitRevision               *revision;
-	GArray                       *paths_state;
-	GHashTable                   *table;
-	gint                          x, y, h;
-	gint                          cur_pos, pos;
-	GList                        *children;
-	gint                          size, i;
+	GiggleGraphRendererPrivate       *priv;
+	GiggleGraphRendererRevisionState *state;
+	GiggleGraphRendererPathState     *path_state;
+	gint                              x, y, h;
+	gint                              cur_pos, pos;
+	gint                              size, i;
 
 	priv = GIGGLE_GRAPH_RENDERER (cell)->_priv;
 
@@ -265,27 +306,28 @@ giggle_graph_renderer_render (GtkCellRenderer *cell,
 		return;
 	}
 
+	state = g_object_get_qdata (G_OBJECT (priv->revision), revision_paths_state_quark);
+
+	if (!state) {
+		/* not laid out yet */
+		return;
+	}
+
 	x = cell_area->x;
 	y = background_area->y;
 	h = background_area->height;
-	revision = priv->revision;
 	size = PANGO_PIXELS (pango_font_description_get_size (gtk_widget_get_style (widget)->font_desc));
 
-	table = g_hash_table_new (g_direct_hash, g_direct_equal);
-	paths_state = g_object_get_qdata (G_OBJECT (revision), revision_paths_state_quark);
-	children = git_revision_get_children (revision);
-	cur_pos = GPOINTER_TO_INT (g_hash_table_lookup (priv->paths_info, revision));
+	cur_pos = state->n_path;
 	cairo_set_line_width (cr, LINE_WIDTH (size));
 	cairo_set_line_join (cr, CAIRO_LINE_JOIN_ROUND);
 
 	/* paint paths */
-	for (i = 0; i < paths_state->len; i++) {
-		path_state = & g_array_index (paths_state, GiggleGraphRendererPathState, i);
-		g_hash_table_insert (table, GINT_TO_POINTER ((gint) path_state->n_path), path_state);
+	for (i = 0; i < state->paths_state->len; i++) {
+		path_state = &g_array_index (state->paths_state, GiggleGraphRendererPathState, i);
 		pos = path_state->n_path;
 
-		if (path_state->lower_n_color != INVALID_COLOR &&
-		    (pos != cur_pos || git_revision_has_parents (revision))) {
+		if (path_state->lower_n_color != INVALID_COLOR) {
 			gdk_cairo_set_source_color (cr, &colors[path_state->lower_n_color]);
 			cairo_move_to (cr, x + (pos * PATH_SPACE (size)), y + (h / 2));
 			cairo_line_to (cr, x + (pos * PATH_SPACE (size)), y + h);
@@ -300,29 +342,29 @@ giggle_graph_renderer_render (GtkCellRenderer *cell,
 		}
 	}
 
-	/* paint connections between paths */
-	while (children) {
-		pos = GPOINTER_TO_INT (g_hash_table_lookup (priv->paths_info, children->data));
-		path_state = g_hash_table_lookup (table, GINT_TO_POINTER (pos));
+	/* paint connections between paths, redrawing the
+	 * connected part of the path before stroking to get
+	 * a rounded connection
+	 */
+	for (i = 0; i < state->paths_state->len; i++) {
+		path_state = &g_array_index (state->paths_state, GiggleGraphRendererPathState, i);
+		pos = path_state->n_path;
 
-		if (path_state->upper_n_color != INVALID_COLOR) {
+		if (path_state->upper_link && path_state->upper_n_color != INVALID_COLOR) {
 			gdk_cairo_set_source_color (cr, &colors[path_state->upper_n_color]);
-			cairo_move_to (cr,
-				       x + (cur_pos * PATH_SPACE (size)),
-				       y + (h / 2));
-			cairo_line_to (cr,
-				       x + (pos * PATH_SPACE (size)),
-				       y + (h / 2));
-
-			/* redraw the upper part of the path before
-			 * stroking to get a rounded connection
-			 */
+			cairo_move_to (cr, x + (cur_pos * PATH_SPACE (size)), y + (h / 2));
+			cairo_line_to (cr, x + (pos * PATH_SPACE (size)), y + (h / 2));
 			cairo_line_to (cr, x + (pos * PATH_SPACE (size)), y);
-
 			cairo_stroke  (cr);
 		}
 
-		children = children->next;
+		if (path_state->lower_link && path_state->lower_n_color != INVALID_COLOR) {
+			gdk_cairo_set_source_color (cr, &colors[path_state->lower_n_color]);
+			cairo_move_to (cr, x + (cur_pos * PATH_SPACE (size)), y + (h / 2));
+			cairo_line_to (cr, x + (pos * PATH_SPACE (size)), y + (h / 2));
+			cairo_line_to (cr, x + (pos * PATH_SPACE (size)), y + h);
+			cairo_stroke  (cr);
+		}
 	}
 
 	/* paint circle */
@@ -334,16 +376,13 @@ giggle_graph_renderer_render (GtkCellRenderer *cell,
 	cairo_stroke (cr);
 
 	/* paint internal circle */
-	path_state = g_hash_table_lookup (table, GINT_TO_POINTER (cur_pos));
-	gdk_cairo_set_source_color (cr, &colors[path_state->lower_n_color]);
+	gdk_cairo_set_source_color (cr, &colors[state->n_color]);
 	cairo_arc (cr,
 		   x + (cur_pos * PATH_SPACE (size)),
 		   y + (h / 2),
 		   DOT_RADIUS (size) - 1, 0, 2 * G_PI);
 	cairo_fill (cr);
 	cairo_stroke (cr);
-
-	g_hash_table_destroy (table);
 }
 
 GtkCellRenderer *
@@ -353,139 +392,186 @@ giggle_graph_renderer_new (void)
 }
 
 static void
-find_free_path (GHashTable *visible_paths,
-		gint       *n_paths,
-		gint       *path)
+free_revision_state (GiggleGraphRendererRevisionState *state)
 {
-	gint cur_path = 1;
+	g_array_free (state->paths_state, TRUE);
+	g_slice_free (GiggleGraphRendererRevisionState, state);
+}
 
-	/* find first path not in list */
-	while (g_hash_table_lookup (visible_paths, GINT_TO_POINTER (cur_path))) {
-		cur_path++;
-	}
+static GiggleGraphRendererPathState *
+get_path_state (GArray *paths_state,
+		gint    n_path)
+{
+	GiggleGraphRendererPathState *path_state;
+	gint                          i;
 
-	*path = cur_path;
+	for (i = 0; i < paths_state->len; i++) {
+		path_state = &g_array_index (paths_state, GiggleGraphRendererPathState, i);
 
-	/* increment number of paths */
-	if (*path > *n_paths) {
-		*n_paths = *path;
+		if (path_state->n_path == n_path) {
+			return path_state;
+		}
 	}
+
+	/* path not visible yet, the new state is cleared */
+	g_array_set_size (paths_state, paths_state->len + 1);
+	path_state = &g_array_index (paths_state, GiggleGraphRendererPathState, i);
+	path_state->n_path = n_path;
+
+	return path_state;
 }
 
-static void
-get_initial_status_foreach (gpointer key,
-			    gpointer value,
-			    gpointer user_data)
+static gint
+find_path (GArray      *paths,
+	   GitRevision *revision)
 {
-	GiggleGraphRendererPathState  path_state;
-	GArray                       *array;
-	gint                          n_color, n_path;
+	gint i;
 
-	array = (GArray *) user_data;
-	n_color = GPOINTER_TO_INT (value);
-	n_path = GPOINTER_TO_INT (key);
+	/* a NULL revision finds the first free path */
+	for (i = 1; i < paths->len; i++) {
+		if (g_array_index (paths, GiggleGraphRendererPath, i).revision == revision) {
+			return i;
+		}
+	}
+
+	if (revision) {
+		return 0;
+	}
 
-	path_state.n_path = n_path;
-	path_state.lower_n_color = n_color;
-	path_state.upper_n_color = n_color;
+	g_array_set_size (paths, paths->len + 1);
 
-	g_array_append_val (array, path_state);
+	return i;
 }
 
-static GArray *
-get_initial_status (GHashTable *visible_paths)
+/**
+ * giggle_graph_renderer_reset:
+ * @renderer: a #GiggleGraphRenderer
+ *
+ * Forget all paths, the next revision added starts a new graph.
+ */
+void
+giggle_graph_renderer_reset (GiggleGraphRenderer *renderer)
 {
-	GArray *array;
-	guint      size;
+	GiggleGraphRendererPrivate *priv;
 
-	size = g_hash_table_size (visible_paths);
-	array = g_array_sized_new (FALSE, TRUE, sizeof (GiggleGraphRendererPathState), size);
+	g_return_if_fail (GIGGLE_IS_GRAPH_RENDERER (renderer));
 
-	g_hash_table_foreach (visible_paths, (GHFunc) get_initial_status_foreach, array);
+	priv = renderer->_priv;
 
-	return array;
+	free_paths (priv->paths);
+	priv->n_paths = 0;
+	priv->n_color = 0;
 }
 
-static void
-free_paths_state (GArray *array)
+/**
+ * giggle_graph_renderer_add_revision:
+ * @renderer: a #GiggleGraphRenderer
+ * @revision: a #GitRevision
+ *
+ * Lay out the paths of @revision below the previously added ones. Revisions
+ * have to be added in the order of the rows, newest first, and only the paths
+ * still open at the bottom are kept, so a log can be displayed page after page
+ * without computing the whole graph again.
+ */
+void
+giggle_graph_renderer_add_revision (GiggleGraphRenderer *renderer,
+				    GitRevision         *revision)
 {
-	g_array_free (array, TRUE);
-}
+	GiggleGraphRendererPrivate       *priv;
+	GiggleGraphRendererRevisionState *state;
+	GiggleGraphRendererPathState     *path_state;
+	GiggleGraphRendererPath          *path;
+	GArray                           *paths;
+	GList                            *parents;
+	gint                              n_path, i;
 
-static void
-giggle_graph_renderer_calculate_revision_state (GiggleGraphRenderer *renderer,
-						GitRevision      *revision,
-						GHashTable          *visible_paths,
-						gint                *n_color)
-{
-	GiggleGraphRendererPathState  path_state;
-	GiggleGraphRendererPrivate   *priv;
-	GitRevision               *rev;
-	GArray                       *paths_state;
-	GList                        *children;
-	gboolean                      current_path_reused = FALSE;
-	gboolean                      update_color;
-	gint                          n_path, i;
+	g_return_if_fail (GIGGLE_IS_GRAPH_RENDERER (renderer));
+	g_return_if_fail (GIT_IS_REVISION (revision));
 
 	priv = renderer->_priv;
-	children = git_revision_get_children (revision);
-	update_color = (g_list_length (children) > 1);
-	paths_state = get_initial_status (visible_paths);
+	paths = priv->paths;
 
-	while (children) {
-		rev = GIT_REVISION (children->data);
-		n_path = GPOINTER_TO_INT (g_hash_table_lookup (priv->paths_info, rev));
+	state = g_slice_new (GiggleGraphRendererRevisionState);
+	state->n_path = 0;
+	state->paths_state = g_array_sized_new (FALSE, TRUE, sizeof (GiggleGraphRendererPathState), paths->len);
 
-		if (!n_path) {
-			/* there wasn't a path for this revision, choose one */
-			if (!current_path_reused) {
-				n_path = GPOINTER_TO_INT (g_hash_table_lookup (priv->paths_info, revision));
-				current_path_reused = TRUE;
-			} else {
-				find_free_path (visible_paths, &priv->n_paths, &n_path);
-			}
+	/* all paths coming from above go through the row, the first one
+	 * expecting this revision continues on it, the others end on it
+	 */
+	for (i = 1; i < paths->len; i++) {
+		path = &g_array_index (paths, GiggleGraphRendererPath, i);
 
-			g_hash_table_insert (priv->paths_info, rev, GINT_TO_POINTER (n_path));
-			path_state.lower_n_color =
-				GPOINTER_TO_INT (g_hash_table_lookup (visible_paths, GINT_TO_POINTER (n_path)));
+		if (!path->revision) {
+			continue;
+		}
 
-			if (update_color) {
-				path_state.upper_n_color = *n_color = NEXT_COLOR (*n_color);
+		path_state = get_path_state (state->paths_state, i);
+		path_state->upper_n_color = path->n_color;
+		path_state->lower_n_color = path->n_color;
+
+		if (path->revision == revision) {
+			if (!state->n_path) {
+				state->n_path = i;
 			} else {
-				path_state.upper_n_color = path_state.lower_n_color;
+				path_state->upper_link = TRUE;
+				path_state->lower_n_color = INVALID_COLOR;
 			}
-		} else {
-			path_state.lower_n_color =
-				GPOINTER_TO_INT (g_hash_table_lookup (visible_paths, GINT_TO_POINTER (n_path)));
 
-			path_state.upper_n_color = path_state.lower_n_color;
+			g_object_unref (path->revision);
+			path->revision = NULL;
 		}
+	}
 
-		path_state.n_path = n_path;
-		g_hash_table_insert (visible_paths, GINT_TO_POINTER (n_path), GINT_TO_POINTER ((gint) path_state.upper_n_color));
-		g_array_append_val (paths_state, path_state);
-
-		children = children->next;
+	if (!state->n_path) {
+		/* no child shown yet, start a new path */
+		state->n_path = find_path (paths, NULL);
+		path = &g_array_index (paths, GiggleGraphRendererPath, state->n_path);
+		path->n_color = priv->n_color = NEXT_COLOR (priv->n_color);
 	}
 
-	if (!current_path_reused) {
-		/* current path is a dead end, remove it from the visible paths table */
-		n_path = GPOINTER_TO_INT (g_hash_table_lookup (priv->paths_info, revision));
-		g_hash_table_remove (visible_paths, GINT_TO_POINTER (n_path));
+	path = &g_array_index (paths, GiggleGraphRendererPath, state->n_path);
+	state->n_color = path->n_color;
+	parents = git_revision_get_parents (revision);
+	path_state = get_path_state (state->paths_state, state->n_path);
+
+	if (parents) {
+		/* the first parent continues on the path of the revision */
+		path->revision = g_object_ref (parents->data);
+		path_state->lower_n_color = path->n_color;
+	} else {
+		path_state->lower_n_color = INVALID_COLOR;
+	}
 
-		for (i = 0; i < paths_state->len; i++) {
-			path_state = g_array_index (paths_state, GiggleGraphRendererPathState, i);
+	/* other parents are merged into the revision */
+	for (parents = parents ? parents->next : NULL; parents; parents = parents->next) {
+		n_path = find_path (paths, parents->data);
 
-			if (path_state.n_path == n_path) {
-				path_state.upper_n_color = INVALID_COLOR;
-				((GiggleGraphRendererPathState *) paths_state->data)[i] = path_state;
-				break;
-			}
+		if (!n_path) {
+			n_path = find_path (paths, NULL);
+			path = &g_array_index (paths, GiggleGraphRendererPath, n_path);
+			path->revision = g_object_ref (parents->data);
+			path->n_color = priv->n_color = NEXT_COLOR (priv->n_color);
 		}
+
+		path = &g_array_index (paths, GiggleGraphRendererPath, n_path);
+		path_state = get_path_state (state->paths_state, n_path);
+		path_state->lower_n_color = path->n_color;
+		path_state->lower_link = TRUE;
+	}
+
+	for (i = 0; i < state->paths_state->len; i++) {
+		n_path = g_array_index (state->paths_state, GiggleGraphRendererPathState, i).n_path;
+		priv->n_paths = MAX (priv->n_paths, n_path);
+	}
+
+	/* drop the free paths at the right side */
+	while (paths->len > 1 &&
+	       !g_array_index (paths, GiggleGraphRendererPath, paths->len - 1).revision) {
+		g_array_set_size (paths, paths->len - 1);
 	}
 
 	g_object_set_qdata_full (G_OBJECT (revision), revision_paths_state_quark,
-				 paths_state, (GDestroyNotify) free_paths_state);
+				 state, (GDestroyNotify) free_revision_state);
 }
 
 void
@@ -493,50 +579,23 @@ giggle_graph_renderer_validate_model (GiggleGraphRenderer *renderer,
 				      GtkTreeModel        *model,
 				      gint                 column)
 {
-	GiggleGraphRendererPrivate *priv;
-	GtkTreeIter                 iter;
-	gint                        n_children;
-	gint                        n_color = 0;
-	GitRevision             *revision;
-	GHashTable                 *visible_paths;
-	GType                       contained_type;
-	gint                        n_path;
+	GtkTreeIter  iter;
+	GitRevision *revision;
+	gboolean     valid;
 
 	g_return_if_fail (GIGGLE_IS_GRAPH_RENDERER (renderer));
 	g_return_if_fail (GTK_IS_TREE_MODEL (model));
 
-	priv = renderer->_priv;
-	contained_type = gtk_tree_model_get_column_type (model, column);
-
-	/*g_return_if_fail (contained_type == GIT_TYPE_REVISION);*/
-
-	if (priv->paths_info) {
-		g_hash_table_destroy (priv->paths_info);
-	}
+	giggle_graph_renderer_reset (renderer);
 
-	priv->n_paths = 0;
-	priv->paths_info = g_hash_table_new (g_direct_hash, g_direct_equal);
-	visible_paths = g_hash_table_new (g_direct_hash, g_direct_equal);
-	n_children = gtk_tree_model_iter_n_children (model, NULL);
-
-	while (n_children) {
-		/* need to calculate state backwards for proper color asignment */
-		n_children--;
-		gtk_tree_model_iter_nth_child (model, &iter, NULL, n_children);
+	for (valid = gtk_tree_model_get_iter_first (model, &iter);
+	     valid;
+	     valid = gtk_tree_model_iter_next (model, &iter)) {
 		gtk_tree_model_get (model, &iter, column, &revision, -1);
 
 		if (revision) {
-			if (!git_revision_has_parents (revision)) {
-				n_color = NEXT_COLOR (n_color);
-				find_free_path (visible_paths, &priv->n_paths, &n_path);
-				g_hash_table_insert (priv->paths_info, revision, GINT_TO_POINTER (n_path));
-				g_hash_table_insert (visible_paths, GINT_TO_POINTER (n_path), GINT_TO_POINTER (n_color));
-			}
-
-			giggle_graph_renderer_calculate_revision_state (renderer, revision, visible_paths, &n_color);
+			giggle_graph_renderer_add_revision (renderer, revision);
 			g_object_unref (revision);
 		}
 	}
-
-	g_hash_table_destroy (visible_paths);
 }
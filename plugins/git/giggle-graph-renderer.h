@@ -24,6 +24,7 @@
 G_BEGIN_DECLS
 
 #include <gtk/gtk.h>
+#include "git-revision.h"
 
 #define GIGGLE_TYPE_GRAPH_RENDERER                 (giggle_graph_renderer_get_type ())
 #define GIGGLE_GRAPH_RENDERER(obj)                 (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIGGLE_TYPE_GRAPH_RENDERER, GiggleGraphRenderer))
@@ -49,6 +50,9 @@ struct GiggleGraphRendererClass {
 GType		 giggle_graph_renderer_get_type (void);
 GtkCellRenderer *giggle_graph_renderer_new      (void);
 
+void             giggle_graph_renderer_reset          (GiggleGraphRenderer *renderer);
+void             giggle_graph_renderer_add_revision   (GiggleGraphRenderer *renderer,
+						       GitRevision         *revision);
 void             giggle_graph_renderer_validate_model (GiggleGraphRenderer *renderer,
 						       GtkTreeModel        *model,
 						       gint                 column);
@@ -24,18 +24,11 @@
 
 #include "git-branch-list-command.h"
 
-/* Detects the currently active branch in the output */
-#define ACTIVE_BRANCH_REGEX "^\\* (.*)"
-
-/* Other branches. Just strips off the space and newlines for us :) */
-#define REGULAR_BRANCH_REGEX "^(?:\\s) (.*)"
-
 struct _GitBranchListCommandPriv
 {
 	GitBranchType type;
-	GRegex *active_branch_regex;
-	GRegex *regular_branch_regex;
 	GList *output;
+	GList *last_output;
 	GFileMonitor *ref_monitor;
 	GFileMonitor *head_monitor;
 };
@@ -46,10 +39,6 @@ static void
 git_branch_list_command_init (GitBranchListCommand *self)
 {
 	self->priv = g_new0 (GitBranchListCommandPriv, 1);
-	self->priv->active_branch_regex = g_regex_new (ACTIVE_BRANCH_REGEX, 0, 0,
-												   NULL);
-	self->priv->regular_branch_regex = g_regex_new (REGULAR_BRANCH_REGEX, 0, 0,
-													NULL);
 }
 
 static void
@@ -58,6 +47,7 @@ git_branch_list_command_clear_output (GitBranchListCommand *self)
 	g_list_foreach (self->priv->output, (GFunc) g_object_unref, NULL);
 	g_list_free (self->priv->output);
 	self->priv->output = NULL;
+	self->priv->last_output = NULL;
 }
 
 static void
@@ -157,9 +147,6 @@ git_branch_list_command_finalize (GObject *object)
 	
 	self = GIT_BRANCH_LIST_COMMAND (object);
 	
-	g_regex_unref (self->priv->active_branch_regex);
-	g_regex_unref (self->priv->regular_branch_regex);
-
 	git_branch_list_command_clear_output (self);
 	git_branch_list_command_stop_automatic_monitor (ANJUTA_COMMAND (self));
 	
@@ -198,52 +185,35 @@ git_branch_list_command_data_arrived (AnjutaCommand *command)
 	git_branch_list_command_clear_output (GIT_BRANCH_LIST_COMMAND (command));
 }
 
-static void
-git_branch_list_command_handle_output (GitCommand *git_command, 
-									   const gchar *output)
+/* Each line is the branch name after a two characters marker, a star for the
+ * active branch */
+static gboolean
+git_branch_list_command_handle_record (GitCommand *git_command, 
+                                       const gchar *record, gsize length)
 {
 	GitBranchListCommand *self;
-	GMatchInfo *active_match_info;
-	GMatchInfo *regular_match_info;
 	gchar *branch_name;
 	GitBranch *branch;
-	gboolean active;
 
 	self = GIT_BRANCH_LIST_COMMAND (git_command);
-	
-	active_match_info = NULL;
-	regular_match_info = NULL;
-	branch_name = NULL;
-	branch = NULL;
-	active = FALSE;
-	
-	if (g_regex_match (self->priv->active_branch_regex, output, 0, 
-					   &active_match_info))
-	{
-		branch_name = g_match_info_fetch (active_match_info, 1);
-		active = TRUE;
-	}
-	else if (g_regex_match (self->priv->regular_branch_regex, output, 0,
-							&regular_match_info))
+
+	if (length < 3 || (record[0] != '*' && record[0] != ' ') || 
+	    record[1] != ' ')
 	{
-		branch_name = g_match_info_fetch (regular_match_info, 1);
+		return FALSE;
 	}
-	
-	if (branch_name)
-		branch = git_branch_new (branch_name, active);
-	
-	g_free (branch_name);
 
+	branch_name = g_strndup (record + 2, length - 2);
+	branch = git_branch_new (branch_name, record[0] == '*');
+	g_free (branch_name);
 
-	if (active_match_info)
-		g_match_info_free (active_match_info);
+	/* Git command notifies once for all the branches read together */
+	if (self->priv->last_output)
+		self->priv->last_output = g_list_append (self->priv->last_output, branch)->next;
+	else
+		self->priv->output = self->priv->last_output = g_list_append (NULL, branch);
 
-	if (regular_match_info)
-		g_match_info_free (regular_match_info);
-	
-	self->priv->output = g_list_append (self->priv->output, branch);
-	anjuta_command_notify_data_arrived (ANJUTA_COMMAND (git_command));
-	
+	return TRUE;
 }
 
 static void
@@ -254,7 +224,7 @@ git_branch_list_command_class_init (GitBranchListCommandClass *klass)
 	AnjutaCommandClass *command_class = ANJUTA_COMMAND_CLASS (klass);
 
 	object_class->finalize = git_branch_list_command_finalize;
-	parent_class->output_handler = git_branch_list_command_handle_output;
+	parent_class->record_handler = git_branch_list_command_handle_record;
 	command_class->run = git_branch_list_command_run;
 	command_class->data_arrived = git_branch_list_command_data_arrived;
 	command_class->start_automatic_monitor = git_branch_list_command_start_automatic_monitor;
@@ -270,7 +240,6 @@ git_branch_list_command_new (const gchar *working_directory,
 	
 	self = g_object_new (GIT_TYPE_BRANCH_LIST_COMMAND,
 						 "working-directory", working_directory,
-						 "single-line-output", TRUE,
 						 NULL);
 	
 	self->priv->type = type;
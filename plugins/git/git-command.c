@@ -23,6 +23,7 @@
  */
 
 #include "git-command.h"
+#include "git-tokenizer.h"
 
 #define ERROR_REGEX "^(?:warning|fatal|error): (.*)"
 #define PROGRESS_REGEX "(\\d{1,3}(?=%))"
@@ -34,7 +35,8 @@ enum
 	
 	PROP_WORKING_DIRECTORY,
 	PROP_SINGLE_LINE_OUTPUT,
-	PROP_STRIP_NEWLINES
+	PROP_STRIP_NEWLINES,
+	PROP_RECORD_SEPARATOR
 };
 
 struct _GitCommandPriv
@@ -50,6 +52,11 @@ struct _GitCommandPriv
 	GQueue *info_queue;
 	gboolean single_line_output;
 	gboolean strip_newlines;
+	gchar record_separator;
+
+	/* Incomplete record or error line kept until the rest arrives */
+	GString *partial_output;
+	GString *partial_error;
 };
 
 G_DEFINE_TYPE (GitCommand, git_command, ANJUTA_TYPE_SYNC_COMMAND);
@@ -194,6 +201,107 @@ git_command_single_line_output_arrived (AnjutaLauncher *launcher,
 	}
 }
 
+static guint
+git_command_split_records (GitCommand *self, GString *partial, gchar separator,
+                           const gchar *chars, gsize length,
+                           gboolean (*handler) (GitCommand *git_command, 
+                                                const gchar *record, 
+                                                gsize length))
+{
+	GitTokenizer tokenizer;
+	const gchar *record;
+	gsize record_length;
+	guint n_records;
+
+	/* Count the records giving some output */
+	git_tokenizer_init (&tokenizer, chars, length);
+	n_records = 0;
+
+	while (git_tokenizer_next (&tokenizer, separator, &record, &record_length))
+	{
+		/* Only records cut between two reads are copied */
+		if (partial->len > 0)
+		{
+			g_string_append_len (partial, record, record_length);
+			if (handler (self, partial->str, partial->len))
+				n_records++;
+			g_string_truncate (partial, 0);
+		}
+		else if (handler (self, record, record_length))
+			n_records++;
+	}
+
+	if (git_tokenizer_get_rest (&tokenizer, &record, &record_length))
+		g_string_append_len (partial, record, record_length);
+
+	return n_records;
+}
+
+static gboolean
+git_command_handle_error_record (GitCommand *self, const gchar *record,
+                                 gsize length)
+{
+	gchar *line;
+
+	line = g_strndup (record, length);
+	GIT_COMMAND_GET_CLASS (self)->error_handler (self, line);
+	g_free (line);
+
+	return FALSE;
+}
+
+static void
+git_command_record_output_arrived (AnjutaLauncher *launcher,
+                                   AnjutaLauncherOutputType output_type,
+                                   const gchar *chars, gsize length,
+                                   GitCommand *self)
+{
+	switch (output_type)
+	{
+		case ANJUTA_LAUNCHER_OUTPUT_STDOUT:
+			if (git_command_split_records (self, self->priv->partial_output,
+			                               self->priv->record_separator,
+			                               chars, length,
+			                               GIT_COMMAND_GET_CLASS (self)->record_handler) > 0)
+			{
+				anjuta_command_notify_data_arrived (ANJUTA_COMMAND (self));
+			}
+			break;
+		case ANJUTA_LAUNCHER_OUTPUT_STDERR:
+			git_command_split_records (self, self->priv->partial_error, '\n',
+			                           chars, length,
+			                           git_command_handle_error_record);
+			break;
+		default:
+			break;
+	}
+}
+
+/* Give the records not terminated by a separator at the end of the output */
+static void
+git_command_flush_records (GitCommand *self)
+{
+	if (self->priv->partial_output->len > 0)
+	{
+		gboolean queued;
+
+		queued = GIT_COMMAND_GET_CLASS (self)->record_handler (self, 
+		                                                       self->priv->partial_output->str,
+		                                                       self->priv->partial_output->len);
+		g_string_truncate (self->priv->partial_output, 0);
+
+		if (queued)
+			anjuta_command_notify_data_arrived (ANJUTA_COMMAND (self));
+	}
+
+	if (self->priv->partial_error->len > 0)
+	{
+		git_command_handle_error_record (self, self->priv->partial_error->str,
+		                                 self->priv->partial_error->len);
+		g_string_truncate (self->priv->partial_error, 0);
+	}
+}
+
 static void
 git_command_launch (GitCommand *self)
 {
@@ -220,6 +328,17 @@ git_command_launch (GitCommand *self)
 	else
 		callback = (AnjutaLauncherOutputCallback) git_command_multi_line_output_arrived;
 
+	/* Records can end with a nul character and are split here, so read the
+	 * output as it comes */
+	if (GIT_COMMAND_GET_CLASS (self)->record_handler)
+	{
+		g_string_truncate (self->priv->partial_output, 0);
+		g_string_truncate (self->priv->partial_error, 0);
+		anjuta_launcher_set_buffered_output (self->priv->launcher, FALSE);
+		anjuta_launcher_set_slice_callback (self->priv->launcher,
+		                                    (AnjutaLauncherSliceCallback) git_command_record_output_arrived);
+	}
+
 	if (!anjuta_launcher_execute_v (self->priv->launcher,
 	    							self->priv->working_directory,
 									args,
@@ -328,6 +447,9 @@ static void
 git_command_child_exited (AnjutaLauncher *launcher, gint child_pid, gint status, 
 						  gulong time, GitCommand *self)
 {	
+	if (GIT_COMMAND_GET_CLASS (self)->record_handler)
+		git_command_flush_records (self);
+
 	if (strlen (self->priv->error_string->str) > 0)
 	{
 		anjuta_command_set_error_message (ANJUTA_COMMAND (self),
@@ -358,6 +480,9 @@ git_command_init (GitCommand *self)
 	self->priv->status_regex = g_regex_new (STATUS_REGEX, 0, 0, NULL);
 	self->priv->error_string = g_string_new ("");
 	self->priv->info_queue = g_queue_new ();
+	self->priv->record_separator = '\n';
+	self->priv->partial_output = g_string_new ("");
+	self->priv->partial_error = g_string_new ("");
 }
 
 static void
@@ -383,6 +508,8 @@ git_command_finalize (GObject *object)
 	g_regex_unref (self->priv->progress_regex);
 	g_regex_unref (self->priv->status_regex);
 	g_string_free (self->priv->error_string, TRUE);
+	g_string_free (self->priv->partial_output, TRUE);
+	g_string_free (self->priv->partial_error, TRUE);
 	g_queue_free (self->priv->info_queue);
 	g_free (self->priv->working_directory);
 	g_free (self->priv);
@@ -410,6 +537,9 @@ git_command_set_property (GObject *object, guint prop_id, const GValue *value,
 		case PROP_STRIP_NEWLINES:
 			self->priv->strip_newlines = g_value_get_boolean (value);
 			break;
+		case PROP_RECORD_SEPARATOR:
+			self->priv->record_separator = g_value_get_schar (value);
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   			break;
@@ -447,6 +577,7 @@ git_command_class_init (GitCommandClass *klass)
 	command_class->start = git_command_start;
 	klass->output_handler = NULL;
 	klass->error_handler = git_command_error_handler;
+	klass->record_handler = NULL;
 	
 	g_object_class_install_property (object_class, PROP_WORKING_DIRECTORY,
 									 g_param_spec_string ("working-directory",
@@ -475,6 +606,20 @@ git_command_class_init (GitCommandClass *klass)
 														   "output.", 
 														   FALSE,
 														   G_PARAM_CONSTRUCT_ONLY | G_PARAM_WRITABLE));
+
+	g_object_class_install_property (object_class, PROP_RECORD_SEPARATOR,
+									 g_param_spec_char ("record-separator",
+														"",
+														"Character ending "
+														"each record given "
+														"to the record "
+														"handler, a nul "
+														"character for the "
+														"-z output of git.",
+														G_MININT8,
+														G_MAXINT8,
+														'\n',
+														G_PARAM_CONSTRUCT_ONLY | G_PARAM_WRITABLE));
 }
 
 
@@ -54,6 +54,13 @@ struct _GitCommandClass
 	/* Virtual methods */
 	void (*output_handler) (GitCommand *git_command, const gchar *output);
 	void (*error_handler) (GitCommand *git_command, const gchar *output);
+
+	/* If set, the standard output is split in records ending with the 
+	 * record-separator property, given in place without a nul terminator. 
+	 * The handler returns TRUE if it has queued some output, ::data-arrived
+	 * is then emitted once for all the records read at once */
+	gboolean (*record_handler) (GitCommand *git_command, const gchar *record, 
+	                            gsize length);
 };
 
 struct _GitCommand
@@ -46,7 +46,7 @@ G_DEFINE_TYPE (GitLogCommand, git_log_command, GIT_TYPE_COMMAND);
 static void
 on_data_command_data_arrived (AnjutaCommand *command, GitLogCommand *self)
 {
-	anjuta_command_notify_data_arrived (command);
+	anjuta_command_notify_data_arrived (ANJUTA_COMMAND (self));
 }
 
 static void
@@ -103,11 +103,8 @@ git_log_command_run (AnjutaCommand *command)
 	
 	git_command_add_arg (GIT_COMMAND (command), "rev-list");
 	git_command_add_arg (GIT_COMMAND (command), "--topo-order");
-	git_command_add_arg (GIT_COMMAND (command), "--pretty=format:parents %P%n"
-												"author %an%n"
-												"time %at%n"
-												"short log %s%n"
-												"\x0c");
+	git_command_add_arg (GIT_COMMAND (command), "--pretty=format:%H%x00%P%x00"
+												"%an%x00%at%x00%s");
 	
 	if (self->priv->author)
 	{
@@ -182,20 +179,33 @@ git_log_command_notify_complete (AnjutaCommand *command, guint return_code)
 	/* Send an empty string to the data processing command so that it knows
 	 * to stop when it's done processing data. The command will finish when 
 	 * the processing thread finishes, and not when git stops executing */
-	git_log_data_command_push_line (self->priv->data_command, "");
+	git_log_data_command_push_record (self->priv->data_command, NULL, 0);
 
 	/* Use the git return code */
 	self->priv->return_code = return_code;
 }
 
-static void
-git_log_command_handle_output (GitCommand *git_command, const gchar *output)
+static gboolean
+git_log_command_handle_record (GitCommand *git_command, const gchar *record,
+                               gsize length)
 {
 	GitLogCommand *self;
 	
 	self = GIT_LOG_COMMAND (git_command);
 
-	git_log_data_command_push_line (self->priv->data_command, output);
+	/* rev-list puts a commit line before each formatted revision, the sha is
+	 * in the format too */
+	if (length == 0 || 
+	    (length > 7 && memcmp (record, "commit ", 7) == 0))
+	{
+		return FALSE;
+	}
+
+	git_log_data_command_push_record (self->priv->data_command, record, 
+	                                  length);
+
+	/* Revisions are notified by the data command once parsed */
+	return FALSE;
 }
 
 static void
@@ -206,7 +216,7 @@ git_log_command_class_init (GitLogCommandClass *klass)
 	AnjutaCommandClass *command_class = ANJUTA_COMMAND_CLASS (klass);
 
 	object_class->finalize = git_log_command_finalize;
-	parent_class->output_handler = git_log_command_handle_output;
+	parent_class->record_handler = git_log_command_handle_record;
 	command_class->run = git_log_command_run;
 	command_class->notify_complete = git_log_command_notify_complete;
 }
@@ -224,7 +234,6 @@ git_log_command_new (const gchar *working_directory,
 	
 	self = g_object_new (GIT_TYPE_LOG_COMMAND, 
 						 "working-directory", working_directory,
-						 "single-line-output", TRUE,
 						 NULL);
 	
 	self->priv->author = g_strdup (author);
@@ -244,3 +253,9 @@ git_log_command_get_output_queue (GitLogCommand *self)
 {
 	return git_log_data_command_get_output (self->priv->data_command);
 }
+
+GHashTable *
+git_log_command_get_revisions (GitLogCommand *self)
+{
+	return git_log_data_command_get_revisions (self->priv->data_command);
+}
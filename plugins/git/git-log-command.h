@@ -67,6 +67,7 @@ GitLogCommand *git_log_command_new (const gchar *working_directory,
 									const gchar *since_commit,
 									const gchar *until_commit);
 GQueue *git_log_command_get_output_queue (GitLogCommand *self);
+GHashTable *git_log_command_get_revisions (GitLogCommand *self);
 
 G_END_DECLS
 
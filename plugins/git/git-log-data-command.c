@@ -18,24 +18,13 @@
  */
 
 #include "git-log-data-command.h"
-
-#define COMMIT_REGEX "^commit ([[:xdigit:]]{40})"
-#define PARENT_REGEX "^parents (.*)"
-#define AUTHOR_REGEX "^author (.*)"
-#define TIME_REGEX "^time (\\d*)"
-#define SHORT_LOG_REGEX "^(?:short log) (.*)"
+#include "git-tokenizer.h"
 
 struct _GitLogDataCommandPriv
 {
 	GAsyncQueue *input_queue;
 	GQueue *output_queue;
 	GHashTable *revisions;
-	GitRevision *current_revision;
-	GRegex *commit_regex;
-	GRegex *parent_regex;
-	GRegex *author_regex;
-	GRegex *time_regex;
-	GRegex *short_log_regex;
 };
 
 G_DEFINE_TYPE (GitLogDataCommand, git_log_data_command, 
@@ -45,15 +34,10 @@ static void
 git_log_data_command_init (GitLogDataCommand *self)
 {
 	self->priv = g_new0 (GitLogDataCommandPriv, 1);
-	self->priv->input_queue = g_async_queue_new_full (g_free);
+	self->priv->input_queue = g_async_queue_new_full ((GDestroyNotify) g_bytes_unref);
 	self->priv->output_queue = g_queue_new ();
 	self->priv->revisions = g_hash_table_new_full (g_str_hash, g_str_equal,
 												   g_free, g_object_unref);
-	self->priv->commit_regex = g_regex_new (COMMIT_REGEX, 0, 0, NULL);
-	self->priv->parent_regex = g_regex_new (PARENT_REGEX, 0, 0, NULL);
-	self->priv->author_regex = g_regex_new (AUTHOR_REGEX, 0, 0, NULL);
-	self->priv->time_regex = g_regex_new (TIME_REGEX, 0, 0, NULL);
-	self->priv->short_log_regex = g_regex_new (SHORT_LOG_REGEX, 0, 0, NULL);
 }
 
 static void
@@ -74,148 +58,123 @@ git_log_data_command_finalize (GObject *object)
 	}
 	
 	g_queue_free (self->priv->output_queue);
-	g_hash_table_destroy (self->priv->revisions);
-	g_regex_unref (self->priv->commit_regex);
-	g_regex_unref (self->priv->parent_regex);
-	g_regex_unref (self->priv->author_regex);
-	g_regex_unref (self->priv->time_regex);
-	g_regex_unref (self->priv->short_log_regex);
+	/* git-log-pane.c may still hold a reference on the revisions */
+	g_hash_table_unref (self->priv->revisions);
 
 	G_OBJECT_CLASS (git_log_data_command_parent_class)->finalize (object);
 }
 
+static GitRevision *
+git_log_data_command_get_revision (GitLogDataCommand *self, 
+                                   const gchar *sha, gsize length)
+{
+	gchar *key;
+	GitRevision *revision;
+
+	key = g_strndup (sha, length);
+	revision = g_hash_table_lookup (self->priv->revisions, key);
+
+	if (!revision)
+	{
+		revision = git_revision_new ();
+		git_revision_set_sha (revision, key);
+		g_hash_table_insert (self->priv->revisions, key, 
+		                     g_object_ref (revision));
+	}
+	else
+		g_free (key);
+
+	return revision;
+}
+
+/* Each record has the sha, the parents, the author, the time and the short
+ * log of a revision separated by nul characters */
 static guint
 git_log_data_command_run (AnjutaCommand *command)
 {
 	GitLogDataCommand *self;
-	gchar *line;
-	GMatchInfo *commit_match_info;
-	GMatchInfo *parent_match_info;
-	GMatchInfo *author_match_info;
-	GMatchInfo *time_match_info;
-	GMatchInfo *short_log_match_info;
-	gchar *commit_sha;
-	gchar *parents;
-	gchar **parent_shas;
-	gint i;
+	GBytes *record;
+	GitTokenizer tokenizer;
+	GitTokenizer parent_tokenizer;
+	const gchar *sha;
+	const gchar *parents;
+	const gchar *author;
+	const gchar *time;
+	const gchar *short_log;
+	gsize sha_length;
+	gsize parents_length;
+	gsize author_length;
+	gsize time_length;
+	gsize short_log_length;
+	const gchar *parent_sha;
+	gsize parent_sha_length;
+	GitRevision *revision;
 	GitRevision *parent_revision;
-	gchar *author;
-	gchar *time;
-	gchar *short_log;
+	gchar *field;
 
 	self = GIT_LOG_DATA_COMMAND (command);
 
-	while ((line = g_async_queue_pop (self->priv->input_queue)))
+	while ((record = g_async_queue_pop (self->priv->input_queue)))
 	{
-		/* An empty string means there's nothing left to process */
-		if (g_utf8_strlen (line, -1) == 0)
+		gconstpointer data;
+		gsize length;
+
+		data = g_bytes_get_data (record, &length);
+
+		/* An empty record means there's nothing left to process */
+		if (length == 0)
 		{
-			g_free (line);
+			g_bytes_unref (record);
 			break;
 		}
 
-		commit_match_info = NULL;
-		parent_match_info = NULL;
-		author_match_info = NULL;
-		time_match_info = NULL;
-		short_log_match_info = NULL;
-
-		/* Entries are delimited by the hex value 0x0c */
-		if (*line == 0x0c && self->priv->current_revision)
-		{	
-			anjuta_async_command_lock (ANJUTA_ASYNC_COMMAND (command));
-			g_queue_push_tail (self->priv->output_queue, 
-			                   self->priv->current_revision);
-			anjuta_async_command_unlock (ANJUTA_ASYNC_COMMAND (command));
-			
-			anjuta_command_notify_data_arrived (command);
-		}
+		git_tokenizer_init (&tokenizer, data, length);
 
-		if (g_regex_match (self->priv->commit_regex, line, 0, &commit_match_info))
+		if (!git_tokenizer_next (&tokenizer, '\0', &sha, &sha_length) ||
+		    !git_tokenizer_next (&tokenizer, '\0', &parents, &parents_length) ||
+		    !git_tokenizer_next (&tokenizer, '\0', &author, &author_length) ||
+		    !git_tokenizer_next (&tokenizer, '\0', &time, &time_length))
 		{
-			commit_sha = g_match_info_fetch (commit_match_info, 1);
-
-			self->priv->current_revision = g_hash_table_lookup (self->priv->revisions, 
-			                                                    commit_sha);
+			g_bytes_unref (record);
+			continue;
+		}
 
-			if (!self->priv->current_revision)
-			{
-				self->priv->current_revision = git_revision_new ();
-				git_revision_set_sha (self->priv->current_revision, commit_sha);
-				g_hash_table_insert (self->priv->revisions, g_strdup (commit_sha),
-				                     g_object_ref (self->priv->current_revision));
-			}
+		git_tokenizer_get_rest (&tokenizer, &short_log, &short_log_length);
 
-			g_free (commit_sha);
-		}
-		else if (g_regex_match (self->priv->parent_regex, line, 0, 
-		                        &parent_match_info))
-		{	
-			parents = g_match_info_fetch (parent_match_info, 1);
-			parent_shas = g_strsplit (parents, " ", -1);
-
-			for (i = 0; parent_shas[i]; i++)
-			{
-				parent_revision = g_hash_table_lookup (self->priv->revisions,
-				                                       parent_shas[i]);
-
-				if (!parent_revision)
-				{
-					parent_revision = git_revision_new ();
-					git_revision_set_sha (parent_revision, parent_shas[i]);
-					g_hash_table_insert (self->priv->revisions,
-					                     g_strdup (parent_shas[i]),
-					                     g_object_ref (parent_revision));
-				}
-
-				git_revision_add_child (parent_revision,
-				                        self->priv->current_revision);
-			}
-
-			g_free (parents);
-			g_strfreev (parent_shas);
-		}
-		else if (g_regex_match (self->priv->author_regex, line, 0, 
-		                        &author_match_info))
-		{
-			author = g_match_info_fetch (author_match_info, 1);
-			git_revision_set_author (self->priv->current_revision, author);
+		revision = git_log_data_command_get_revision (self, sha, sha_length);
 
-			g_free (author);
-		}
-		else if (g_regex_match (self->priv->time_regex, line, 0, 
-		                        &time_match_info))
-		{
-			time = g_match_info_fetch (time_match_info, 1);
-			git_revision_set_date (self->priv->current_revision, atol (time));
+		/* Parents are separated by spaces */
+		git_tokenizer_init (&parent_tokenizer, parents, parents_length);
 
-			g_free (time);
-		}
-		else if (g_regex_match (self->priv->short_log_regex, line, 0, 
-		                        &short_log_match_info))
+		while (git_tokenizer_next (&parent_tokenizer, ' ', &parent_sha, 
+		                           &parent_sha_length) ||
+		       git_tokenizer_get_rest (&parent_tokenizer, &parent_sha,
+		                               &parent_sha_length))
 		{
-			short_log = g_match_info_fetch (short_log_match_info, 1);
-			git_revision_set_short_log (self->priv->current_revision, short_log);
-
-			g_free (short_log);
+			parent_revision = git_log_data_command_get_revision (self, 
+			                                                     parent_sha,
+			                                                     parent_sha_length);
+			git_revision_add_child (parent_revision, revision);
 		}
 
-		if (commit_match_info)
-			g_match_info_free (commit_match_info);
+		field = g_strndup (author, author_length);
+		git_revision_set_author (revision, field);
+		g_free (field);
 
-		if (parent_match_info)
-			g_match_info_free (parent_match_info);
+		/* The time is followed by a separator */
+		git_revision_set_date (revision, atol (time));
 
-		if (author_match_info)
-			g_match_info_free (author_match_info);
+		field = g_strndup (short_log, short_log_length);
+		git_revision_set_short_log (revision, field);
+		g_free (field);
 
-		if (time_match_info)
-			g_match_info_free (time_match_info);
+		g_bytes_unref (record);
 
-		if (short_log_match_info)
-			g_match_info_free (short_log_match_info);
+		anjuta_async_command_lock (ANJUTA_ASYNC_COMMAND (command));
+		g_queue_push_tail (self->priv->output_queue, revision);
+		anjuta_async_command_unlock (ANJUTA_ASYNC_COMMAND (command));
 
-		g_free (line);
+		anjuta_command_notify_data_arrived (command);
 	}
 
 	return 0;
@@ -243,8 +202,19 @@ git_log_data_command_get_output (GitLogDataCommand *self)
 	return self->priv->output_queue;
 }
 
+/* Table of all the revisions by sha, including parents not in the log. It
+ * owns the revisions, which don't own each other */
+GHashTable *
+git_log_data_command_get_revisions (GitLogDataCommand *self)
+{
+	return self->priv->revisions;
+}
+
+/* Copy a record of the log output for the processing thread, an empty record
+ * ends the processing */
 void
-git_log_data_command_push_line (GitLogDataCommand *self, const gchar *line)
+git_log_data_command_push_record (GitLogDataCommand *self, const gchar *record,
+                                  gsize length)
 {
-	g_async_queue_push (self->priv->input_queue, g_strdup (line));
+	g_async_queue_push (self->priv->input_queue, g_bytes_new (record, length));
 }
@@ -53,8 +53,9 @@ struct _GitLogDataCommand
 GType git_log_data_command_get_type (void) G_GNUC_CONST;
 GitLogDataCommand *git_log_data_command_new (void);
 GQueue *git_log_data_command_get_output (GitLogDataCommand *self);
-void git_log_data_command_push_line (GitLogDataCommand *self, 
-                                     const gchar *line);
+GHashTable *git_log_data_command_get_revisions (GitLogDataCommand *self);
+void git_log_data_command_push_record (GitLogDataCommand *self, 
+                                       const gchar *record, gsize length);
 
 G_END_DECLS
 
@@ -47,6 +47,10 @@ enum
 	BRANCH_COL_NAME
 };
 
+/* Number of revisions added to the log view each time it is scrolled near its
+ * end */
+#define LOG_PAGE_SIZE 1000
+
 /* DnD source targets */
 static GtkTargetEntry drag_source_targets[] =
 {
@@ -96,6 +100,17 @@ struct _GitLogPanePriv
 	GitBranchListCommand *branch_list_command;
 	GitLogMessageCommand *log_message_command;
 	GitLogCommand        *log_command;
+
+	/* Revision table of the last log command, it keeps alive the parents of
+	 * the revisions in the view, even after the command is gone */
+	GHashTable *revisions;
+
+	/* Revisions received from the log command but not shown yet. Rows are
+	 * added a page at a time as the view is scrolled down, so a long history
+	 * doesn't have to be in the model before the first revisions are shown */
+	GQueue pending_revisions;
+	gint n_revisions;
+	gint wanted_revisions;
 };
 
 G_DEFINE_TYPE (GitLogPane, git_log_pane, GIT_TYPE_PANE);
@@ -272,20 +287,64 @@ git_log_pane_set_view_mode (GitLogPane *self, LogViewMode mode)
 }
 
 static void
-on_log_command_finished (AnjutaCommand *command, guint return_code, 
-						 GitLogPane *self)
+git_log_pane_clear_pending_revisions (GitLogPane *self)
+{
+	GitRevision *revision;
+
+	while ((revision = g_queue_pop_head (&self->priv->pending_revisions)))
+		g_object_unref (revision);
+}
+
+static void
+git_log_pane_add_pending_revisions (GitLogPane *self)
 {
-	GtkTreeView *log_view;
-	GQueue *queue;
 	GtkTreeIter iter;
 	GitRevision *revision;
 
-	/* Show the actual log view */
-	git_log_pane_set_view_mode (self, LOG_VIEW_NORMAL);
+	while (self->priv->n_revisions < self->priv->wanted_revisions &&
+	       (revision = g_queue_pop_head (&self->priv->pending_revisions)))
+	{
+		gtk_list_store_append (self->priv->log_model, &iter);
+		gtk_list_store_set (self->priv->log_model, &iter, LOG_COL_REVISION, 
+		                    revision, -1);
 
-	log_view = GTK_TREE_VIEW (gtk_builder_get_object (self->priv->builder, 
-	                                                  "log_view"));
-	
+		/* Rows are added in order so the graph of a revision only depends on
+		 * the rows above it */
+		giggle_graph_renderer_add_revision (GIGGLE_GRAPH_RENDERER (self->priv->graph_renderer),
+		                                    revision);
+
+		g_object_unref (revision);
+		self->priv->n_revisions++;
+	}
+
+	/* Show the actual log view as soon as there is something in it */
+	if (self->priv->n_revisions > 0 && self->priv->spin_timer_id > 0)
+		git_log_pane_set_view_mode (self, LOG_VIEW_NORMAL);
+}
+
+static void
+git_log_pane_take_revisions (GitLogPane *self, AnjutaCommand *command)
+{
+	GQueue *queue;
+
+	queue = git_log_command_get_output_queue (GIT_LOG_COMMAND (command));
+
+	while (g_queue_peek_head (queue))
+		g_queue_push_tail (&self->priv->pending_revisions, g_queue_pop_head (queue));
+}
+
+static void
+on_log_command_data_arrived (AnjutaCommand *command, GitLogPane *self)
+{
+	/* The data command keeps the output queue locked while notifying */
+	git_log_pane_take_revisions (self, command);
+	git_log_pane_add_pending_revisions (self);
+}
+
+static void
+on_log_command_finished (AnjutaCommand *command, guint return_code, 
+						 GitLogPane *self)
+{
 	if (return_code != 0)
 	{
 		/* Don't report erros in the log view as this is usually no user requested
@@ -296,40 +355,41 @@ on_log_command_finished (AnjutaCommand *command, guint return_code,
 		git_pane_report_errors (command, return_code,
 		                        ANJUTA_PLUGIN_GIT (anjuta_dock_pane_get_plugin (ANJUTA_DOCK_PANE (self))));
 #endif
-		g_object_ref (self->priv->log_model);
-		gtk_tree_view_set_model (GTK_TREE_VIEW (log_view), NULL);
-		g_object_unref (command);
-		
-		return;
+		git_log_pane_clear_pending_revisions (self);
+		gtk_list_store_clear (self->priv->log_model);
 	}
-	
-	
-	g_object_ref (self->priv->log_model);
-	gtk_tree_view_set_model (GTK_TREE_VIEW (log_view), NULL);
-	
-	queue = git_log_command_get_output_queue (GIT_LOG_COMMAND (command));
-	
-	while (g_queue_peek_head (queue))
+	else
 	{
-		revision = g_queue_pop_head (queue);
-		
-		gtk_list_store_append (self->priv->log_model, &iter);
-		gtk_list_store_set (self->priv->log_model, &iter, LOG_COL_REVISION, 
-		                    revision, -1);
-
-		g_object_unref (revision);
+		/* The data thread is done, get the revisions not notified yet */
+		git_log_pane_take_revisions (self, command);
+		git_log_pane_add_pending_revisions (self);
 	}
-	
-	giggle_graph_renderer_validate_model (GIGGLE_GRAPH_RENDERER (self->priv->graph_renderer),
-										  GTK_TREE_MODEL (self->priv->log_model),
-										  0);
-	gtk_tree_view_set_model (GTK_TREE_VIEW (log_view), 
-							 GTK_TREE_MODEL (self->priv->log_model));
-	g_object_unref (self->priv->log_model);
+
+	git_log_pane_set_view_mode (self, LOG_VIEW_NORMAL);
 	
 	g_clear_object (&self->priv->log_command);
 }
 
+static void
+on_log_view_adjustment_value_changed (GtkAdjustment *adjustment, 
+                                      GitLogPane *self)
+{
+	gdouble value;
+	gdouble page_size;
+
+	value = gtk_adjustment_get_value (adjustment);
+	page_size = gtk_adjustment_get_page_size (adjustment);
+
+	/* Add another page when there is less than a screen left to scroll and
+	 * the current page is full */
+	if (value + 2 * page_size >= gtk_adjustment_get_upper (adjustment) &&
+	    self->priv->n_revisions >= self->priv->wanted_revisions)
+	{
+		self->priv->wanted_revisions = self->priv->n_revisions + LOG_PAGE_SIZE;
+		git_log_pane_add_pending_revisions (self);
+	}
+}
+
 static void
 refresh_log (GitLogPane *self)
 {
@@ -342,7 +402,10 @@ refresh_log (GitLogPane *self)
 
 	/* Unref the previous command if it's still running. */
 	if (self->priv->log_command)
+	{
+		g_signal_handlers_disconnect_by_data (self->priv->log_command, self);
 		g_object_unref (self->priv->log_command);
+	}
 
 	/* We don't support filters for now */
 	self->priv->log_command = git_log_command_new (plugin->project_root_directory,
@@ -362,11 +425,23 @@ refresh_log (GitLogPane *self)
 	else
 		gtk_tree_view_column_set_visible (graph_column, TRUE);
 
+	g_signal_connect (G_OBJECT (self->priv->log_command), "data-arrived",
+	                  G_CALLBACK (on_log_command_data_arrived),
+	                  self);
+
 	g_signal_connect (G_OBJECT (self->priv->log_command), "command-finished",
 	                  G_CALLBACK (on_log_command_finished),
 	                  self);
 
+	git_log_pane_clear_pending_revisions (self);
 	gtk_list_store_clear (self->priv->log_model);
+	if (self->priv->revisions)
+		g_hash_table_unref (self->priv->revisions);
+	self->priv->revisions = 
+		g_hash_table_ref (git_log_command_get_revisions (self->priv->log_command));
+	giggle_graph_renderer_reset (GIGGLE_GRAPH_RENDERER (self->priv->graph_renderer));
+	self->priv->n_revisions = 0;
+	self->priv->wanted_revisions = LOG_PAGE_SIZE;
 
 	/* Show the loading spinner */
 	git_log_pane_set_view_mode (self, LOG_VIEW_LOADING);
@@ -915,6 +990,12 @@ git_log_pane_init (GitLogPane *self)
 	
 	gtk_tree_view_set_model (log_view, GTK_TREE_MODEL (self->priv->log_model));
 
+	/* Add more revisions when scrolling near the end of the log */
+	g_signal_connect (G_OBJECT (gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (log_view))),
+	                  "value-changed",
+	                  G_CALLBACK (on_log_view_adjustment_value_changed),
+	                  self);
+
 	/* Ref icon tooltip */
 	g_signal_connect (G_OBJECT (log_view), "query-tooltip",
 	                  G_CALLBACK (on_log_view_query_tooltip),
@@ -1011,7 +1092,16 @@ git_log_pane_finalize (GObject *object)
 
 	g_clear_object (&self->priv->branch_list_command);
 	g_clear_object (&self->priv->log_message_command);
-	g_clear_object (&self->priv->log_command);
+
+	if (self->priv->log_command)
+	{
+		g_signal_handlers_disconnect_by_data (self->priv->log_command, self);
+		g_clear_object (&self->priv->log_command);
+	}
+
+	git_log_pane_clear_pending_revisions (self);
+	if (self->priv->revisions)
+		g_hash_table_unref (self->priv->revisions);
 
 	/* Remove spin timer source. */
 	if (self->priv->spin_timer_id > 0)
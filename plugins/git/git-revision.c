@@ -31,6 +31,7 @@ struct _GitRevisionPriv
 	gchar *date;
 	gchar *short_log;
 	GList *children;
+	GList *parents;
 	gboolean has_parents;
 };
 
@@ -55,6 +56,7 @@ git_revision_finalize (GObject *object)
 	g_free (self->priv->short_log);
 	
 	g_list_free (self->priv->children);
+	g_list_free (self->priv->parents);
 	g_free (self->priv);
 
 	G_OBJECT_CLASS (git_revision_parent_class)->finalize (object);
@@ -206,6 +208,10 @@ git_revision_add_child (GitRevision *self, GitRevision *child)
 {
 	self->priv->children = g_list_prepend (self->priv->children,
 										  child);
+	/* Keep parents in the order given by git, the first one is the
+	 * revision the child is based on. Like children, they are owned by the
+	 * revision table of the log command */
+	child->priv->parents = g_list_append (child->priv->parents, self);
 	git_revision_set_has_parents (child, TRUE);
 }
 
@@ -215,6 +221,12 @@ git_revision_get_children (GitRevision *self)
 	return self->priv->children;
 }
 
+GList *
+git_revision_get_parents (GitRevision *self)
+{
+	return self->priv->parents;
+}
+
 void
 git_revision_set_has_parents (GitRevision *self, gboolean has_parents)
 {
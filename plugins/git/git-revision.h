@@ -65,6 +65,7 @@ void git_revision_set_date (GitRevision *self, time_t unix_time);
 gchar *git_revision_get_formatted_date (GitRevision *self);
 void git_revision_add_child (GitRevision *self, GitRevision *child);
 GList *git_revision_get_children (GitRevision *self);
+GList *git_revision_get_parents (GitRevision *self);
 void git_revision_set_has_parents (GitRevision *self, gboolean has_parents);
 gboolean git_revision_has_parents (GitRevision *self);
 
@@ -24,7 +24,8 @@
 
 #include "git-status-command.h"
 
-#define STATUS_REGEX "((M|A|D|U|\\?|\\s){2}) (.*)"
+/* Status letters of the entries shown */
+#define STATUS_CODES "MADU? "
 
 struct _GitStatusCommandPriv
 {
@@ -32,7 +33,7 @@ struct _GitStatusCommandPriv
 	GitStatusSections sections;
 	GHashTable *status_codes;
 	GHashTable *conflict_codes;
-	GRegex *status_regex;
+	gboolean skip_record;
 	GFileMonitor *head_monitor;
 	GFileMonitor *index_monitor;
 };
@@ -44,96 +45,117 @@ git_status_command_run (AnjutaCommand *command)
 {
 	git_command_add_arg (GIT_COMMAND (command), "status");
 	git_command_add_arg (GIT_COMMAND (command), "--porcelain");
+	git_command_add_arg (GIT_COMMAND (command), "-z");
+
+	GIT_STATUS_COMMAND (command)->priv->skip_record = FALSE;
 	
 	return 0;
 }
 
-static void
-git_status_command_handle_output (GitCommand *git_command, const gchar *output)
+/* Each entry is "XY path", without any quoting of the path in -z output */
+static gboolean
+git_status_command_handle_record (GitCommand *git_command, 
+                                  const gchar *record, gsize length)
 {
 	GitStatusCommand *self;
-	GMatchInfo *match_info;
 	GitStatus *status_object;
-	gchar *status;
+	gchar status[3];
 	gchar *path;
 	
 	self = GIT_STATUS_COMMAND (git_command);
 	status_object = NULL;
 
-	if (g_regex_match (self->priv->status_regex, output, 0, &match_info))
+	/* Renamed and copied entries are followed by their original path. Like
+	 * before, neither of them is shown */
+	if (self->priv->skip_record)
 	{
-		/* Determine which section this entry goes in */
-		status = g_match_info_fetch (match_info, 1);
-		path = g_match_info_fetch (match_info, 3);
+		self->priv->skip_record = FALSE;
+		return FALSE;
+	}
+
+	if (length < 4 || record[2] != ' ')
+		return FALSE;
+
+	if (record[0] == 'R' || record[0] == 'C')
+	{
+		self->priv->skip_record = TRUE;
+		return FALSE;
+	}
+
+	/* Other status codes, like type changes, aren't handled either */
+	if (strchr (STATUS_CODES, record[0]) == NULL || 
+	    strchr (STATUS_CODES, record[1]) == NULL)
+	{
+		return FALSE;
+	}
 
-		if (status[0] == ' ')
+	status[0] = record[0];
+	status[1] = record[1];
+	status[2] = '\0';
+	path = g_strndup (record + 3, length - 3);
+
+	/* Determine which section this entry goes in */
+	if (status[0] == ' ')
+	{
+		/* Changed but not updated */
+		if (self->priv->sections & GIT_STATUS_SECTION_NOT_UPDATED)
 		{
-			/* Changed but not updated */
-			if (self->priv->sections & GIT_STATUS_SECTION_NOT_UPDATED)
+			status_object = git_status_new(path, 
+			                               GPOINTER_TO_INT (g_hash_table_lookup (self->priv->status_codes, 
+			                                                					 GINT_TO_POINTER (status[1]))));
+		}
+	}
+	else if (status[1] == ' ')
+	{
+		/* Added to commit */
+		if (self->priv->sections & GIT_STATUS_SECTION_COMMIT)
+		{
+			status_object = git_status_new(path, 
+			                               GPOINTER_TO_INT (g_hash_table_lookup (self->priv->status_codes, 
+			                                                    				 GINT_TO_POINTER (status[0]))));
+		}
+	}
+	else
+	{
+		/* File may have been added to the index and then changed again in
+		 * the working tree, or it could be a conflict */
+
+		/* Unversioned files */
+		if (status[0] == '?')
+		{
+			if (self->priv->sections & GIT_STATUS_SECTION_UNTRACKED)
 			{
 				status_object = git_status_new(path, 
-				                               GPOINTER_TO_INT (g_hash_table_lookup (self->priv->status_codes, 
-				                                                					 GINT_TO_POINTER (status[1]))));
+			                           		   ANJUTA_VCS_STATUS_UNVERSIONED);
 			}
 		}
-		else if (status[1] == ' ')
+		else if (g_hash_table_lookup_extended (self->priv->conflict_codes, status,
+		                                       NULL, NULL))
 		{
-			/* Added to commit */
-			if (self->priv->sections & GIT_STATUS_SECTION_COMMIT)
+			/* Conflicts are put in the changed but not updated section */
+			if (self->priv->sections & GIT_STATUS_SECTION_NOT_UPDATED)
 			{
-				status_object = git_status_new(path, 
-				                               GPOINTER_TO_INT (g_hash_table_lookup (self->priv->status_codes, 
-				                                                    				 GINT_TO_POINTER (status[0]))));
+				status_object = git_status_new (path, 
+				                                ANJUTA_VCS_STATUS_CONFLICTED);
 			}
 		}
 		else
 		{
-			/* File may have been added to the index and then changed again in
-			 * the working tree, or it could be a conflict */
-
-			/* Unversioned files */
-			if (status[0] == '?')
-			{
-				if (self->priv->sections & GIT_STATUS_SECTION_UNTRACKED)
-				{
-					status_object = git_status_new(path, 
-				                           		   ANJUTA_VCS_STATUS_UNVERSIONED);
-				}
-			}
-			else if (g_hash_table_lookup_extended (self->priv->conflict_codes, status,
-			                                       NULL, NULL))
-			{
-				/* Conflicts are put in the changed but not updated section */
-				if (self->priv->sections & GIT_STATUS_SECTION_NOT_UPDATED)
-				{
-					status_object = git_status_new (path, 
-					                                ANJUTA_VCS_STATUS_CONFLICTED);
-				}
-			}
-			else
-			{
-				status_object = git_status_new(path, 
-				                               GPOINTER_TO_INT(g_hash_table_lookup (self->priv->status_codes, 
-				                                                                    GINT_TO_POINTER (status[0]))));
-			}
-			    
+			status_object = git_status_new(path, 
+			                               GPOINTER_TO_INT(g_hash_table_lookup (self->priv->status_codes, 
+			                                                                    GINT_TO_POINTER (status[0]))));
 		}
+	}
 
-		
+	g_free (path);
 
-		g_free (status);
-		g_free (path);
+	if (status_object == NULL)
+		return FALSE;
 
-		if (status_object)
-		{
-			g_queue_push_tail (self->priv->status_queue, status_object);
-			anjuta_command_notify_data_arrived (ANJUTA_COMMAND (self));
-		}
-		
-	}
+	/* Git command notifies once for all the entries read together */
+	g_queue_push_tail (self->priv->status_queue, status_object);
 
-	g_match_info_free (match_info);
-	
+	return TRUE;
 }
 
 static void
@@ -141,8 +163,7 @@ git_status_command_init (GitStatusCommand *self)
 {
 	self->priv = g_new0 (GitStatusCommandPriv, 1);
 	self->priv->status_queue = g_queue_new ();
-	
-	self->priv->status_regex = g_regex_new (STATUS_REGEX, 0, 0, NULL);
+
 	self->priv->status_codes = g_hash_table_new (g_direct_hash, g_direct_equal);
 	self->priv->conflict_codes = g_hash_table_new (g_str_hash, g_str_equal);
 
@@ -288,7 +309,6 @@ git_status_command_finalize (GObject *object)
 	git_status_command_stop_automatic_monitor (ANJUTA_COMMAND (self));
 	
 	g_queue_free (self->priv->status_queue);
-	g_regex_unref (self->priv->status_regex);
 	
 	g_free (self->priv);
 
@@ -303,7 +323,7 @@ git_status_command_class_init (GitStatusCommandClass *klass)
 	AnjutaCommandClass* command_class = ANJUTA_COMMAND_CLASS (klass);
 
 	object_class->finalize = git_status_command_finalize;
-	parent_class->output_handler = git_status_command_handle_output;
+	parent_class->record_handler = git_status_command_handle_record;
 	command_class->run = git_status_command_run;
 	command_class->data_arrived = git_status_command_data_arrived;
 	command_class->start_automatic_monitor = git_status_command_start_automatic_monitor;
@@ -319,7 +339,7 @@ git_status_command_new (const gchar *working_directory,
 	
 	self = g_object_new (GIT_TYPE_STATUS_COMMAND, 
 						 "working-directory", working_directory,
-						 "single-line-output", TRUE,
+						 "record-separator", '\0',
 						 NULL);
 	
 	self->priv->sections = sections;
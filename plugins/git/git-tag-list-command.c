@@ -59,6 +59,22 @@ git_tag_list_command_run (AnjutaCommand *command)
 	return 0;
 }
 
+static gboolean
+git_tag_list_command_handle_record (GitCommand *git_command, 
+                                    const gchar *record, gsize length)
+{
+	GQueue *output;
+
+	if (length == 0)
+		return FALSE;
+
+	/* Git command notifies once for all the tags read together */
+	output = git_raw_output_command_get_output (GIT_RAW_OUTPUT_COMMAND (git_command));
+	g_queue_push_tail (output, g_strndup (record, length));
+
+	return TRUE;
+}
+
 static void
 on_file_monitor_changed (GFileMonitor *monitor, GFile *file, GFile *other_file,
                          GFileMonitorEvent event, AnjutaCommand *command)
@@ -155,9 +171,11 @@ static void
 git_tag_list_command_class_init (GitTagListCommandClass *klass)
 {
 	GObjectClass* object_class = G_OBJECT_CLASS (klass);
+	GitCommandClass* parent_class = GIT_COMMAND_CLASS (klass);
 	AnjutaCommandClass *command_class = ANJUTA_COMMAND_CLASS (klass);
 
 	object_class->finalize = git_tag_list_command_finalize;
+	parent_class->record_handler = git_tag_list_command_handle_record;
 	command_class->run = git_tag_list_command_run;
 	command_class->start_automatic_monitor = git_tag_list_command_start_automatic_monitor;
 	command_class->stop_automatic_monitor = git_tag_list_command_stop_automatic_monitor;
@@ -169,7 +187,5 @@ git_tag_list_command_new (const gchar *working_directory)
 {
 	return g_object_new (GIT_TYPE_TAG_LIST_COMMAND, 
 						 "working-directory", working_directory,
-						 "single-line-output", TRUE,
-						 "strip-newlines", TRUE,
 						 NULL);
 }
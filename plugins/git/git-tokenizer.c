@@ -0,0 +1,64 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta
+ * 
+ * anjuta is free software.
+ * 
+ * You may redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ * 
+ * anjuta is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with anjuta.  If not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#include <string.h>
+#include "git-tokenizer.h"
+
+void
+git_tokenizer_init (GitTokenizer *self, const gchar *chars, gsize length)
+{
+	self->pos = chars;
+	self->end = chars + length;
+}
+
+/* Get the next token terminated by the separator. Returns FALSE if there is
+ * no separator left, the remaining characters can be an incomplete token */
+gboolean
+git_tokenizer_next (GitTokenizer *self, gchar separator, const gchar **token, 
+                    gsize *length)
+{
+	const gchar *next;
+
+	next = memchr (self->pos, separator, self->end - self->pos);
+
+	if (next == NULL)
+		return FALSE;
+
+	*token = self->pos;
+	*length = next - self->pos;
+	self->pos = next + 1;
+
+	return TRUE;
+}
+
+/* Get the characters after the last separator, used for the last field of a
+ * record or to keep an incomplete token until more output arrives */
+gboolean
+git_tokenizer_get_rest (GitTokenizer *self, const gchar **token, gsize *length)
+{
+	*token = self->pos;
+	*length = self->end - self->pos;
+	self->pos = self->end;
+
+	return *length > 0;
+}
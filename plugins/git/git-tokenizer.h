@@ -0,0 +1,49 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta
+ * 
+ * anjuta is free software.
+ * 
+ * You may redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ * 
+ * anjuta is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with anjuta.  If not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _GIT_TOKENIZER_H_
+#define _GIT_TOKENIZER_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GitTokenizer GitTokenizer;
+
+/* Splits git output in place, tokens point into the scanned characters and
+ * are not nul terminated */
+struct _GitTokenizer
+{
+	const gchar *pos;
+	const gchar *end;
+};
+
+void git_tokenizer_init (GitTokenizer *self, const gchar *chars, gsize length);
+gboolean git_tokenizer_next (GitTokenizer *self, gchar separator,
+                             const gchar **token, gsize *length);
+gboolean git_tokenizer_get_rest (GitTokenizer *self, const gchar **token,
+                                 gsize *length);
+
+G_END_DECLS
+
+#endif /* _GIT_TOKENIZER_H_ */
@@ -21,6 +21,7 @@
 #include <config.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
 #include <libanjuta/anjuta-debug.h>
 #include <libanjuta/anjuta-utils.h>
 #include <libanjuta/interfaces/ianjuta-iterable.h>
@@ -1419,6 +1420,502 @@ cpp_java_indentation_changed (IAnjutaEditor *editor,
 	}
 }
 
+/* Range indentation: the indentation of a range of lines is computed in one
+ * pass over the text, from the beginning of the file, keeping the state of
+ * the brackets, comments and preprocessor lines from one line to the next
+ * instead of searching backward the context of each line.
+ *
+ * The backward search of get_line_auto_indentation() stays the reference.
+ * When the text contains something the forward pass cannot follow the same
+ * way, a string continued on the next line or conditional preprocessor
+ * branches not opening the same brackets, the following lines are indented
+ * one by one with it.
+ */
+
+typedef struct
+{
+	gchar ch;			/* Opening bracket, 0 for the file level */
+	gint line;
+	gint anchor;		/* Indentation of the statement owning the bracket */
+	gint indent;		/* Indentation of the lines inside a parenthesis */
+	gint parenthesis_indent;
+	gint colon;			/* 1 after a label, 2 after an indented label */
+} IndentCBlock;
+
+typedef struct
+{
+	gint line;
+	gint length;		/* Length of the old indentation */
+	gchar *indent_string;
+} IndentCChange;
+
+typedef struct
+{
+	IndentCPlugin *plugin;
+	gint tab_size;
+	gboolean lineup;
+	gint parenthesis_size;
+	GArray *blocks;
+	gboolean comment;
+	gint comment_indent;
+	gboolean preprocessor;
+	GArray *conditionals;	/* Blocks depth at each opened #if */
+	gboolean fallback;	/* The following lines need the backward search */
+	gchar last;			/* Last character of code, out of comments */
+	gint line_indent;	/* Indentation of the previous line */
+} IndentCRange;
+
+static gboolean
+is_statement_end (gchar ch)
+{
+	return ch == '\0' || ch == ';' || ch == ',' || ch == '{' || ch == '}' || ch == ':';
+}
+
+/* Get the last character of code in the line, skipping spaces and comments */
+static gchar
+get_line_last_char (IndentCRange *range, const gchar *text, const gchar *end)
+{
+	gboolean comment = range->comment;
+	gchar last = '\0';
+	const gchar *idx;
+
+	for (idx = text; idx < end; idx++)
+	{
+		if (comment)
+		{
+			if (idx[0] == '*' && idx + 1 < end && idx[1] == '/')
+			{
+				comment = FALSE;
+				idx++;
+			}
+		}
+		else if (idx[0] == '/' && idx + 1 < end && idx[1] == '*')
+		{
+			comment = TRUE;
+			idx++;
+		}
+		else if (idx[0] == '/' && idx + 1 < end && idx[1] == '/')
+		{
+			break;
+		}
+		else if (idx[0] == '"' || idx[0] == '\'')
+		{
+			/* Comment marks are not recognized in strings */
+			gchar quote = idx[0];
+
+			for (idx++; idx < end && *idx != quote; idx++)
+			{
+				if (*idx == '\\' && idx + 1 < end)
+					idx++;
+			}
+			last = quote;
+		}
+		else if (!isspace (*idx))
+		{
+			last = *idx;
+		}
+	}
+
+	return last;
+}
+
+/* Check that the branches of a conditional preprocessor line open the same
+ * blocks, else the forward pass cannot know which one to follow */
+static void
+scan_range_conditional (IndentCRange *range, const gchar *text, const gchar *end)
+{
+	const gchar *directive;
+	guint depth = range->blocks->len;
+
+	for (directive = text + 1; directive < end && isspace (*directive); directive++);
+
+	if (end - directive >= 2 && strncmp (directive, "if", 2) == 0)
+	{
+		g_array_append_val (range->conditionals, depth);
+	}
+	else if ((end - directive >= 2 && strncmp (directive, "el", 2) == 0) ||
+	         (end - directive >= 5 && strncmp (directive, "endif", 5) == 0))
+	{
+		guint *opened;
+
+		if (range->conditionals->len == 0)
+			return;
+
+		opened = &g_array_index (range->conditionals, guint, range->conditionals->len - 1);
+		if (*opened != depth)
+			range->fallback = TRUE;
+		if (directive[1] == 'n')
+			g_array_set_size (range->conditionals, range->conditionals->len - 1);
+	}
+}
+
+/* Compute the new indentation of a line starting with ch */
+static void
+get_range_line_indentation (IndentCRange *range,
+                            gchar ch,
+                            gchar line_last,
+                            gint *indentation,
+                            gint *parenthesis_indentation)
+{
+	IndentCPlugin *plugin = range->plugin;
+	IndentCBlock *block = &g_array_index (range->blocks, IndentCBlock, range->blocks->len - 1);
+	gint line_indent;
+
+	*parenthesis_indentation = 0;
+
+	if (range->preprocessor)
+	{
+		/* Continuation of preprocessor line -- just maintain indentation */
+		*indentation = range->line_indent;
+		return;
+	}
+	else if (range->comment)
+	{
+		*indentation = range->comment_indent + 1;
+		return;
+	}
+	else if (ch == '#')
+	{
+		*indentation = 0;
+		return;
+	}
+
+	if (block->ch == '(' || block->ch == '[')
+	{
+		line_indent = block->indent;
+		*parenthesis_indentation = block->parenthesis_indent;
+		if (ch == '{' && line_indent > 0)
+			line_indent += BRACE_INDENT;
+	}
+	else
+	{
+		line_indent = block->ch == '{' ? block->anchor + INDENT_SIZE : 0;
+		if (block->colon == 2)
+			line_indent += INDENT_SIZE;
+		if (block->colon && line_last == ':')
+			line_indent -= INDENT_SIZE;
+
+		if (ch == '}')
+		{
+			if (block->ch == '{')
+				line_indent = block->anchor;
+		}
+		else if (ch == '{')
+		{
+			/* The first level braces are excused from brace indentation */
+			if (line_indent > 0)
+			{
+				line_indent += BRACE_INDENT;
+				/* It looks ugly to add extra indent after case: so remove that */
+				if (block->colon)
+					line_indent -= INDENT_SIZE;
+			}
+		}
+		else if (!is_statement_end (range->last) && line_indent > 0)
+		{
+			/* First levels are excused from incomplete statement indent */
+			line_indent += INDENT_SIZE;
+		}
+	}
+	*indentation = line_indent;
+}
+
+/* Update the state with the line, indented with indent */
+static void
+scan_range_line (IndentCRange *range, gint line,
+                 const gchar *indent, const gchar *indent_end,
+                 const gchar *text, const gchar *end)
+{
+	gint line_indent;
+	gint anchor;
+	gint tabs = 0;
+	gint chars = 0;
+	gchar previous = range->last;
+	const gchar *idx;
+
+	for (idx = indent; idx < indent_end; idx++)
+	{
+		if (*idx == '\t')
+			tabs += range->tab_size;
+		else
+			chars++;
+	}
+	line_indent = tabs + chars;
+	anchor = line_indent;
+	range->line_indent = line_indent;
+
+	/* Preprocessor lines are skipped */
+	if (range->preprocessor || (!range->comment && text < end && *text == '#'))
+	{
+		if (!range->preprocessor)
+			scan_range_conditional (range, text, end);
+		range->preprocessor = end > text && end[-1] == '\\';
+		return;
+	}
+
+	range->last = '\0';
+
+	for (idx = text; idx < end; idx++)
+	{
+		gchar ch = *idx;
+
+		/* Count the columns for parenthesis line up */
+		if (ch == '\t')
+			tabs += range->tab_size;
+		else if ((ch & 0xC0) != 0x80)
+			chars++;
+
+		if (range->comment)
+		{
+			if (ch == '*' && idx + 1 < end && idx[1] == '/')
+			{
+				range->comment = FALSE;
+				idx++;
+				chars++;
+			}
+			continue;
+		}
+
+		switch (ch)
+		{
+			case '/':
+				if (idx + 1 < end && idx[1] == '*')
+				{
+					range->comment = TRUE;
+					range->comment_indent = line_indent;
+					idx++;
+					chars++;
+				}
+				else if (idx + 1 < end && idx[1] == '/')
+				{
+					idx = end;
+				}
+				else
+				{
+					range->last = ch;
+				}
+				break;
+			case '"':
+			case '\'':
+				/* Skip strings and characters */
+				for (idx++; idx < end && *idx != ch; idx++)
+				{
+					if ((*idx & 0xC0) != 0x80)
+						chars++;
+					if (*idx == '\\' && idx + 1 < end)
+					{
+						idx++;
+						chars++;
+					}
+				}
+				/* The string goes on in the next line */
+				if (idx >= end)
+					range->fallback = TRUE;
+				chars++;
+				range->last = ch;
+				break;
+			case '{':
+			case '(':
+			case '[':
+			{
+				IndentCBlock block = {ch, line, anchor, 0, 0, 0};
+
+				if (ch != '{')
+				{
+					if (range->lineup)
+					{
+						block.indent = tabs;
+						block.parenthesis_indent = chars;
+					}
+					else
+					{
+						block.indent = anchor;
+						block.parenthesis_indent = range->parenthesis_size;
+					}
+				}
+				g_array_append_val (range->blocks, block);
+				range->last = ch;
+				break;
+			}
+			case '}':
+			case ')':
+			case ']':
+				if (range->blocks->len > 1)
+				{
+					IndentCBlock *block = &g_array_index (range->blocks, IndentCBlock, range->blocks->len - 1);
+
+					/* A parenthesis closed on another line gives the
+					 * indentation of the following block */
+					if (block->ch != '{' && block->line != line)
+						anchor = block->anchor;
+					g_array_set_size (range->blocks, range->blocks->len - 1);
+				}
+				range->last = ch;
+				break;
+			default:
+				if (!isspace (ch))
+					range->last = ch;
+				break;
+		}
+	}
+
+	/* A label indents the following lines of the block */
+	if (range->last == '\0')
+	{
+		range->last = previous;
+	}
+	else if (range->last == ':')
+	{
+		IndentCBlock *block = &g_array_index (range->blocks, IndentCBlock, range->blocks->len - 1);
+
+		if (block->ch != '(' && block->ch != '[')
+			block->colon = line_indent > 0 ? 2 : 1;
+	}
+}
+
+/* Indent the lines one by one, searching backward the context of each one */
+static void
+set_lines_auto_indentation (IndentCPlugin *plugin, IAnjutaEditor *editor,
+                            gint line_start, gint line_end)
+{
+	gint line;
+
+	for (line = line_start; line <= line_end; line++)
+	{
+		gint line_indent;
+		gint parenthesis_indentation = 0;
+
+		line_indent = get_line_auto_indentation (plugin, editor, line,
+		                                         &parenthesis_indentation);
+		/* DEBUG_PRINT ("Line indent for line %d = %d", line, line_indent); */
+		set_line_indentation (plugin, editor, line, line_indent, parenthesis_indentation);
+	}
+}
+
+static void
+set_range_indentation (IndentCPlugin *plugin, IAnjutaEditor *editor,
+                       gint line_start, gint line_end)
+{
+	IndentCRange range = {plugin, TAB_SIZE, FALSE, 0, NULL, FALSE, 0, FALSE, NULL, FALSE, '\0', 0};
+	IndentCBlock file_block = {'\0', 0, 0, 0, 0, 0};
+	IAnjutaIterable *begin, *end;
+	GArray *changes;
+	gchar *text, *line_text;
+	gint line;
+	gint nchars = 0;
+	guint i;
+
+	begin = ianjuta_editor_get_start_position (editor, NULL);
+	end = ianjuta_editor_get_line_end_position (editor, line_end, NULL);
+	text = ianjuta_editor_get_text (editor, begin, end, NULL);
+	g_object_unref (begin);
+	g_object_unref (end);
+	if (text == NULL)
+		return;
+
+	range.lineup = g_settings_get_boolean (plugin->settings, PREF_INDENT_PARENTHESIS_LINEUP);
+	range.parenthesis_size = g_settings_get_int (plugin->settings, PREF_INDENT_PARENTHESIS_SIZE);
+	range.blocks = g_array_new (FALSE, FALSE, sizeof (IndentCBlock));
+	g_array_append_val (range.blocks, file_block);
+	range.conditionals = g_array_new (FALSE, FALSE, sizeof (guint));
+	changes = g_array_new (FALSE, FALSE, sizeof (IndentCChange));
+
+	/* Compute all indentations on the text */
+	for (line = 1, line_text = text; line <= line_end; line++)
+	{
+		gchar *line_last;
+		gchar *code;
+		const gchar *indent = line_text;
+		const gchar *indent_end;
+
+		line_last = line_text + strcspn (line_text, "\r\n");
+		for (code = line_text; code < line_last && (*code == ' ' || *code == '\t'); code++);
+
+		indent_end = code;
+		if (line >= line_start)
+		{
+			IndentCChange change;
+			gint indentation = 0;
+			gint parenthesis_indentation = 0;
+
+			/* Empty lines are cleared, except the last one */
+			if (code < line_last || line == line_end)
+			{
+				get_range_line_indentation (&range,
+				                            code < line_last ? *code : '\n',
+				                            get_line_last_char (&range, code, line_last),
+				                            &indentation,
+				                            &parenthesis_indentation);
+			}
+			change.line = line;
+			change.length = code - line_text;
+			change.indent_string = get_line_indentation_string (plugin, editor,
+			                                                    indentation,
+			                                                    parenthesis_indentation);
+			nchars = change.indent_string ? strlen (change.indent_string) : 0;
+			if ((nchars == change.length) &&
+			    ((nchars == 0) || (strncmp (line_text, change.indent_string, nchars) == 0)))
+			{
+				g_free (change.indent_string);
+			}
+			else
+			{
+				g_array_append_val (changes, change);
+				indent = change.indent_string;
+				indent_end = indent + nchars;
+			}
+		}
+
+		scan_range_line (&range, line, indent, indent_end, code, line_last);
+		if (range.fallback)
+			break;
+
+		line_text = line_last;
+		if (*line_text == '\r') line_text++;
+		if (*line_text == '\n') line_text++;
+	}
+	g_free (text);
+	g_array_free (range.blocks, TRUE);
+	g_array_free (range.conditionals, TRUE);
+
+	/* Change the indentation of the lines in the editor */
+	for (i = 0; i < changes->len; i++)
+	{
+		IndentCChange *change = &g_array_index (changes, IndentCChange, i);
+
+		begin = ianjuta_editor_get_line_begin_position (editor, change->line, NULL);
+		if (change->length > 0)
+		{
+			end = ianjuta_iterable_clone (begin, NULL);
+			ianjuta_iterable_set_position (end,
+			                               ianjuta_iterable_get_position (begin, NULL) + change->length,
+			                               NULL);
+			ianjuta_editor_erase (editor, begin, end, NULL);
+			g_object_unref (end);
+		}
+		if (change->indent_string != NULL)
+			ianjuta_editor_insert (editor, begin, change->indent_string, -1, NULL);
+		g_object_unref (begin);
+		g_free (change->indent_string);
+	}
+	g_array_free (changes, TRUE);
+
+	if (range.fallback && line < line_end)
+	{
+		/* The lines before keep the indentation computed above */
+		set_lines_auto_indentation (plugin, editor, MAX (line + 1, line_start), line_end);
+		return;
+	}
+
+	/* Put the cursor after the indentation of the last line */
+	begin = ianjuta_editor_get_line_begin_position (editor, line_end, NULL);
+	ianjuta_iterable_set_position (begin,
+	                               ianjuta_iterable_get_position (begin, NULL) + nchars,
+	                               NULL);
+	ianjuta_editor_goto_position (editor, begin, NULL);
+	g_object_unref (begin);
+}
+
 void
 cpp_auto_indentation (IAnjutaEditor *editor,
                       IndentCPlugin *lang_plugin,
@@ -1426,8 +1923,6 @@ cpp_auto_indentation (IAnjutaEditor *editor,
                       IAnjutaIterable *end)
 {
 	gint line_start, line_end;
-	gint insert_line;
-	gint line_indent;
 	gboolean has_selection;
 
 	has_selection = ianjuta_editor_selection_has_selection
@@ -1459,14 +1954,14 @@ cpp_auto_indentation (IAnjutaEditor *editor,
 	}
 	ianjuta_document_begin_undo_action (IANJUTA_DOCUMENT(editor), NULL);
 
-	for (insert_line = line_start; insert_line <= line_end; insert_line++)
+	if (line_end > line_start)
 	{
-		gint parenthesis_indentation = 0;
-		line_indent = get_line_auto_indentation (lang_plugin, editor,
-		                                         insert_line,
-		                                         &parenthesis_indentation);
-		/* DEBUG_PRINT ("Line indent for line %d = %d", insert_line, line_indent); */
-		set_line_indentation (lang_plugin, editor, insert_line, line_indent, parenthesis_indentation);
+		/* Avoid searching backward the context of each line */
+		set_range_indentation (lang_plugin, editor, line_start, line_end);
+	}
+	else
+	{
+		set_lines_auto_indentation (lang_plugin, editor, line_start, line_end);
 	}
 	ianjuta_document_end_undo_action (IANJUTA_DOCUMENT(editor), NULL);
 }
@@ -1,27 +1,69 @@
-import getopt
 import sys
+import threading
+import time
 from collections import namedtuple
-from rope.base.project import Project 
-from rope.contrib import codeassist
-from rope.contrib import autoimport
 import os, re
 import pkg_resources
 from distutils.version import LooseVersion as V
+try:
+	import Queue as queue
+except ImportError:
+	import queue
+
+# Completion server, started once by the python plugin. Each request is
+# read from stdin as a header line
+#   <id> <command> <offset> <project length> <resource length> <builder files length> <source length>
+# followed by the project path, the resource path, the builder files
+# separated by '|' and the source code with the given lengths in bytes.
+# The command is autocomplete, calltip or cancel. The answer of a request
+# which has not been cancelled is written on stdout as a header line
+#   <id> <length>
+# followed by the output of the command with the given length in bytes.
 
 BUILDER_EXTENSION = '.ui'
 ROPE_VERSION = ''
+VALIDATE_INTERVAL = 5
 
 CompletionItem = namedtuple('CompletionItem', 'name info type scope location')
 def new_completion_item(**i):
         return CompletionItem('_','_','_','_','_')._replace(**i)
 
+Request = namedtuple('Request', 'id command position project_path file_path project_files source_code')
+
+class BuilderIndex(object):
+	""" keep the objects of each ui file, the files are parsed again only
+	when they have changed """
+	def __init__(self):
+		self.files = {}
+
+	def get_objects(self, file_list):
+		ret = []
+		for f in file_list:
+			try:
+				mtime = os.stat(f).st_mtime
+			except OSError:
+				continue
+			cached = self.files.get(f)
+			if cached is None or cached[0] != mtime:
+				cached = (mtime, self.parse(f))
+				self.files[f] = cached
+			ret.extend(cached[1])
+		return ret
+
+	def parse(self, f):
+		""" extract all <object/> tags and return their ids """
+		from xml.dom import minidom
+		md = minidom.parse(f)
+		return [new_completion_item(name=e.getAttribute('id'), scope='external', location=f, type='builder_object')
+		        for e in md.getElementsByTagName('object')]
+
 class BuilderComplete(object):
-	def __init__(self, project_path, resource_path, source_code, code_point, project_files):
+	def __init__(self, index, source_code, code_point, project_files):
+		self.index = index
 		self.code_point = code_point
-		self.src_dir = os.path.join(project_path, os.path.dirname(resource_path))
 		self.source_code = source_code
 		#grab all of the ui files from the project source files
-		self.builder_files = [f for f in project_files if f.endswith(BUILDER_EXTENSION) and os.path.exists(f)]
+		self.builder_files = [f for f in project_files if f.endswith(BUILDER_EXTENSION)]
 
 		#suggest completions whenever someone types get_object(' in some form
 		self.should_autocompelte_re = re.compile(r'get_object\s*\(\s*[\'"](\w*)$')
@@ -37,34 +79,18 @@ class BuilderComplete(object):
 				return []
 			starting_word = reg_search.groups()[0]
 
-		possible_completions = self.get_all_builder_objects(self.builder_files)
+		possible_completions = self.index.get_objects(self.builder_files)
 		#return only the ones with valid start
 		return [item for item in possible_completions if item.name.startswith(starting_word)]
 
-	def get_all_builder_objects(self, file_list):
-		""" go through every file in file_list and extract all <object/>
-		tags and return their ids """
-		from xml.dom import minidom
-		ret = []
-		for f in file_list:
-			md = minidom.parse(f)
-			for e in md.getElementsByTagName('object'):
-				item = new_completion_item(name=e.getAttribute('id'), scope='external', location=f, type='builder_object')
-				ret.append(item)
-		return ret
-
 class RopeComplete(object):
-	def __init__(self, project_path, source_code, resource_path, code_point):
-		self.project = Project(project_path)
-		self.project.pycore._init_python_files()
-		
-		self.resource = self.project.get_resource(resource_path)
+	def __init__(self, project, source_code, resource_path, code_point):
+		self.project = project
+		# an unsaved buffer has no resource
+		self.resource = self.project.get_resource(resource_path) if resource_path else None
 		self.source_code = source_code
 		self.code_point = code_point
 
-	def __del__(self):
-		self.project.close()
-
 	def get_proposals(self):
 		ret = []
 		proposals = codeassist.code_assist(self.project, self.source_code, self.code_point, resource=self.resource, maxfixes=10)
@@ -83,65 +109,139 @@ class RopeComplete(object):
 		calltip = codeassist.get_doc(self.project, self.source_code, self.code_point, resource=self.resource, maxfixes=10)
 		return calltip
 
-def parse_arguments(args):
-	""" Returns a dictionary containing all the parsed args
-	and a string containing the source_code """
-	ret = {}
-
-	options, remainder = getopt.getopt(args, 'o:p:s:r:f:b:')
-	for opt, arg in options:
-		if opt in ('-o', '--option'):
-			option_arg = arg
-		elif opt in ('-p', '--project'):
-			project_arg = arg
-		elif opt == '-s':
-			source_code_arg = arg
-		elif opt == '-r':
-			res_arg = arg
-		elif opt == '-f':
-			offset_arg = arg
-		elif opt == '-b':
-			builder_files_arg = arg
-
-	ret['option'] = option_arg;
-	ret['project_path'] = str.replace(project_arg, 'file://', '') if project_arg.startswith('file://') else project_arg
-	ret['resource_path'] = os.path.relpath(res_arg, ret['project_path'])
-	if ret['option'] != 'calltip':
-		ret['project_files'] = builder_files_arg.split('|')
-	ret['position'] = int(offset_arg)
-
-	input = open(source_code_arg, 'r')
-	ret['source_code'] = input.read()
-
-
-	return ret
-
-if __name__ == '__main__':
-	try:
-		ROPE_VERSION = pkg_resources.get_distribution('rope').version
-	except:
-		print '|Missing python-rope module!|.|.|.|.|'
-		sys.exit(1)
-	try:
-		args = parse_arguments(sys.argv[1:])
-
+class CompletionServer(object):
+	def __init__(self, input, output):
+		self.input = input
+		self.output = output
+		self.requests = queue.Queue()
+		self.cancelled = set()
+		self.pending = set()
+		self.lock = threading.Lock()
+		self.projects = {}
+		self.builder_index = BuilderIndex()
+
+	def read_requests(self):
+		""" read the requests in a thread, so they can be cancelled while
+		another one is running """
+		try:
+			while True:
+				header = self.input.readline()
+				if not header:
+					break
+				try:
+					request = self.read_request(header)
+				except (ValueError, IndexError):
+					# malformed frame, keep reading the next ones
+					continue
+				with self.lock:
+					if request.command == 'cancel':
+						# an answered request is not pending anymore
+						if request.id in self.pending:
+							self.cancelled.add(request.id)
+						continue
+					self.pending.add(request.id)
+				self.requests.put(request)
+		finally:
+			self.requests.put(None)
+
+	def read_request(self, header):
+		fields = header.split()
+		lengths = [int(l) for l in fields[3:7]]
+		data = [self.input.read(l) for l in lengths]
+		if str is not bytes:
+			fields = [f.decode('utf-8') for f in fields]
+			data = [d.decode('utf-8', 'replace') for d in data]
+		project_path = data[0]
+		if project_path.startswith('file://'):
+			project_path = project_path[len('file://'):]
+		return Request(fields[0], fields[1], int(fields[2]), project_path,
+		               data[1], data[2].split('|'), data[3])
+
+	def is_cancelled(self, request):
+		with self.lock:
+			return request.id in self.cancelled
+
+	def done(self, request):
+		with self.lock:
+			self.pending.discard(request.id)
+			self.cancelled.discard(request.id)
+
+	def get_project(self, project_path):
+		""" keep the rope project of each path, checking from time to time
+		the files changed outside """
+		now = time.time()
+		if project_path not in self.projects:
+			project = Project(project_path)
+			project.pycore._init_python_files()
+			self.projects[project_path] = [project, now]
+		entry = self.projects[project_path]
+		if now - entry[1] > VALIDATE_INTERVAL:
+			entry[0].validate(entry[0].root)
+			entry[1] = now
+		return entry[0]
+
+	def run_request(self, request):
 		suggestions = []
 		calltip = ''
-		if args['option'] == 'autocomplete':
+		resource_path = None
+		if request.file_path:
+			resource_path = os.path.relpath(request.file_path, request.project_path)
+		if request.command == 'autocomplete':
 			#get any completions Rope offers us
-			comp = RopeComplete(args['project_path'], args['source_code'], args['resource_path'], args['position'])
+			comp = RopeComplete(self.get_project(request.project_path), request.source_code, resource_path, request.position)
 			suggestions.extend(comp.get_proposals())
 			#see if we've typed get_object(' and if so, offer completions based upon the builder ui files in the project
-			comp = BuilderComplete(args['project_path'], args['resource_path'], args['source_code'], args['position'], args['project_files'])
+			comp = BuilderComplete(self.builder_index, request.source_code, request.position, request.project_files)
 			suggestions.extend(comp.get_proposals())
-		elif args['option'] == 'calltip':
-			calltip_obj = RopeComplete(args['project_path'], args['source_code'], args['resource_path'], args['position'])
-			calltip = calltip_obj.get_calltip()
+		elif request.command == 'calltip':
+			calltip_obj = RopeComplete(self.get_project(request.project_path), request.source_code, resource_path, request.position)
+			calltip = calltip_obj.get_calltip() or ''
+
+		lines = ["|{0}|{1}|{2}|{3}|{4}|\n".format(s.name, s.scope, s.type, s.location, s.info) for s in suggestions]
+		return ''.join(lines) + calltip
+
+	def write_answer(self, request, answer):
+		if not isinstance(answer, bytes):
+			answer = answer.encode('utf-8')
+		self.output.write(('%s %d\n' % (request.id, len(answer))).encode('ascii'))
+		self.output.write(answer)
+		self.output.flush()
+
+	def run(self):
+		reader = threading.Thread(target=self.read_requests)
+		reader.daemon = True
+		reader.start()
+		while True:
+			request = self.requests.get()
+			if request is None:
+				break
+			if self.is_cancelled(request):
+				self.done(request)
+				continue
+			try:
+				answer = self.run_request(request)
+			except Exception:
+				answer = ''
+			if not self.is_cancelled(request):
+				self.write_answer(request, answer)
+			self.done(request)
+		for project in self.projects.values():
+			project[0].close()
+
+class MissingRopeServer(CompletionServer):
+	def run_request(self, request):
+		if request.command == 'autocomplete':
+			return '|Missing python-rope module!|.|.|.|.|\n'
+		return ''
 
-		for s in suggestions:
-			print "|{0}|{1}|{2}|{3}|{4}|".format(s.name, s.scope, s.type, s.location, s.info)
-		print calltip
+if __name__ == '__main__':
+	input = getattr(sys.stdin, 'buffer', sys.stdin)
+	output = getattr(sys.stdout, 'buffer', sys.stdout)
+	try:
+		from rope.base.project import Project
+		from rope.contrib import codeassist
+		ROPE_VERSION = pkg_resources.get_distribution('rope').version
+		server = CompletionServer(input, output)
 	except:
-		pass
-
-
+		server = MissingRopeServer(input, output)
+	server.run()
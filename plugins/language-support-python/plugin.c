@@ -275,9 +275,14 @@ install_support (PythonPlugin *lang_plugin)
 
 		project_root = ANJUTA_PLUGIN_PYTHON(plugin)->project_root_directory;
 
+		/* The completion server is shared by all the editors */
+		if (!lang_plugin->server)
+			lang_plugin->server = python_server_new (lang_plugin->settings);
+
 		lang_plugin->assist = python_assist_new (ieditor,
 		                                         sym_manager,
 		                                         lang_plugin->settings,
+		                                         lang_plugin->server,
 		                                         plugin,
 		                                         project_root);
 	}
@@ -462,6 +467,9 @@ python_plugin_deactivate (AnjutaPlugin *plugin)
 								lang_plugin->project_root_watch_id,
 								TRUE);
 
+	if (lang_plugin->server)
+		python_server_free (lang_plugin->server);
+	lang_plugin->server = NULL;
 
 	ui = anjuta_shell_get_ui (plugin->shell, NULL);
 	anjuta_ui_remove_action_group (ui, ANJUTA_PLUGIN_PYTHON(plugin)->action_group);
@@ -503,6 +511,7 @@ python_plugin_instance_init (GObject *obj)
 	plugin->editor_watch_id = 0;
 	plugin->uiid = 0;
 	plugin->assist = NULL;
+	plugin->server = NULL;
 	plugin->settings = g_settings_new (PREF_SCHEMA);
 	plugin->editor_settings = g_settings_new (ANJUTA_PREF_SCHEMA_PREFIX IANJUTA_EDITOR_PREF_SCHEMA);
 }
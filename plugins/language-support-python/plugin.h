@@ -63,6 +63,7 @@ struct _PythonPlugin{
 	
 	/* Assist */
 	PythonAssist *assist;
+	PythonServer *server;
 
 	/* Preferences */
 	GtkBuilder* bxml;
@@ -24,11 +24,9 @@
 
 #include <ctype.h>
 #include <string.h>
-#include <unistd.h>
 #include <glib/gi18n.h>
 #include <libanjuta/anjuta-debug.h>
 #include <libanjuta/anjuta-language-provider.h>
-#include <libanjuta/anjuta-launcher.h>
 #include <libanjuta/anjuta-plugin.h>
 #include <libanjuta/anjuta-utils.h>
 #include <libanjuta/interfaces/ianjuta-file.h>
@@ -41,15 +39,13 @@
 #include <libanjuta/interfaces/ianjuta-project-manager.h>
 #include "python-assist.h"
 
-#define PREF_INTERPRETER_PATH "interpreter-path"
 #define MAX_COMPLETIONS 30
 #define BRACE_SEARCH_LIMIT 500
 #define SCOPE_BRACE_JUMP_LIMIT 50
 
-#define AUTOCOMPLETE_SCRIPT SCRIPTS_DIR"/anjuta-python-autocomplete.py"
-
 #define AUTOCOMPLETE_REGEX_IN_GET_OBJECT "get_object\\s*\\(\\s*['\"]\\w*$"
 #define FILE_LIST_DELIMITER "|"
+#define BUILDER_EXTENSION ".ui"
 #define SCOPE_CONTEXT_CHARACTERS ".0"
 #define WORD_CHARACTER "_0"
 
@@ -69,8 +65,9 @@ struct _PythonAssistPriv {
 	IAnjutaEditorAssist* iassist;
 	IAnjutaEditorTip* itip;
 	AnjutaLanguageProvider* lang_prov;
-	AnjutaLauncher* launcher;
-	AnjutaLauncher* calltip_launcher;	
+	PythonServer* server;
+	guint completion_query;
+	guint calltip_query;
 	AnjutaPlugin* plugin;
 
 	const gchar* project_root;
@@ -81,13 +78,11 @@ struct _PythonAssistPriv {
 	gchar *pre_word;
 	
 	gint cache_position;
-	GString* rope_cache;
 
 	/* Calltips */
 	gchar* calltip_context;
 	IAnjutaIterable* calltip_iter;
 	GList* tips;
-	GString* calltip_cache;
 };
 
 static gchar*
@@ -119,10 +114,10 @@ python_assist_tag_destroy (AnjutaLanguageProposalData *tag)
 static void
 python_assist_cancel_queries (PythonAssist* assist)
 {
-	if (assist->priv->launcher)
+	if (assist->priv->completion_query)
 	{
-		g_object_unref (assist->priv->launcher);
-		assist->priv->launcher = NULL;
+		python_server_cancel (assist->priv->server, assist->priv->completion_query);
+		assist->priv->completion_query = 0;
 	}
 }
 
@@ -141,11 +136,6 @@ python_assist_destroy_completion_cache (PythonAssist *assist)
 		g_completion_free (assist->priv->completion_cache);
 		assist->priv->completion_cache = NULL;
 	}
-	if (assist->priv->rope_cache)
-	{
-		g_string_free (assist->priv->rope_cache, TRUE);
-		assist->priv->rope_cache = NULL;
-	}
 }
 
 static void free_proposal (IAnjutaEditorAssistProposal* proposal)
@@ -192,72 +182,16 @@ python_assist_update_autocomplete (PythonAssist *assist)
 	g_list_free (suggestions);
 }
 
-/* Returns NULL if creation fails */
-static gchar*
-create_tmp_file (const gchar* source)
-{
-	gchar* tmp_file;
-	gint tmp_fd;
-	GError* err = NULL;
-
-	tmp_fd = g_file_open_tmp (NULL, &tmp_file, &err);
-	if (tmp_fd >= 0)
-	{
-		FILE *rope_file = fdopen (tmp_fd, "w");
-		if (rope_file)
-		{
-			fprintf (rope_file, "%s", source);
-			fclose (rope_file);
-			close (tmp_fd);
-			return tmp_file;
-		}
-	}
-
-	/* Error */
-	g_warning ("Creating tmp_file failed: %s", err->message);
-	g_error_free (err);
-	return NULL;
-}
-
-static void 
-on_autocomplete_output (AnjutaLauncher *launcher,
-                        AnjutaLauncherOutputType output_type,
-                        const gchar *chars,
-                        gpointer user_data)
-{
-	PythonAssist* assist = PYTHON_ASSIST (user_data);
-	if (output_type == ANJUTA_LAUNCHER_OUTPUT_STDOUT)
-	{
-		DEBUG_PRINT ("chars from script: %s", chars);
-		if (assist->priv->rope_cache)
-		{
-			g_string_append (assist->priv->rope_cache, chars);
-		}
-		else
-		{
-			assist->priv->rope_cache = g_string_new (chars);
-		}
-	}
-	if (output_type == ANJUTA_LAUNCHER_OUTPUT_STDERR)
-	{
-		g_warning ("Problem in python script: %s", chars);
-	}
-}
-
 static void
-on_autocomplete_finished (AnjutaLauncher* launcher,
-                          int child_pid, int exit_status,
-                          gulong time, gpointer user_data)
+on_autocomplete_finished (const gchar* output, gpointer user_data)
 {
 	PythonAssist* assist = PYTHON_ASSIST (user_data);
-	DEBUG_PRINT ("Python-Complete took %lu seconds and returned %d", time, exit_status);
 
-	g_object_unref (launcher);
-	assist->priv->launcher = NULL;
-	
-	if (assist->priv->rope_cache)
+	assist->priv->completion_query = 0;
+
+	if (output)
 	{
-		GStrv completions = g_strsplit (assist->priv->rope_cache->str, "\n", -1);
+		GStrv completions = g_strsplit (output, "\n", -1);
 		GStrv cur_comp;
 		GList* suggestions = NULL;
 		GError *err = NULL;
@@ -324,9 +258,6 @@ on_autocomplete_finished (AnjutaLauncher* launcher,
 		g_regex_unref (regex);
 		g_strfreev (completions);
 
-		g_string_free (assist->priv->rope_cache, TRUE);
-		assist->priv->rope_cache = NULL;
-
 		assist->priv->completion_cache = g_completion_new (completion_function);
 		g_completion_add_items (assist->priv->completion_cache, suggestions);
 		g_list_free (suggestions);
@@ -343,27 +274,15 @@ python_assist_create_word_completion_cache (PythonAssist *assist, IAnjutaIterabl
 	const gchar *cur_filename;
 	gint offset = ianjuta_iterable_get_position (cursor, NULL);
 	const gchar *project = assist->priv->project_root;
-	gchar *interpreter_path;
-	gchar *ropecommand;
 	GString *builder_file_paths = g_string_new("");
 	GList *project_files_list, *node;
-
-	gchar *source = ianjuta_editor_get_text_all (editor, NULL);
-	gchar *tmp_file;
+	gchar *source;
 
 	cur_filename = assist->priv->editor_filename;
 	if (!project)
 		project = g_get_tmp_dir ();
-	
-	/* Create rope command and temporary source file */
-	interpreter_path = g_settings_get_string (assist->priv->settings,
-	                                          PREF_INTERPRETER_PATH);
-
-	tmp_file = create_tmp_file (source);
-	g_free (source);
-
-	if (!tmp_file)
-		return FALSE;
+	if (!cur_filename)
+		cur_filename = "";
 
 	/* Get a list of all the builder files in the project */
 	IAnjutaProjectManager *manager = anjuta_shell_get_interface (ANJUTA_PLUGIN (assist->priv->plugin)->shell,
@@ -375,29 +294,28 @@ python_assist_create_word_completion_cache (PythonAssist *assist, IAnjutaIterabl
 	for (node = project_files_list; node != NULL; node = g_list_next (node))
 	{
 		gchar *file_path = g_file_get_path (node->data);
-		builder_file_paths = g_string_append (builder_file_paths, FILE_LIST_DELIMITER);
-		builder_file_paths = g_string_append (builder_file_paths, file_path);
+		if (file_path && g_str_has_suffix (file_path, BUILDER_EXTENSION))
+		{
+			builder_file_paths = g_string_append (builder_file_paths, FILE_LIST_DELIMITER);
+			builder_file_paths = g_string_append (builder_file_paths, file_path);
+		}
 		g_free (file_path);
 		g_object_unref (node->data);
 	}
 	g_list_free (project_files_list);
-	
-	ropecommand = g_strdup_printf("%s %s -o autocomplete -p \"%s\" -r \"%s\" -s \"%s\" -f %d -b \"%s\"", 
-	                              interpreter_path, AUTOCOMPLETE_SCRIPT, project, 
-	                              cur_filename, tmp_file, offset, builder_file_paths->str);
-	g_string_free (builder_file_paths, TRUE);
-	g_free (tmp_file);
 
-	DEBUG_PRINT("%s", ropecommand);
+	/* Send the source to the completion server and wait for results */
+	source = ianjuta_editor_get_text_all (editor, NULL);
+	assist->priv->completion_query =
+		python_server_query (assist->priv->server, "autocomplete",
+		                     project, cur_filename, builder_file_paths->str,
+		                     offset, source ? source : "",
+		                     on_autocomplete_finished, assist);
+	g_string_free (builder_file_paths, TRUE);
+	g_free (source);
 
-	/* Exec command and wait for results */
-	assist->priv->launcher = anjuta_launcher_new ();
-	g_signal_connect (assist->priv->launcher, "child-exited",
-	                  G_CALLBACK(on_autocomplete_finished), assist);
-	anjuta_launcher_execute (assist->priv->launcher, ropecommand,
-	                         on_autocomplete_output,
-	                         assist);
-	g_free (ropecommand);
+	if (!assist->priv->completion_query)
+		return FALSE;
 
 	assist->priv->cache_position = offset;
 	
@@ -408,50 +326,20 @@ python_assist_create_word_completion_cache (PythonAssist *assist, IAnjutaIterabl
 	return TRUE;
 }
 
-static void 
-on_calltip_output (AnjutaLauncher *launcher,
-                   AnjutaLauncherOutputType output_type,
-                   const gchar *chars,
-                   gpointer user_data)
-{
-	PythonAssist* assist = PYTHON_ASSIST (user_data);
-	if (output_type == ANJUTA_LAUNCHER_OUTPUT_STDOUT)
-	{
-		if (assist->priv->calltip_cache)
-		{
-			g_string_append (assist->priv->calltip_cache, chars);
-		}
-		else
-		{
-			assist->priv->calltip_cache = g_string_new (chars);
-		}
-	}
-}
-
 static void
-on_calltip_finished (AnjutaLauncher* launcher,
-                     int child_pid, int exit_status,
-                     gulong time, gpointer user_data)
+on_calltip_finished (const gchar* output, gpointer user_data)
 {
 	PythonAssist* assist = PYTHON_ASSIST (user_data);
-	DEBUG_PRINT ("Python-Complete took %lu seconds and returned %d", time, exit_status);
 
-	g_object_unref (launcher);
-	assist->priv->calltip_launcher = NULL;
+	assist->priv->calltip_query = 0;
 
-	if (assist->priv->calltip_cache)
+	if (output && *output != '\0')
 	{
-		GString* calltip_text = g_string_new (assist->priv->calltip_cache->str);
-		assist->priv->tips = g_list_prepend (NULL, calltip_text->str);
-		if (g_strncasecmp ("None", assist->priv->tips->data, 4))
-		{
-			ianjuta_editor_tip_show (IANJUTA_EDITOR_TIP(assist->priv->itip),
-				                     assist->priv->tips,
-				                     assist->priv->calltip_iter,
-				                     NULL);
-		}
-		g_string_free (assist->priv->calltip_cache, TRUE);
-		assist->priv->calltip_cache = NULL;
+		assist->priv->tips = g_list_prepend (NULL, g_strdup (output));
+		ianjuta_editor_tip_show (IANJUTA_EDITOR_TIP(assist->priv->itip),
+		                         assist->priv->tips,
+		                         assist->priv->calltip_iter,
+		                         NULL);
 	}
 }
 
@@ -481,42 +369,23 @@ python_assist_query_calltip (PythonAssist* assist, const gchar *call_context)
 	
 	gint offset = python_assist_get_calltip_context_position (assist);
 	
-	gchar *interpreter_path;
 	const gchar *cur_filename;
 	gchar *source = ianjuta_editor_get_text_all (editor, NULL);
 	const gchar *project = assist->priv->project_root;
-	gchar *tmp_file;
-	gchar *ropecommand;
 
 	cur_filename = assist->priv->editor_filename;
 	if (!project)
 		project = g_get_tmp_dir ();
-	
-	interpreter_path = g_settings_get_string (assist->priv->settings,
-	                                          PREF_INTERPRETER_PATH);
-
-	tmp_file = create_tmp_file (source);
+	if (!cur_filename)
+		cur_filename = "";
+
+	/* Send the source to the completion server and wait for results */
+	assist->priv->calltip_query =
+		python_server_query (assist->priv->server, "calltip",
+		                     project, cur_filename, "",
+		                     offset, source ? source : "",
+		                     on_calltip_finished, assist);
 	g_free (source);
-
-	if (!tmp_file)
-		return;
-	
-	ropecommand = g_strdup_printf("%s %s -o calltip -p \"%s\" -r \"%s\" -s \"%s\" -f %d", 
-								interpreter_path, AUTOCOMPLETE_SCRIPT, project, 
-								cur_filename, tmp_file, offset);
-
-	DEBUG_PRINT ("%s", ropecommand);
-
-	g_free (tmp_file);
-
-	/* Exec command and wait for results */
-	assist->priv->calltip_launcher = anjuta_launcher_new ();
-	g_signal_connect (assist->priv->calltip_launcher, "child-exited",
-	                  G_CALLBACK(on_calltip_finished), assist);
-	anjuta_launcher_execute (assist->priv->calltip_launcher, ropecommand,
-	                         on_calltip_output,
-	                         assist);
-	g_free (ropecommand);	
 }
 
 static void
@@ -531,11 +400,11 @@ python_assist_create_calltip_context (PythonAssist* assist,
 static void
 python_assist_clear_calltip_context (PythonAssist* assist)
 {
-	if (assist->priv->calltip_launcher)
+	if (assist->priv->calltip_query)
 	{
-		g_object_unref (assist->priv->calltip_launcher);
-	}	
-	assist->priv->calltip_launcher = NULL;
+		python_server_cancel (assist->priv->server, assist->priv->calltip_query);
+	}
+	assist->priv->calltip_query = 0;
 	
 	g_list_foreach (assist->priv->tips, (GFunc) g_free, NULL);
 	g_list_free (assist->priv->tips);
@@ -751,12 +620,14 @@ PythonAssist *
 python_assist_new (IAnjutaEditor *ieditor,
                    IAnjutaSymbolManager *isymbol_manager,
                    GSettings* settings,
+                   PythonServer *server,
                    AnjutaPlugin *plugin,
                    const gchar *project_root)
 {
 	PythonAssist *assist = g_object_new (TYPE_PYTHON_ASSIST, NULL);
 	assist->priv->lang_prov = g_object_new (ANJUTA_TYPE_LANGUAGE_PROVIDER, NULL);
 	assist->priv->settings = settings;
+	assist->priv->server = server;
 	assist->priv->plugin = plugin;
 	assist->priv->project_root = project_root;
 		
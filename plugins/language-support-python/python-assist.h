@@ -29,6 +29,7 @@
 #include <libanjuta/interfaces/ianjuta-editor-assist.h>
 #include <libanjuta/interfaces/ianjuta-symbol-manager.h>
 #include <libanjuta/interfaces/ianjuta-project-manager.h>
+#include "python-server.h"
 
 G_BEGIN_DECLS
 
@@ -67,6 +68,7 @@ PythonAssist*
 python_assist_new                             (IAnjutaEditor *ieditor,
                                                IAnjutaSymbolManager *isymbol_manager,
                                                GSettings* settings,
+                                               PythonServer *server,
                                                AnjutaPlugin *plugin,
                                                const gchar *project_root);
 
@@ -0,0 +1,437 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * python-server.c
+ *
+ * anjuta is free software.
+ *
+ * You may redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * anjuta is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with anjuta.  If not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+/* The completion script is started once and keeps running, so the rope
+ * project and the builder objects are loaded only once. The requests and
+ * their answers are exchanged through pipes, the format is described in
+ * the script. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <libanjuta/anjuta-debug.h>
+#include "python-server.h"
+
+#define PREF_INTERPRETER_PATH "interpreter-path"
+
+#define AUTOCOMPLETE_SCRIPT SCRIPTS_DIR"/anjuta-python-autocomplete.py"
+
+#define READ_SIZE 65536
+
+typedef struct
+{
+	guint id;
+	PythonServerCallback callback;
+	gpointer user_data;
+} PythonServerRequest;
+
+struct _PythonServer
+{
+	GSettings *settings;
+
+	/* Pipes, -1 when the server is not running */
+	gint input;
+	gint output;
+	guint input_watch;
+	guint output_watch;
+
+	GString *pending;		/* Requests not written yet */
+	GString *answer;		/* Answers not read completely */
+
+	guint last_id;
+	GQueue requests;
+};
+
+static void python_server_write (PythonServer *server);
+
+static void
+on_server_exited (GPid pid, gint status, gpointer data)
+{
+	DEBUG_PRINT ("Python completion server exited with %d", status);
+	g_spawn_close_pid (pid);
+}
+
+static void
+python_server_stop (PythonServer *server, gboolean notify)
+{
+	GList *requests;
+	GList *node;
+
+	if (server->input_watch)
+		g_source_remove (server->input_watch);
+	server->input_watch = 0;
+	if (server->output_watch)
+		g_source_remove (server->output_watch);
+	server->output_watch = 0;
+
+	/* The server exits when its input is closed */
+	if (server->input >= 0)
+		close (server->input);
+	server->input = -1;
+	if (server->output >= 0)
+		close (server->output);
+	server->output = -1;
+
+	g_string_truncate (server->pending, 0);
+	g_string_truncate (server->answer, 0);
+
+	/* Callbacks can send new requests */
+	requests = server->requests.head;
+	g_queue_init (&server->requests);
+	for (node = requests; node != NULL; node = g_list_next (node))
+	{
+		PythonServerRequest *request = (PythonServerRequest *)node->data;
+
+		if (notify)
+			request->callback (NULL, request->user_data);
+		g_slice_free (PythonServerRequest, request);
+	}
+	g_list_free (requests);
+}
+
+static GList *
+python_server_find_request (PythonServer *server, guint id)
+{
+	GList *node;
+
+	for (node = server->requests.head; node != NULL; node = g_list_next (node))
+	{
+		PythonServerRequest *request = (PythonServerRequest *)node->data;
+
+		if (request->id == id)
+			return node;
+	}
+
+	return NULL;
+}
+
+static PythonServerRequest *
+python_server_take_request (PythonServer *server, guint id)
+{
+	GList *node = python_server_find_request (server, id);
+	PythonServerRequest *request;
+
+	if (node == NULL)
+		return NULL;
+	request = (PythonServerRequest *)node->data;
+	g_queue_delete_link (&server->requests, node);
+
+	return request;
+}
+
+/* Call the callback of each complete answer */
+static void
+python_server_read_answers (PythonServer *server)
+{
+	gsize pos = 0;
+
+	while (server->answer->len > pos)
+	{
+		gchar *str = server->answer->str;
+		gchar *header_end;
+		gchar *next;
+		guint id;
+		gsize start;
+		gsize length;
+		PythonServerRequest *request;
+
+		header_end = memchr (str + pos, '\n', server->answer->len - pos);
+		if (header_end == NULL)
+			break;
+		id = strtoul (str + pos, &next, 10);
+		length = strtoul (next, NULL, 10);
+		start = header_end + 1 - str;
+		if (start + length > server->answer->len)
+			break;
+		pos = start + length;
+
+		/* Answers of cancelled requests are dropped */
+		request = python_server_take_request (server, id);
+		if (request != NULL)
+		{
+			gchar last = str[pos];
+
+			str[pos] = '\0';
+			request->callback (str + start, request->user_data);
+			g_slice_free (PythonServerRequest, request);
+
+			/* The server has been stopped by the callback */
+			if (server->output < 0)
+				return;
+			server->answer->str[pos] = last;
+		}
+	}
+	g_string_erase (server->answer, 0, pos);
+}
+
+static gboolean
+on_server_output (GIOChannel *channel, GIOCondition condition, gpointer data)
+{
+	PythonServer *server = (PythonServer *)data;
+
+	if (condition & G_IO_IN)
+	{
+		gsize len = server->answer->len;
+		gssize n;
+
+		g_string_set_size (server->answer, len + READ_SIZE);
+		n = read (server->output, server->answer->str + len, READ_SIZE);
+		g_string_set_size (server->answer, len + MAX (n, 0));
+		if (n > 0)
+		{
+			python_server_read_answers (server);
+			return TRUE;
+		}
+		else if (n < 0 && (errno == EAGAIN || errno == EINTR))
+		{
+			return TRUE;
+		}
+	}
+
+	/* The server has exited */
+	server->output_watch = 0;
+	python_server_stop (server, TRUE);
+
+	return FALSE;
+}
+
+static gboolean
+on_server_input (GIOChannel *channel, GIOCondition condition, gpointer data)
+{
+	PythonServer *server = (PythonServer *)data;
+
+	server->input_watch = 0;
+	python_server_write (server);
+
+	return FALSE;
+}
+
+/* Writing to a server which has just exited should not kill anjuta. SIGPIPE
+ * is blocked during the write and the signal raised by it is discarded, so
+ * the disposition of the signal is left to the application. */
+static gssize
+python_server_write_no_sigpipe (gint fd, const gchar *data, gsize len)
+{
+	sigset_t sigpipe_mask;
+	sigset_t old_mask;
+	gssize n;
+	gint saved_errno;
+
+	sigemptyset (&sigpipe_mask);
+	sigaddset (&sigpipe_mask, SIGPIPE);
+	pthread_sigmask (SIG_BLOCK, &sigpipe_mask, &old_mask);
+
+	n = write (fd, data, len);
+	saved_errno = errno;
+
+	if (n < 0 && saved_errno == EPIPE && !sigismember (&old_mask, SIGPIPE))
+	{
+		struct timespec no_wait = {0, 0};
+
+		while (sigtimedwait (&sigpipe_mask, NULL, &no_wait) < 0 && errno == EINTR);
+	}
+	pthread_sigmask (SIG_SETMASK, &old_mask, NULL);
+
+	errno = saved_errno;
+	return n;
+}
+
+static void
+python_server_write (PythonServer *server)
+{
+	while (server->pending->len > 0)
+	{
+		gssize n = python_server_write_no_sigpipe (server->input,
+		                                           server->pending->str,
+		                                           server->pending->len);
+
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN)
+			{
+				g_warning ("Unable to write to python completion server: %s",
+				           g_strerror (errno));
+				python_server_stop (server, TRUE);
+				return;
+			}
+			break;
+		}
+		g_string_erase (server->pending, 0, n);
+	}
+
+	/* Wait until the server has read the previous requests */
+	if (server->pending->len > 0 && server->input_watch == 0)
+	{
+		GIOChannel *channel = g_io_channel_unix_new (server->input);
+
+		server->input_watch = g_io_add_watch (channel, G_IO_OUT | G_IO_ERR,
+		                                      on_server_input, server);
+		g_io_channel_unref (channel);
+	}
+}
+
+static gboolean
+python_server_start (PythonServer *server)
+{
+	gchar *interpreter_path;
+	gchar *command;
+	gchar **argv = NULL;
+	GPid pid;
+	GIOChannel *channel;
+	GError *err = NULL;
+	gboolean ok;
+
+	interpreter_path = g_settings_get_string (server->settings,
+	                                          PREF_INTERPRETER_PATH);
+	command = g_strdup_printf ("%s %s", interpreter_path, AUTOCOMPLETE_SCRIPT);
+	DEBUG_PRINT ("%s", command);
+	ok = g_shell_parse_argv (command, NULL, &argv, &err) &&
+		g_spawn_async_with_pipes (NULL, argv, NULL,
+		                          G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_SEARCH_PATH,
+		                          NULL, NULL,
+		                          &pid,
+		                          &server->input,
+		                          &server->output,
+		                          NULL,
+		                          &err);
+	g_strfreev (argv);
+	g_free (command);
+	g_free (interpreter_path);
+
+	if (!ok)
+	{
+		g_warning ("Unable to start python completion server: %s", err->message);
+		g_error_free (err);
+		server->input = -1;
+		server->output = -1;
+		return FALSE;
+	}
+
+	g_child_watch_add (pid, on_server_exited, NULL);
+	fcntl (server->input, F_SETFL, fcntl (server->input, F_GETFL) | O_NONBLOCK);
+	fcntl (server->output, F_SETFL, fcntl (server->output, F_GETFL) | O_NONBLOCK);
+
+	channel = g_io_channel_unix_new (server->output);
+	server->output_watch = g_io_add_watch (channel, G_IO_IN | G_IO_HUP | G_IO_ERR,
+	                                       on_server_output, server);
+	g_io_channel_unref (channel);
+
+	return TRUE;
+}
+
+PythonServer *
+python_server_new (GSettings *settings)
+{
+	PythonServer *server = g_slice_new0 (PythonServer);
+
+	server->settings = g_object_ref (settings);
+	server->input = -1;
+	server->output = -1;
+	server->pending = g_string_new (NULL);
+	server->answer = g_string_new (NULL);
+	g_queue_init (&server->requests);
+
+	return server;
+}
+
+void
+python_server_free (PythonServer *server)
+{
+	python_server_stop (server, FALSE);
+	g_string_free (server->pending, TRUE);
+	g_string_free (server->answer, TRUE);
+	g_object_unref (server->settings);
+	g_slice_free (PythonServer, server);
+}
+
+/* Returns the id of the request, 0 if the server cannot be started or
+ * reached. In the latter case the callback has already been called with a
+ * NULL output. The server is started on the first request and after it has
+ * exited. */
+guint
+python_server_query (PythonServer *server,
+                     const gchar *command,
+                     const gchar *project,
+                     const gchar *resource,
+                     const gchar *builder_files,
+                     gint offset,
+                     const gchar *source,
+                     PythonServerCallback callback,
+                     gpointer user_data)
+{
+	PythonServerRequest *request;
+	guint id;
+
+	if (server->output < 0 && !python_server_start (server))
+		return 0;
+
+	request = g_slice_new (PythonServerRequest);
+	if (++server->last_id == 0)
+		server->last_id++;
+	request->id = server->last_id;
+	request->callback = callback;
+	request->user_data = user_data;
+	g_queue_push_tail (&server->requests, request);
+
+	g_string_append_printf (server->pending,
+	                        "%u %s %d %" G_GSIZE_FORMAT " %" G_GSIZE_FORMAT
+	                        " %" G_GSIZE_FORMAT " %" G_GSIZE_FORMAT "\n",
+	                        request->id, command, offset,
+	                        strlen (project), strlen (resource),
+	                        strlen (builder_files), strlen (source));
+	g_string_append (server->pending, project);
+	g_string_append (server->pending, resource);
+	g_string_append (server->pending, builder_files);
+	g_string_append (server->pending, source);
+
+	/* The request is freed if the server cannot be reached */
+	id = request->id;
+	python_server_write (server);
+
+	return python_server_find_request (server, id) != NULL ? id : 0;
+}
+
+/* The callback of a cancelled request is not called */
+void
+python_server_cancel (PythonServer *server, guint id)
+{
+	PythonServerRequest *request;
+
+	request = python_server_take_request (server, id);
+	if (request == NULL)
+		return;
+	g_slice_free (PythonServerRequest, request);
+
+	if (server->input >= 0)
+	{
+		g_string_append_printf (server->pending, "%u cancel 0 0 0 0 0\n", id);
+		python_server_write (server);
+	}
+}
@@ -0,0 +1,52 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * python-server.h
+ *
+ * anjuta is free software.
+ *
+ * You may redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * anjuta is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with anjuta.  If not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _PYTHON_SERVER_H_
+#define _PYTHON_SERVER_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _PythonServer PythonServer;
+
+/* output is NULL if the server has stopped before answering */
+typedef void (*PythonServerCallback) (const gchar *output, gpointer user_data);
+
+PythonServer *python_server_new (GSettings *settings);
+void python_server_free (PythonServer *server);
+
+guint python_server_query (PythonServer *server,
+                           const gchar *command,
+                           const gchar *project,
+                           const gchar *resource,
+                           const gchar *builder_files,
+                           gint offset,
+                           const gchar *source,
+                           PythonServerCallback callback,
+                           gpointer user_data);
+void python_server_cancel (PythonServer *server, guint id);
+
+G_END_DECLS
+
+#endif /* _PYTHON_SERVER_H_ */
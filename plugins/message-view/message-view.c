@@ -27,10 +27,17 @@
 #define COLOR_ERROR "color-error"
 #define COLOR_WARNING "color-warning"
 
+/* Messages added by idle iteration by ianjuta_message_view_append_batched() */
+#define MESSAGES_BATCH 500
+
 struct _MessageViewPrivate
 {
 	//guint num_messages;
-	gchar *line_buffer;
+	GString *line_buffer;
+
+	/* Messages waiting to be added */
+	GQueue *pending;
+	guint pending_idle;
 
 	GtkWidget *tree_view;
 	GtkTreeModel *model;
@@ -53,6 +60,8 @@ struct _MessageViewPrivate
 	gboolean highlite;
 
 	GSettings* settings;
+	gchar *color_error;
+	gchar *color_warning;
 };
 
 typedef struct
@@ -69,6 +78,7 @@ enum
 	COLUMN_SUMMARY,
 	COLUMN_MESSAGE,
 	COLUMN_PIXBUF,
+	COLUMN_TYPE,
 	N_COLUMNS
 };
 
@@ -84,6 +94,7 @@ static gpointer parent_class;
 
 static void prefs_init (MessageView *mview);
 static void prefs_finalize (MessageView *mview);
+static void message_view_flush_pending (MessageView *view);
 
 static gboolean
 message_view_tree_view_filter (GtkTreeModel *model,
@@ -191,19 +202,6 @@ message_get_type ()
 }
 
 /* Utility functions */
-/* Adds the char c to the string str */
-static void
-add_char(gchar** str, gchar c)
-{
-	gchar* buffer;
-
-	g_return_if_fail(str != NULL);
-
-	buffer = g_strdup_printf("%s%c", *str, c);
-	g_free(*str);
-	*str = buffer;
-}
-
 static gchar*
 escape_string (const gchar *str)
 {
@@ -436,6 +434,11 @@ message_view_dispose (GObject *obj)
 {
 	MessageView *mview = MESSAGE_VIEW (obj);
 	prefs_finalize (mview);
+	if (mview->privat->pending_idle)
+	{
+		g_source_remove (mview->privat->pending_idle);
+		mview->privat->pending_idle = 0;
+	}
 	if (mview->privat->tree_view)
 	{
 		mview->privat->tree_view = NULL;
@@ -447,7 +450,9 @@ static void
 message_view_finalize (GObject *obj)
 {
 	MessageView *mview = MESSAGE_VIEW (obj);
-	g_free (mview->privat->line_buffer);
+	g_string_free (mview->privat->line_buffer, TRUE);
+	g_queue_foreach (mview->privat->pending, (GFunc) message_free, NULL);
+	g_queue_free (mview->privat->pending);
 	g_free (mview->privat->label);
 	g_free (mview->privat->pixmap);
 	g_free (mview->privat);
@@ -470,12 +475,14 @@ message_view_instance_init (MessageView * self)
 	self->privat = g_new0 (MessageViewPrivate, 1);
 
 	/* Init private data */
-	self->privat->line_buffer = g_strdup("");
+	self->privat->line_buffer = g_string_new (NULL);
+	self->privat->pending = g_queue_new ();
 	self->privat->flags = 0xF;
 
 	/* Create the tree widget */
 	model = gtk_list_store_new (N_COLUMNS, G_TYPE_STRING,
-								G_TYPE_STRING, MESSAGE_TYPE,  G_TYPE_STRING);
+								G_TYPE_STRING, MESSAGE_TYPE,  G_TYPE_STRING,
+								G_TYPE_INT);
 	self->privat->model = GTK_TREE_MODEL (model);
 
 	/* message filter */
@@ -612,6 +619,8 @@ message_view_serialize (MessageView *view, AnjutaSerializer *serializer)
 
 	g_return_val_if_fail (view != NULL && MESSAGE_IS_VIEW (view), FALSE);
 
+	message_view_flush_pending (view);
+
 	if (!anjuta_serializer_write_string (serializer, "label",
 										 view->privat->label))
 		return FALSE;
@@ -859,6 +868,8 @@ void message_view_save(MessageView* view)
 
 	g_return_if_fail (view != NULL && MESSAGE_IS_VIEW (view));
 
+	message_view_flush_pending (view);
+
 	parent = GTK_WINDOW (gtk_widget_get_toplevel (GTK_WIDGET (view)));
 
 	uri = ask_user_for_save_uri (parent);
@@ -927,16 +938,27 @@ pref_change_color (MessageView *mview, IAnjutaMessageViewType type,
 	success = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
 	while (success)
 	{
-		Message *message;
-		gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, COLUMN_MESSAGE,
-							&message, -1);
-		if (message && message->type == type)
+		gint message_type;
+		gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, COLUMN_TYPE,
+							&message_type, -1);
+		if (message_type == type)
 		{
 			gtk_list_store_set (store, &iter, COLUMN_COLOR, color, -1);
 		}
 		success = gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter);
 	}
-	g_free(color);
+
+	/* Keep it for the next messages */
+	if (type == IANJUTA_MESSAGE_VIEW_TYPE_ERROR)
+	{
+		g_free (mview->privat->color_error);
+		mview->privat->color_error = color;
+	}
+	else
+	{
+		g_free (mview->privat->color_warning);
+		mview->privat->color_warning = color;
+	}
 }
 
 
@@ -962,6 +984,11 @@ prefs_init (MessageView *mview)
 	                  G_CALLBACK (on_notify_color), mview);
 	g_signal_connect (mview->privat->settings, "changed::" COLOR_WARNING,
 	                  G_CALLBACK (on_notify_color), mview);
+
+	mview->privat->color_error =
+		g_settings_get_string (mview->privat->settings, COLOR_ERROR);
+	mview->privat->color_warning =
+		g_settings_get_string (mview->privat->settings, COLOR_WARNING);
 }
 
 static void
@@ -970,6 +997,108 @@ prefs_finalize (MessageView *mview)
 	if (mview->privat->settings)
 		g_object_unref (mview->privat->settings);
 	mview->privat->settings = NULL;
+	g_free (mview->privat->color_error);
+	mview->privat->color_error = NULL;
+	g_free (mview->privat->color_warning);
+	mview->privat->color_warning = NULL;
+}
+
+/* Adds a message to the store */
+static void
+message_view_add (MessageView *view, const Message *message)
+{
+	const gchar* color = NULL;
+	const gchar* stock_id = NULL;
+	gchar *escaped_str;
+
+	if (view->privat->highlite)
+	{
+		switch (message->type)
+		{
+			case IANJUTA_MESSAGE_VIEW_TYPE_INFO:
+				view->privat->info_count++;
+				stock_id = GTK_STOCK_INFO;
+				break;
+			case IANJUTA_MESSAGE_VIEW_TYPE_WARNING:
+				color = view->privat->color_warning;
+				/* FIXME: There is no GTK_STOCK_WARNING which would fit better here */
+				view->privat->warn_count++;
+				stock_id = GTK_STOCK_DIALOG_WARNING;
+				break;
+			case IANJUTA_MESSAGE_VIEW_TYPE_ERROR:
+				color = view->privat->color_error;
+				view->privat->error_count++;
+				stock_id = GTK_STOCK_STOP;
+				break;
+			default:
+				view->privat->normal_count++;
+		}
+	}
+
+	if (message->details && *message->details != '\0')
+	{
+		gchar *summary;
+		summary = escape_string (message->summary);
+		escaped_str = g_strconcat ("<b>", summary, "</b>", NULL);
+		g_free (summary);
+	} else {
+		escaped_str = escape_string (message->summary);
+	}
+
+	/* Set all the columns at once, the filter and the view get a single
+	 * notification */
+	gtk_list_store_insert_with_values (GTK_LIST_STORE (view->privat->model),
+									   NULL, -1,
+									   COLUMN_COLOR, color,
+									   COLUMN_SUMMARY, escaped_str,
+									   COLUMN_MESSAGE, message,
+									   COLUMN_PIXBUF, stock_id,
+									   COLUMN_TYPE, message->type,
+									   -1);
+	g_free (escaped_str);
+}
+
+/* Adds the messages queued by ianjuta_message_view_append_batched() */
+static void
+message_view_flush_pending (MessageView *view)
+{
+	Message *message;
+
+	if (view->privat->pending_idle)
+	{
+		g_source_remove (view->privat->pending_idle);
+		view->privat->pending_idle = 0;
+	}
+
+	while ((message = g_queue_pop_head (view->privat->pending)) != NULL)
+	{
+		message_view_add (view, message);
+		message_free (message);
+	}
+}
+
+static gboolean
+on_pending_idle (gpointer data)
+{
+	MessageView *view = MESSAGE_VIEW (data);
+	Message *message;
+	gint i;
+
+	for (i = 0; i < MESSAGES_BATCH; i++)
+	{
+		message = g_queue_pop_head (view->privat->pending);
+		if (message == NULL)
+			break;
+		message_view_add (view, message);
+		message_free (message);
+	}
+
+	if (g_queue_is_empty (view->privat->pending))
+	{
+		view->privat->pending_idle = 0;
+		return FALSE;
+	}
+	return TRUE;
 }
 
 /* IAnjutaMessageView interface implementation */
@@ -982,34 +1111,26 @@ imessage_view_buffer_append (IAnjutaMessageView * message_view,
 									const gchar * message, GError ** e)
 {
 	MessageView *view;
-	gint cur_char;
-	int len;
+	const gchar *eol;
 
 	g_return_if_fail (MESSAGE_IS_VIEW (message_view));
 
 	if (!message)
 		return;
 
-	len = strlen(message);
-
 	view = MESSAGE_VIEW (message_view);
 
 	/* Check if message contains newlines */
-	for (cur_char = 0; cur_char < len; cur_char++)
+	while ((eol = strchr (message, '\n')) != NULL)
 	{
 		/* Is newline => print line */
-		if (message[cur_char] != '\n')
-		{
-			add_char(&view->privat->line_buffer, message[cur_char]);
-		}
-		else
-		{
-			g_signal_emit_by_name (G_OBJECT (view), "buffer_flushed",
-								   view->privat->line_buffer);
-			g_free(view->privat->line_buffer);
-			view->privat->line_buffer = g_strdup("");
-		}
+		g_string_append_len (view->privat->line_buffer, message, eol - message);
+		g_signal_emit_by_name (G_OBJECT (view), "buffer_flushed",
+							   view->privat->line_buffer->str);
+		g_string_truncate (view->privat->line_buffer, 0);
+		message = eol + 1;
 	}
+	g_string_append (view->privat->line_buffer, message);
 }
 
 static void
@@ -1019,87 +1140,45 @@ imessage_view_append (IAnjutaMessageView *message_view,
 					  const gchar *details,
 					  GError ** e)
 {
-	gchar* color;
-	GtkListStore *store;
-	GtkTreeIter iter;
-	gboolean highlite;
-	gchar *utf8_msg;
-	gchar *escaped_str;
-	gchar* stock_id = NULL;
-
 	MessageView *view;
-	Message *message;
+	Message message;
 
 	g_return_if_fail (MESSAGE_IS_VIEW (message_view));
 
 	view = MESSAGE_VIEW (message_view);
 
-	message = message_new (type, summary, details);
+	/* Keep the order of the batched messages */
+	message_view_flush_pending (view);
 
-	g_object_get (G_OBJECT (view), "highlite", &highlite, NULL);
-	color = NULL;
-	if (highlite)
-	{
-		switch (message->type)
-		{
-			case IANJUTA_MESSAGE_VIEW_TYPE_INFO:
-				view->privat->info_count++;
-				stock_id = GTK_STOCK_INFO;
-				break;
-			case IANJUTA_MESSAGE_VIEW_TYPE_WARNING:
-				color = g_settings_get_string (view->privat->settings, COLOR_WARNING);
-				/* FIXME: There is no GTK_STOCK_WARNING which would fit better here */
-				view->privat->warn_count++;
-				stock_id = GTK_STOCK_DIALOG_WARNING;
-				break;
-			case IANJUTA_MESSAGE_VIEW_TYPE_ERROR:
-				color = g_settings_get_string (view->privat->settings, COLOR_ERROR);
-				view->privat->error_count++;
-				stock_id = GTK_STOCK_STOP;
-				break;
-			default:
-				color = NULL;
-				view->privat->normal_count++;
-		}
-	}
+	message.type = type;
+	message.summary = (gchar *) summary;
+	message.details = (gchar *) details;
+	message_view_add (view, &message);
+}
 
-	/* Add the message to the tree */
-	store = GTK_LIST_STORE (view->privat->model);
-	gtk_list_store_append (store, &iter);
-
-	/*
-	 * Must be normalized to compose representation to be
-	 * displayed correctly (Bug in gtk_list???)
-	 */
-	utf8_msg = g_utf8_normalize (message->summary, -1,
-								 G_NORMALIZE_DEFAULT_COMPOSE);
-	if (message->details && strlen (message->details) > 0)
-	{
-		gchar *summary;
-		summary = escape_string (message->summary);
-		escaped_str = g_strdup_printf ("<b>%s</b>", summary);
-		g_free (summary);
-	} else {
-		escaped_str = escape_string (message->summary);
-	}
-	gtk_list_store_set (store, &iter,
-							COLUMN_SUMMARY, escaped_str,
-							COLUMN_MESSAGE, message,
-							-1);
-	if (color)
-	{
-		gtk_list_store_set (store, &iter,
-							COLUMN_COLOR, color, -1);
-	}
-	if (stock_id)
+static void
+imessage_view_append_batched (IAnjutaMessageView *message_view,
+							  IAnjutaMessageViewType type,
+							  const gchar *summary,
+							  const gchar *details,
+							  GError ** e)
+{
+	MessageView *view;
+
+	g_return_if_fail (MESSAGE_IS_VIEW (message_view));
+
+	view = MESSAGE_VIEW (message_view);
+
+	g_queue_push_tail (view->privat->pending,
+					   message_new (type, summary, details));
+
+	/* Added after the view is redrawn */
+	if (!view->privat->pending_idle)
 	{
-		gtk_list_store_set (store, &iter,
-							COLUMN_PIXBUF, stock_id, -1);
+		view->privat->pending_idle =
+			g_idle_add_full (G_PRIORITY_HIGH_IDLE + 30, on_pending_idle,
+							 view, NULL);
 	}
-	g_free(color);
-	message_free (message);
-	g_free (utf8_msg);
-	g_free (escaped_str);
 }
 
 /* Clear all messages from the message view */
@@ -1112,6 +1191,15 @@ imessage_view_clear (IAnjutaMessageView *message_view, GError **e)
 	g_return_if_fail (MESSAGE_IS_VIEW (message_view));
 	view = MESSAGE_VIEW (message_view);
 
+	/* Drop the messages not added yet */
+	if (view->privat->pending_idle)
+	{
+		g_source_remove (view->privat->pending_idle);
+		view->privat->pending_idle = 0;
+	}
+	g_queue_foreach (view->privat->pending, (GFunc) message_free, NULL);
+	g_queue_clear (view->privat->pending);
+
 	/* filter settings restart */
 	view->privat->normal_count = 0;
 	view->privat->info_count = 0;
@@ -1128,6 +1216,7 @@ imessage_view_select_next (IAnjutaMessageView * message_view,
 						   GError ** e)
 {
 	MessageView* view = MESSAGE_VIEW(message_view);
+	message_view_flush_pending (view);
 	message_view_next(view);
 }
 
@@ -1137,6 +1226,7 @@ imessage_view_select_previous (IAnjutaMessageView * message_view,
 							   GError ** e)
 {
 	MessageView *view = MESSAGE_VIEW(message_view);
+	message_view_flush_pending (view);
 	message_view_previous(view);
 }
 
@@ -1157,6 +1247,7 @@ imessage_view_get_current_message (IAnjutaMessageView * message_view,
 	g_return_val_if_fail (MESSAGE_IS_VIEW (message_view), NULL);
 
 	view = MESSAGE_VIEW (message_view);
+	message_view_flush_pending (view);
 	select = gtk_tree_view_get_selection (GTK_TREE_VIEW
 									      (view->privat->tree_view));
 
@@ -1207,6 +1298,7 @@ imessage_view_get_all_messages (IAnjutaMessageView * message_view,
 	g_return_val_if_fail (MESSAGE_IS_VIEW (message_view), NULL);
 
 	view = MESSAGE_VIEW (message_view);
+	message_view_flush_pending (view);
 	store = GTK_LIST_STORE (view->privat->model);
 
 	if (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter))
@@ -1227,6 +1319,7 @@ imessage_view_iface_init (IAnjutaMessageViewIface *iface)
 {
 	iface->buffer_append = imessage_view_buffer_append;
 	iface->append = imessage_view_append;
+	iface->append_batched = imessage_view_append_batched;
 	iface->clear = imessage_view_clear;
 	iface->select_next = imessage_view_select_next;
 	iface->select_previous = imessage_view_select_previous;
@@ -1238,23 +1331,23 @@ static gboolean
 message_view_tree_view_filter (GtkTreeModel *model, GtkTreeIter  *iter,
 							   gpointer      data)
 {
-	Message *msg;
+	gint type;
 	MessageView *msgview;
 
 	msgview = MESSAGE_VIEW (data);
-	gtk_tree_model_get (msgview->privat->model, iter, COLUMN_MESSAGE, &msg, -1);
-
-	if (msg != NULL) {
-		if (msg->type == IANJUTA_MESSAGE_VIEW_TYPE_NORMAL) {
-			return msgview->privat->flags & MESSAGE_VIEW_SHOW_NORMAL;
-		} else if (msg->type == IANJUTA_MESSAGE_VIEW_TYPE_INFO) {
-			return msgview->privat->flags & MESSAGE_VIEW_SHOW_INFO;
-		} else if (msg->type == IANJUTA_MESSAGE_VIEW_TYPE_WARNING) {
-			return msgview->privat->flags & MESSAGE_VIEW_SHOW_WARNING;
-		} else if (msg->type == IANJUTA_MESSAGE_VIEW_TYPE_ERROR) {
-			return msgview->privat->flags & MESSAGE_VIEW_SHOW_ERROR;
-		} else return TRUE;
-	} else return FALSE;
+
+	/* The type has its own column, getting the boxed message copies it */
+	gtk_tree_model_get (msgview->privat->model, iter, COLUMN_TYPE, &type, -1);
+
+	if (type == IANJUTA_MESSAGE_VIEW_TYPE_NORMAL) {
+		return msgview->privat->flags & MESSAGE_VIEW_SHOW_NORMAL;
+	} else if (type == IANJUTA_MESSAGE_VIEW_TYPE_INFO) {
+		return msgview->privat->flags & MESSAGE_VIEW_SHOW_INFO;
+	} else if (type == IANJUTA_MESSAGE_VIEW_TYPE_WARNING) {
+		return msgview->privat->flags & MESSAGE_VIEW_SHOW_WARNING;
+	} else if (type == IANJUTA_MESSAGE_VIEW_TYPE_ERROR) {
+		return msgview->privat->flags & MESSAGE_VIEW_SHOW_ERROR;
+	} else return TRUE;
 }
 
 MessageViewFlags
@@ -0,0 +1,106 @@
+/* parser-cxx scope cache benchmark: replays a completion session */
+
+
+#include "../cxxparser/scope-cache.h"
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* every how many completions an edit is done above the cursor */
+#define EDIT_EVERY 8
+
+/* 
+ * The session types the file from its start: a completion is triggered on
+ * each '.', '->' and '::', on the text above it. Some completions follow an
+ * edit of the lines above, which invalidates the checkpoints after it.
+ */
+static gdouble
+replay_session (const string& text, ScopeCache *cache, gboolean cached,
+                gint *completions)
+{
+	GTimer *timer;
+	GRand *rand;
+	string above;
+	string edited = text;
+	gsize pos;
+	gdouble elapsed = 0;
+
+	timer = g_timer_new ();
+	rand = g_rand_new_with_seed (1);
+	*completions = 0;
+	
+	for (pos = 1; pos < edited.size (); pos++)
+	{
+		if (edited[pos] != '.' && 
+		    !(edited[pos] == '>' && edited[pos - 1] == '-') &&
+		    !(edited[pos] == ':' && edited[pos - 1] == ':'))
+			continue;
+
+		if (++(*completions) % EDIT_EVERY == 0)
+		{
+			/* add a declaration somewhere in the last 2k above */
+			gsize at = pos - MIN (pos, (gsize)g_rand_int_range (rand, 1, 2048));
+			at = edited.find ('\n', at);
+			if (at != string::npos && at < pos)
+			{
+				edited.insert (at + 1, "int edited;\n");
+				pos += strlen ("int edited;\n");
+			}
+		}
+
+		above.assign (edited, 0, pos + 1);
+		
+		g_timer_start (timer);
+		if (!cached)
+			cache->clear ();
+		cache->optimizeScope ("benchmark.cpp", above);
+		g_timer_stop (timer);
+		
+		elapsed += g_timer_elapsed (timer, NULL);
+	}
+
+	g_rand_free (rand);
+	g_timer_destroy (timer);
+
+	return elapsed;
+}
+
+int 
+main (int argc, char** argv)
+{
+	gchar *contents;
+	gsize length;
+	GError *error = NULL;
+	ScopeCache cache;
+	gint completions;
+	gdouble uncached_time, cached_time;
+
+	if (argc < 2)
+	{
+		printf ("Usage: %s file.cpp\n", argv[0]);
+		return 1;
+	}
+
+	if (!g_file_get_contents (argv[1], &contents, &length, &error))
+	{
+		g_warning ("Cannot read %s: %s", argv[1], error->message);
+		g_error_free (error);
+		return 1;
+	}
+
+	string text (contents, length);
+	g_free (contents);
+
+	g_message ("replaying completions over %s (%" G_GSIZE_FORMAT " bytes)", 
+	           argv[1], length);
+
+	uncached_time = replay_session (text, &cache, FALSE, &completions);
+	g_message ("full lexing: %d completions in %f seconds (%f ms each)", 
+	           completions, uncached_time, uncached_time * 1000 / completions);
+
+	cached_time = replay_session (text, &cache, TRUE, &completions);
+	g_message ("checkpoints: %d completions in %f seconds (%f ms each)", 
+	           completions, cached_time, cached_time * 1000 / completions);
+
+	return 0;
+}
@@ -53,6 +53,8 @@ CppTokenizer::CppTokenizer() : m_curr(0)
 {
 	m_data = NULL;
 	m_pcurr = NULL;
+	m_bufEnd = NULL;
+	m_total = 0;
 	m_keepComments = 0;
 	m_returnWhite = 0;
 	m_comment = "";
@@ -70,13 +72,15 @@ CppTokenizer::LexerInput(char *buf, int max_size)
 		return 0;
 
 	memset(buf, 0, max_size);
-	char *pendData = m_data + strlen(m_data);
+	char *pendData = m_data + m_total;
 	int n = (max_size < (pendData - m_pcurr)) ? max_size : (pendData - m_pcurr);
 	if(n > 0)
 	{
 		memcpy(buf, m_pcurr, n);
 		m_pcurr += n;
 	}
+	/* the lexer buffer holds the text read so far up to here */
+	m_bufEnd = buf + n;
 	return n;
 }
 
@@ -86,8 +90,9 @@ CppTokenizer::setText(const char* data)
 	// release previous buffer
 	reset();
 
-	m_data = new char[strlen(data)+1];
-	strcpy(m_data, data);
+	m_total = strlen(data);
+	m_data = new char[m_total+1];
+	memcpy(m_data, data, m_total+1);
 	m_pcurr = m_data;
 }
 
@@ -99,7 +104,9 @@ CppTokenizer::reset()
 		delete [] m_data;
 		m_data = NULL;
 		m_pcurr = NULL;
+		m_bufEnd = NULL;
 		m_curr = 0;
+		m_total = 0;
 	}
 
 	// Notify lex to restart its buffer
@@ -114,6 +121,16 @@ CppTokenizer::lineNo() const
 	return yylineno;
 }
 
+size_t 
+CppTokenizer::tokenEnd() const
+{
+	if (!m_data || !m_bufEnd)
+		return 0;
+
+	/* bytes given to the lexer minus the ones it still has to match */
+	return (m_pcurr - m_data) - (m_bufEnd - (yytext + yyleng));
+}
+
 void 
 CppTokenizer::clearComment() 
 { 
@@ -65,6 +65,9 @@ public:
 	 *	incase the comment spans over number of lines
 	 */
 	const int& lineNo() const; 
+
+	/* Offset in the text set of the byte following the last token */
+	size_t tokenEnd() const;
 	inline void clearComment();
 	inline const char* getComment() const;
 	inline void keepComment(const int& keep);
@@ -73,6 +76,7 @@ public:
 private:
 	char *m_data;
 	char *m_pcurr;
+	char *m_bufEnd;
 	int   m_total;
 	int   m_curr;
 };
@@ -22,6 +22,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 
 
 #ifdef __cplusplus
@@ -32,6 +33,7 @@ extern "C" {
 
 #include "expression-result.h"
 #include "cpp-flex-tokenizer.h"
+#include "scope-cache.h"
 
 using namespace std;
 
@@ -72,6 +74,12 @@ public:
     				  							const string& above_text,
     				  							const string& full_file_path, 
     				  							unsigned long linenum);
+
+	/* Drops the cached scopes of a file, e.g. when its editor is closed */
+	void forgetFile (const string& full_file_path);
+
+	/* Drops the symbols cached from the db, e.g. when they change */
+	void clearSymbolCache ();
 	
 protected:
 
@@ -112,8 +120,19 @@ private:
 	 * variables and the functions names. 
 	 * You can use this method to retrieve the type of a local variable, if it's
 	 * present in the passed buffer of course.
+	 * The buffer is expected to be the text of full_file_path from its start:
+	 * the lexing resumes from the last block boundary cached for the file.
+	 */
+	string optimizeScope(const string& full_file_path, const string& srcString);
+
+	/**
+	 * These run the queries whose results don't depend on the statement,
+	 * i.e. the steps between the members of a chain: the results are cached
+	 * until the symbols of the db change. A new reference is returned.
 	 */
-	string optimizeScope(const string& srcString);
+	IAnjutaIterable * searchType (const string& type_name);
+	IAnjutaIterable * searchInScope (const string& name, IAnjutaSymbol *scope);
+	IAnjutaIterable * searchParentScope (IAnjutaSymbol *node);
 	
 	/*
 	 * D A T A
@@ -121,12 +140,17 @@ private:
 	static EngineParser *s_engine;	
 
 	CppTokenizer *_main_tokenizer;
-	CppTokenizer *_extra_tokenizer;
+	ScopeCache *_scope_cache;
 	
 	IAnjutaSymbolQuery *_query_scope;
 	IAnjutaSymbolQuery *_query_search;
 	IAnjutaSymbolQuery *_query_search_in_scope;
 	IAnjutaSymbolQuery *_query_parent_scope;
+
+	IAnjutaSymbolManager *_manager;
+	map<string, IAnjutaIterable *> _type_cache;
+	map<pair<int, string>, IAnjutaIterable *> _member_cache;
+	map<int, IAnjutaIterable *> _parent_scope_cache;
 };
 
 
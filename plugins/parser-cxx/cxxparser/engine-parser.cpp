@@ -36,6 +36,9 @@
 
 using namespace std;
 
+/* Results kept for each kind of cached query */
+#define SYMBOL_CACHE_MAX		512
+
 /* Singleton pattern. */
 EngineParser* 
 EngineParser::getInstance ()
@@ -51,13 +54,15 @@ EngineParser::getInstance ()
 EngineParser::EngineParser ()
 {	
 	_main_tokenizer = new CppTokenizer ();	
-	_extra_tokenizer = new CppTokenizer ();	
+	_scope_cache = new ScopeCache ();
+	_manager = NULL;
 }
 
 EngineParser::~EngineParser ()
 {
+	clearSymbolCache ();
 	delete _main_tokenizer;
-	delete _extra_tokenizer;
+	delete _scope_cache;
 }
 
 bool 
@@ -116,9 +121,26 @@ EngineParser::parseExpression(const string &in)
 	return parse_expression (in.c_str ());	
 }
 
+/* Handles prj-symbol-changed as well as the end of the project and system
+ * scans, the latter updating the globals */
+static void
+on_symbol_manager_symbols_changed (IAnjutaSymbolManager *manager,
+                                   gint id, EngineParser *parser)
+{
+	parser->clearSymbolCache ();
+}
+
 void
 EngineParser::unsetSymbolManager ()
 {
+	clearSymbolCache ();
+	
+	if (_manager)
+		g_signal_handlers_disconnect_by_func (_manager, 
+		                                      (gpointer)on_symbol_manager_symbols_changed,
+		                                      this);
+	_manager = NULL;
+
 	if (_query_scope)
 		g_object_unref (_query_scope);
 	_query_scope = NULL;
@@ -160,6 +182,21 @@ EngineParser::setSymbolManager (IAnjutaSymbolManager *manager)
 		IANJUTA_SYMBOL_FIELD_KIND, IANJUTA_SYMBOL_FIELD_RETURNTYPE,
 		IANJUTA_SYMBOL_FIELD_SIGNATURE, IANJUTA_SYMBOL_FIELD_TYPE_NAME
 	};
+
+	/* the cached symbols are valid until the project or system ones change */
+	clearSymbolCache ();
+	if (_manager)
+		g_signal_handlers_disconnect_by_func (_manager, 
+		                                      (gpointer)on_symbol_manager_symbols_changed,
+		                                      this);
+	_manager = manager;
+	g_signal_connect (manager, "prj-symbol-changed",
+	                  G_CALLBACK (on_symbol_manager_symbols_changed), this);
+	g_signal_connect (manager, "prj-scan-end",
+	                  G_CALLBACK (on_symbol_manager_symbols_changed), this);
+	g_signal_connect (manager, "sys-scan-end",
+	                  G_CALLBACK (on_symbol_manager_symbols_changed), this);
+	
 	_query_search =
 		ianjuta_symbol_manager_create_query (manager,
 		                                     IANJUTA_SYMBOL_QUERY_SEARCH,
@@ -214,6 +251,109 @@ EngineParser::trim (string& str, string trimChars /* = "{};\r\n\t\v " */)
 	}
 }
 
+template <class Key> static void
+clear_iterables_map (map<Key, IAnjutaIterable *>& iterables)
+{
+	typename map<Key, IAnjutaIterable *>::iterator iter;
+
+	for (iter = iterables.begin (); iter != iterables.end (); iter++)
+	{
+		if (iter->second != NULL)
+			g_object_unref (iter->second);
+	}
+	iterables.clear ();
+}
+
+/* Returns a new cursor on a cached result, rewound to its first symbol */
+template <class Key> static IAnjutaIterable *
+lookup_iterables_map (map<Key, IAnjutaIterable *>& iterables, const Key& key)
+{
+	typename map<Key, IAnjutaIterable *>::iterator iter = iterables.find (key);
+	IAnjutaIterable *clone;
+
+	if (iter == iterables.end ())
+		return NULL;
+
+	clone = ianjuta_iterable_clone (iter->second, NULL);
+	if (clone != NULL)
+		ianjuta_iterable_first (clone, NULL);
+	return clone;
+}
+
+/* Keeps a cursor of its own on the result, missing symbols are not cached
+ * as they can show up with the next scan */
+template <class Key> static void
+insert_iterables_map (map<Key, IAnjutaIterable *>& iterables, const Key& key,
+                      IAnjutaIterable *iter)
+{
+	IAnjutaIterable *clone;
+
+	if (iter == NULL)
+		return;
+	clone = ianjuta_iterable_clone (iter, NULL);
+	if (clone == NULL)
+		return;
+
+	if (iterables.size () >= SYMBOL_CACHE_MAX)
+		clear_iterables_map (iterables);
+	iterables[key] = clone;
+}
+
+void
+EngineParser::clearSymbolCache ()
+{
+	clear_iterables_map (_type_cache);
+	clear_iterables_map (_member_cache);
+	clear_iterables_map (_parent_scope_cache);
+}
+
+IAnjutaIterable *
+EngineParser::searchType (const string& type_name)
+{
+	IAnjutaIterable *iter;
+
+	if ((iter = lookup_iterables_map (_type_cache, type_name)) != NULL)
+		return iter;
+	
+	iter = ianjuta_symbol_query_search (_query_search, type_name.c_str (), NULL);
+	insert_iterables_map (_type_cache, type_name, iter);
+	
+	return iter;
+}
+
+IAnjutaIterable *
+EngineParser::searchInScope (const string& name, IAnjutaSymbol *scope)
+{
+	IAnjutaIterable *iter;
+	pair<int, string> key (ianjuta_symbol_get_int (scope, IANJUTA_SYMBOL_FIELD_ID, 
+	                                               NULL), name);
+
+	if ((iter = lookup_iterables_map (_member_cache, key)) != NULL)
+		return iter;
+	
+	iter = ianjuta_symbol_query_search_in_scope (_query_search_in_scope,
+	                                             name.c_str (), scope, NULL);
+	insert_iterables_map (_member_cache, key, iter);
+	
+	return iter;
+}
+
+IAnjutaIterable *
+EngineParser::searchParentScope (IAnjutaSymbol *node)
+{
+	IAnjutaIterable *iter;
+	int key = ianjuta_symbol_get_int (node, IANJUTA_SYMBOL_FIELD_ID, NULL);
+
+	if ((iter = lookup_iterables_map (_parent_scope_cache, key)) != NULL)
+		return iter;
+	
+	iter = ianjuta_symbol_query_search_parent_scope (_query_parent_scope,
+	                                                 node, NULL);
+	insert_iterables_map (_parent_scope_cache, key, iter);
+	
+	return iter;
+}
+
 /**
  * @return NULL on global 
  */
@@ -245,9 +385,7 @@ EngineParser::getNearestClassInCurrentScopeChainByFileLine (const char* full_fil
 				out_type_name = ianjuta_symbol_get_string (node, IANJUTA_SYMBOL_FIELD_NAME, NULL);
 				break;
 			}
-			parent_iter =
-				ianjuta_symbol_query_search_parent_scope (_query_parent_scope,
-				                                          node, NULL);
+			parent_iter = searchParentScope (node);
 
 			if (parent_iter && 
 			    ianjuta_symbol_get_int (IANJUTA_SYMBOL (iter), IANJUTA_SYMBOL_FIELD_ID, NULL) == 
@@ -352,7 +490,7 @@ EngineParser::getTypeNameAndScopeByToken (ExpressionResult &result,
 		DEBUG_PRINT ("*** Found an identifier or local variable...");
 
 		/* optimize scope'll clear the scopes leaving the local variables */
-		string optimized_scope = optimizeScope(above_text);
+		string optimized_scope = optimizeScope(full_file_path, above_text);
 
 		VariableList li;
 		std::map<std::string, std::string> ignoreTokens;
@@ -433,8 +571,7 @@ IAnjutaIterable *
 EngineParser::getCurrentSearchableScope (string &type_name, string &type_scope)
 {
 	// FIXME: case of more results now it's hardcoded to 1
-	IAnjutaIterable *curr_searchable_scope =
-		ianjuta_symbol_query_search (_query_search, type_name.c_str(), NULL);
+	IAnjutaIterable *curr_searchable_scope = searchType (type_name);
 	
 	if (curr_searchable_scope != NULL)
 	{
@@ -487,8 +624,7 @@ EngineParser::switchTypedefToStruct (IAnjutaIterable * test,
 
 	DEBUG_PRINT ("Switching TYPEDEF (%d) ==> to STRUCT",
 	             ianjuta_symbol_get_int (node, IANJUTA_SYMBOL_FIELD_ID, NULL));
-	new_struct = ianjuta_symbol_query_search_parent_scope (_query_parent_scope,
-	                                                       node, NULL);
+	new_struct = searchParentScope (node);
 	                                         
 	if (new_struct != NULL)
 	{
@@ -516,8 +652,7 @@ EngineParser::switchMemberToContainer (IAnjutaIterable * test)
 	DEBUG_PRINT ("Switching container with type_name %s", sym_type_name);
 
 	/* hopefully we'll find a new container for the type_name of test param */
-	new_container = ianjuta_symbol_query_search (_query_search,
-	                                             sym_type_name, NULL);
+	new_container = sym_type_name != NULL ? searchType (sym_type_name) : NULL;
 	if (new_container != NULL)
 	{
 		g_object_unref (test);
@@ -626,9 +761,7 @@ EngineParser::processExpression(const string& stmt,
 
 		node = IANJUTA_SYMBOL (curr_searchable_scope);
 		
-		iter = ianjuta_symbol_query_search_in_scope (_query_search_in_scope,
-		                                             result.m_name.c_str (),
-		                                             node, NULL);
+		iter = searchInScope (result.m_name, node);
 		
 		if (iter == NULL)
 		{
@@ -729,115 +862,15 @@ EngineParser::processExpression(const string& stmt,
  * @return The visible scope until pchStopWord is encountered
  */
 string 
-EngineParser::optimizeScope(const string& srcString)
+EngineParser::optimizeScope(const string& full_file_path, const string& srcString)
 {
-	string wxcurrScope;
-	std::vector<std::string> scope_stack;
-	std::string currScope;
-
-	int type;
-
-	/* Initialize the scanner with the string to search */
-	const char * scannerText =  srcString.c_str ();
-	_extra_tokenizer->setText (scannerText);
-	bool changedLine = false;
-	bool prepLine = false;
-	int curline = 0;
-	while (true) 
-	{
-		type = _extra_tokenizer->yylex();
-
-		/* Eof ? */
-		if (type == 0) 
-		{
-			if (!currScope.empty())
-				scope_stack.push_back(currScope);
-			break;
-		}
-
-		/* eat up all tokens until next line */
-		if ( prepLine && _extra_tokenizer->lineno() == curline) 
-		{
-			currScope += " ";
-			currScope += _extra_tokenizer->YYText();
-			continue;
-		}
-
-		prepLine = false;
-
-		/* Get the current line number, it will help us detect preprocessor lines */
-		changedLine = (_extra_tokenizer->lineno() > curline);
-		if (changedLine) 
-		{
-			currScope += "\n";
-		}
-
-		curline = _extra_tokenizer->lineno();
-		switch (type) 
-		{
-		case (int)'(':
-			currScope += "\n";
-			scope_stack.push_back(currScope);
-			currScope = "(\n";
-			break;
-		case (int)'{':
-			currScope += "\n";
-			scope_stack.push_back(currScope);
-			currScope = "{\n";
-			break;
-		case (int)')':
-			// Discard the current scope since it is completed
-			if ( !scope_stack.empty() ) {
-				currScope = scope_stack.back();
-				scope_stack.pop_back();
-				currScope += "()";
-			} else
-				currScope.clear();
-			break;
-		case (int)'}':
-			/* Discard the current scope since it is completed */
-			if ( !scope_stack.empty() ) {
-				currScope = scope_stack.back();
-				scope_stack.pop_back();
-				currScope += "\n{}\n";
-			} else {
-				currScope.clear();
-			}
-			break;
-		case (int)'#':
-			if (changedLine) {
-				/* We are at the start of a new line
-				 * consume everything until new line is found or end of text
-				 */
-				currScope += " ";
-				currScope += _extra_tokenizer->YYText();
-				prepLine = true;
-				break;
-			}
-		default:
-			currScope += " ";
-			currScope += _extra_tokenizer->YYText();
-			break;
-		}
-	}
-
-	_extra_tokenizer->reset();
-
-	if (scope_stack.empty())
-		return srcString;
-
-	currScope.clear();
-	size_t i = 0;
-	for (; i < scope_stack.size(); i++)
-		currScope += scope_stack.at(i);
-
-	/* if the current scope is not empty, terminate it with ';' and return */
-	if ( currScope.empty() == false ) {
-		currScope += ";";
-		return currScope.c_str();
-	}
+	return _scope_cache->optimizeScope (full_file_path, srcString);
+}
 
-	return srcString;
+void
+EngineParser::forgetFile (const string& full_file_path)
+{
+	_scope_cache->forgetDocument (full_file_path);
 }
 
 /************ C FUNCTIONS ************/
@@ -854,6 +887,12 @@ engine_parser_deinit ()
 	EngineParser::getInstance ()->unsetSymbolManager ();
 }
 
+void
+engine_parser_forget_file (const gchar *full_file_path)
+{
+	EngineParser::getInstance ()->forgetFile (full_file_path);
+}
+
 IAnjutaIterable *
 engine_parser_process_expression (const gchar *stmt, const gchar * above_text,
     const gchar * full_file_path, gulong linenum)
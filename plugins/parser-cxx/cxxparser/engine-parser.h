@@ -45,6 +45,12 @@ IAnjutaIterable *
 engine_parser_process_expression (const gchar *stmt, const gchar * above_text,
     const gchar * full_file_path, gulong linenum);	
 
+/**
+ * Drops what was cached while processing the expressions of a file.
+ * @param full_file_path The full path to the file.
+ */
+void engine_parser_forget_file (const gchar * full_file_path);
+
 #ifdef __cplusplus
 }	// extern "C" 
 #endif
@@ -0,0 +1,269 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta
+ * Copyright (C) 2012
+ *
+ * anjuta is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * anjuta is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scope-cache.h"
+
+/* Minimum distance in bytes between two checkpoints of a document. Each
+ * checkpoint copies the scope stack, so they are also spaced by half of its
+ * size: the checkpoints of a document never take more than twice its text.
+ */
+#define CHECKPOINT_MIN_DISTANCE		2048
+
+/* Documents whose checkpoints are kept */
+#define DOCUMENTS_MAX				8
+
+
+ScopeCache::ScopeCache () : _uses(0)
+{
+	_tokenizer = new CppTokenizer ();
+}
+
+ScopeCache::~ScopeCache ()
+{
+	delete _tokenizer;
+}
+
+void
+ScopeCache::forgetDocument (const string& document)
+{
+	_documents.erase (document);
+}
+
+void
+ScopeCache::clear ()
+{
+	_documents.clear ();
+}
+
+ScopeCache::Document&
+ScopeCache::getDocument (const string& document)
+{
+	map<string, Document>::iterator iter = _documents.find (document);
+
+	if (iter == _documents.end ())
+	{
+		/* make room dropping the least recently used one */
+		if (_documents.size () >= DOCUMENTS_MAX)
+		{
+			map<string, Document>::iterator oldest = _documents.begin ();
+			for (iter = _documents.begin (); iter != _documents.end (); iter++)
+			{
+				if (iter->second.last_use < oldest->second.last_use)
+					oldest = iter;
+			}
+			_documents.erase (oldest);
+		}
+		iter = _documents.insert (make_pair (document, Document ())).first;
+	}
+
+	iter->second.last_use = ++_uses;
+	return iter->second;
+}
+
+void
+ScopeCache::invalidate (Document& doc, const string& text)
+{
+	size_t len = min (doc.text.size (), text.size ());
+	size_t changed = 0;
+
+	while (changed < len && doc.text[changed] == text[changed])
+		changed++;
+
+	if (changed == text.size ())
+	{
+		/* nothing changed above the statement, the text after it is still
+		 * the one of the checkpoints */
+		return;
+	}
+
+	/* drop the checkpoints whose state depends on the changed text */
+	while (!doc.checkpoints.empty () && doc.checkpoints.back ().offset > changed)
+		doc.checkpoints.pop_back ();
+
+	doc.text = text;
+}
+
+string
+ScopeCache::optimizeScope (const string& document, const string& text)
+{
+	Document &doc = getDocument (document);
+	std::vector<std::string> scope_stack;
+	std::string currScope;
+	deque<Checkpoint>::reverse_iterator checkpoint;
+	bool add_checkpoints;
+	size_t base_offset = 0;
+	size_t last_offset = 0;
+	int base_line = 0;
+
+	int type;
+
+	invalidate (doc, text);
+
+	/* resume from the nearest checkpoint above the statement */
+	for (checkpoint = doc.checkpoints.rbegin ();
+	     checkpoint != doc.checkpoints.rend (); checkpoint++)
+	{
+		if (checkpoint->offset <= text.size ())
+			break;
+	}
+
+	/* new checkpoints are only appended */
+	add_checkpoints = checkpoint == doc.checkpoints.rbegin ();
+
+	bool changedLine = false;
+	bool prepLine = false;
+	int curline = 0;
+
+	if (checkpoint != doc.checkpoints.rend ())
+	{
+		scope_stack = checkpoint->scope_stack;
+		currScope = checkpoint->curr_scope;
+		base_offset = last_offset = checkpoint->offset;
+
+		/* the text resumed starts on the line of the boundary */
+		curline = checkpoint->line;
+		base_line = checkpoint->line - 1;
+	}
+
+	/* Initialize the scanner with the string to search */
+	_tokenizer->setText (text.c_str () + base_offset);
+	while (true)
+	{
+		type = _tokenizer->yylex();
+
+		/* Eof ? */
+		if (type == 0)
+		{
+			if (!currScope.empty())
+				scope_stack.push_back(currScope);
+			break;
+		}
+
+		int lineno = base_line + _tokenizer->lineno ();
+
+		/* eat up all tokens until next line */
+		if ( prepLine && lineno == curline)
+		{
+			currScope += " ";
+			currScope += _tokenizer->YYText();
+			continue;
+		}
+
+		prepLine = false;
+
+		/* Get the current line number, it will help us detect preprocessor lines */
+		changedLine = (lineno > curline);
+		if (changedLine)
+		{
+			currScope += "\n";
+		}
+
+		curline = lineno;
+		switch (type)
+		{
+		case (int)'(':
+			currScope += "\n";
+			scope_stack.push_back(currScope);
+			currScope = "(\n";
+			break;
+		case (int)'{':
+			currScope += "\n";
+			scope_stack.push_back(currScope);
+			currScope = "{\n";
+			break;
+		case (int)')':
+			// Discard the current scope since it is completed
+			if ( !scope_stack.empty() ) {
+				currScope = scope_stack.back();
+				scope_stack.pop_back();
+				currScope += "()";
+			} else
+				currScope.clear();
+			break;
+		case (int)'}':
+			/* Discard the current scope since it is completed */
+			if ( !scope_stack.empty() ) {
+				currScope = scope_stack.back();
+				scope_stack.pop_back();
+				currScope += "\n{}\n";
+			} else {
+				currScope.clear();
+			}
+			break;
+		case (int)'#':
+			if (changedLine) {
+				/* We are at the start of a new line
+				 * consume everything until new line is found or end of text
+				 */
+				currScope += " ";
+				currScope += _tokenizer->YYText();
+				prepLine = true;
+				break;
+			}
+		default:
+			currScope += " ";
+			currScope += _tokenizer->YYText();
+			break;
+		}
+
+		/* checkpoint the state at block boundaries */
+		if (add_checkpoints && (type == (int)'{' || type == (int)'}'))
+		{
+			size_t offset = base_offset + _tokenizer->tokenEnd ();
+
+			if (offset - last_offset >= CHECKPOINT_MIN_DISTANCE)
+			{
+				size_t state_size = currScope.size ();
+				for (size_t i = 0; i < scope_stack.size (); i++)
+					state_size += scope_stack[i].size ();
+
+				if (offset - last_offset >= state_size / 2)
+				{
+					doc.checkpoints.push_back (Checkpoint ());
+
+					Checkpoint &added = doc.checkpoints.back ();
+					added.offset = offset;
+					added.line = curline;
+					added.scope_stack = scope_stack;
+					added.curr_scope = currScope;
+
+					last_offset = offset;
+				}
+			}
+		}
+	}
+
+	_tokenizer->reset();
+
+	if (scope_stack.empty())
+		return text;
+
+	currScope.clear();
+	size_t i = 0;
+	for (; i < scope_stack.size(); i++)
+		currScope += scope_stack.at(i);
+
+	/* if the current scope is not empty, terminate it with ';' and return */
+	if ( currScope.empty() == false ) {
+		currScope += ";";
+		return currScope.c_str();
+	}
+
+	return text;
+}
@@ -0,0 +1,93 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta
+ * Copyright (C) 2012
+ *
+ * anjuta is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * anjuta is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SCOPE_CACHE_H_
+#define _SCOPE_CACHE_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+#include "cpp-flex-tokenizer.h"
+
+using namespace std;
+
+
+/**
+ * Reduces the text above a statement to the scopes enclosing it: all the
+ * completed scopes are dropped, leaving the local variables and the functions
+ * names only.
+ *
+ * The state of the reduction is checkpointed at block boundaries for each
+ * document. When the text passed for a document differs from the previous one
+ * only after a checkpoint, e.g. while typing, the reduction resumes from the
+ * nearest checkpoint instead of lexing the whole text again. Checkpoints
+ * after the first changed byte are dropped.
+ */
+class ScopeCache
+{
+public:
+
+	ScopeCache ();
+
+	virtual ~ScopeCache ();
+
+	/**
+	 * @param document Key of the document, e.g. its full path.
+	 * @param text Text of the document from its start up to the statement.
+	 * @return The reduced text, or text itself if there's nothing to reduce.
+	 */
+	string optimizeScope (const string& document, const string& text);
+
+	/* Drops the checkpoints of a document, e.g. when it is closed */
+	void forgetDocument (const string& document);
+
+	void clear ();
+
+private:
+
+	struct Checkpoint
+	{
+		size_t offset;					/* byte where the lexer resumes */
+		int line;						/* line of the block boundary */
+		vector<string> scope_stack;
+		string curr_scope;
+	};
+
+	struct Document
+	{
+		string text;					/* longest text seen */
+		deque<Checkpoint> checkpoints;	/* sorted by offset */
+		unsigned long last_use;
+	};
+
+	Document& getDocument (const string& document);
+
+	void invalidate (Document& doc, const string& text);
+
+	/*
+	 * D A T A
+	 */
+	CppTokenizer *_tokenizer;
+	map<string, Document> _documents;
+	unsigned long _uses;
+};
+
+#endif // _SCOPE_CACHE_H_
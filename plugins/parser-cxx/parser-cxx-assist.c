@@ -583,11 +583,11 @@ parser_cxx_assist_create_autocompletion_cache (ParserCxxAssist* assist,
 		}
 		/* This will avoid duplicates of FUNCTION and PROTOTYPE */
 		assist->priv->async_project_id = 1;
-		ianjuta_symbol_query_search (assist->priv->ac_query_project, pattern,
-		                             NULL);
+		ianjuta_symbol_query_search_text (assist->priv->ac_query_project,
+		                                  pre_word, NULL);
 		assist->priv->async_system_id = 1;
-		ianjuta_symbol_query_search (assist->priv->ac_query_system, pattern,
-		                             NULL);
+		ianjuta_symbol_query_search_text (assist->priv->ac_query_system,
+		                                  pre_word, NULL);
 		g_free (pre_word);
 		g_free (pattern);
 		
@@ -1018,6 +1018,8 @@ parser_cxx_assist_finalize (GObject *object)
 		g_object_unref (priv->sync_query_project);
 	priv->sync_query_project = NULL;
 
+	if (priv->editor_filename)
+		engine_parser_forget_file (priv->editor_filename);
 	engine_parser_deinit ();
 	
 	g_free (assist->priv);
@@ -1146,10 +1148,11 @@ parser_cxx_assist_new (IAnjutaEditor *ieditor,
 	                               IANJUTA_SYMBOL_QUERY_MODE_ASYNC, NULL);
 	g_signal_connect (assist->priv->ac_query_file, "async-result",
 	                  G_CALLBACK (on_symbol_search_complete), assist);
-	/* AC in project */
+	/* AC in project, through the name index: the ranking puts the prefix
+	 * matches kept by the completion first */
 	assist->priv->ac_query_project =
 		ianjuta_symbol_manager_create_query (isymbol_manager,
-		                                     IANJUTA_SYMBOL_QUERY_SEARCH,
+		                                     IANJUTA_SYMBOL_QUERY_SEARCH_TEXT,
 		                                     IANJUTA_SYMBOL_QUERY_DB_PROJECT,
 		                                     NULL);
 	ianjuta_symbol_query_set_group_by (assist->priv->ac_query_project,
@@ -1167,7 +1170,7 @@ parser_cxx_assist_new (IAnjutaEditor *ieditor,
 	/* AC in system */
 	assist->priv->ac_query_system =
 		ianjuta_symbol_manager_create_query (isymbol_manager,
-		                                     IANJUTA_SYMBOL_QUERY_SEARCH,
+		                                     IANJUTA_SYMBOL_QUERY_SEARCH_TEXT,
 		                                     IANJUTA_SYMBOL_QUERY_DB_SYSTEM,
 		                                     NULL);
 	ianjuta_symbol_query_set_group_by (assist->priv->ac_query_system,
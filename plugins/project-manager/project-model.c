@@ -45,9 +45,23 @@ struct _GbfProjectModelPrivate {
 	GtkTreeRowReference *root_group;
 	GList               *shortcuts;
 
+	GHashTable          *rows;	   /* Indexed row of each tree store node */
+	GHashTable          *nodes;	   /* Rows of each project node */
+	GHashTable          *files;	   /* Rows of each project node file */
+	GHashTable          *datas;	   /* Row of each tree data */
+
 	gboolean default_shortcut;	   /* Add shortcut for each primary node */
 };
 
+/* Row index entry, the iterators of a GtkTreeStore stay valid until the row
+ * is removed. */
+typedef struct {
+	GtkTreeIter          iter;
+	GbfTreeData         *data;
+	AnjutaProjectNode   *node;
+	GFile               *file;
+} GbfProjectModelRow;
+
 enum {
 	PROP_NONE,
 	PROP_PROJECT
@@ -64,6 +78,11 @@ static void     load_project                         (GbfProjectModel        *mo
 static void     insert_empty_node                    (GbfProjectModel        *model);
 static void     unload_project                       (GbfProjectModel        *model);
 
+static void     gbf_project_model_row_free           (GbfProjectModelRow     *row);
+static void     on_row_changed                       (GtkTreeModel           *model,
+						      GtkTreePath            *path,
+						      GtkTreeIter            *iter,
+						      gpointer                user_data);
 static gint     default_sort_func                    (GtkTreeModel           *model,
 						      GtkTreeIter            *iter_a,
 						      GtkTreeIter            *iter_b,
@@ -163,6 +182,10 @@ finalize (GObject *obj)
 {
 	GbfProjectModel *model = GBF_PROJECT_MODEL (obj);
 
+	g_hash_table_destroy (model->priv->nodes);
+	g_hash_table_destroy (model->priv->files);
+	g_hash_table_destroy (model->priv->datas);
+	g_hash_table_destroy (model->priv->rows);
 	g_free (model->priv);
 
 	G_OBJECT_CLASS (parent_class)->dispose (obj);
@@ -199,6 +222,16 @@ gbf_project_model_instance_init (GbfProjectModel *model)
 
 	model->priv = g_new0 (GbfProjectModelPrivate, 1);
 	model->priv->default_shortcut = TRUE;
+	model->priv->rows = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+						   NULL, (GDestroyNotify)gbf_project_model_row_free);
+	model->priv->nodes = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+						    NULL, (GDestroyNotify)g_queue_free);
+	model->priv->files = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal,
+						    g_object_unref, (GDestroyNotify)g_queue_free);
+	model->priv->datas = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	/* keep the indexes up to date */
+	g_signal_connect (model, "row-changed", G_CALLBACK (on_row_changed), NULL);
 
 	/* sorting function */
 	gtk_tree_sortable_set_default_sort_func (GTK_TREE_SORTABLE (model),
@@ -211,6 +244,208 @@ gbf_project_model_instance_init (GbfProjectModel *model)
 	insert_empty_node (model);
 }
 
+/* Model index functions ------------ */
+
+/* The rows are indexed by tree data, by project node and by project node
+ * file, so they can be found without walking the whole tree. The indexes are
+ * updated each time the data of a row is set and before removing a row. */
+
+static void
+gbf_project_model_row_free (GbfProjectModelRow *row)
+{
+	if (row->file != NULL) g_object_unref (row->file);
+	g_slice_free (GbfProjectModelRow, row);
+}
+
+static void
+gbf_project_model_unlink_row (GHashTable *index, gpointer key, GbfProjectModelRow *row)
+{
+	GQueue *rows;
+
+	rows = (GQueue *)g_hash_table_lookup (index, key);
+	if (rows != NULL)
+	{
+		g_queue_remove (rows, row);
+		if (g_queue_is_empty (rows)) g_hash_table_remove (index, key);
+	}
+}
+
+static void
+gbf_project_model_unindex_row (GbfProjectModel *model, GtkTreeIter *iter)
+{
+	GbfProjectModelRow *row;
+
+	row = (GbfProjectModelRow *)g_hash_table_lookup (model->priv->rows, iter->user_data);
+	if (row == NULL) return;
+
+	/* The data and the node could be already freed, use only the pointers */
+	if (g_hash_table_lookup (model->priv->datas, row->data) == row)
+	{
+		g_hash_table_remove (model->priv->datas, row->data);
+	}
+	if (row->node != NULL) gbf_project_model_unlink_row (model->priv->nodes, row->node, row);
+	if (row->file != NULL) gbf_project_model_unlink_row (model->priv->files, row->file, row);
+	g_hash_table_remove (model->priv->rows, iter->user_data);
+}
+
+static void
+gbf_project_model_index_row (GbfProjectModel *model, GtkTreeIter *iter, GbfTreeData *data)
+{
+	GbfProjectModelRow *row;
+	GQueue *rows;
+
+	row = g_slice_new0 (GbfProjectModelRow);
+	row->iter = *iter;
+	row->data = data;
+	row->node = gbf_tree_data_get_node (data);
+	if (row->node != NULL)
+	{
+		row->file = anjuta_project_node_get_file (row->node);
+		if (row->file != NULL) g_object_ref (row->file);
+	}
+	g_hash_table_insert (model->priv->rows, iter->user_data, row);
+	g_hash_table_insert (model->priv->datas, data, row);
+
+	if (row->node != NULL)
+	{
+		rows = (GQueue *)g_hash_table_lookup (model->priv->nodes, row->node);
+		if (rows == NULL)
+		{
+			rows = g_queue_new ();
+			g_hash_table_insert (model->priv->nodes, row->node, rows);
+		}
+		g_queue_push_tail (rows, row);
+	}
+	if (row->file != NULL)
+	{
+		rows = (GQueue *)g_hash_table_lookup (model->priv->files, row->file);
+		if (rows == NULL)
+		{
+			rows = g_queue_new ();
+			g_hash_table_insert (model->priv->files, g_object_ref (row->file), rows);
+		}
+		g_queue_push_tail (rows, row);
+	}
+}
+
+static void
+gbf_project_model_unindex_tree (GbfProjectModel *model, GtkTreeIter *iter)
+{
+	GtkTreeIter child;
+	gboolean valid;
+
+	for (valid = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), &child, iter); valid; valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &child))
+	{
+		gbf_project_model_unindex_tree (model, &child);
+	}
+	gbf_project_model_unindex_row (model, iter);
+}
+
+/* Remove a row and all its children without freeing their data */
+static gboolean
+gbf_project_model_remove_row (GbfProjectModel *model, GtkTreeIter *iter)
+{
+	gbf_project_model_unindex_tree (model, iter);
+
+	return gtk_tree_store_remove (GTK_TREE_STORE (model), iter);
+}
+
+static void
+on_row_changed (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, gpointer user_data)
+{
+	GbfProjectModel *project_model = GBF_PROJECT_MODEL (model);
+	GbfProjectModelRow *row;
+	GbfTreeData *data;
+
+	gtk_tree_model_get (model, iter,
+			    GBF_PROJECT_MODEL_COLUMN_DATA, &data,
+			    -1);
+
+	row = (GbfProjectModelRow *)g_hash_table_lookup (project_model->priv->rows, iter->user_data);
+	if (row != NULL)
+	{
+		if ((row->data == data) && (row->node == gbf_tree_data_get_node (data))) return;
+		gbf_project_model_unindex_row (project_model, iter);
+	}
+	if (data != NULL) gbf_project_model_index_row (project_model, iter, data);
+}
+
+/* Compare the position of two rows below the same parent, the first one is
+ * the one found by searching the direct children of the parent before
+ * searching recursively in each child. */
+static gint
+gbf_project_model_compare_rows (GbfProjectModel *model, GtkTreeIter *iter_a, GtkTreeIter *iter_b, gint level)
+{
+	GtkTreePath *path_a;
+	GtkTreePath *path_b;
+	gint *indices_a;
+	gint *indices_b;
+	gint depth_a;
+	gint depth_b;
+	gint cmp;
+
+	path_a = gtk_tree_model_get_path (GTK_TREE_MODEL (model), iter_a);
+	path_b = gtk_tree_model_get_path (GTK_TREE_MODEL (model), iter_b);
+	indices_a = gtk_tree_path_get_indices_with_depth (path_a, &depth_a);
+	indices_b = gtk_tree_path_get_indices_with_depth (path_b, &depth_b);
+
+	for (;; level++)
+	{
+		gboolean child_a = depth_a == level + 1;
+		gboolean child_b = depth_b == level + 1;
+
+		if (child_a != child_b)
+		{
+			cmp = child_a ? -1 : 1;
+			break;
+		}
+		else if (child_a || (indices_a[level] != indices_b[level]))
+		{
+			cmp = indices_a[level] - indices_b[level];
+			break;
+		}
+	}
+
+	gtk_tree_path_free (path_a);
+	gtk_tree_path_free (path_b);
+
+	return cmp;
+}
+
+/* Find the first indexed row below parent, having the same file if not NULL */
+static gboolean
+gbf_project_model_find_row (GbfProjectModel *model,
+    GQueue		*rows,
+    GtkTreeIter		*found,
+    GtkTreeIter		*parent,
+    GbfTreeNodeType	type,
+    GFile		*file)
+{
+	GbfProjectModelRow *best = NULL;
+	GList *item;
+	gint level;
+
+	if (rows == NULL) return FALSE;
+
+	level = parent != NULL ? gtk_tree_store_iter_depth (GTK_TREE_STORE (model), parent) + 1 : 0;
+	for (item = g_queue_peek_head_link (rows); item != NULL; item = g_list_next (item))
+	{
+		GbfProjectModelRow *row = (GbfProjectModelRow *)item->data;
+
+		if ((file != NULL) && !gbf_tree_data_equal_file (row->data, type, file)) continue;
+		if ((parent != NULL) && !gtk_tree_store_is_ancestor (GTK_TREE_STORE (model), parent, &row->iter)) continue;
+
+		if ((best == NULL) || (gbf_project_model_compare_rows (model, &row->iter, &best->iter, level) < 0))
+		{
+			best = row;
+		}
+	}
+
+	if (best != NULL) *found = best->iter;
+
+	return best != NULL;
+}
+
 /* Model data functions ------------ */
 
 /* Remove node without checking its shortcuts */
@@ -231,7 +466,7 @@ gbf_project_model_remove_children (GbfProjectModel *model, GtkTreeIter *iter)
 		gtk_tree_model_get (GTK_TREE_MODEL (model), &child,
 		   	 GBF_PROJECT_MODEL_COLUMN_DATA, &data,
 		    	-1);
-		valid = gtk_tree_store_remove (GTK_TREE_STORE (model), &child);
+		valid = gbf_project_model_remove_row (model, &child);
 		if (data != NULL) gbf_tree_data_free (data);
 	}
 
@@ -283,7 +518,7 @@ gbf_project_model_remove_invalid_shortcut (GbfProjectModel *model, GtkTreeIter *
 		if (data->shortcut->type == GBF_TREE_NODE_INVALID)
 		{
 			gbf_project_model_remove_children (model, &child);
-			valid = gtk_tree_store_remove (GTK_TREE_STORE (model), &child);
+			valid = gbf_project_model_remove_row (model, &child);
 			if (data != NULL) gbf_tree_data_free (data);
 		}
 		else
@@ -429,7 +664,7 @@ gbf_project_model_remove (GbfProjectModel *model, GtkTreeIter *iter)
 	}
 
 	/* Free parent node */
-	valid = gtk_tree_store_remove (GTK_TREE_STORE (model), iter);
+	valid = gbf_project_model_remove_row (model, iter);
 	if (data != NULL) gbf_tree_data_free (data);
 
 	return valid;
@@ -645,7 +880,7 @@ gbf_project_model_move_target_shortcut (GbfProjectModel *model,
 	src_path = gtk_tree_model_get_path (GTK_TREE_MODEL (model), iter);
 	if (gtk_tree_path_compare (src_path, before_path) != 0)
 	{
-		gtk_tree_store_remove (GTK_TREE_STORE (model), iter);
+		gbf_project_model_remove_row (model, iter);
 		gtk_tree_store_insert_before (GTK_TREE_STORE (model), iter, NULL, &sibling);
 		gtk_tree_store_set (GTK_TREE_STORE (model), iter,
 				    GBF_PROJECT_MODEL_COLUMN_DATA, shortcut,
@@ -813,8 +1048,16 @@ gbf_project_model_find_tree_data (GbfProjectModel 	*model,
 			          GbfTreeData  		*data)
 {
 	GtkTreeIter tmp_iter;
+	GbfProjectModelRow *row;
 	gboolean retval = FALSE;
 
+	row = (GbfProjectModelRow *)g_hash_table_lookup (model->priv->datas, data);
+	if (row != NULL) {
+		*iter = row->iter;
+		return TRUE;
+	}
+
+	/* Look for an equal data */
 	if (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (model), &tmp_iter)) {
 		if (recursive_find_tree_data (GTK_TREE_MODEL (model), &tmp_iter, data)) {
 			retval = TRUE;
@@ -833,34 +1076,9 @@ gbf_project_model_find_file (GbfProjectModel 	*model,
      GbfTreeNodeType type,
     GFile		*file)
 {
-	GtkTreeIter iter;
-	gboolean valid;
-
-	/* Search for direct children */
-	for (valid = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), &iter, parent); valid == TRUE; valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter))
-	{
-		GbfTreeData *data;
-
-		gtk_tree_model_get (GTK_TREE_MODEL (model), &iter,
-		    GBF_PROJECT_MODEL_COLUMN_DATA, &data, -1);
-
-		if (gbf_tree_data_equal_file (data, type, file))
-		{
-			*found = iter;
-			break;
-		}
-	}
-
-	/* Search for children of children */
-	if (!valid)
-	{
-		for (valid = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), &iter, parent); valid == TRUE; valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter))
-		{
-			if (gbf_project_model_find_file (model, found, &iter, type, file)) break;
-		}
-	}
-
-	return valid;
+	return gbf_project_model_find_row (model,
+	                                   g_hash_table_lookup (model->priv->files, file),
+	                                   found, parent, type, file);
 }
 
 gboolean
@@ -869,34 +1087,9 @@ gbf_project_model_find_node (GbfProjectModel 	*model,
     GtkTreeIter		*parent,
     AnjutaProjectNode	*node)
 {
-	GtkTreeIter iter;
-	gboolean valid;
-
-	/* Search for direct children */
-	for (valid = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), &iter, parent); valid == TRUE; valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter))
-	{
-		GbfTreeData *data;
-
-		gtk_tree_model_get (GTK_TREE_MODEL (model), &iter,
-			GBF_PROJECT_MODEL_COLUMN_DATA, &data, -1);
-
-		if (node == gbf_tree_data_get_node (data))
-		{
-			*found = iter;
-			break;
-		}
-	}
-
-	/* Search for children of children */
-	if (!valid)
-	{
-		for (valid = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), &iter, parent); valid == TRUE; valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter))
-		{
-			if (gbf_project_model_find_node (model, found, &iter, node)) break;
-		}
-	}
-
-	return valid;
+	return gbf_project_model_find_row (model,
+	                                   g_hash_table_lookup (model->priv->nodes, node),
+	                                   found, parent, GBF_TREE_NODE_UNKNOWN, NULL);
 }
 
 /* Can return shortcut node if exist */
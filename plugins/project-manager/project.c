@@ -87,7 +87,10 @@ pm_command_load_complete (AnjutaPmProject *project, AnjutaProjectNode *node, GEr
 		anjuta_project_node_clear_state (node, ANJUTA_PROJECT_LOADING | ANJUTA_PROJECT_INCOMPLETE);
 		anjuta_project_node_foreach (node, G_POST_ORDER, (AnjutaProjectNodeForeachFunc)on_pm_project_load_incomplete, project);
 
-		complete = !project->loaded && (project->incomplete_node == 0);
+		/* The backend can display a cached tree before loading the project,
+		 * it is complete only when the backend has finished too */
+		complete = !project->loaded && (project->incomplete_node == 0) &&
+			ianjuta_project_is_loaded (project->project, NULL);
 		if (complete) project->loaded = TRUE;
 	}
 
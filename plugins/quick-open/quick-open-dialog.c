@@ -24,6 +24,7 @@
 #include <string.h>
 
 #include "quick-open-dialog.h"
+#include "quick-open-index.h"
 
 struct _QuickOpenDialogPrivate
 {
@@ -31,7 +32,7 @@ struct _QuickOpenDialogPrivate
 
     GtkEntry* filter_entry;
     guint filter_changed_timeout;
-    char** filter_strings;
+    char* filter_text;
 
     GtkNotebook* tree_view_notebook;
     GtkTreeView* tree_view;
@@ -40,6 +41,10 @@ struct _QuickOpenDialogPrivate
     GtkTreeModelFilter* filter_model;
     GHashTable* project_files_hash;
 
+    /* Project files are searched in the index, only the best matches are
+     * in the store */
+    QuickOpenIndex* project_index;
+
     GSList* documents;
     GHashTable* document_files_hash;
 };
@@ -48,7 +53,8 @@ enum {
     COLUMN_IS_SEPARATOR = 0,
     COLUMN_TITLE,
     COLUMN_IS_DOCUMENT,
-    COLUMN_OBJECT
+    COLUMN_OBJECT,
+    COLUMN_RANK
 };
 
 enum {
@@ -60,6 +66,9 @@ enum {
 
 #define FILTER_CHANGED_TIMEOUT 150
 
+/* Project files shown for a filter */
+#define PROJECT_RESULTS_MAX 100
+
 
 G_DEFINE_TYPE (QuickOpenDialog, quick_open_dialog, GTK_TYPE_DIALOG);
 
@@ -221,27 +230,14 @@ quick_open_dialog_move_selection(QuickOpenDialog* self, MoveSelection mode, gint
 }
 
 static gboolean
-quick_open_dialog_filter_item(QuickOpenDialog* self, const char* title, GFile* file)
+quick_open_dialog_filter_item(QuickOpenDialog* self, const char* title)
 {
     QuickOpenDialogPrivate* priv = self->priv;
-    char** iter;
-
-    /* Don't show project files that are already shown as an open document. */
-    if (file && g_hash_table_lookup(priv->document_files_hash, file))
-        return FALSE;
 
-    if (!priv->filter_strings)
+    if (!priv->filter_text)
         return TRUE;
 
-    for (iter = priv->filter_strings; *iter; iter++)
-    {
-        const char* filter_string = *iter;
-
-        if (!g_strstr_len(title, -1, filter_string))
-            return FALSE;
-    }
-
-    return TRUE;
+    return quick_open_index_score(priv->filter_text, title) >= 0;
 }
 
 static gboolean
@@ -252,25 +248,69 @@ quick_open_dialog_tree_visible_func(GtkTreeModel *model, GtkTreeIter *iter,
 
     gboolean is_separator, is_document, visible;
     char* title;
-    GFile* file = NULL;
 
     gtk_tree_model_get(model, iter, COLUMN_IS_SEPARATOR, &is_separator,
-        COLUMN_TITLE, &title, COLUMN_IS_DOCUMENT, &is_document, -1);
-    if (is_separator)
-        return TRUE;
+        COLUMN_IS_DOCUMENT, &is_document, -1);
 
-    if (!is_document)
-        gtk_tree_model_get(model, iter, COLUMN_OBJECT, &file, -1);
-
-    visible = quick_open_dialog_filter_item(self, title, file);
+    /* Project files in the store are already filtered. */
+    if (is_separator || !is_document)
+        return TRUE;
 
+    gtk_tree_model_get(model, iter, COLUMN_TITLE, &title, -1);
+    visible = quick_open_dialog_filter_item(self, title);
     g_free(title);
-    if (file)
-        g_object_unref(file);
 
     return visible;
 }
 
+/* Replaces the project files in the store with the best matches of the
+ * filter. */
+static void
+quick_open_dialog_update_project_results(QuickOpenDialog* self)
+{
+    QuickOpenDialogPrivate* priv = self->priv;
+
+    GtkTreeModel* model = GTK_TREE_MODEL(priv->store);
+    GtkTreeIter iter;
+    gboolean res;
+    GPtrArray* results;
+    guint i;
+    gint rank = 0;
+
+    res = gtk_tree_model_get_iter_first(model, &iter);
+    while (res)
+    {
+        gboolean is_separator, is_document;
+
+        gtk_tree_model_get(model, &iter, COLUMN_IS_SEPARATOR, &is_separator,
+            COLUMN_IS_DOCUMENT, &is_document, -1);
+        if (!is_separator && !is_document)
+            res = gtk_list_store_remove(priv->store, &iter);
+        else
+            res = gtk_tree_model_iter_next(model, &iter);
+    }
+
+    /* Get enough results to skip the open documents. */
+    results = quick_open_index_query(priv->project_index,
+        priv->filter_text ? priv->filter_text : "",
+        PROJECT_RESULTS_MAX + g_hash_table_size(priv->document_files_hash));
+
+    for (i = 0; i < results->len && rank < PROJECT_RESULTS_MAX; i++)
+    {
+        QuickOpenIndexItem* item = g_ptr_array_index(results, i);
+
+        /* Don't show project files that are already shown as an open document. */
+        if (g_hash_table_lookup(priv->document_files_hash, item->file))
+            continue;
+
+        gtk_list_store_insert_with_values(priv->store, NULL, -1,
+            COLUMN_TITLE, item->path, COLUMN_OBJECT, item->file,
+            COLUMN_RANK, rank++, -1);
+    }
+
+    g_ptr_array_unref(results);
+}
+
 static gboolean
 quick_open_dialog_row_separator_func(GtkTreeModel* model, GtkTreeIter* iter,
                                      gpointer user_data)
@@ -292,6 +332,7 @@ quick_open_dialog_tree_sort_func(GtkTreeModel* model, GtkTreeIter* a,
     gboolean is_separator;
     gboolean is_document1, is_document2;
     char* title1, *title2;
+    gint rank1, rank2;
     gboolean res;
 
     gtk_tree_model_get(model, a, COLUMN_IS_SEPARATOR, &is_separator, -1);
@@ -324,6 +365,14 @@ quick_open_dialog_tree_sort_func(GtkTreeModel* model, GtkTreeIter* a,
     if (!is_document1 && is_document2)
         return 1;
 
+    /* Project files keep the order of the index. */
+    if (!is_document1)
+    {
+        gtk_tree_model_get(model, a, COLUMN_RANK, &rank1, -1);
+        gtk_tree_model_get(model, b, COLUMN_RANK, &rank2, -1);
+
+        return rank1 - rank2;
+    }
 
     gtk_tree_model_get(model, a, COLUMN_TITLE, &title1, -1);
     gtk_tree_model_get(model, b, COLUMN_TITLE, &title2, -1);
@@ -392,14 +441,15 @@ filter_changed_timeout(gpointer user_data)
 
     filter_text = gtk_entry_get_text(priv->filter_entry);
 
-    g_strfreev(priv->filter_strings);
+    g_free(priv->filter_text);
 
     if (!filter_text || *filter_text == '\0')
-        priv->filter_strings = NULL;
+        priv->filter_text = NULL;
 
     else
-        priv->filter_strings = g_strsplit(filter_text, " ", -1);
+        priv->filter_text = g_strdup(filter_text);
 
+    quick_open_dialog_update_project_results(self);
     gtk_tree_model_filter_refilter(priv->filter_model);
 
     /* Select the first item. */
@@ -448,8 +498,8 @@ quick_open_dialog_get_selected_object(QuickOpenDialog* self)
     return object;
 }
 
-void
-quick_open_dialog_add_project_file(QuickOpenDialog* self, GFile* file)
+static void
+quick_open_dialog_index_project_file(QuickOpenDialog* self, GFile* file)
 {
     QuickOpenDialogPrivate* priv = self->priv;
 
@@ -469,14 +519,20 @@ quick_open_dialog_add_project_file(QuickOpenDialog* self, GFile* file)
     else
         path = g_file_get_path(file);
 
-    gtk_list_store_insert_with_values(priv->store, NULL, -1, COLUMN_TITLE, path,
-        COLUMN_OBJECT, file, -1);
+    quick_open_index_add(priv->project_index, path, file);
 
     g_free(path);
 
     g_hash_table_add(priv->project_files_hash, g_object_ref(file));
 }
 
+void
+quick_open_dialog_add_project_file(QuickOpenDialog* self, GFile* file)
+{
+    quick_open_dialog_index_project_file(self, file);
+    quick_open_dialog_update_project_results(self);
+}
+
 void
 quick_open_dialog_add_project_files(QuickOpenDialog* self, GSList* files)
 {
@@ -489,29 +545,14 @@ quick_open_dialog_add_project_files(QuickOpenDialog* self, GSList* files)
     priv = self->priv;
 
 
-    /* Unset model to keep the tree view from doing unecessary stuff while we
-     * insert the files. */
-    gtk_tree_view_set_model(priv->tree_view, NULL);
-
-    /* Set sort column id to GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID so that
-     * every insert doesn't trigger a resort. It is faster to sort the model once
-     * when all files are inserted. */
-    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(priv->store),
-        GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, GTK_SORT_ASCENDING);
-
-    /* Add the files. */
+    /* Add the files to the index, only the best matches go in the store. */
     for (l = files; l; l = l->next)
     {
         GFile* file = l->data;
-        quick_open_dialog_add_project_file(self, file);
+        quick_open_dialog_index_project_file(self, file);
     }
 
-    /* Now we sort the model. */
-    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(priv->store),
-        GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID, GTK_SORT_ASCENDING);
-
-    /* Set the model again. */
-    gtk_tree_view_set_model (priv->tree_view, GTK_TREE_MODEL(priv->filter_model));
+    quick_open_dialog_update_project_results(self);
 
     /* Select the first item. */
     quick_open_dialog_move_selection(self, MOVE_SELECTION_FIRST, 0);
@@ -527,6 +568,7 @@ quick_open_dialog_clear_project_files(QuickOpenDialog* self)
     GSList* documents;
 
     gtk_list_store_clear(priv->store);
+    quick_open_index_clear(priv->project_index);
     g_hash_table_remove_all(priv->project_files_hash);
     g_hash_table_remove_all(priv->document_files_hash);
 
@@ -833,6 +875,7 @@ quick_open_dialog_init (QuickOpenDialog* self)
 
     priv->project_files_hash = g_hash_table_new_full(g_file_hash, (GEqualFunc)g_file_equal,
         g_object_unref, NULL);
+    priv->project_index = quick_open_index_new();
     priv->document_files_hash = g_hash_table_new_full(g_file_hash, (GEqualFunc)g_file_equal,
         g_object_unref, NULL);
 
@@ -855,6 +898,8 @@ quick_open_dialog_finalize (GObject* object)
 
     g_hash_table_unref(priv->project_files_hash);
     g_hash_table_unref(priv->document_files_hash);
+    quick_open_index_free(priv->project_index);
+    g_free(priv->filter_text);
 
     for (l = priv->documents; l; l = l->next)
     {
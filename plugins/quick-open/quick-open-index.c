@@ -0,0 +1,455 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * quick-open-index.c
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <string.h>
+
+#include "quick-open-index.h"
+
+/*
+ * Each word of a query has to match a path as a subsequence. Matches at the
+ * start of a path segment or of a word inside it, consecutive matches and
+ * matches inside the file name score higher, gaps between the matched
+ * characters lower the score. Queries without upper case letters are case
+ * insensitive.
+ */
+
+#define SCORE_MATCH         16
+#define SCORE_CONSECUTIVE   16
+#define SCORE_BOUNDARY      24
+#define SCORE_BASENAME      32
+#define GAP_PENALTY_MAX     16
+
+/* Longer paths lose one point every LENGTH_PENALTY bytes */
+#define LENGTH_PENALTY      8
+
+#define NO_MATCH            G_MININT
+
+typedef struct
+{
+    QuickOpenIndexItem item;
+    guint basename;             /* offset of the last path segment */
+    guint length;
+} IndexItem;
+
+struct _QuickOpenIndex
+{
+    GPtrArray* items;
+
+    /* Last query with the indexes of all the items matching it. A query
+     * extending it only matches some of them. */
+    char* last_query;
+    GArray* last_matches;
+};
+
+typedef struct
+{
+    GPtrArray* words;
+    gboolean fold;
+} Query;
+
+typedef struct
+{
+    gint score;
+    guint index;
+} Result;
+
+#define INDEX_ITEM(index, i) ((IndexItem*) g_ptr_array_index ((index)->items, (i)))
+
+static void
+index_item_free (IndexItem* item)
+{
+    g_free (item->item.path);
+    g_object_unref (item->item.file);
+    g_slice_free (IndexItem, item);
+}
+
+static void
+query_init (Query* query, const char* text)
+{
+    char** words;
+    char** word;
+    const char* c;
+
+    query->words = g_ptr_array_new_with_free_func (g_free);
+    query->fold = TRUE;
+
+    for (c = text; *c; c++)
+    {
+        if (g_ascii_isupper (*c))
+        {
+            query->fold = FALSE;
+            break;
+        }
+    }
+
+    words = g_strsplit (text, " ", -1);
+    for (word = words; *word; word++)
+    {
+        if (**word == '\0')
+            g_free (*word);
+        else
+            g_ptr_array_add (query->words, *word);
+    }
+    g_free (words);
+}
+
+static void
+query_clear (Query* query)
+{
+    g_ptr_array_unref (query->words);
+}
+
+static gboolean
+is_boundary (const char* text, guint pos)
+{
+    char prev;
+
+    if (pos == 0)
+        return TRUE;
+
+    prev = text[pos - 1];
+    if (prev == '/' || prev == '_' || prev == '-' || prev == '.' || prev == ' ')
+        return TRUE;
+
+    return g_ascii_islower (prev) && g_ascii_isupper (text[pos]);
+}
+
+static inline char
+fold_char (char c, gboolean fold)
+{
+    return fold ? g_ascii_tolower (c) : c;
+}
+
+/* Scores the leftmost subsequence of the text matching the word */
+static gint
+score_subsequence (const char* text, guint length, const char* word,
+                   gboolean fold)
+{
+    gint score = 0;
+    gint prev = -1;
+    guint pos = 0;
+    const char* w;
+
+    for (w = word; *w; w++)
+    {
+        guint p = pos;
+
+        while (p < length && fold_char (text[p], fold) != *w)
+            p++;
+        if (p == length)
+            return NO_MATCH;
+
+        score += SCORE_MATCH;
+        if (prev >= 0 && p == (guint) prev + 1)
+            score += SCORE_CONSECUTIVE;
+        else
+        {
+            if (is_boundary (text, p))
+                score += SCORE_BOUNDARY;
+            if (prev >= 0)
+                score -= MIN (p - pos, GAP_PENALTY_MAX);
+        }
+
+        prev = p;
+        pos = p + 1;
+    }
+
+    return score;
+}
+
+/* Scores the best occurrence of the word as a substring of the text, the
+ * leftmost subsequence misses it when its first characters appear before */
+static gint
+score_substring (const char* text, guint length, const char* word,
+                 guint word_length, gboolean fold)
+{
+    gint score = NO_MATCH;
+    guint p;
+
+    for (p = 0; p + word_length <= length; p++)
+    {
+        guint i;
+
+        for (i = 0; i < word_length; i++)
+        {
+            if (fold_char (text[p + i], fold) != word[i])
+                break;
+        }
+        if (i < word_length)
+            continue;
+
+        score = word_length * SCORE_MATCH + (word_length - 1) * SCORE_CONSECUTIVE;
+        if (is_boundary (text, p))
+            return score + SCORE_BOUNDARY;
+    }
+
+    return score;
+}
+
+static gint
+score_text (const char* text, guint length, const char* word, gboolean fold)
+{
+    gint score;
+    gint substring;
+
+    score = score_subsequence (text, length, word, fold);
+    if (score == NO_MATCH)
+        return NO_MATCH;
+
+    substring = score_substring (text, length, word, strlen (word), fold);
+
+    return MAX (score, substring);
+}
+
+static gint
+score_path (const char* path, guint length, guint basename, const Query* query)
+{
+    gint score = 0;
+    guint i;
+
+    if (query->words->len == 0)
+        return 0;
+
+    for (i = 0; i < query->words->len; i++)
+    {
+        const char* word = g_ptr_array_index (query->words, i);
+        gint word_score;
+
+        word_score = score_text (path + basename, length - basename, word,
+                                 query->fold);
+        if (word_score != NO_MATCH)
+            word_score += SCORE_BASENAME;
+        else
+            word_score = score_text (path, length, word, query->fold);
+
+        if (word_score == NO_MATCH)
+            return NO_MATCH;
+        score += word_score;
+    }
+
+    return score - length / LENGTH_PENALTY;
+}
+
+/* Whether a ranks after b, equal scores are in path order */
+static gboolean
+result_worse (QuickOpenIndex* index, const Result* a, const Result* b)
+{
+    if (a->score != b->score)
+        return a->score < b->score;
+
+    return strcmp (INDEX_ITEM (index, a->index)->item.path,
+                   INDEX_ITEM (index, b->index)->item.path) > 0;
+}
+
+static gint
+result_compare (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    QuickOpenIndex* index = user_data;
+
+    if (result_worse (index, a, b))
+        return 1;
+    if (result_worse (index, b, a))
+        return -1;
+
+    return 0;
+}
+
+/* Keeps the best max results in a heap whose root is the worst of them */
+static void
+heap_push (QuickOpenIndex* index, GArray* heap, guint max, Result* result)
+{
+    Result* nodes;
+    guint i;
+
+    if (heap->len < max)
+    {
+        g_array_append_val (heap, *result);
+        nodes = (Result*) heap->data;
+
+        for (i = heap->len - 1; i > 0; i = (i - 1) / 2)
+        {
+            Result tmp;
+            guint parent = (i - 1) / 2;
+
+            if (!result_worse (index, &nodes[i], &nodes[parent]))
+                break;
+            tmp = nodes[i];
+            nodes[i] = nodes[parent];
+            nodes[parent] = tmp;
+        }
+        return;
+    }
+
+    nodes = (Result*) heap->data;
+    if (max == 0 || !result_worse (index, &nodes[0], result))
+        return;
+
+    nodes[0] = *result;
+    for (i = 0;;)
+    {
+        Result tmp;
+        guint worst = i;
+        guint child = 2 * i + 1;
+
+        if (child < heap->len && result_worse (index, &nodes[child], &nodes[worst]))
+            worst = child;
+        child++;
+        if (child < heap->len && result_worse (index, &nodes[child], &nodes[worst]))
+            worst = child;
+        if (worst == i)
+            break;
+
+        tmp = nodes[i];
+        nodes[i] = nodes[worst];
+        nodes[worst] = tmp;
+        i = worst;
+    }
+}
+
+static void
+quick_open_index_forget_query (QuickOpenIndex* index)
+{
+    g_free (index->last_query);
+    index->last_query = NULL;
+    g_array_set_size (index->last_matches, 0);
+}
+
+QuickOpenIndex*
+quick_open_index_new (void)
+{
+    QuickOpenIndex* index = g_slice_new0 (QuickOpenIndex);
+
+    index->items = g_ptr_array_new_with_free_func ((GDestroyNotify) index_item_free);
+    index->last_matches = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    return index;
+}
+
+void
+quick_open_index_free (QuickOpenIndex* index)
+{
+    g_ptr_array_unref (index->items);
+    g_array_unref (index->last_matches);
+    g_free (index->last_query);
+    g_slice_free (QuickOpenIndex, index);
+}
+
+void
+quick_open_index_clear (QuickOpenIndex* index)
+{
+    quick_open_index_forget_query (index);
+    g_ptr_array_set_size (index->items, 0);
+}
+
+void
+quick_open_index_add (QuickOpenIndex* index, const char* path, GFile* file)
+{
+    IndexItem* item = g_slice_new (IndexItem);
+    const char* basename = strrchr (path, '/');
+
+    item->item.path = g_strdup (path);
+    item->item.file = g_object_ref (file);
+    item->length = strlen (path);
+    item->basename = basename ? basename + 1 - path : 0;
+
+    g_ptr_array_add (index->items, item);
+
+    quick_open_index_forget_query (index);
+}
+
+/*
+ * Returns the max_results items matching the query best, best first. The
+ * items are owned by the index and valid until it changes.
+ */
+GPtrArray*
+quick_open_index_query (QuickOpenIndex* index, const char* query,
+                        guint max_results)
+{
+    Query parsed;
+    GArray* matches;
+    GArray* heap;
+    GPtrArray* results;
+    gboolean narrow;
+    guint n_candidates;
+    guint i;
+
+    g_return_val_if_fail (query != NULL, NULL);
+
+    query_init (&parsed, query);
+
+    narrow = index->last_query && g_str_has_prefix (query, index->last_query);
+    n_candidates = narrow ? index->last_matches->len : index->items->len;
+
+    matches = g_array_sized_new (FALSE, FALSE, sizeof (guint), n_candidates);
+    heap = g_array_sized_new (FALSE, FALSE, sizeof (Result), max_results);
+
+    for (i = 0; i < n_candidates; i++)
+    {
+        IndexItem* item;
+        Result result;
+
+        result.index = narrow ? g_array_index (index->last_matches, guint, i) : i;
+        item = INDEX_ITEM (index, result.index);
+
+        result.score = score_path (item->item.path, item->length,
+                                   item->basename, &parsed);
+        if (result.score == NO_MATCH)
+            continue;
+
+        g_array_append_val (matches, result.index);
+        heap_push (index, heap, max_results, &result);
+    }
+
+    g_free (index->last_query);
+    index->last_query = g_strdup (query);
+    g_array_unref (index->last_matches);
+    index->last_matches = matches;
+
+    g_array_sort_with_data (heap, result_compare, index);
+    results = g_ptr_array_sized_new (heap->len);
+    for (i = 0; i < heap->len; i++)
+    {
+        Result* result = &g_array_index (heap, Result, i);
+        g_ptr_array_add (results, &INDEX_ITEM (index, result->index)->item);
+    }
+
+    g_array_unref (heap);
+    query_clear (&parsed);
+
+    return results;
+}
+
+/*
+ * Returns the score of a path for a query using the same rules as the index,
+ * or -1 if the path doesn't match.
+ */
+gint
+quick_open_index_score (const char* query, const char* path)
+{
+    Query parsed;
+    const char* basename = strrchr (path, '/');
+    gint score;
+
+    query_init (&parsed, query);
+    score = score_path (path, strlen (path), basename ? basename + 1 - path : 0,
+                        &parsed);
+    query_clear (&parsed);
+
+    return score == NO_MATCH ? -1 : MAX (score, 0);
+}
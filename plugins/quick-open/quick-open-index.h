@@ -0,0 +1,55 @@
+/* -*- Mode: C; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * quick-open-index.h
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _QUICK_OPEN_INDEX_H_
+#define _QUICK_OPEN_INDEX_H_
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _QuickOpenIndex QuickOpenIndex;
+typedef struct _QuickOpenIndexItem QuickOpenIndexItem;
+
+struct _QuickOpenIndexItem
+{
+    char* path;
+    GFile* file;
+};
+
+QuickOpenIndex* quick_open_index_new   (void);
+
+void            quick_open_index_free  (QuickOpenIndex* index);
+
+void            quick_open_index_clear (QuickOpenIndex* index);
+
+void            quick_open_index_add   (QuickOpenIndex* index,
+                                        const char* path,
+                                        GFile* file);
+
+GPtrArray*      quick_open_index_query (QuickOpenIndex* index,
+                                        const char* query,
+                                        guint max_results);
+
+gint            quick_open_index_score (const char* query,
+                                        const char* path);
+
+G_END_DECLS
+
+#endif /* _QUICK_OPEN_INDEX_H_ */
@@ -23,7 +23,8 @@
 #include <libanjuta/anjuta-convert.h>
 #include <libanjuta/anjuta-encodings.h>
 
-#define READ_SIZE 4096
+#define READ_SIZE 65536	/* First read, doubled at each read */
+#define READ_SIZE_MAX (4 * 1024 * 1024)
 #define RATE_LIMIT 5000 /* Use a big rate limit to avoid duplicates */
 
 enum
@@ -42,7 +43,7 @@ static guint io_signals[LAST_SIGNAL] = { 0 };
 
 #define IO_ERROR_QUARK g_quark_from_string ("SourceviewIO-Error")
 
-#define IO_PRIORITY G_PRIORITY_DEFAULT
+#define INSERT_PRIORITY G_PRIORITY_DEFAULT_IDLE
 
 G_DEFINE_TYPE (SourceviewIO, sourceview_io, G_TYPE_OBJECT);
 
@@ -51,12 +52,10 @@ sourceview_io_init (SourceviewIO *object)
 {
 	object->file = NULL;
 	object->filename = NULL;
-	object->read_buffer = NULL;
 	object->write_buffer = NULL;
 	object->cancel = g_cancellable_new();
 	object->monitor = NULL;
 	object->last_encoding = NULL;
-	object->bytes_read = 0;
 }
 
 static void
@@ -67,7 +66,6 @@ sourceview_io_finalize (GObject *object)
 		g_object_unref (sio->file);
 	g_free (sio->etag);
 	g_free(sio->filename);
-	g_free(sio->read_buffer);
 	g_free(sio->write_buffer);
 	g_object_unref (sio->cancel);
 	if (sio->monitor)
@@ -343,15 +341,54 @@ sourceview_io_save_as (SourceviewIO* sio, GFile* file)
 	g_object_ref (sio);
 }
 
-static void insert_text_in_document(SourceviewIO* sio, const gchar* text, gsize len)
+typedef enum
+{
+	READ_TEXT,		/* Text to append to the document */
+	READ_RESTART,	/* The file is not UTF-8, remove the text appended */
+	READ_FINISHED,
+	READ_FAILED
+} SourceviewIOReadStep;
+
+/* Sent from the read thread to the main loop */
+typedef struct
+{
+	SourceviewIO* sio;
+	SourceviewIOReadStep step;
+	gchar* text;
+	gsize len;
+	gchar* etag;
+	const AnjutaEncoding* encoding;
+	GError* error;
+} SourceviewIOChunk;
+
+typedef struct
+{
+	SourceviewIO* sio;
+	GFile* file;
+	GCancellable* cancel;
+	const AnjutaEncoding* fallback_encoding;
+} SourceviewIORead;
+
+static void
+append_text_in_document (SourceviewIO* sio, const gchar* text, gsize len)
 {
 	GtkSourceBuffer* document = GTK_SOURCE_BUFFER (sio->sv->priv->document);
-	gtk_source_buffer_begin_not_undoable_action (GTK_SOURCE_BUFFER (sio->sv->priv->document));
+	GtkTextIter iter;
+	gboolean first;
+
+	gtk_source_buffer_begin_not_undoable_action (document);
+
+	/* Append text in the buffer */
+	first = gtk_text_buffer_get_char_count (GTK_TEXT_BUFFER (document)) == 0;
+	gtk_text_buffer_get_end_iter (GTK_TEXT_BUFFER (document), &iter);
+	gtk_text_buffer_insert (GTK_TEXT_BUFFER (document), &iter, text, len);
 
-	/* Insert text in the buffer */
-	gtk_text_buffer_set_text (GTK_TEXT_BUFFER (document),
-							  text,
-							  len);
+	/* Keep the cursor at the beginning while the rest is loaded */
+	if (first)
+	{
+		gtk_text_buffer_get_start_iter (GTK_TEXT_BUFFER (document), &iter);
+		gtk_text_buffer_place_cursor (GTK_TEXT_BUFFER (document), &iter);
+	}
 
 	gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (document),
 				      FALSE);
@@ -360,120 +397,236 @@ static void insert_text_in_document(SourceviewIO* sio, const gchar* text, gsize
 }
 
 static gboolean
-append_buffer (SourceviewIO* sio, gsize size)
+on_read_chunk (gpointer data)
 {
-	/* Text is utf-8 - good */
-	if (g_utf8_validate (sio->read_buffer, size, NULL))
+	SourceviewIOChunk* chunk = data;
+	SourceviewIO* sio = chunk->sio;
+	GtkSourceBuffer* document = GTK_SOURCE_BUFFER (sio->sv->priv->document);
+
+	switch (chunk->step)
 	{
-		insert_text_in_document (sio, sio->read_buffer, size);
+		case READ_TEXT:
+			if (!g_cancellable_is_cancelled (sio->cancel))
+				append_text_in_document (sio, chunk->text, chunk->len);
+			break;
+		case READ_RESTART:
+			gtk_source_buffer_begin_not_undoable_action (document);
+			gtk_text_buffer_set_text (GTK_TEXT_BUFFER (document), "", 0);
+			gtk_source_buffer_end_not_undoable_action (document);
+			break;
+		case READ_FINISHED:
+			g_free (sio->etag);
+			sio->etag = chunk->etag;
+			chunk->etag = NULL;
+			sio->last_encoding = chunk->encoding;
+
+			gtk_text_buffer_set_modified (GTK_TEXT_BUFFER (document), FALSE);
+			g_signal_emit_by_name (sio, "open-finished");
+			setup_monitor (sio);
+			break;
+		case READ_FAILED:
+			g_signal_emit_by_name (sio, "open-failed", chunk->error);
+			break;
 	}
-	else
-	{
-		/* Text is not utf-8 */
-		GError *conv_error = NULL;
-		gchar *converted_text = NULL;
-		gsize new_len = size;
-		const AnjutaEncoding* enc = NULL;
-
-		converted_text = anjuta_convert_to_utf8 (sio->read_buffer,
-												 size,
-												 &enc,
-												 &new_len,
-												 &conv_error);
-		if  (converted_text == NULL)
-		{
-			/* Last chance, let's try 8859-15 */
-			enc = anjuta_encoding_get_from_charset( "ISO-8859-15");
-			conv_error = NULL;
-			converted_text = anjuta_convert_to_utf8 (sio->read_buffer,
-													 size,
-													 &enc,
-													 &new_len,
-													 &conv_error);
-		}
-		if (converted_text == NULL)
-		{
-			g_return_val_if_fail (conv_error != NULL, FALSE);
 
-			g_signal_emit_by_name (sio, "open-failed", conv_error);
-			g_error_free (conv_error);
-			g_cancellable_cancel (sio->cancel);
-			return FALSE;
-		}
-		sio->last_encoding = enc;
-		insert_text_in_document (sio, converted_text, new_len);
-		g_free (converted_text);
+	g_free (chunk->text);
+	g_free (chunk->etag);
+	if (chunk->error)
+		g_error_free (chunk->error);
+	g_object_unref (chunk->sio);
+	g_slice_free (SourceviewIOChunk, chunk);
+
+	return FALSE;
+}
+
+/* Called in the read thread, the chunks are handled in order by the main loop
+ * below the redraw priority so the document is displayed while loading */
+static SourceviewIOChunk*
+post_chunk (SourceviewIORead* read, SourceviewIOReadStep step,
+            const gchar* text, gsize len)
+{
+	SourceviewIOChunk* chunk = g_slice_new0 (SourceviewIOChunk);
+
+	chunk->sio = g_object_ref (read->sio);
+	chunk->step = step;
+	if (text != NULL)
+	{
+		chunk->text = g_memdup (text, len);
+		chunk->len = len;
 	}
-	return TRUE;
+	g_idle_add_full (INSERT_PRIORITY, on_read_chunk, chunk, NULL);
+
+	return chunk;
 }
 
+/* Send converted text by pieces, cut between two characters */
 static void
-on_read_finished (GObject* input, GAsyncResult* result, gpointer data)
+post_converted_text (SourceviewIORead* read, const gchar* text, gsize len)
 {
-	SourceviewIO* sio = SOURCEVIEW_IO(data);
-	GInputStream* input_stream = G_INPUT_STREAM(input);
-	gsize current_bytes = 0;
-	GError* err = NULL;
+	gsize pos = 0;
 
-	if (!g_cancellable_set_error_if_cancelled (sio->cancel, &err))
-		current_bytes = g_input_stream_read_finish (input_stream, result, &err);
-	if (err)
+	while (pos < len)
 	{
-		g_signal_emit_by_name (sio, "open-failed", err);
-		g_error_free (err);
+		gsize end = MIN (pos + READ_SIZE_MAX, len);
+
+		while (end < len && end > pos + 1 && (text[end] & 0xC0) == 0x80)
+			end--;
+		post_chunk (read, READ_TEXT, text + pos, end - pos);
+		pos = end;
 	}
-	else
+}
+
+static gchar*
+convert_buffer (SourceviewIORead* read, const gchar* buffer, gsize len,
+                const AnjutaEncoding** enc, gsize* new_len, GError** err)
+{
+	gchar* converted_text;
+
+	converted_text = anjuta_convert_to_utf8 (buffer, len, enc, new_len, NULL);
+	if  (converted_text == NULL)
 	{
-		sio->bytes_read += current_bytes;
-		if (current_bytes != 0)
+		/* Last chance, let's try 8859-15 */
+		*enc = read->fallback_encoding;
+		converted_text = anjuta_convert_to_utf8 (buffer, len, enc, new_len, err);
+	}
+
+	return converted_text;
+}
+
+static gpointer
+read_thread (gpointer data)
+{
+	SourceviewIORead* read = data;
+	GFileInputStream* input_stream;
+	GFileInfo* info;
+	GError* err = NULL;
+	gchar* buffer = NULL;
+	gsize size = READ_SIZE;
+	gsize len = 0;
+	gsize valid = 0;
+	gsize read_size = READ_SIZE;
+	gboolean utf8 = TRUE;
+	gchar* etag = NULL;
+	const AnjutaEncoding* enc = NULL;
+	SourceviewIOChunk* chunk;
+
+	input_stream = g_file_read (read->file, read->cancel, &err);
+	if (input_stream != NULL)
+	{
+		/* Size the buffer for the whole file up front */
+		info = g_file_input_stream_query_info (input_stream,
+		                                       G_FILE_ATTRIBUTE_STANDARD_SIZE,
+		                                       read->cancel, NULL);
+		if (info != NULL)
 		{
-			sio->read_buffer = g_realloc (sio->read_buffer, sio->bytes_read + READ_SIZE);
-			g_input_stream_read_async (G_INPUT_STREAM (input_stream),
-									   sio->read_buffer + sio->bytes_read,
-									   READ_SIZE,
-									   IO_PRIORITY,
-									   sio->cancel,
-									   on_read_finished,
-									   sio);
-			return;
+			if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_SIZE))
+				size = g_file_info_get_size (info) + 1;
+			g_object_unref (info);
 		}
-		else
+		buffer = g_malloc (size);
+
+		while (TRUE)
 		{
-			GFileInfo* info;
+			gssize n;
 
-			info = g_file_input_stream_query_info (G_FILE_INPUT_STREAM (input_stream),
-			                                       G_FILE_ATTRIBUTE_ETAG_VALUE,
-			                                       NULL, &err);
-			if (!info)
+			/* The file can be longer than expected */
+			if (len == size)
+			{
+				size *= 2;
+				buffer = g_realloc (buffer, size);
+			}
+
+			n = g_input_stream_read (G_INPUT_STREAM (input_stream),
+			                         buffer + len,
+			                         MIN (read_size, size - len),
+			                         read->cancel,
+			                         &err);
+			if (n <= 0)
+				break;
+			len += n;
+			if (read_size < READ_SIZE_MAX)
+				read_size *= 2;
+
+			/* Send the valid UTF-8 text read so far, a character can be
+			 * cut at the end */
+			if (utf8)
 			{
-				g_signal_emit_by_name (sio, "open-failed", err);
-				g_error_free (err);
+				const gchar* end;
+
+				if (!g_utf8_validate (buffer + valid, len - valid, &end) &&
+				    buffer + len - end >= 4)
+				{
+					utf8 = FALSE;
+				}
+				else if (end > buffer + valid)
+				{
+					post_chunk (read, READ_TEXT, buffer + valid,
+					            end - buffer - valid);
+					valid = end - buffer;
+				}
 			}
-			else
+		}
+		if (valid < len)
+			utf8 = FALSE;
+
+		if (err == NULL)
+		{
+			info = g_file_input_stream_query_info (input_stream,
+			                                       G_FILE_ATTRIBUTE_ETAG_VALUE,
+			                                       NULL, &err);
+			if (info != NULL)
 			{
-				g_free (sio->etag);
-				sio->etag = g_strdup (g_file_info_get_etag (info));
+				etag = g_strdup (g_file_info_get_etag (info));
 				g_object_unref (info);
+			}
+		}
+
+		/* Text is not utf-8, convert it all and send it again */
+		if (err == NULL && !utf8)
+		{
+			gchar* converted_text;
+			gsize new_len = len;
 
-				if (append_buffer (sio, sio->bytes_read))
-					g_signal_emit_by_name (sio, "open-finished");
-				setup_monitor (sio);
+			converted_text = convert_buffer (read, buffer, len, &enc, &new_len,
+			                                 &err);
+			if (converted_text != NULL)
+			{
+				if (valid > 0)
+					post_chunk (read, READ_RESTART, NULL, 0);
+				post_converted_text (read, converted_text, new_len);
+				g_free (converted_text);
 			}
 		}
+
+		g_free (buffer);
+		g_object_unref (input_stream);
 	}
 
-	g_object_unref (input_stream);
-	g_free (sio->read_buffer);
-	sio->read_buffer = NULL;
-	sio->bytes_read = 0;
-	g_object_unref (sio);
+	if (err != NULL)
+	{
+		chunk = post_chunk (read, READ_FAILED, NULL, 0);
+		chunk->error = err;
+		g_free (etag);
+	}
+	else
+	{
+		chunk = post_chunk (read, READ_FINISHED, NULL, 0);
+		chunk->etag = etag;
+		chunk->encoding = enc;
+	}
+
+	g_object_unref (read->sio);
+	g_object_unref (read->file);
+	g_object_unref (read->cancel);
+	g_slice_free (SourceviewIORead, read);
+
+	return NULL;
 }
 
 void
 sourceview_io_open (SourceviewIO* sio, GFile* file)
 {
-	GFileInputStream* input_stream;
-	GError* err = NULL;
+	SourceviewIORead* read;
 
 	g_return_if_fail (file != NULL);
 
@@ -485,21 +638,13 @@ sourceview_io_open (SourceviewIO* sio, GFile* file)
 		set_display_name(sio);
 	}
 
-	input_stream = g_file_read (file, NULL, &err);
-	if (!input_stream)
-	{
-		g_signal_emit_by_name (sio, "open-failed", err);
-		g_error_free (err);
-		return;
-	}
-	sio->read_buffer = g_realloc (sio->read_buffer, READ_SIZE);
-	g_input_stream_read_async (G_INPUT_STREAM (input_stream),
-							   sio->read_buffer,
-							   READ_SIZE,
-							   IO_PRIORITY,
-							   sio->cancel,
-							   on_read_finished,
-							   g_object_ref (sio));
+	/* The file is read, validated and converted in a thread */
+	read = g_slice_new0 (SourceviewIORead);
+	read->sio = g_object_ref (sio);
+	read->file = g_object_ref (file);
+	read->cancel = g_object_ref (sio->cancel);
+	read->fallback_encoding = anjuta_encoding_get_from_charset ("ISO-8859-15");
+	g_thread_unref (g_thread_new ("sourceview-io", read_thread, read));
 }
 
 GFile*
@@ -59,10 +59,8 @@ struct _SourceviewIO
 	gchar* filename;
 	Sourceview* sv;
 	gchar* write_buffer;
-	gchar* read_buffer;
 	GCancellable* cancel;
 	GFileMonitor* monitor;
-	gssize bytes_read;
 
 	const AnjutaEncoding* last_encoding;
 };
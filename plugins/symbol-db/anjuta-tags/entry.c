@@ -47,6 +47,7 @@
 #include "routines.h"
 #include "sort.h"
 #include "strlist.h"
+#include "tag-stream.h"
 
 /*
 *   MACROS
@@ -459,7 +460,7 @@ static void sortTagFile (void)
 {
 	if (TagFile.numTags.added > 0L)
 	{
-		if (Option.sorted != SO_UNSORTED)
+		if (Option.sorted != SO_UNSORTED  &&  ! Option.binary)
 		{
 			verbose ("sorting tag file\n");
 #ifdef EXTERNAL_SORT
@@ -793,6 +794,211 @@ static int writeLineNumberEntry (const tagEntryInfo *const tag)
 	return fprintf (TagFile.fp, "%lu", tag->lineNumber);
 }
 
+/*  Binary tag stream, see tag-stream.h
+ */
+static int streamCode (const char *const *table, const char *const name)
+{
+	int i;
+
+	if (name == NULL)
+		return TAG_STREAM_CODE_NONE;
+	for (i = 1  ;  table [i] != NULL  ;  ++i)
+		if (strcmp (table [i], name) == 0)
+			return i;
+	return TAG_STREAM_CODE_OTHER;
+}
+
+/*  A record is made of binary data and nul terminated strings, it is built
+ *  in a plain byte buffer: a vString can't hold nul characters.
+ */
+typedef struct sStreamRecord {
+	unsigned char *buffer;
+	size_t length;
+	size_t size;
+} streamRecord;
+
+static void streamPutBytes (streamRecord *const record, const void *const data,
+		const size_t length)
+{
+	if (record->length + length > record->size)
+	{
+		while (record->length + length > record->size)
+			record->size *= 2;
+		record->buffer = xRealloc (record->buffer, record->size, unsigned char);
+	}
+	memcpy (record->buffer + record->length, data, length);
+	record->length += length;
+}
+
+static void streamPutByte (streamRecord *const record, const unsigned char c)
+{
+	streamPutBytes (record, &c, 1);
+}
+
+/*  Strings are written with their terminator
+ */
+static void streamPutString (streamRecord *const record, const char *const s)
+{
+	streamPutBytes (record, s, strlen (s) + 1);
+}
+
+static void streamPutField (streamRecord *const record, int *const count,
+		const char *const key, const char *const value)
+{
+	if (*count < TAG_STREAM_MAX_FIELDS)
+	{
+		streamPutString (record, key);
+		streamPutString (record, value);
+		++*count;
+	}
+}
+
+/*  Same pattern than writePatternEntry ()
+ */
+static void streamPutPattern (streamRecord *const record, const tagEntryInfo *const tag)
+{
+	static vString *pattern = NULL;
+	char *const line = readSourceLine (TagFile.vLine, tag->filePosition, NULL);
+	const int searchChar = Option.backward ? '?' : '/';
+	boolean newlineTerminated;
+	const char *p;
+
+	if (pattern == NULL)
+		pattern = vStringNew ();
+	vStringClear (pattern);
+
+	if (tag->truncateLine)
+		truncateTagLine (line, tag->name, FALSE);
+	newlineTerminated = (boolean) (line [strlen (line) - 1] == '\n');
+
+	vStringPut (pattern, searchChar);
+	vStringPut (pattern, '^');
+	for (p = line  ;  *p != '\0'  &&  *p != CRETURN  &&  *p != NEWLINE  ;  ++p)
+	{
+		const int next = *(p + 1);
+
+		if (*p == BACKSLASH  ||  *p == searchChar  ||
+			(*p == '$'  &&  (next == NEWLINE  ||  next == CRETURN)))
+			vStringPut (pattern, BACKSLASH);
+		vStringPut (pattern, *p);
+	}
+	if (newlineTerminated)
+		vStringPut (pattern, '$');
+	vStringPut (pattern, searchChar);
+	streamPutString (record, vStringValue (pattern));
+}
+
+static int writeBinaryEntry (const tagEntryInfo *const tag)
+{
+	static streamRecord record = { NULL, 0, 0 };
+	const unsigned int zero = 0;
+	const unsigned int lineNumber = (unsigned int) tag->lineNumber;
+	unsigned int length;
+	unsigned char header [5];
+	char kind [2];
+	const char *kindName = tag->kindName;
+	size_t countOffset;
+	int count = 0;
+
+	if (record.buffer == NULL)
+	{
+		record.size = 256;
+		record.buffer = xMalloc (record.size, unsigned char);
+	}
+	record.length = 0;
+
+	kind [0] = tag->kind;
+	kind [1] = '\0';
+	if (kindName == NULL  &&  tag->kind != '\0')
+		kindName = kind;
+
+	header [0] = streamCode (TagStreamKinds, kindName);
+	header [1] = Option.extensionFields.access ?
+			streamCode (TagStreamAccesses, tag->extensionFields.access) :
+			TAG_STREAM_CODE_NONE;
+	header [2] = Option.extensionFields.implementation ?
+			streamCode (TagStreamImplementations,
+					tag->extensionFields.implementation) :
+			TAG_STREAM_CODE_NONE;
+	header [3] = (Option.extensionFields.fileScope  &&  tag->isFileScope) ?
+			TAG_STREAM_FILE_SCOPE : 0;
+	header [4] = 0;   /* number of fields, set below */
+
+	/*  The length is set at the end */
+	streamPutBytes (&record, &zero, TAG_STREAM_LENGTH_SIZE);
+	streamPutByte (&record, TAG_STREAM_TAG);
+	streamPutBytes (&record, &lineNumber, 4);
+	streamPutBytes (&record, header, 5);
+	countOffset = record.length - 1;
+
+	streamPutString (&record, tag->name);
+	streamPutString (&record, tag->sourceFileName);
+	if (tag->lineNumberEntry)
+	{
+		char number [24];
+
+		sprintf (number, "%lu", tag->lineNumber);
+		streamPutString (&record, number);
+	}
+	else
+		streamPutPattern (&record, tag);
+
+	if (header [0] == TAG_STREAM_CODE_OTHER)
+		streamPutString (&record, kindName);
+	if (header [1] == TAG_STREAM_CODE_OTHER)
+		streamPutString (&record, tag->extensionFields.access);
+	if (header [2] == TAG_STREAM_CODE_OTHER)
+		streamPutString (&record, tag->extensionFields.implementation);
+
+	if (Option.extensionFields.language  &&  tag->language != NULL)
+		streamPutField (&record, &count, "language", tag->language);
+	if (Option.extensionFields.scope  &&
+			tag->extensionFields.scope [0] != NULL  &&
+			tag->extensionFields.scope [1] != NULL)
+		streamPutField (&record, &count, tag->extensionFields.scope [0],
+				tag->extensionFields.scope [1]);
+	if (Option.extensionFields.typeRef  &&
+			tag->extensionFields.typeRef [0] != NULL  &&
+			tag->extensionFields.typeRef [1] != NULL)
+	{
+		vString *const typeRef = vStringNewInit (tag->extensionFields.typeRef [0]);
+
+		vStringPut (typeRef, ':');
+		vStringCatS (typeRef, tag->extensionFields.typeRef [1]);
+		streamPutField (&record, &count, "typeref", vStringValue (typeRef));
+		vStringDelete (typeRef);
+	}
+	if (Option.extensionFields.inheritance  &&
+			tag->extensionFields.inheritance != NULL)
+		streamPutField (&record, &count, "inherits",
+				tag->extensionFields.inheritance);
+	if (Option.extensionFields.signature  &&
+			tag->extensionFields.signature != NULL)
+		streamPutField (&record, &count, "signature",
+				tag->extensionFields.signature);
+	if (Option.extensionFields.returnType &&
+			tag->extensionFields.returnType != NULL)
+		streamPutField (&record, &count, "returntype",
+				tag->extensionFields.returnType);
+	record.buffer [countOffset] = (unsigned char) count;
+
+	length = (unsigned int) record.length - TAG_STREAM_LENGTH_SIZE;
+	memcpy (record.buffer, &length, TAG_STREAM_LENGTH_SIZE);
+	fwrite (record.buffer, 1, record.length, TagFile.fp);
+
+	return (int) record.length;
+}
+
+/*  Written after the tags of each file in filter mode
+ */
+extern void writeBinaryEnd (FILE *const fp)
+{
+	const unsigned int length = 1;
+
+	fwrite (&length, TAG_STREAM_LENGTH_SIZE, 1, fp);
+	putc (TAG_STREAM_END, fp);
+}
+
 static int writeCtagsEntry (const tagEntryInfo *const tag)
 {
 	int length = fprintf (TagFile.fp, "%s\t%s\t",
@@ -828,6 +1034,8 @@ extern void makeTagEntry (const tagEntryInfo *const tag)
 		}
 		else if (Option.etags)
 			length = writeEtagsEntry (tag);
+		else if (Option.binary)
+			length = writeBinaryEntry (tag);
 		else
 			length = writeCtagsEntry (tag);
 
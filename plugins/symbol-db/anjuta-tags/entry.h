@@ -98,6 +98,7 @@ extern void beginEtagsFile (void);
 extern void endEtagsFile (const char *const name);
 extern void makeTagEntry (const tagEntryInfo *const tag);
 extern void initTagEntry (tagEntryInfo *const e, const char *const name);
+extern void writeBinaryEnd (FILE *const fp);
 
 #endif  /* _ENTRY_H */
 
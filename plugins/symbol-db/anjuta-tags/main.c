@@ -77,6 +77,7 @@
 
 
 #include "debug.h"
+#include "entry.h"
 #include "keyword.h"
 #include "main.h"
 #include "options.h"
@@ -367,7 +368,9 @@ static boolean createTagsFromFileInput (FILE *const fp, const boolean filter)
 			resize |= createTagsForEntry (cArgItem (args));
 			if (filter)
 			{
-				if (Option.filterTerminator != NULL)
+				if (Option.binary)
+					writeBinaryEnd (stdout);
+				else if (Option.filterTerminator != NULL)
 					fputs (Option.filterTerminator, stdout);
 				fflush (stdout);
 			}
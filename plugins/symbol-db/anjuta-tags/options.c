@@ -146,6 +146,7 @@ optionValues Option = {
 	TRUE,       /* --links */
 	FALSE,      /* --filter */
 	NULL,       /* --filter-terminator */
+	FALSE,      /* --binary */
 	FALSE,      /* --tag-relative */
 	FALSE,      /* --totals */
 	FALSE,      /* --line-directives */
@@ -196,6 +197,9 @@ static optionDescription LongOptionDescription [] = {
  {1,"  -x   Print a tabular cross reference file to standard output."},
  {1,"  --append=[yes|no]"},
  {1,"       Should tags should be appended to existing tag file [no]?"},
+ {1,"  --binary=[yes|no]"},
+ {1,"       Write the tags as binary records for anjuta instead of text,"},
+ {1,"       the tags are not sorted [no]."},
  {1,"  --etags-include=file"},
  {1,"      Include reference to 'file' in Emacs-style tag file (requires -e)."},
  {1,"  --exclude=pattern"},
@@ -1397,6 +1401,7 @@ static parametricOption ParametricOptions [] = {
 
 static booleanOption BooleanOptions [] = {
 	{ "append",         &Option.append,                 TRUE    },
+	{ "binary",         &Option.binary,                 TRUE    },
 	{ "file-scope",     &Option.include.fileScope,      FALSE   },
 	{ "file-tags",      &Option.include.fileNames,      FALSE   },
 	{ "filter",         &Option.filter,                 TRUE    },
@@ -106,6 +106,7 @@ typedef struct sOptionValues {
 	boolean followLinks;    /* --link  follow symbolic links? */
 	boolean filter;         /* --filter  behave as filter: files in, tags out */
 	char* filterTerminator; /* --filter-terminator  string to output */
+	boolean binary;         /* --binary  write the binary tag stream */
 	boolean tagRelative;    /* --tag-relative file paths relative to tag file */
 	boolean printTotals;    /* --totals  print cumulative statistics */
 	boolean lineDirectives; /* --linedirectives  process #line directives */
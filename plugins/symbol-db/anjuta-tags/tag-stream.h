@@ -0,0 +1,71 @@
+/*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   Binary tag stream written with --binary=yes, used by symbol-db to read
+*   the tags directly from the pipe. This header has no dependency, it is
+*   included by both sides.
+*
+*   Each record starts with its length on 32 bits followed by the record
+*   type on 1 byte and its data, the length includes the type byte. Numbers
+*   are in host byte order as the stream is read on the same host.
+*
+*   TAG_STREAM_TAG
+*       32 bits line number
+*       1 byte kind, access and implementation codes, 0 when not present,
+*         TAG_STREAM_CODE_OTHER when the name is not in the table below
+*       1 byte flags (TAG_STREAM_FILE_SCOPE)
+*       1 byte number of extension fields
+*       nul terminated strings: name, file, pattern, the kind, access and
+*         implementation names which have the TAG_STREAM_CODE_OTHER code,
+*         then the key and the value of each extension field
+*
+*   TAG_STREAM_END
+*       no data, written after the tags of each file in filter mode, in
+*       place of the filter terminator
+*/
+#ifndef _TAG_STREAM_H
+#define _TAG_STREAM_H
+
+/*
+*   MACROS
+*/
+#define TAG_STREAM_LENGTH_SIZE  4
+
+#define TAG_STREAM_TAG  1
+#define TAG_STREAM_END  2
+
+#define TAG_STREAM_TAG_HEADER_SIZE  (1 + 4 + 3 + 1 + 1)
+
+#define TAG_STREAM_FILE_SCOPE  0x01
+
+#define TAG_STREAM_CODE_NONE   0
+#define TAG_STREAM_CODE_OTHER  255
+
+#define TAG_STREAM_MAX_FIELDS  16
+
+/*
+*   DATA DEFINITIONS
+*/
+
+/* Codes are the index in these tables */
+static const char *const TagStreamKinds [] = {
+	NULL, "undef", "class", "enum", "enumerator", "field", "function",
+	"interface", "member", "method", "namespace", "package", "prototype",
+	"struct", "typedef", "union", "variable", "externvar", "macro",
+	"macro_with_arg", "file", "other", "local", "enum constant", "signal",
+	"property", "module", "label", NULL
+};
+
+static const char *const TagStreamAccesses [] = {
+	NULL, "public", "protected", "private", "friend", "default", "local",
+	NULL
+};
+
+static const char *const TagStreamImplementations [] = {
+	NULL, "abstract", "virtual", "pure virtual", NULL
+};
+
+#endif  /* _TAG_STREAM_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
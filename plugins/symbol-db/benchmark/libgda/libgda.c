@@ -154,6 +154,9 @@ main (int argc, char *argv[])
 	 */
 	load_queue_values ();
 
+	/* per-row GdaHolder values, as sdb_engine_add_new_symbol () does. Compare 
+	 * with the multi-row run of benchmark-sqlite */
+	g_message ("*** libgda per-row holders ***");
 	insert_data (cnc);	
 
 	
@@ -8,11 +8,16 @@
 #define HASH_VALUES_FILE "../data/hash_values.log"
 #define DB_FILE "example_db.db"
 
+/* rows per statement in the multi-row VALUES run */
+#define BULK_ROWS 256
+
 GQueue *values_queue;
 
 static void
 create_table (sqlite3 *db)
 {
+	sqlite3_exec(db, "DROP TABLE IF EXISTS sym_type", NULL, 0, NULL);
+
 	gchar *sql = "CREATE TABLE sym_type (type_id integer PRIMARY KEY AUTOINCREMENT,"
                    "type_type text not null,"
                    "type_name text not null,"
@@ -145,6 +150,96 @@ insert_data (sqlite3 *db)
 	g_message ("..OK (elapsed %f)", elapsed_DEBUG);
 }
 
+/*
+ * Same rows as insert_data () but with a single prepared statement inserting
+ * BULK_ROWS rows at a time, like the symbol-db first population does.
+ */
+static void
+insert_data_bulk (sqlite3 *db)
+{
+	sqlite3_stmt *stmt;
+	sqlite3_stmt *single_stmt;
+	GString *sql;
+	GPtrArray *rows;
+	gint i, j;
+	gdouble elapsed_DEBUG;
+	GTimer *sym_timer_DEBUG  = g_timer_new ();	
+	
+	sql = g_string_new ("INSERT INTO sym_type (type_type, type_name) VALUES (?, ?)");
+	for (i = 1; i < BULK_ROWS; i++)
+		g_string_append (sql, ", (?, ?)");
+
+	if (sqlite3_prepare_v2 (db, sql->str, -1, &stmt, NULL) != SQLITE_OK ||
+	    sqlite3_prepare_v2 (db, "INSERT INTO sym_type (type_type, type_name) "
+	                        "VALUES (?, ?)", -1, &single_stmt, NULL) != SQLITE_OK)
+	{
+		printf("\nCould not prepare statement.");
+		g_string_free (sql, TRUE);
+		return;
+	}
+	g_string_free (sql, TRUE);
+
+	/* split the values before starting the timer */
+	rows = g_ptr_array_new_with_free_func ((GDestroyNotify)g_strfreev);
+	while (g_queue_get_length (values_queue) > 0)
+	{
+		gchar * value = g_queue_pop_head (values_queue);	
+		g_ptr_array_add (rows, g_strsplit (value, "|", 2));
+		g_free (value);
+	}
+
+	g_timer_reset (sym_timer_DEBUG);
+	
+	g_message ("begin transaction...");
+	sqlite3_exec(db, "BEGIN", 0, 0, 0);
+	g_message ("..OK");
+	
+	g_message ("populating transaction (%d rows per statement)..", BULK_ROWS);
+	for (i = 0; i + BULK_ROWS <= rows->len; i += BULK_ROWS)
+	{
+		for (j = 0; j < BULK_ROWS; j++)
+		{
+			gchar **tokens = g_ptr_array_index (rows, i + j);
+			sqlite3_bind_text (stmt, j * 2 + 1, tokens[0], -1, SQLITE_STATIC);
+			sqlite3_bind_text (stmt, j * 2 + 2, tokens[1], -1, SQLITE_STATIC);
+		}
+		
+		if (sqlite3_step(stmt) != SQLITE_DONE) {
+			printf("\nCould not step (execute) stmt.\n");
+			return;
+		}
+		sqlite3_reset(stmt);
+	}
+
+	/* the tail */
+	for (; i < rows->len; i++)
+	{
+		gchar **tokens = g_ptr_array_index (rows, i);
+		sqlite3_bind_text (single_stmt, 1, tokens[0], -1, SQLITE_STATIC);
+		sqlite3_bind_text (single_stmt, 2, tokens[1], -1, SQLITE_STATIC);
+		
+		if (sqlite3_step(single_stmt) != SQLITE_DONE) {
+			printf("\nCould not step (execute) stmt.\n");
+			return;
+		}
+		sqlite3_reset(single_stmt);
+	}
+	elapsed_DEBUG = g_timer_elapsed (sym_timer_DEBUG, NULL);
+	g_message ("..OK (elapsed %f)", elapsed_DEBUG);
+	
+	g_message ("committing...");
+	
+	sqlite3_exec(db, "COMMIT", 0, 0, 0);
+	
+	elapsed_DEBUG = g_timer_elapsed (sym_timer_DEBUG, NULL);
+	g_message ("..OK (elapsed %f)", elapsed_DEBUG);
+
+	sqlite3_finalize (stmt);
+	sqlite3_finalize (single_stmt);
+	g_ptr_array_unref (rows);
+	g_timer_destroy (sym_timer_DEBUG);
+}
+
 gint 
 main(gint argc, gchar **argv)
 {
@@ -170,9 +265,17 @@ main(gint argc, gchar **argv)
 	 */
 	load_queue_values ();
 
-
+	/* before: one statement prepared and executed per row */
+	g_message ("*** per-row statements ***");
 	insert_data (db);	
 	
+	/* after: one prepared multi-row VALUES statement */
+	create_table (db);
+	load_queue_values ();
+	
+	g_message ("*** multi-row statements ***");
+	insert_data_bulk (db);
+	
 	
   	sqlite3_close(db);
   	return 0;
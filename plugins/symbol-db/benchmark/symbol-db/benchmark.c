@@ -3,9 +3,13 @@
 
 #include "../../symbol-db-engine.h"
 #include <gtk/gtk.h>
+#include <glib/gstdio.h>
 
 static GMainLoop *main_loop;
 
+/* anjuta-tags workers tested in --workers mode */
+static const gint workers_steps[] = { 1, 2, 4, 8 };
+
 static GPtrArray * 
 get_source_files_by_mime (const gchar* dir, const GHashTable *mimes)
 {
@@ -76,6 +80,145 @@ on_scan_end (SymbolDBEngine* engine, gpointer user_data)
  	g_main_loop_quit(main_loop);
 }
 
+static void 
+on_workers_scan_end (SymbolDBEngine* engine, gint process_id, gpointer user_data)
+{
+ 	g_main_loop_quit(main_loop);
+}
+
+static gint
+get_symbols_count (SymbolDBEngine* engine)
+{
+	GdaStatement *stmt;
+	GdaDataModel *model;
+	const GValue *value;
+	gint count = 0;
+	
+	stmt = symbol_db_engine_get_statement (engine, "SELECT COUNT(*) FROM symbol");
+	model = symbol_db_engine_execute_select (engine, stmt, NULL);
+	if (model != NULL)
+	{
+		value = gda_data_model_get_value_at (model, 0, 0, NULL);
+		if (value != NULL)
+			count = g_value_get_int (value);
+		g_object_unref (model);
+	}
+	g_object_unref (stmt);
+	
+	return count;
+}
+
+/* 
+ * Populate a fresh db with the files and report the first scan throughput.
+ * workers_num is the number of anjuta-tags workers, 0 for the default.
+ */
+static int
+run_populate_benchmark (const gchar *root_dir, GPtrArray *files, GPtrArray *languages,
+                        const gchar *label, gint workers_num, gboolean binary,
+                        gboolean bulk)
+{
+	SymbolDBEngine* engine;
+	GTimer *timer;
+	gchar *db_name;
+	gchar *db_file;
+	gdouble elapsed;
+	gint symbols;
+
+	db_name = g_strdup_printf ("benchmark-db-%s", label);
+	db_file = g_strdup_printf ("%s/%s.db", root_dir, db_name);
+	g_unlink (db_file);
+	
+	engine = symbol_db_engine_new_full ("anjuta-tags", db_name);
+	if (workers_num > 0)
+		symbol_db_engine_set_ctags_workers (engine, workers_num);
+	symbol_db_engine_set_binary_tags (engine, binary);
+	symbol_db_engine_set_bulk_population (engine, bulk);
+	
+	if (symbol_db_engine_open_db (engine, root_dir, root_dir) == DB_OPEN_STATUS_FATAL)
+	{
+		g_message ("Could not open database: %s", db_file);
+		return -1;
+	}
+	symbol_db_engine_add_new_project (engine, NULL, root_dir, "1.0");
+	
+	g_signal_connect (engine, "scan-end", G_CALLBACK (on_workers_scan_end), NULL);
+
+	timer = g_timer_new ();
+	symbol_db_engine_add_new_files_full_async (engine, root_dir, "1.0", files, 
+	                                           languages, TRUE);
+	g_main_loop_run (main_loop);
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	symbols = get_symbols_count (engine);
+	g_message ("%s: %d files, %d symbols in %.2f sec "
+	           "[%.1f files/sec] [%.1f symbols/sec]", label,
+	           files->len, symbols, elapsed, files->len / elapsed,
+	           symbols / elapsed);
+	
+	symbol_db_engine_close_db (engine);
+	g_object_unref (engine);
+	g_unlink (db_file);
+	g_free (db_file);
+	g_free (db_name);
+	
+	return 0;
+}
+
+/* 
+ * Populate a fresh db with the files, once for each workers step.
+ */
+static int
+run_workers_benchmark (const gchar *root_dir, GPtrArray *files, GPtrArray *languages)
+{
+	int i;
+	
+	for (i = 0; i < G_N_ELEMENTS (workers_steps); i++)
+	{
+		gchar *label;
+		int ret;
+
+		label = g_strdup_printf ("workers-%d", workers_steps[i]);
+		ret = run_populate_benchmark (root_dir, files, languages, label,
+		                              workers_steps[i], TRUE, TRUE);
+		g_free (label);
+		if (ret != 0)
+			return ret;
+	}
+	
+	return 0;
+}
+
+/* 
+ * Populate a fresh db with the files, reading the text then the binary tag
+ * stream of anjuta-tags.
+ */
+static int
+run_formats_benchmark (const gchar *root_dir, GPtrArray *files, GPtrArray *languages)
+{
+	if (run_populate_benchmark (root_dir, files, languages, "text", 0, FALSE,
+	                            TRUE) != 0)
+		return -1;
+
+	return run_populate_benchmark (root_dir, files, languages, "binary", 0, TRUE,
+	                               TRUE);
+}
+
+/* 
+ * Populate a fresh db with the files, writing the symbols through libgda then
+ * through the bulk sqlite3 inserts.
+ */
+static int
+run_inserts_benchmark (const gchar *root_dir, GPtrArray *files, GPtrArray *languages)
+{
+	if (run_populate_benchmark (root_dir, files, languages, "libgda", 0, TRUE,
+	                            FALSE) != 0)
+		return -1;
+
+	return run_populate_benchmark (root_dir, files, languages, "bulk", 0, TRUE,
+	                               TRUE);
+}
+
 int main (int argc, char** argv)
 {
   	SymbolDBEngine* engine;
@@ -84,6 +227,9 @@ int main (int argc, char** argv)
 	gchar* root_dir;
 	GFile *g_dir;
 	GHashTable *mimes;
+	gboolean workers_mode = FALSE;
+	gboolean formats_mode = FALSE;
+	gboolean inserts_mode = FALSE;
 	int i;
 
 	main_loop = g_main_loop_new (NULL, FALSE);
@@ -92,9 +238,28 @@ int main (int argc, char** argv)
   	g_thread_init (NULL);
 	gda_init ();
 	
+	if (argc == 3 && g_str_equal (argv[1], "--workers"))
+	{
+		workers_mode = TRUE;
+		argv++;
+		argc--;
+	}
+	else if (argc == 3 && g_str_equal (argv[1], "--formats"))
+	{
+		formats_mode = TRUE;
+		argv++;
+		argc--;
+	}
+	else if (argc == 3 && g_str_equal (argv[1], "--inserts"))
+	{
+		inserts_mode = TRUE;
+		argv++;
+		argc--;
+	}
+	
 	if (argc != 2)
 	{
-		g_message ("Usage: benchmark <source_directory>");
+		g_message ("Usage: benchmark [--workers|--formats|--inserts] <source_directory>");
 		return 1;
 	}
 
@@ -107,16 +272,6 @@ int main (int argc, char** argv)
 
 	root_dir = g_file_get_path (g_dir);
 	
-    engine = symbol_db_engine_new_full ("anjuta-tags", "benchmark-db");
-  
-	if (symbol_db_engine_open_db (engine, root_dir, root_dir) == DB_OPEN_STATUS_FATAL)
-	{
-		g_message ("Could not open database: %s", root_dir);
-		return -1;
-	}
-
-	symbol_db_engine_add_new_project (engine, NULL, root_dir, "1.0");
-			
 	mimes = g_hash_table_new (g_str_hash, g_str_equal);
 	g_hash_table_insert (mimes, "text/x-csrc", "text/x-csrc");
 	g_hash_table_insert (mimes, "text/x-chdr", "text/x-chdr");
@@ -128,6 +283,32 @@ int main (int argc, char** argv)
 
 	for (i = 0; i < files->len; i++)
 		g_ptr_array_add (languages, "C");
+
+	if (workers_mode || formats_mode || inserts_mode)
+	{
+		int ret;
+
+		if (workers_mode)
+			ret = run_workers_benchmark (root_dir, files, languages);
+		else if (formats_mode)
+			ret = run_formats_benchmark (root_dir, files, languages);
+		else
+			ret = run_inserts_benchmark (root_dir, files, languages);
+
+		g_free (root_dir);
+		g_object_unref (g_dir);
+		return ret;
+	}
+	
+    engine = symbol_db_engine_new_full ("anjuta-tags", "benchmark-db");
+  
+	if (symbol_db_engine_open_db (engine, root_dir, root_dir) == DB_OPEN_STATUS_FATAL)
+	{
+		g_message ("Could not open database: %s", root_dir);
+		return -1;
+	}
+
+	symbol_db_engine_add_new_project (engine, NULL, root_dir, "1.0");
 	
 	g_signal_connect (engine, "scan-end", G_CALLBACK (on_scan_end), NULL);
 	g_signal_connect (G_OBJECT (engine), "single-file-scan-end",
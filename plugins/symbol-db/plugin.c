@@ -76,6 +76,8 @@
 
 #define PREF_SCHEMA 						"org.gnome.anjuta.symbol-db"
 
+#define EDITOR_SYNC_KEY						"symbol-db-buffer-sync"
+
 
 
 static gpointer parent_class;
@@ -352,6 +354,137 @@ static GtkActionEntry actions_search[] = {
   }
 };
 
+/* Buffer state of each editor, kept as its EDITOR_SYNC_KEY data */
+typedef struct _SdbEditorSync
+{
+	gboolean buffer_synced;					/* the symbols on db are the ones of
+	 										 * the buffer but for the dirty lines:
+	 										 * only those need a rescan.
+	 										 */
+	gint dirty_first_line;
+	gint dirty_last_line;
+	gint dirty_lines_delta;
+} SdbEditorSync;
+
+static void
+editor_buffer_sync_free (SdbEditorSync *sync)
+{
+	g_slice_free (SdbEditorSync, sync);
+}
+
+static SdbEditorSync *
+editor_buffer_get_sync (IAnjutaEditor *editor)
+{
+	SdbEditorSync *sync;
+
+	sync = g_object_get_data (G_OBJECT (editor), EDITOR_SYNC_KEY);
+	if (sync == NULL)
+	{
+		sync = g_slice_new0 (SdbEditorSync);
+		g_object_set_data_full (G_OBJECT (editor), EDITOR_SYNC_KEY, sync,
+		                        (GDestroyNotify) editor_buffer_sync_free);
+	}
+	return sync;
+}
+
+static void
+editor_buffer_reset_dirty_lines (SdbEditorSync *sync)
+{
+	sync->dirty_first_line = 0;
+	sync->dirty_last_line = 0;
+	sync->dirty_lines_delta = 0;
+}
+
+/* The next update of the buffer will scan it in full */
+static void
+editor_buffer_unsync (IAnjutaEditor *editor)
+{
+	SdbEditorSync *sync = editor_buffer_get_sync (editor);
+
+	sync->buffer_synced = FALSE;
+	editor_buffer_reset_dirty_lines (sync);
+}
+
+static gboolean
+editor_line_is_blank (IAnjutaEditor *editor, gint line)
+{
+	IAnjutaIterable *begin;
+	IAnjutaIterable *end;
+	gchar *text;
+	gboolean blank;
+	
+	begin = ianjuta_editor_get_line_begin_position (editor, line, NULL);
+	end = ianjuta_editor_get_line_end_position (editor, line, NULL);
+	text = ianjuta_editor_get_text (editor, begin, end, NULL);
+
+	blank = text == NULL || *g_strstrip (text) == '\0';
+
+	g_free (text);
+	g_object_unref (begin);
+	g_object_unref (end);
+	
+	return blank;
+}
+
+/*
+ * Rescans only the top level declarations around the dirty lines. 
+ * Returns the scan process id, or -1 if the whole buffer has to be scanned.
+ */
+static gint
+editor_buffer_range_update (IAnjutaEditor *editor, SymbolDBPlugin *sdb_plugin,
+                            const gchar *local_path)
+{
+	IAnjutaIterable *begin;
+	IAnjutaIterable *end;
+	gchar *text;
+	gint start_line, end_line, floor_line;
+	gint line;
+	gint proc_id;
+	SdbEditorSync *sync = editor_buffer_get_sync (editor);
+
+	if (symbol_db_engine_get_buffer_scan_range (sdb_plugin->sdbe_project, 
+	                                            local_path,
+	                                            sync->dirty_first_line,
+	                                            sync->dirty_last_line,
+	                                            sync->dirty_lines_delta,
+	                                            &start_line, &end_line,
+	                                            &floor_line) == FALSE)
+		return -1;
+
+	/* the lines before the declaration, e.g. the return type on its own line,
+	 * are part of it. Stop at the first blank line */
+	for (line = start_line - 1; line >= floor_line; line--)
+	{
+		if (editor_line_is_blank (editor, line))
+		{
+			start_line = line + 1;
+			break;
+		}
+	}
+	
+	begin = ianjuta_editor_get_line_begin_position (editor, start_line, NULL);
+	if (end_line < 0)
+		end = ianjuta_editor_get_end_position (editor, NULL);
+	else
+		end = ianjuta_editor_get_line_end_position (editor, end_line, NULL);
+	text = ianjuta_editor_get_text (editor, begin, end, NULL);
+	g_object_unref (begin);
+	g_object_unref (end);
+
+	if (text == NULL)
+		return -1;
+	
+	DEBUG_PRINT ("updating lines %d-%d of %s", start_line, end_line, local_path);
+	proc_id = symbol_db_engine_update_buffer_range (sdb_plugin->sdbe_project,
+	                                                sdb_plugin->project_opened,
+	                                                local_path, text, strlen (text),
+	                                                start_line, end_line,
+	                                                sync->dirty_lines_delta);
+	g_free (text);
+	
+	return proc_id;
+}
+
 static gboolean
 editor_buffer_symbols_update (IAnjutaEditor *editor, SymbolDBPlugin *sdb_plugin)
 {
@@ -362,6 +495,7 @@ editor_buffer_symbols_update (IAnjutaEditor *editor, SymbolDBPlugin *sdb_plugin)
 	GPtrArray *real_files_list;
 	GPtrArray *text_buffers;
 	GPtrArray *buffer_sizes;
+	SdbEditorSync *sync;
 	gint i;
 	gint proc_id ;
 	
@@ -372,9 +506,6 @@ editor_buffer_symbols_update (IAnjutaEditor *editor, SymbolDBPlugin *sdb_plugin)
 
 	if (editor) 
 	{
-		buffer_size = ianjuta_editor_get_length (editor, NULL);
-		current_buffer = ianjuta_editor_get_text_all (editor, NULL);
-				
 		file = ianjuta_file_get_file (IANJUTA_FILE (editor), NULL);
 	} 
 	else
@@ -397,35 +528,60 @@ editor_buffer_symbols_update (IAnjutaEditor *editor, SymbolDBPlugin *sdb_plugin)
 			/* hey we found it */
 			/* something is already scanning this buffer file. Drop the procedure now. */
 			DEBUG_PRINT ("something is already scanning the file %s", local_path);
+			g_free (local_path);
+			g_object_unref (file);
 			return FALSE;			
 		}
 	}
 
-	real_files_list = g_ptr_array_new_with_free_func (g_free);
-	g_ptr_array_add (real_files_list, local_path);
+	proc_id = 0;
+	sync = editor_buffer_get_sync (editor);
+	if (sync->buffer_synced == TRUE && sync->dirty_first_line <= 0)
+	{
+		/* nothing which defines symbols has changed */
+		g_free (local_path);
+		g_object_unref (file);
+		sdb_plugin->need_symbols_update = FALSE;
+		return TRUE;
+	}
+	
+	if (sync->buffer_synced == TRUE &&
+	    symbol_db_engine_is_connected (sdb_plugin->sdbe_project))
+	{
+		proc_id = editor_buffer_range_update (editor, sdb_plugin, local_path);
+	}
 
-	text_buffers = g_ptr_array_new ();
-	g_ptr_array_add (text_buffers, current_buffer);	
+	if (proc_id <= 0 && symbol_db_engine_is_connected (sdb_plugin->sdbe_project))
+	{
+		buffer_size = ianjuta_editor_get_length (editor, NULL);
+		current_buffer = ianjuta_editor_get_text_all (editor, NULL);
 
-	buffer_sizes = g_ptr_array_new ();
-	g_ptr_array_add (buffer_sizes, GINT_TO_POINTER (buffer_size));
+		real_files_list = g_ptr_array_new_with_free_func (g_free);
+		g_ptr_array_add (real_files_list, g_strdup (local_path));
 
+		text_buffers = g_ptr_array_new ();
+		g_ptr_array_add (text_buffers, current_buffer);	
+
+		buffer_sizes = g_ptr_array_new ();
+		g_ptr_array_add (buffer_sizes, GINT_TO_POINTER (buffer_size));
 
-	proc_id = 0;
-	if (symbol_db_engine_is_connected (sdb_plugin->sdbe_project))
-	{		
 		proc_id = symbol_db_engine_update_buffer_symbols (sdb_plugin->sdbe_project,
 											sdb_plugin->project_opened,
 											real_files_list,
 											text_buffers,
 											buffer_sizes);
+		g_ptr_array_unref (real_files_list);
+		g_free (current_buffer);  
 	}
 
+	/* from now on the changes are relative to the text just sent */
+	sync->buffer_synced = proc_id > 0;
+	editor_buffer_reset_dirty_lines (sync);
+	
 	if (proc_id > 0)
 	{		
 		/* good. All is ready for a buffer scan. Add the file_scan into the arrays */
-		gchar * local_path_dup = g_strdup (local_path);
-		g_ptr_array_add (sdb_plugin->buffer_update_files, local_path_dup);	
+		g_ptr_array_add (sdb_plugin->buffer_update_files, local_path);	
 		/* add the id too */
 		g_ptr_array_add (sdb_plugin->buffer_update_ids, GINT_TO_POINTER (proc_id));
 
@@ -433,14 +589,11 @@ editor_buffer_symbols_update (IAnjutaEditor *editor, SymbolDBPlugin *sdb_plugin)
 		g_tree_insert (sdb_plugin->proc_id_tree, GINT_TO_POINTER (proc_id),
 					   GINT_TO_POINTER (TASK_BUFFER_UPDATE));		
 	}
+	else
+		g_free (local_path);
 
-	g_ptr_array_unref (real_files_list);
-	g_free (current_buffer);  
 	g_object_unref (file);
 
-	/* no need to free local_path, it'll be automatically freed later by the buffer_update
-	 * function */
-
 	sdb_plugin->need_symbols_update = FALSE;
 
 	return proc_id > 0 ? TRUE : FALSE;
@@ -583,6 +736,63 @@ on_char_added (IAnjutaEditor *editor, IAnjutaIterable *position, gchar ch,
 		sdb_plugin->need_symbols_update = TRUE;
 }
 
+static void
+on_editor_changed (IAnjutaEditor *editor, IAnjutaIterable *position, 
+                   gboolean added, gint length, gint lines, const gchar *text,
+                   SymbolDBPlugin *sdb_plugin)
+{
+	gint line;
+	gint first, last;
+	SdbEditorSync *sync;
+
+	/* editors other than the current one will be scanned in full when they
+	 * get the focus */
+	if (G_OBJECT (editor) != sdb_plugin->current_editor)
+	{
+		editor_buffer_unsync (editor);
+		return;
+	}
+
+	sync = editor_buffer_get_sync (editor);
+	if (sync->buffer_synced == FALSE)
+		return;
+	
+	line = ianjuta_editor_get_line_from_position (editor, position, NULL);
+	
+	if (sync->dirty_first_line <= 0)
+	{
+		sync->dirty_first_line = line;
+		sync->dirty_last_line = added ? line + lines : line;
+		sync->dirty_lines_delta = added ? lines : -lines;
+		return;
+	}
+	
+	first = sync->dirty_first_line;
+	last = sync->dirty_last_line;
+
+	/* move the dirty lines where they are now */
+	if (added)
+	{
+		if (first > line)
+			first += lines;
+		if (last > line)
+			last += lines;
+		
+		sync->dirty_first_line = MIN (first, line);
+		sync->dirty_last_line = MAX (last, line + lines);
+		sync->dirty_lines_delta += lines;
+	}
+	else
+	{
+		first = first > line + lines ? first - lines : MIN (first, line);
+		last = last > line + lines ? last - lines : MIN (last, line);
+
+		sync->dirty_first_line = MIN (first, line);
+		sync->dirty_last_line = MAX (last, line);
+		sync->dirty_lines_delta -= lines;
+	}
+}
+
 static void
 on_editor_saved (IAnjutaEditor *editor, GFile* file,
 				 SymbolDBPlugin *sdb_plugin)
@@ -641,8 +851,10 @@ on_editor_saved (IAnjutaEditor *editor, GFile* file,
 	g_hash_table_insert (sdb_plugin->editor_connected, editor,
 						 g_strdup (saved_uri));
 
-	/* if we saved it we shouldn't update a second time */
+	/* if we saved it we shouldn't update a second time. The next changes will
+	 * need a whole buffer scan though, as the file update is still queued */
 	sdb_plugin->need_symbols_update = FALSE;
+	editor_buffer_unsync (editor);
 	
 	on_editor_update_ui (editor, sdb_plugin);
 	g_free (saved_uri);
@@ -744,6 +956,9 @@ value_added_current_editor (AnjutaPlugin *plugin, const char *name,
 		g_signal_connect (G_OBJECT (editor), "code-added",
 						  G_CALLBACK (on_code_added),
 						  sdb_plugin);
+		g_signal_connect (G_OBJECT (editor), "changed",
+						  G_CALLBACK (on_editor_changed),
+						  sdb_plugin);
 		g_signal_connect (G_OBJECT(editor), "update_ui",
 						  G_CALLBACK (on_editor_update_ui),
 						  sdb_plugin);
@@ -751,7 +966,10 @@ value_added_current_editor (AnjutaPlugin *plugin, const char *name,
 	g_free (uri);
 	g_free (local_path);
 	
+	/* other files may have been scanned meanwhile: start from a whole
+	 * buffer scan */
 	sdb_plugin->need_symbols_update = FALSE;
+	editor_buffer_unsync (IANJUTA_EDITOR (editor));
 }
 
 static void
@@ -769,9 +987,13 @@ on_editor_foreach_disconnect (gpointer key, gpointer value, gpointer user_data)
 	g_signal_handlers_disconnect_by_func (G_OBJECT(key),
 										  G_CALLBACK (on_code_added),
 										  user_data);
+	g_signal_handlers_disconnect_by_func (G_OBJECT(key),
+										  G_CALLBACK (on_editor_changed),
+										  user_data);
 	g_object_weak_unref (G_OBJECT(key),
 						 (GWeakNotify) (on_editor_destroy),
 						 user_data);
+	g_object_set_data (G_OBJECT (key), EDITOR_SYNC_KEY, NULL);
 }
 
 static void
@@ -1916,6 +2138,17 @@ on_isymbol_manager_prj_scan_end (SymbolDBEngine *dbe,
 	g_signal_emit_by_name (sm, "prj-scan-end", process_id);
 }
 
+static void
+on_isymbol_manager_prj_symbols_changed (SymbolDBEngine *dbe,
+                                        GArray *symbols_ids,
+                                        IAnjutaSymbolManager *sm)
+{
+	/* a single emission for the whole batch, see the interface */
+	if (symbols_ids->len > 0)
+		g_signal_emit_by_name (sm, "prj-symbol-changed",
+		                       g_array_index (symbols_ids, gint, 0));
+}
+
 static void
 on_isymbol_manager_sys_scan_begin (SymbolDBEngine *dbe, gint process_id, 
                                    SymbolDBPlugin *sdb_plugin)
@@ -2090,6 +2323,12 @@ symbol_db_activate (AnjutaPlugin *plugin)
 
 	g_signal_connect (G_OBJECT (sdb_plugin->sdbe_project), "scan-end",
 				G_CALLBACK (on_isymbol_manager_prj_scan_end), sdb_plugin);
+	g_signal_connect (G_OBJECT (sdb_plugin->sdbe_project), "symbols-inserted",
+				G_CALLBACK (on_isymbol_manager_prj_symbols_changed), sdb_plugin);
+	g_signal_connect (G_OBJECT (sdb_plugin->sdbe_project), "symbols-updated",
+				G_CALLBACK (on_isymbol_manager_prj_symbols_changed), sdb_plugin);
+	g_signal_connect (G_OBJECT (sdb_plugin->sdbe_project), "symbols-removed",
+				G_CALLBACK (on_isymbol_manager_prj_symbols_changed), sdb_plugin);
 	
 	/* connect signals for interface to receive them */
 	g_signal_connect (G_OBJECT (sdb_plugin->sdbe_globals), "single-file-scan-end",
@@ -2317,6 +2556,9 @@ symbol_db_deactivate (AnjutaPlugin *plugin)
 	g_signal_handlers_disconnect_by_func (G_OBJECT (sdb_plugin->sdbe_project),
 				G_CALLBACK (on_isymbol_manager_prj_scan_end), plugin);
 
+	g_signal_handlers_disconnect_by_func (G_OBJECT (sdb_plugin->sdbe_project),
+				G_CALLBACK (on_isymbol_manager_prj_symbols_changed), plugin);
+
 	g_signal_handlers_disconnect_by_func (G_OBJECT (pm),
 	    		G_CALLBACK (on_project_element_added), plugin);
 
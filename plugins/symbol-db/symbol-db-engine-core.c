@@ -25,6 +25,7 @@
  * 	Boston, MA  02110-1301, USA.
  */
 
+#include <config.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/types.h>
@@ -43,6 +44,7 @@
 #include <libgda/libgda.h>
 #include <sql-parser/gda-sql-parser.h>
 #include "readtags.h"
+#include "anjuta-tags/tag-stream.h"
 #include "symbol-db-engine-priv.h"
 #include "symbol-db-engine-core.h"
 #include "symbol-db-engine-utils.h"
@@ -94,6 +96,26 @@ typedef struct _TableMapSymbol {
 
 } TableMapSymbol;
 
+/*
+ * SdbTagBatch: all the tags ctags produced for a single file, read out of a
+ * worker's shared memory file. Strings are owned by the batch, so that parsing
+ * can be done without holding the engine mutex.
+ */
+typedef struct _SdbTagBatch {
+	GArray *entries;
+	GStringChunk *strings;
+	GPtrArray *fields_lists;
+
+	/* may be NULL: not a fake file scan */
+	gchar *real_file;
+	gboolean force_sym_update;
+	/* the file was unreadable: no entries, it only counts as scanned */
+	gboolean skipped;
+	/* the scan the file belongs to */
+	gint scan_id;
+
+} SdbTagBatch;
+
 typedef struct _EngineScanDataAsync {
 	GPtrArray *files_list;
 	GPtrArray *real_files_list;
@@ -120,6 +142,9 @@ enum
 	SYMBOL_UPDATED,
 	SYMBOL_SCOPE_UPDATED,
 	SYMBOL_REMOVED,
+	SYMBOLS_INSERTED,
+	SYMBOLS_UPDATED,
+	SYMBOLS_REMOVED,
 	LAST_SIGNAL
 };
 
@@ -128,9 +153,7 @@ enum
  */
 enum {
 	DO_UPDATE_SYMS = 1,
-	DO_UPDATE_SYMS_AND_EXIT,
 	DONT_UPDATE_SYMS,
-	DONT_UPDATE_SYMS_AND_EXIT,
 	DONT_FAKE_UPDATE_SYMS,
 	END_UPDATE_GROUP_SYMS
 };
@@ -150,8 +173,8 @@ typedef struct _ScanFiles1Data {
 	
 	gchar *real_file;	/* may be NULL. If not NULL must be freed */
 	gint partial_count;
-	gint files_list_len;
 	gint symbols_update;
+	gint scan_id;
 	
 } ScanFiles1Data;
 
@@ -178,6 +201,12 @@ static gint
 sdb_engine_add_new_symbol (SymbolDBEngine * dbe, const tagEntry * tag_entry,
 						   int file_defined_id, gboolean sym_update);
 
+static gboolean
+sdb_engine_bulk_populate_db_by_tags (SymbolDBEngine * dbe, SdbTagBatch *batch);
+
+static void
+sdb_engine_bulk_close (SymbolDBEngine *dbe);
+
 GNUC_INLINE const GdaStatement *
 sdb_engine_get_statement_by_query_id (SymbolDBEngine * dbe, static_query_type query_id);
 
@@ -522,6 +551,8 @@ sdb_engine_disconnect_from_db (SymbolDBEngine * dbe)
 	g_return_val_if_fail (dbe != NULL, FALSE);
 	priv = dbe->priv;
 
+	sdb_engine_bulk_close (dbe);
+
 	DEBUG_PRINT ("VACUUM command issued on %s", priv->cnc_string);
 	sdb_engine_execute_non_select_sql (dbe, "VACUUM");
 	
@@ -755,59 +786,381 @@ sdb_engine_get_file_defined_id (SymbolDBEngine* dbe,
 	return file_defined_id;
 }
 
+static SdbTagBatch *
+sdb_engine_tag_batch_new (gchar *real_file, gboolean force_sym_update)
+{
+	SdbTagBatch *batch = g_slice_new0 (SdbTagBatch);
+
+	batch->entries = g_array_new (FALSE, FALSE, sizeof (tagEntry));
+	batch->strings = g_string_chunk_new (4096);
+	batch->fields_lists = g_ptr_array_new_with_free_func (g_free);
+	batch->real_file = real_file;
+	batch->force_sym_update = force_sym_update;
+
+	return batch;
+}
+
+static void
+sdb_engine_tag_batch_free (SdbTagBatch *batch)
+{
+	g_array_free (batch->entries, TRUE);
+	g_string_chunk_free (batch->strings);
+	g_ptr_array_unref (batch->fields_lists);
+	g_free (batch->real_file);
+
+	g_slice_free (SdbTagBatch, batch);
+}
+
+static GNUC_INLINE const gchar *
+sdb_engine_tag_batch_strdup (SdbTagBatch *batch, const gchar *str)
+{
+	if (str == NULL)
+		return NULL;
+	return g_string_chunk_insert (batch->strings, str);
+}
+
+static void
+sdb_engine_tag_batch_add (SdbTagBatch *batch, const tagEntry *tag_entry)
+{
+	tagEntry entry;
+	gint i;
+
+	entry.name = sdb_engine_tag_batch_strdup (batch, tag_entry->name);
+	entry.file = sdb_engine_tag_batch_strdup (batch, tag_entry->file);
+	entry.address.pattern =
+		sdb_engine_tag_batch_strdup (batch, tag_entry->address.pattern);
+	entry.address.lineNumber = tag_entry->address.lineNumber;
+	entry.kind = sdb_engine_tag_batch_strdup (batch, tag_entry->kind);
+	entry.fileScope = tag_entry->fileScope;
+	entry.fields.count = tag_entry->fields.count;
+	entry.fields.list = NULL;
+
+	if (tag_entry->fields.count > 0)
+	{
+		tagExtensionField *list;
+
+		list = g_new (tagExtensionField, tag_entry->fields.count);
+		for (i = 0; i < tag_entry->fields.count; i++)
+		{
+			/* keys are a handful of well known strings */
+			list[i].key = g_string_chunk_insert_const (batch->strings,
+			                                           tag_entry->fields.list[i].key);
+			list[i].value = sdb_engine_tag_batch_strdup (batch,
+			                                             tag_entry->fields.list[i].value);
+		}
+		g_ptr_array_add (batch->fields_lists, list);
+		entry.fields.list = list;
+	}
+
+	g_array_append_val (batch->entries, entry);
+}
+
 /**
- * ### Thread note: this function inherits the mutex lock ###
+ * ~~~ Thread note: this function does not need the mutex lock ~~~
  *
- * If fake_file is != NULL we claim and assert that tags contents which are
- * scanned belong to the fake_file in the project.
- * More: the fake_file refers to just one single file and cannot be used
- * for multiple fake_files.
+ * Parse the ctags text output stored in fd into a batch.
  */
 static void
-sdb_engine_populate_db_by_tags (SymbolDBEngine * dbe, FILE* fd,
-								gchar * fake_file_on_db,
-								gboolean force_sym_update)
+sdb_engine_tag_batch_read (SdbTagBatch *batch, FILE *fd)
 {
 	tagFile *tag_file;
 	tagFileInfo tag_file_info;
 	tagEntry tag_entry;
+
+	if ((tag_file = tagsOpen_1 (fd, &tag_file_info)) == NULL)
+	{
+		g_warning ("error in opening ctags file");
+		return;
+	}
+
+	tag_entry.file = NULL;
+	while (tagsNext (tag_file, &tag_entry) != TagFailure)
+	{
+		if (tag_entry.file != NULL)
+			sdb_engine_tag_batch_add (batch, &tag_entry);
+
+		tag_entry.file = NULL;
+	}
+
+	/* we've done with tag_file but we don't need to tagsClose (tag_file); */
+}
+
+/**
+ * ~~~ Thread note: this function does not need the mutex lock ~~~
+ *
+ * Create the batch of the next file written by the worker. The scan flag and
+ * the real file are queued in the same order of its output.
+ */
+static SdbTagBatch *
+sdb_engine_ctags_worker_next_batch (SdbCtagsWorker *worker)
+{
+	SdbTagBatch *batch;
+	DBESignal *dbesig;
+	gint scan_flag;
+	gint scan_id;
+	gchar *real_file;
+
+	/* get the scan flag from the queue. We need it to know whether
+	 * an update of symbols must be done or not */
+	dbesig = g_async_queue_try_pop (worker->scan_aqueue);
+	scan_flag = GPOINTER_TO_INT(dbesig->value);
+	scan_id = dbesig->process_id;
+	g_slice_free (DBESignal, dbesig);
+
+	dbesig = g_async_queue_try_pop (worker->scan_aqueue);
+	real_file = dbesig->value;
+	g_slice_free (DBESignal, dbesig);
+
+	/* the batch takes ownership of real_file, if it's a char */
+	batch = sdb_engine_tag_batch_new (
+			(gsize)real_file == DONT_FAKE_UPDATE_SYMS ? NULL : real_file,
+			scan_flag == DO_UPDATE_SYMS);
+	batch->scan_id = scan_id;
+
+	return batch;
+}
+
+static const gchar *
+sdb_engine_tag_stream_string (const gchar **ptr, const gchar *end)
+{
+	const gchar *str = *ptr;
+	const gchar *nul;
+
+	if (str >= end || (nul = memchr (str, '\0', end - str)) == NULL)
+		return NULL;
+	*ptr = nul + 1;
+
+	return str;
+}
+
+static const gchar *
+sdb_engine_tag_stream_code (const gchar *const *table, guint size, guint code,
+                            const gchar **ptr, const gchar *end)
+{
+	if (code == TAG_STREAM_CODE_OTHER)
+		return sdb_engine_tag_stream_string (ptr, end);
+
+	return code < size ? table[code] : NULL;
+}
+
+/**
+ * ~~~ Thread note: this function does not need the mutex lock ~~~
+ *
+ * Decode a TAG_STREAM_TAG record, see anjuta-tags/tag-stream.h. The entry
+ * points into the record, fields must have room for 
+ * TAG_STREAM_MAX_FIELDS + 2 fields. 
+ *
+ * Returns: FALSE if the record is malformed.
+ */
+static gboolean
+sdb_engine_tag_stream_decode (const gchar *record, gsize len, 
+                              tagEntry *entry, tagExtensionField *fields)
+{
+	const gchar *ptr = record + TAG_STREAM_TAG_HEADER_SIZE;
+	const gchar *end = record + len;
+	const guchar *header;
+	const gchar *access;
+	const gchar *implementation;
+	guint32 line;
+	gint count;
+	gint i;
+
+	if (len < TAG_STREAM_TAG_HEADER_SIZE)
+		return FALSE;
+
+	memcpy (&line, record + 1, sizeof (line));
+	header = (const guchar *)record + 5;
+
+	entry->name = sdb_engine_tag_stream_string (&ptr, end);
+	entry->file = sdb_engine_tag_stream_string (&ptr, end);
+	entry->address.pattern = sdb_engine_tag_stream_string (&ptr, end);
+	entry->address.lineNumber = line;
+	entry->kind = sdb_engine_tag_stream_code (TagStreamKinds, 
+	                                          G_N_ELEMENTS (TagStreamKinds),
+	                                          header[0], &ptr, end);
+	access = sdb_engine_tag_stream_code (TagStreamAccesses, 
+	                                     G_N_ELEMENTS (TagStreamAccesses),
+	                                     header[1], &ptr, end);
+	implementation = sdb_engine_tag_stream_code (TagStreamImplementations, 
+	                                             G_N_ELEMENTS (TagStreamImplementations),
+	                                             header[2], &ptr, end);
+	entry->fileScope = (header[3] & TAG_STREAM_FILE_SCOPE) != 0;
+
+	if (entry->name == NULL || entry->file == NULL || 
+	    entry->address.pattern == NULL || header[4] > TAG_STREAM_MAX_FIELDS)
+		return FALSE;
+
+	/* access and implementation are extension fields in the text format */
+	count = 0;
+	if (access != NULL)
+	{
+		fields[count].key = "access";
+		fields[count++].value = access;
+	}
+	if (implementation != NULL)
+	{
+		fields[count].key = "implementation";
+		fields[count++].value = implementation;
+	}
+	for (i = 0; i < header[4]; i++, count++)
+	{
+		fields[count].key = sdb_engine_tag_stream_string (&ptr, end);
+		fields[count].value = sdb_engine_tag_stream_string (&ptr, end);
+		if (fields[count].key == NULL || fields[count].value == NULL)
+			return FALSE;
+	}
+	entry->fields.count = count;
+	entry->fields.list = count > 0 ? fields : NULL;
+
+	return TRUE;
+}
+
+/**
+ * ~~~ Thread note: this function does not need the mutex lock ~~~
+ *
+ * Append a chunk of the binary tag stream and parse its complete records.
+ * The tags are added to the batch of the current file, which is handed to
+ * the writer thread at the end of the file.
+ */
+static void
+sdb_engine_ctags_output_read_stream (SdbCtagsWorker *worker, GString *chunk)
+{
+	SymbolDBEnginePriv *priv;
+	GByteArray *stream;
+	gsize pos = 0;
+
+	priv = worker->dbe->priv;
+	stream = worker->stream;
+	g_byte_array_append (stream, (const guint8 *)chunk->str, chunk->len);
+
+	while (stream->len - pos >= TAG_STREAM_LENGTH_SIZE + 1)
+	{
+		const gchar *record;
+		guint32 len;
+
+		memcpy (&len, stream->data + pos, TAG_STREAM_LENGTH_SIZE);
+		if (stream->len - pos - TAG_STREAM_LENGTH_SIZE < len)
+			break;
+
+		record = (const gchar *)stream->data + pos + TAG_STREAM_LENGTH_SIZE;
+		pos += TAG_STREAM_LENGTH_SIZE + len;
+
+		if (worker->batch == NULL)
+			worker->batch = sdb_engine_ctags_worker_next_batch (worker);
+
+		if (record[0] == TAG_STREAM_TAG)
+		{
+			tagEntry entry;
+			tagExtensionField fields[TAG_STREAM_MAX_FIELDS + 2];
+
+			if (sdb_engine_tag_stream_decode (record, len, &entry, fields))
+				sdb_engine_tag_batch_add (worker->batch, &entry);
+			else
+				g_warning ("malformed tag in the anjuta-tags stream");
+		}
+		else if (record[0] == TAG_STREAM_END)
+		{
+			/* and now let the writer populate the db */
+			g_thread_pool_push (priv->thread_pool, worker->batch, NULL);
+			worker->batch = NULL;
+		}
+	}
+
+	g_byte_array_remove_range (stream, 0, pos);
+}
+
+static void
+sdb_engine_symbol_snapshot_free (SdbSymbolSnapshot *snapshot)
+{
+	g_free (snapshot->signature);
+	g_free (snapshot->returntype);
+	g_slice_free (SdbSymbolSnapshot, snapshot);
+}
+
+static void
+sdb_engine_buffer_range_free (SdbBufferRange *range)
+{
+	if (range->snapshot)
+		g_hash_table_destroy (range->snapshot);
+	g_slice_free (SdbBufferRange, range);
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * Returns: FALSE if the symbol was in the rescanned range and nothing 
+ * changed but its update_flag.
+ */
+static gboolean
+sdb_engine_buffer_range_symbol_changed (SdbBufferRange *range, gint symbol_id,
+                                        gint file_position, gint is_file_scope,
+                                        const gchar *signature, 
+                                        const gchar *returntype,
+                                        gint kind_id, gint access_kind_id,
+                                        gint implementation_kind_id)
+{
+	SdbSymbolSnapshot *snapshot;
+
+	snapshot = g_hash_table_lookup (range->snapshot, GINT_TO_POINTER (symbol_id));
+	if (snapshot == NULL)
+		return TRUE;
+
+	return snapshot->file_position != file_position ||
+		snapshot->is_file_scope != is_file_scope ||
+		snapshot->kind_id != kind_id ||
+		snapshot->access_kind_id != access_kind_id ||
+		snapshot->implementation_kind_id != implementation_kind_id ||
+		g_strcmp0 (snapshot->signature, signature) != 0 ||
+		g_strcmp0 (snapshot->returntype, returntype) != 0;
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * If batch->real_file is != NULL we claim and assert that tags contents which
+ * are scanned belong to the fake_file in the project.
+ * More: the fake_file refers to just one single file and cannot be used
+ * for multiple fake_files.
+ */
+static void
+sdb_engine_populate_db_by_tags (SymbolDBEngine * dbe, SdbTagBatch *batch)
+{
 	gint file_defined_id_cache = 0;
 	gchar* tag_entry_file_cache = NULL;
-	
+	gchar *fake_file_on_db;
+	guint i;
+
 	SymbolDBEnginePriv *priv = dbe->priv;
 
+	fake_file_on_db = batch->real_file;
 	gchar* base_prj_path = fake_file_on_db == NULL ?
 		priv->project_directory : NULL;
-	
+
 	g_return_if_fail (dbe != NULL);
 
 	g_return_if_fail (priv->db_connection != NULL);
-	g_return_if_fail (fd != NULL);
-	
-	if ((tag_file = tagsOpen_1 (fd, &tag_file_info)) == NULL)
-	{
-		g_warning ("error in opening ctags file");
-	}
+
+	/* is it the slice of a buffer? */
+	if (fake_file_on_db != NULL)
+		priv->current_buffer_range = g_hash_table_lookup (priv->buffer_ranges,
+		                                                  fake_file_on_db);
 
 #ifdef DEBUG
 	if (sym_timer_DEBUG == NULL)
 		sym_timer_DEBUG = g_timer_new ();
 	else
-		g_timer_reset (sym_timer_DEBUG);	
+		g_timer_reset (sym_timer_DEBUG);
 	gint tags_num_DEBUG = 0;
-#endif	
-	tag_entry.file = NULL;
+#endif
 
-	while (tagsNext (tag_file, &tag_entry) != TagFailure)
+	for (i = 0; i < batch->entries->len; i++)
 	{
+		tagEntry *tag_entry = &g_array_index (batch->entries, tagEntry, i);
 		gint file_defined_id = 0;
-		if (tag_entry.file == NULL)
-		{
-			continue;
-		}
+
 		if (file_defined_id_cache > 0)
 		{
-			if (g_str_equal (tag_entry.file, tag_entry_file_cache))
+			if (g_str_equal (tag_entry->file, tag_entry_file_cache))
 			{
 				file_defined_id = file_defined_id_cache;
 			}
@@ -817,16 +1170,16 @@ sdb_engine_populate_db_by_tags (SymbolDBEngine * dbe, FILE* fd,
 			file_defined_id = sdb_engine_get_file_defined_id (dbe,
 															  base_prj_path,
 															  fake_file_on_db,
-															  &tag_entry);
+															  tag_entry);
 			file_defined_id_cache = file_defined_id;
 			g_free (tag_entry_file_cache);
-			tag_entry_file_cache = g_strdup (tag_entry.file);
+			tag_entry_file_cache = g_strdup (tag_entry->file);
 		}
-		
+
 		if (priv->symbols_scanned_count++ % BATCH_SYMBOL_NUMBER == 0)
 		{
 			GError *error = NULL;
-			
+
 			/* if we aren't at the first cycle then we can commit the transaction */
 			if (priv->symbols_scanned_count > 1)
 			{
@@ -840,256 +1193,394 @@ sdb_engine_populate_db_by_tags (SymbolDBEngine * dbe, FILE* fd,
 					error = NULL;
 				}
 			}
-			
+
 			gda_connection_begin_transaction (priv->db_connection, "symboltrans",
 						GDA_TRANSACTION_ISOLATION_READ_UNCOMMITTED, &error);
-			
+
 			if (error)
 			{
 				DEBUG_PRINT ("err: %s", error->message);
 				g_error_free (error);
 				error = NULL;
-			}			
+			}
 		}
-		
+
+		if (priv->current_buffer_range != NULL)
+			tag_entry->address.lineNumber += priv->current_buffer_range->line_offset;
+
 		/* insert or update a symbol */
-		sdb_engine_add_new_symbol (dbe, &tag_entry, file_defined_id,
-								   force_sym_update);
+		sdb_engine_add_new_symbol (dbe, tag_entry, file_defined_id,
+								   batch->force_sym_update);
 #ifdef DEBUG
 		tags_num_DEBUG++;
-#endif		
-		tag_entry.file = NULL;
+#endif
 	}
 	g_free (tag_entry_file_cache);
-	
-	
+	priv->current_buffer_range = NULL;
+
+
 #ifdef DEBUG
 	gdouble elapsed_DEBUG = g_timer_elapsed (sym_timer_DEBUG, NULL);
 	tags_total_DEBUG += tags_num_DEBUG;
 	elapsed_total_DEBUG += elapsed_DEBUG;
 /*	DEBUG_PRINT ("elapsed: %f for (%d) [%f sec/symbol] [av %f sec/symbol]", elapsed_DEBUG,
-				 tags_num_DEBUG, elapsed_DEBUG / tags_num_DEBUG, 
+				 tags_num_DEBUG, elapsed_DEBUG / tags_num_DEBUG,
 				 elapsed_total_DEBUG / tags_total_DEBUG);
-*/				 
+*/
 #endif
-	
+
 	/* notify listeners that another file has been scanned */
 	DBESignal *dbesig = g_slice_new0 (DBESignal);
 	dbesig->value = GINT_TO_POINTER (SINGLE_FILE_SCAN_END +1);
 	dbesig->process_id = priv->current_scan_process_id;
-	
+
 	g_async_queue_push (priv->signals_aqueue, dbesig);
-	
-	/* we've done with tag_file but we don't need to tagsClose (tag_file); */
 }
 
-/* ~~~ Thread note: this function locks the mutex ~~~ */ 
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * Queue a signal for the ids. real_signal is the per symbol signal, the ids
+ * are emitted at once with the matching batched signal.
+ */
 static void
-sdb_engine_ctags_output_thread (gpointer data, gpointer user_data)
+sdb_engine_queue_symbols_signal (SymbolDBEngine *dbe, gint real_signal, 
+                                 GArray *ids)
 {
-	gint len_chars;
-	gchar *chars, *chars_ptr;
-	gint remaining_chars;
-	gint len_marker;
 	SymbolDBEnginePriv *priv;
-	SymbolDBEngine *dbe;
-	
-	chars = chars_ptr = (gchar *)data;
-	dbe = SYMBOL_DB_ENGINE (user_data);
-	
-	g_return_if_fail (dbe != NULL);	
-	g_return_if_fail (chars_ptr != NULL);
+	DBESignal *dbesig1;
+	DBESignal *dbesig2;
 
 	priv = dbe->priv;
 
-	SDB_LOCK(priv);
-	
-	remaining_chars = len_chars = strlen (chars_ptr);
-	len_marker = strlen (CTAGS_MARKER);	
+	dbesig1 = g_slice_new (DBESignal);
+	dbesig1->value = GINT_TO_POINTER (real_signal + 1);
+	dbesig1->process_id = priv->current_scan_process_id;
 
-	/*DEBUG_PRINT ("program output [new version]: ==>%s<==", chars);*/
-	if (len_chars >= len_marker) 
-	{
-		gchar *marker_ptr = NULL;
-		gint tmp_str_length = 0;
+	dbesig2 = g_slice_new (DBESignal);
+	dbesig2->value = ids;
+	dbesig2->process_id = priv->current_scan_process_id;
 
-		/* is it an end file marker? */
-		marker_ptr = strstr (chars_ptr, CTAGS_MARKER);
+	/* we must be sure to insert both signals at once */
+	g_async_queue_lock (priv->signals_aqueue);
+	g_async_queue_push_unlocked (priv->signals_aqueue, dbesig1);
+	g_async_queue_push_unlocked (priv->signals_aqueue, dbesig2);
+	g_async_queue_unlock (priv->signals_aqueue);
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * Empty ids_aqueue, queueing a signal every SYMBOLS_SIGNAL_IDS ids.
+ */
+static void
+sdb_engine_queue_symbols_ids (SymbolDBEngine *dbe, GAsyncQueue *ids_aqueue,
+                              gint real_signal)
+{
+	GArray *ids = NULL;
+	gint symbol_id;
+
+	while ((symbol_id = GPOINTER_TO_INT(
+			g_async_queue_try_pop (ids_aqueue))) > 0)
+	{
+		if (ids == NULL)
+			ids = g_array_sized_new (FALSE, FALSE, sizeof (gint), 
+			                         SYMBOLS_SIGNAL_IDS);
+		g_array_append_val (ids, symbol_id);
 
-		do  
+		if (ids->len == SYMBOLS_SIGNAL_IDS)
 		{
-			if (marker_ptr != NULL) 
-			{
-				int scan_flag;
-				gchar *real_file;
-		
-				/* set the length of the string parsed */
-				tmp_str_length = marker_ptr - chars_ptr;
-	
-				/* write to shm_file all the chars_ptr received without the marker ones */
-				fwrite (chars_ptr, sizeof(gchar), tmp_str_length, priv->shared_mem_file);
+			sdb_engine_queue_symbols_signal (dbe, real_signal, ids);
+			ids = NULL;
+		}
+	}
 
-				chars_ptr = marker_ptr + len_marker;
-				remaining_chars -= (tmp_str_length + len_marker);
-				fflush (priv->shared_mem_file);
-				
-				/* get the scan flag from the queue. We need it to know whether
-				 * an update of symbols must be done or not */
-				DBESignal *dbesig = g_async_queue_try_pop (priv->scan_aqueue);
-				scan_flag = GPOINTER_TO_INT(dbesig->value);
-				g_slice_free (DBESignal, dbesig);
-
-				dbesig = g_async_queue_try_pop (priv->scan_aqueue);
-				real_file = dbesig->value;
-				g_slice_free (DBESignal, dbesig);
-				
-				/* and now call the populating function */
-				if (scan_flag == DO_UPDATE_SYMS ||
-					scan_flag == DO_UPDATE_SYMS_AND_EXIT)
-				{
-					sdb_engine_populate_db_by_tags (dbe, priv->shared_mem_file,
-								(gsize)real_file == DONT_FAKE_UPDATE_SYMS ? NULL : real_file, 
-								TRUE);
-				}
-				else 
-				{
-					sdb_engine_populate_db_by_tags (dbe, priv->shared_mem_file,
-								(gsize)real_file == DONT_FAKE_UPDATE_SYMS ? NULL : real_file, 
-								FALSE);					
-				}
-				
-				/* don't forget to free the real_file, if it's a char */
-				if ((gsize)real_file != DONT_FAKE_UPDATE_SYMS)
-					g_free (real_file);
-				
-				/* check also if, together with an end file marker, we have an 
-				 * end group-of-files end marker.
-				 */
-				if (scan_flag == DO_UPDATE_SYMS_AND_EXIT || 
-					 scan_flag == DONT_UPDATE_SYMS_AND_EXIT )
-				{
-					gint tmp_inserted;
-					gint tmp_updated;
+	if (ids != NULL)
+		sdb_engine_queue_symbols_signal (dbe, real_signal, ids);
+}
 
-					/* scan has ended. Go go with second step. */
-					DEBUG_PRINT ("%s", "FOUND end-of-group-files marker.");
-					
-					chars_ptr += len_marker;
-					remaining_chars -= len_marker;
-					
-					/* will emit symbol_scope_updated and will flush on disk 
-					 * tablemaps
-					 */
-					sdb_engine_second_pass_do (dbe);					
-					
-					/* Here we are. It's the right time to notify the listeners
-					 * about out fresh new inserted/updated symbols...
-					 * Go on by emitting them.
-					 */
-					while ((tmp_inserted = GPOINTER_TO_INT(
-							g_async_queue_try_pop (priv->inserted_syms_id_aqueue))) > 0)
-					{
-						/* we must be sure to insert both signals at once */
-						g_async_queue_lock (priv->signals_aqueue);
-
-						DBESignal *dbesig1 = g_slice_new0 (DBESignal);
-						DBESignal *dbesig2 = g_slice_new0 (DBESignal);
-						
-						dbesig1->value = GINT_TO_POINTER (SYMBOL_INSERTED + 1);
-						dbesig1->process_id = priv->current_scan_process_id;
-
-						dbesig2->value = GINT_TO_POINTER (tmp_inserted);
-						dbesig2->process_id = priv->current_scan_process_id;
-						
-						g_async_queue_push_unlocked (priv->signals_aqueue, 
-													 dbesig1);
-						g_async_queue_push_unlocked (priv->signals_aqueue, 
-													 dbesig2);
-						
-						g_async_queue_unlock (priv->signals_aqueue);
-					}
-						
-					while ((tmp_updated = GPOINTER_TO_INT(
-							g_async_queue_try_pop (priv->updated_syms_id_aqueue))) > 0)
-					{
-						g_async_queue_lock (priv->signals_aqueue);
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * All the files of the scan scan_id have been populated: go on with the second
+ * pass and queue the symbols signals.
+ */
+static void
+sdb_engine_scan_group_end (SymbolDBEngine *dbe, gint scan_id)
+{
+	SymbolDBEnginePriv *priv;
 
-						DBESignal *dbesig1 = g_slice_new0 (DBESignal);
-						DBESignal *dbesig2 = g_slice_new0 (DBESignal);
+	priv = dbe->priv;
 
-						dbesig1->value = GINT_TO_POINTER (SYMBOL_UPDATED + 1);
-						dbesig1->process_id = priv->current_scan_process_id;
+	/* scan has ended. Go go with second step. */
+	DEBUG_PRINT ("%s", "FOUND end-of-group-files marker.");
 
-						dbesig2->value = GINT_TO_POINTER (tmp_updated);
-						dbesig2->process_id = priv->current_scan_process_id;
-						
-						g_async_queue_push_unlocked (priv->signals_aqueue, dbesig1);
-						g_async_queue_push_unlocked (priv->signals_aqueue, dbesig2);
-						g_async_queue_unlock (priv->signals_aqueue);
-					}
+	/* bulk rows are all committed: the raw connection isn't needed anymore */
+	sdb_engine_bulk_close (dbe);
 
-					while ((tmp_updated = GPOINTER_TO_INT(
-							g_async_queue_try_pop (priv->updated_scope_syms_id_aqueue))) > 0)
-					{
-						g_async_queue_lock (priv->signals_aqueue);
-
-						DBESignal *dbesig1 = g_slice_new0 (DBESignal);
-						DBESignal *dbesig2 = g_slice_new0 (DBESignal);
-
-						dbesig1->value = GINT_TO_POINTER (SYMBOL_SCOPE_UPDATED + 1);
-						dbesig1->process_id = priv->current_scan_process_id;
-
-						dbesig2->value = GINT_TO_POINTER (tmp_updated);
-						dbesig2->process_id = priv->current_scan_process_id;
-						
-						g_async_queue_push_unlocked (priv->signals_aqueue, dbesig1);
-						g_async_queue_push_unlocked (priv->signals_aqueue, dbesig2);
-						g_async_queue_unlock (priv->signals_aqueue);
-					}		
-										
-#ifdef DEBUG	
-					if (priv->first_scan_timer_DEBUG != NULL)
-					{
-						DEBUG_PRINT ("~~~~~ TOTAL FIRST SCAN elapsed: %f ",
-						    g_timer_elapsed (priv->first_scan_timer_DEBUG, NULL));
-						g_timer_destroy (priv->first_scan_timer_DEBUG);
-						priv->first_scan_timer_DEBUG = NULL;
-					}
+	/* will emit symbol_scope_updated and will flush on disk
+	 * tablemaps
+	 */
+	sdb_engine_second_pass_do (dbe);
+
+	/* Here we are. It's the right time to notify the listeners
+	 * about out fresh new inserted/updated symbols...
+	 * Go on by emitting them.
+	 */
+	sdb_engine_queue_symbols_ids (dbe, priv->inserted_syms_id_aqueue,
+	                              SYMBOL_INSERTED);
+	sdb_engine_queue_symbols_ids (dbe, priv->updated_syms_id_aqueue,
+	                              SYMBOL_UPDATED);
+	sdb_engine_queue_symbols_ids (dbe, priv->updated_scope_syms_id_aqueue,
+	                              SYMBOL_SCOPE_UPDATED);
+
+#ifdef DEBUG
+	if (priv->first_scan_timer_DEBUG != NULL)
+	{
+		DEBUG_PRINT ("~~~~~ TOTAL FIRST SCAN elapsed: %f ",
+		    g_timer_elapsed (priv->first_scan_timer_DEBUG, NULL));
+		g_timer_destroy (priv->first_scan_timer_DEBUG);
+		priv->first_scan_timer_DEBUG = NULL;
+	}
 #endif
-		
-					DBESignal *dbesig1 = g_slice_new0 (DBESignal);
 
-					dbesig1->value = GINT_TO_POINTER (SCAN_END + 1);
-					dbesig1->process_id = priv->current_scan_process_id;
-					
-					g_async_queue_push (priv->signals_aqueue, dbesig1);
-				}
-				
+	DBESignal *dbesig1 = g_slice_new0 (DBESignal);
+
+	dbesig1->value = GINT_TO_POINTER (SCAN_END + 1);
+	dbesig1->process_id = scan_id;
+
+	g_async_queue_push (priv->signals_aqueue, dbesig1);
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * One more file of the scan scan_id has been written or skipped, whether ctags
+ * found some tags in it or not. The last one ends the scan.
+ */
+static void
+sdb_engine_scan_file_done (SymbolDBEngine *dbe, gint scan_id)
+{
+	SymbolDBEnginePriv *priv;
+	gint pending;
+
+	priv = dbe->priv;
+
+	pending = GPOINTER_TO_INT (g_hash_table_lookup (priv->scan_files_pending,
+	                                                GINT_TO_POINTER (scan_id)));
+	if (pending <= 0)
+	{
+		g_warning ("File written for the unknown scan %d", scan_id);
+		return;
+	}
+
+	if (pending > 1)
+	{
+		g_hash_table_insert (priv->scan_files_pending, GINT_TO_POINTER (scan_id),
+		                     GINT_TO_POINTER (pending - 1));
+		return;
+	}
+
+	g_hash_table_remove (priv->scan_files_pending, GINT_TO_POINTER (scan_id));
+	sdb_engine_scan_group_end (dbe, scan_id);
+}
+
+/**
+ * ~~~ Thread note: this function locks the mutex ~~~
+ *
+ * The single db writer. Batches come from all the ctags workers, in any order.
+ * The last file of the scan triggers the second pass.
+ */
+static void
+sdb_engine_ctags_writer_thread (gpointer data, gpointer user_data)
+{
+	SdbTagBatch *batch;
+	SymbolDBEnginePriv *priv;
+	SymbolDBEngine *dbe;
+
+	batch = (SdbTagBatch *)data;
+	dbe = SYMBOL_DB_ENGINE (user_data);
+
+	g_return_if_fail (dbe != NULL);
+	g_return_if_fail (batch != NULL);
+
+	priv = dbe->priv;
+
+	SDB_LOCK(priv);
+
+	/* the signals queued while writing belong to the scan of the batch */
+	priv->current_scan_process_id = batch->scan_id;
+
+	if (batch->skipped == FALSE)
+	{
+		/* nothing to update on first population: take the fast path, unless
+		 * the libgda symboltrans transaction is open and locks the db */
+		if (priv->is_first_population == FALSE ||
+		    priv->bulk_population == FALSE ||
+		    batch->force_sym_update == TRUE ||
+		    priv->symbols_scanned_count > 0 ||
+		    sdb_engine_bulk_populate_db_by_tags (dbe, batch) == FALSE)
+		{
+			sdb_engine_populate_db_by_tags (dbe, batch);
+		}
+	}
+
+	sdb_engine_scan_file_done (dbe, batch->scan_id);
+
+	SDB_UNLOCK(priv);
+
+	sdb_engine_tag_batch_free (batch);
+}
+
+/**
+ * ~~~ Thread note: this function does not need the mutex lock ~~~
+ *
+ * Every worker has its own exclusive thread: the chunks of its stream are
+ * handled in order, while the workers parse their tags concurrently. Parsed
+ * batches are then handed to the writer thread.
+ */
+static void
+sdb_engine_ctags_output_thread (gpointer data, gpointer user_data)
+{
+	gint len_chars;
+	gchar *chars_ptr;
+	gint remaining_chars;
+	gint len_marker;
+	SymbolDBEnginePriv *priv;
+	SymbolDBEngine *dbe;
+	SdbCtagsWorker *worker;
+	GString *chunk;
+
+	chunk = (GString *)data;
+	worker = (SdbCtagsWorker *)user_data;
+	dbe = worker->dbe;
+
+	g_return_if_fail (dbe != NULL);
+	g_return_if_fail (chunk != NULL);
+
+	if (worker->binary)
+	{
+		sdb_engine_ctags_output_read_stream (worker, chunk);
+		g_string_free (chunk, TRUE);
+		g_atomic_int_add (&worker->chunks_pending, -1);
+		return;
+	}
+
+	chars_ptr = chunk->str;
+	priv = dbe->priv;
+
+	remaining_chars = len_chars = strlen (chars_ptr);
+	len_marker = strlen (CTAGS_MARKER);
+
+	/*DEBUG_PRINT ("program output [new version]: ==>%s<==", chars_ptr);*/
+	if (len_chars >= len_marker)
+	{
+		gchar *marker_ptr = NULL;
+		gint tmp_str_length = 0;
+
+		/* is it an end file marker? */
+		marker_ptr = strstr (chars_ptr, CTAGS_MARKER);
+
+		do
+		{
+			if (marker_ptr != NULL)
+			{
+				SdbTagBatch *batch;
+
+				/* set the length of the string parsed */
+				tmp_str_length = marker_ptr - chars_ptr;
+
+				/* write to shm_file all the chars_ptr received without the marker ones */
+				fwrite (chars_ptr, sizeof(gchar), tmp_str_length,
+						worker->shared_mem_file);
+
+				chars_ptr = marker_ptr + len_marker;
+				remaining_chars -= (tmp_str_length + len_marker);
+				fflush (worker->shared_mem_file);
+
+				batch = sdb_engine_ctags_worker_next_batch (worker);
+
+				/* parse here, out of the lock */
+				sdb_engine_tag_batch_read (batch, worker->shared_mem_file);
+
 				/* truncate the file to 0 length */
-				ftruncate (priv->shared_mem_fd, 0);				
+				ftruncate (worker->shared_mem_fd, 0);
+
+				/* and now let the writer populate the db */
+				g_thread_pool_push (priv->thread_pool, batch, NULL);
 			}
 			else
-			{ 
+			{
 				/* marker_ptr is NULL here. We should then exit the loop. */
 				/* write to shm_file all the chars received */
-				fwrite (chars_ptr, sizeof(gchar), remaining_chars, 
-						priv->shared_mem_file);
+				fwrite (chars_ptr, sizeof(gchar), remaining_chars,
+						worker->shared_mem_file);
 
-				fflush (priv->shared_mem_file);
+				fflush (worker->shared_mem_file);
 				break;
 			}
 
-			/* found out a new marker */ 
+			/* found out a new marker */
 			marker_ptr = strstr (marker_ptr + len_marker, CTAGS_MARKER);
 		} while (remaining_chars + len_marker < len_chars || marker_ptr != NULL);
 	}
-	
-	SDB_UNLOCK(priv);
-	
-	g_free (chars);
+
+	g_string_free (chunk, TRUE);
+	g_atomic_int_add (&worker->chunks_pending, -1);
 }
 
 
+static gboolean
+sdb_engine_ctags_workers_are_idle (SymbolDBEngine *dbe)
+{
+	SymbolDBEnginePriv *priv;
+	gint i;
+
+	priv = dbe->priv;
+	for (i = 0; i < CTAGS_WORKERS_MAX; i++)
+	{
+		SdbCtagsWorker *worker = priv->ctags_workers[i];
+
+		if (worker == NULL)
+			continue;
+
+		/* the exclusive thread of the pool is never stopped, so its chunks
+		 * are counted instead */
+		if (g_atomic_int_get (&worker->chunks_pending) > 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Emit the ids queued after a symbols signal at once. The per symbol signal is
+ * emitted for each id only if somebody is connected to it.
+ */
+static void
+sdb_engine_emit_symbols_signal (SymbolDBEngine *dbe, gint batch_signal,
+                                gint symbol_signal)
+{
+	DBESignal *dbesig2;
+	GArray *ids;
+
+	dbesig2 = g_async_queue_try_pop (dbe->priv->signals_aqueue);
+	ids = (GArray *)dbesig2->value;
+	g_slice_free (DBESignal, dbesig2);
+
+	g_signal_emit (dbe, signals[batch_signal], 0, ids);
+
+	if (g_signal_has_handler_pending (dbe, signals[symbol_signal], 0, FALSE))
+	{
+		gint i;
+
+		for (i = 0; i < ids->len; i++)
+			g_signal_emit (dbe, signals[symbol_signal], 0, 
+			               g_array_index (ids, gint, i));
+	}
+
+	g_array_unref (ids);
+}
+
 /**
  * This function runs on the main glib thread, so that it can safely spread signals 
  */
@@ -1139,6 +1630,10 @@ sdb_engine_timeout_trigger_signals (gpointer user_data)
 				{
 					/* reset count */
 					priv->symbols_scanned_count = 0;
+					if (priv->bulk_symbols_count > 0)
+						DEBUG_PRINT ("%" G_GSIZE_FORMAT " symbols bulk inserted",
+									 priv->bulk_symbols_count);
+					priv->bulk_symbols_count = 0;
 
 					DEBUG_PRINT ("Committing symboltrans transaction...");
 					gda_connection_commit_transaction (priv->db_connection, "symboltrans",
@@ -1160,47 +1655,23 @@ sdb_engine_timeout_trigger_signals (gpointer user_data)
 					break;
 	
 				case SYMBOL_INSERTED:
-				{
-					DBESignal *dbesig2; 
-					
-					dbesig2 = g_async_queue_try_pop (priv->signals_aqueue);
-					g_signal_emit (dbe, signals[SYMBOL_INSERTED], 0, dbesig2->value);
-
-					g_slice_free (DBESignal, dbesig2);
-				}
+					sdb_engine_emit_symbols_signal (dbe, SYMBOLS_INSERTED,
+					                                SYMBOL_INSERTED);
 					break;
 	
 				case SYMBOL_UPDATED:
-				{
-					DBESignal *dbesig2;
-					
-					dbesig2 = g_async_queue_try_pop (priv->signals_aqueue);
-					g_signal_emit (dbe, signals[SYMBOL_UPDATED], 0, dbesig2->value);
-
-					g_slice_free (DBESignal, dbesig2);
-				}
+					sdb_engine_emit_symbols_signal (dbe, SYMBOLS_UPDATED,
+					                                SYMBOL_UPDATED);
 					break;
 	
 				case SYMBOL_SCOPE_UPDATED:
-				{
-					DBESignal *dbesig2;
-					
-					dbesig2 = g_async_queue_try_pop (priv->signals_aqueue);
-					g_signal_emit (dbe, signals[SYMBOL_SCOPE_UPDATED], 0, dbesig2->value);
-
-					g_slice_free (DBESignal, dbesig2);
-				}
+					sdb_engine_emit_symbols_signal (dbe, SYMBOLS_UPDATED,
+					                                SYMBOL_SCOPE_UPDATED);
 					break;
 	
 				case SYMBOL_REMOVED:
-				{
-					DBESignal *dbesig2;
-					
-					dbesig2 = g_async_queue_try_pop (priv->signals_aqueue);
-					g_signal_emit (dbe, signals[SYMBOL_REMOVED], 0, dbesig2->value);
-
-					g_slice_free (DBESignal, dbesig2);					
-				}
+					sdb_engine_emit_symbols_signal (dbe, SYMBOLS_REMOVED,
+					                                SYMBOL_REMOVED);
 					break;
 			}
 
@@ -1213,9 +1684,16 @@ sdb_engine_timeout_trigger_signals (gpointer user_data)
 		priv->trigger_closure_retries++;
 	}
 	
-	if (priv->thread_pool != NULL &&
+	/* signals queued by the writer after the loop above are left for the
+	 * next run. A scan may still have files waiting for their info, so keep
+	 * on until its scan-end has been emitted */
+	if (priv->is_scanning == FALSE &&
+	    priv->thread_pool != NULL &&
+	    sdb_engine_ctags_workers_are_idle (dbe) == TRUE &&
 	    g_thread_pool_unprocessed (priv->thread_pool) == 0 &&
-		g_thread_pool_get_num_threads (priv->thread_pool) == 0)
+		g_thread_pool_get_num_threads (priv->thread_pool) == 0 &&
+	    (priv->signals_aqueue == NULL ||
+	     g_async_queue_length (priv->signals_aqueue) == 0))
 	{
 		/* remove the trigger coz we don't need it anymore... */
 		g_source_remove (priv->timeout_trigger_handler);
@@ -1226,31 +1704,71 @@ sdb_engine_timeout_trigger_signals (gpointer user_data)
 	return TRUE;
 }
 
+/**
+ * Start the signals monitor on the main thread, if it isn't running yet.
+ */
 static void
-sdb_engine_ctags_output_callback_1 (AnjutaLauncher * launcher,
-								  AnjutaLauncherOutputType output_type,
-								  const gchar * chars, gpointer user_data)
+sdb_engine_signals_monitor_start (SymbolDBEngine *dbe)
 {
-	SymbolDBEngine *dbe = (SymbolDBEngine *) user_data;
 	SymbolDBEnginePriv *priv;
 
-	g_return_if_fail (user_data != NULL);
-	
+	priv = dbe->priv;
+	if (priv->timeout_trigger_handler <= 0)
+	{
+		priv->timeout_trigger_handler = 
+			g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, TRIGGER_SIGNALS_DELAY, 
+						   sdb_engine_timeout_trigger_signals, dbe, NULL);
+		priv->trigger_closure_retries = 0;
+	}
+}
+
+static void
+sdb_engine_ctags_output_push (SdbCtagsWorker *worker, GString *chunk)
+{
+	SymbolDBEngine *dbe;
+	SymbolDBEnginePriv *priv;
+
+	dbe = worker->dbe;
 	priv = dbe->priv;	
 	
 	if (priv->shutting_down == TRUE)
+	{
+		g_string_free (chunk, TRUE);
 		return;
+	}
 
-	g_thread_pool_push (priv->thread_pool, g_strdup (chars), NULL);
+	g_atomic_int_inc (&worker->chunks_pending);
+	g_thread_pool_push (worker->output_pool, chunk, NULL);
 	
 	/* signals monitor */
-	if (priv->timeout_trigger_handler <= 0)
-	{
-		priv->timeout_trigger_handler = 
-			g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, TRIGGER_SIGNALS_DELAY, 
-						   sdb_engine_timeout_trigger_signals, user_data, NULL);
-		priv->trigger_closure_retries = 0;
-	}
+	sdb_engine_signals_monitor_start (dbe);
+}
+
+static void
+sdb_engine_ctags_output_callback_1 (AnjutaLauncher * launcher,
+								  AnjutaLauncherOutputType output_type,
+								  const gchar * chars, gpointer user_data)
+{
+	g_return_if_fail (user_data != NULL);
+
+	sdb_engine_ctags_output_push ((SdbCtagsWorker *) user_data, 
+	                              g_string_new (chars));
+}
+
+/* the binary tag stream can contain nul characters, it's read as it comes */
+static void
+sdb_engine_ctags_output_slice_callback (AnjutaLauncher * launcher,
+                                        AnjutaLauncherOutputType output_type,
+                                        const gchar * chars, gsize len,
+                                        gpointer user_data)
+{
+	g_return_if_fail (user_data != NULL);
+
+	if (output_type != ANJUTA_LAUNCHER_OUTPUT_STDOUT)
+		return;
+
+	sdb_engine_ctags_output_push ((SdbCtagsWorker *) user_data, 
+	                              g_string_new_len (chars, len));
 }
 
 static void
@@ -1274,61 +1792,201 @@ on_scan_files_end_1 (AnjutaLauncher * launcher, int child_pid,
 	priv->ctags_path = NULL;
 }
 
+static gboolean sdb_engine_ctags_worker_open_shm (SdbCtagsWorker *worker);
+
+/* the stream is chosen again on each launch, so that a change of ctags program
+ * or of symbol_db_engine_set_binary_tags () applies to the next child */
 static void
-sdb_engine_ctags_launcher_create (SymbolDBEngine * dbe)
+sdb_engine_ctags_launcher_create (SdbCtagsWorker *worker)
 {
 	SymbolDBEnginePriv *priv;
 	gchar *exe_string;
 		
-	priv = dbe->priv;
+	priv = worker->dbe->priv;
+
+	/* only anjuta-tags knows the binary stream, other ctags write text
+	 * through the shared memory file */
+	worker->binary = priv->binary_tags && priv->ctags_path != NULL &&
+		g_str_has_suffix (priv->ctags_path, "anjuta-tags");
+	if (worker->binary && worker->stream == NULL)
+		worker->stream = g_byte_array_new ();
+	else if (worker->binary)
+		g_byte_array_set_size (worker->stream, 0);
+	else if (!worker->binary && worker->shared_mem_file == NULL)
+		sdb_engine_ctags_worker_open_shm (worker);
 	
 	DEBUG_PRINT ("Creating anjuta_launcher with %s for %s", priv->ctags_path, 
 					priv->cnc_string);
 
-	priv->ctags_launcher = anjuta_launcher_new ();
+	worker->launcher = anjuta_launcher_new ();
 
-	anjuta_launcher_set_check_passwd_prompt (priv->ctags_launcher, FALSE);
-	anjuta_launcher_set_encoding (priv->ctags_launcher, NULL);
+	anjuta_launcher_set_check_passwd_prompt (worker->launcher, FALSE);
+	anjuta_launcher_set_encoding (worker->launcher, NULL);
 		
-	g_signal_connect (G_OBJECT (priv->ctags_launcher), "child-exited",
-						  G_CALLBACK (on_scan_files_end_1), dbe);
+	g_signal_connect (G_OBJECT (worker->launcher), "child-exited",
+						  G_CALLBACK (on_scan_files_end_1), worker->dbe);
 
-	exe_string = g_strdup_printf ("%s --sort=no --fields=afmiKlnsStTz --c++-kinds=+p "
-								  "--filter=yes --filter-terminator='"CTAGS_MARKER"'",
-								  priv->ctags_path);
+	if (worker->binary)
+	{
+		exe_string = g_strdup_printf ("%s --sort=no --fields=afmiKlnsStTz --c++-kinds=+p "
+									  "--filter=yes --binary=yes",
+									  priv->ctags_path);
+		anjuta_launcher_set_buffered_output (worker->launcher, FALSE);
+		anjuta_launcher_set_binary_output (worker->launcher, TRUE);
+		anjuta_launcher_set_slice_callback (worker->launcher,
+		                                    sdb_engine_ctags_output_slice_callback);
+	}
+	else
+	{
+		exe_string = g_strdup_printf ("%s --sort=no --fields=afmiKlnsStTz --c++-kinds=+p "
+									  "--filter=yes --filter-terminator='"CTAGS_MARKER"'",
+									  priv->ctags_path);
+	}
 	DEBUG_PRINT ("Launching %s", exe_string);
-	anjuta_launcher_execute (priv->ctags_launcher,
+	anjuta_launcher_execute (worker->launcher,
 								 exe_string, sdb_engine_ctags_output_callback_1, 
-								 dbe);
+								 worker);
 	g_free (exe_string);
 }
 
-/**
- * A GAsyncReadyCallback function. This function is the async continuation for
- * sdb_engine_scan_files_1 ().
- */
-static void  
-sdb_engine_scan_files_2 (GFile *gfile,
-                         GAsyncResult *res,
-                         gpointer user_data)
+/* create the shared memory file where the worker collects the tags of a file */
+static gboolean
+sdb_engine_ctags_worker_open_shm (SdbCtagsWorker *worker)
 {
-	ScanFiles1Data *sf_data = (ScanFiles1Data*)user_data;
-	SymbolDBEngine *dbe;
-	SymbolDBEnginePriv *priv;
-	GFileInfo *ginfo;
-	gchar *local_path;
-	gchar *real_file;
-	gboolean symbols_update;
-	gint partial_count;
-	gint files_list_len;
+	gchar *temp_file;
+	gint i = 0;
 
-	dbe = sf_data->dbe;
-	symbols_update = sf_data->symbols_update;
-	real_file = sf_data->real_file;
-	files_list_len = sf_data->files_list_len;
-	partial_count = sf_data->partial_count;
+	while (TRUE)
+	{
+		temp_file = g_strdup_printf ("/anjuta-%d_%ld%d.tags", getpid (),
+							 time (NULL), i++);
+		gchar *test;
+		test = g_strconcat (SHARED_MEMORY_PREFIX, temp_file, NULL);
+		if (g_file_test (test, G_FILE_TEST_EXISTS) == TRUE)
+		{
+			DEBUG_PRINT ("Temp file %s already exists... retrying", test);
+			g_free (test);
+			g_free (temp_file);
+			continue;
+		}
+		else
+		{
+			g_free (test);
+			break;
+		}
+	}
 
-	priv = dbe->priv;
+	worker->shared_mem_str = temp_file;
+	
+	if ((worker->shared_mem_fd = 
+		 shm_open (temp_file, O_CREAT|O_RDWR, S_IRUSR|S_IWUSR)) < 0)
+	{
+		g_warning ("Error while trying to open a shared memory file. Be"
+				   "sure to have "SHARED_MEMORY_PREFIX" mounted with tmpfs");
+		return FALSE;
+	}
+
+	worker->shared_mem_file = fdopen (worker->shared_mem_fd, "a+b");
+
+	/* no need to free temp_file (alias shared_mem_str). It will be freed
+	 * with the worker */
+	return TRUE;
+}
+
+static SdbCtagsWorker *
+sdb_engine_ctags_worker_new (SymbolDBEngine *dbe)
+{
+	SdbCtagsWorker *worker;
+
+	worker = g_new0 (SdbCtagsWorker, 1);
+	worker->dbe = dbe;
+
+	/* it will contain the scan flags and real files of the files sent to
+	 * this worker, in the same order of its output */
+	worker->scan_aqueue = g_async_queue_new ();
+
+	/* one exclusive thread: output chunks must be parsed in order */
+	worker->output_pool = g_thread_pool_new (sdb_engine_ctags_output_thread,
+											 worker, 1, TRUE, NULL);
+
+	sdb_engine_ctags_launcher_create (worker);
+
+	return worker;
+}
+
+static void
+sdb_engine_ctags_worker_free (SdbCtagsWorker *worker)
+{
+	/* disposing the launcher removes its output sources too */
+	if (worker->launcher)
+		g_object_unref (worker->launcher);
+
+	/* wait for the pending chunks */
+	g_thread_pool_free (worker->output_pool, TRUE, TRUE);
+
+	g_async_queue_unref (worker->scan_aqueue);
+
+	/* the tags of an unfinished file are dropped */
+	if (worker->batch)
+		sdb_engine_tag_batch_free (worker->batch);
+	if (worker->stream)
+		g_byte_array_free (worker->stream, TRUE);
+
+	if (worker->shared_mem_file)
+		fclose (worker->shared_mem_file);
+
+	if (worker->shared_mem_str)
+	{
+		shm_unlink (worker->shared_mem_str);
+		g_free (worker->shared_mem_str);
+	}
+
+	g_free (worker);
+}
+
+static void
+sdb_engine_ctags_workers_free (SymbolDBEngine *dbe)
+{
+	SymbolDBEnginePriv *priv;
+	gint i;
+
+	priv = dbe->priv;
+	for (i = 0; i < CTAGS_WORKERS_MAX; i++)
+	{
+		if (priv->ctags_workers[i] == NULL)
+			continue;
+
+		sdb_engine_ctags_worker_free (priv->ctags_workers[i]);
+		priv->ctags_workers[i] = NULL;
+	}
+}
+
+/**
+ * A GAsyncReadyCallback function. This function is the async continuation for
+ * sdb_engine_scan_files_1 ().
+ */
+static void  
+sdb_engine_scan_files_2 (GFile *gfile,
+                         GAsyncResult *res,
+                         gpointer user_data)
+{
+	ScanFiles1Data *sf_data = (ScanFiles1Data*)user_data;
+	SymbolDBEngine *dbe;
+	SymbolDBEnginePriv *priv;
+	SdbCtagsWorker *worker;
+	GFileInfo *ginfo;
+	gchar *local_path;
+	gchar *real_file;
+	gboolean symbols_update;
+	gint partial_count;
+	DBESignal *dbesig;
+
+	dbe = sf_data->dbe;
+	symbols_update = sf_data->symbols_update;
+	real_file = sf_data->real_file;
+	partial_count = sf_data->partial_count;
+
+	priv = dbe->priv;
 	
 	ginfo = g_file_query_info_finish (gfile, res, NULL);
 
@@ -1338,8 +1996,16 @@ sdb_engine_scan_files_2 (GFile *gfile,
 		g_file_info_get_attribute_boolean (ginfo, 
 								   G_FILE_ATTRIBUTE_ACCESS_CAN_READ) == FALSE)
 	{
+		SdbTagBatch *batch;
+		
 		g_warning ("File does not exist or is unreadable by user (%s)", local_path);
 
+		/* the writer must count it anyway, or the scan will never end */
+		batch = sdb_engine_tag_batch_new (NULL, FALSE);
+		batch->skipped = TRUE;
+		batch->scan_id = sf_data->scan_id;
+		g_thread_pool_push (priv->thread_pool, batch, NULL);
+
 		g_free (local_path);
 		g_free (real_file);
 		g_free (sf_data);
@@ -1350,85 +2016,42 @@ sdb_engine_scan_files_2 (GFile *gfile,
 			g_object_unref (gfile);
 		return;
 	}
+
+	/* files are sharded among the workers by their position in the list */
+	worker = priv->ctags_workers[partial_count % priv->scan_workers_active];
 	
 	/* DEBUG_PRINT ("sent to stdin %s", local_path); */
-	anjuta_launcher_send_stdin (priv->ctags_launcher, local_path);
-	anjuta_launcher_send_stdin (priv->ctags_launcher, "\n");
+	anjuta_launcher_send_stdin (worker->launcher, local_path);
+	anjuta_launcher_send_stdin (worker->launcher, "\n");
 	
-	if (symbols_update == TRUE) 
-	{
-		DBESignal *dbesig;
-		
-		/* will this be the last file in the list? */
-		if (partial_count + 1 >= files_list_len) 
-		{
-			dbesig = g_slice_new0 (DBESignal);
-			dbesig->value = GINT_TO_POINTER (DO_UPDATE_SYMS_AND_EXIT);
-			dbesig->process_id = priv->current_scan_process_id;
-			
-			/* yes */
-			g_async_queue_push (priv->scan_aqueue, dbesig);
-		}
-		else 
-		{
-			dbesig = g_slice_new0 (DBESignal);
-			dbesig->value = GINT_TO_POINTER (DO_UPDATE_SYMS);
-			dbesig->process_id = priv->current_scan_process_id;
-
-			/* no */
-			g_async_queue_push (priv->scan_aqueue, dbesig);
-		}
-	}
-	else 
-	{
-		DBESignal *dbesig;
-		
-		if (partial_count + 1 >= files_list_len) 
-		{
-			dbesig = g_slice_new0 (DBESignal);
-			dbesig->value = GINT_TO_POINTER (DONT_UPDATE_SYMS_AND_EXIT);
-			dbesig->process_id = priv->current_scan_process_id;
-			
-			/* yes */
-			g_async_queue_push (priv->scan_aqueue, dbesig);
-		}
-		else 
-		{
-			dbesig = g_slice_new0 (DBESignal);
-			dbesig->value = GINT_TO_POINTER (DONT_UPDATE_SYMS);
-			dbesig->process_id = priv->current_scan_process_id;
-			
-			/* no */
-			g_async_queue_push (priv->scan_aqueue, dbesig);
-		}
-	}
+	/* push the scan flag. We need it to know whether an update of symbols
+	 * must be done or not */
+	dbesig = g_slice_new0 (DBESignal);
+	dbesig->value = GINT_TO_POINTER (symbols_update == TRUE ? 
+	                                 DO_UPDATE_SYMS : DONT_UPDATE_SYMS);
+	dbesig->process_id = sf_data->scan_id;
+	
+	g_async_queue_push (worker->scan_aqueue, dbesig);
 
 	/* don't forget to add the real_files if the caller provided a list for
 	 * them! */
+	dbesig = g_slice_new0 (DBESignal);
+	dbesig->process_id = sf_data->scan_id;
+	
 	if (real_file != NULL)
 	{
-		DBESignal *dbesig;
-		
-		dbesig = g_slice_new0 (DBESignal);
 		dbesig->value = real_file;
-		dbesig->process_id = priv->current_scan_process_id;
-
-		g_async_queue_push (priv->scan_aqueue, dbesig);
 	}
 	else 
 	{
-		DBESignal *dbesig;
-		
-		dbesig = g_slice_new0 (DBESignal);
-		dbesig->value = GINT_TO_POINTER (DONT_FAKE_UPDATE_SYMS);
-		dbesig->process_id = priv->current_scan_process_id;
-		
 		/* else add a DONT_FAKE_UPDATE_SYMS marker, just to notify that this 
 		 * is not a fake file scan 
 		 */
-		g_async_queue_push (priv->scan_aqueue, dbesig);
+		dbesig->value = GINT_TO_POINTER (DONT_FAKE_UPDATE_SYMS);
 	}	
 	
+	g_async_queue_push (worker->scan_aqueue, dbesig);
+	
 	/* we don't need ginfo object anymore, bye */
 	g_object_unref (ginfo);
 	g_object_unref (gfile);
@@ -1485,6 +2108,9 @@ static gint sdb_sort_files_list (gconstpointer file1, gconstpointer file2)
  * database. On the above example we can have anjuta_XYZ.cxx mapped as /src/main.c 
  * on db. In this mode files_list and real_files_list must have the same size.
  *
+ * The files are sharded among up to ctags_workers_num anjuta-tags processes,
+ * each one with its own shared memory file. The tags are parsed by the workers
+ * in parallel, while the db is populated by the single writer thread.
  */
 static gboolean
 sdb_engine_scan_files_1 (SymbolDBEngine * dbe, const GPtrArray * files_list,
@@ -1496,70 +2122,43 @@ sdb_engine_scan_files_1 (SymbolDBEngine * dbe, const GPtrArray * files_list,
 
 	priv = dbe->priv;
 	
-	/* if ctags_launcher isn't initialized, then do it now. */
+	/* no need to spawn more anjuta-tags than files to scan */
+	priv->scan_workers_active = MIN (priv->ctags_workers_num, files_list->len);
+	
+	/* if ctags workers aren't initialized, then do it now. */
 	/* lazy initialization */
-	if (priv->ctags_launcher == NULL) 
+	for (i = 0; i < priv->scan_workers_active; i++)
 	{
-		sdb_engine_ctags_launcher_create (dbe);
+		if (priv->ctags_workers[i] == NULL)
+			priv->ctags_workers[i] = sdb_engine_ctags_worker_new (dbe);
 	}
-
 	
 	/* Enter scanning state */
 	priv->is_scanning = TRUE;
 
-	priv->current_scan_process_id = scan_id;
+	/* each scan counts its own files: the writer can still be busy with the
+	 * previous one */
+	SDB_LOCK(priv);
+	g_hash_table_insert (priv->scan_files_pending, GINT_TO_POINTER (scan_id),
+	                     GINT_TO_POINTER (files_list->len));
+	SDB_UNLOCK(priv);
 	
 	DBESignal *dbesig;
 
 	dbesig = g_slice_new0 (DBESignal);
 	dbesig->value = GINT_TO_POINTER (SCAN_BEGIN + 1);
-	dbesig->process_id = priv->current_scan_process_id;
+	dbesig->process_id = scan_id;
 	
 	g_async_queue_push (priv->signals_aqueue, dbesig);	
 
+	/* scan-end must be emitted even if no file produces any ctags output,
+	 * by example if all of them are unreadable */
+	sdb_engine_signals_monitor_start (dbe);
+
 #ifdef DEBUG	
 	if (priv->first_scan_timer_DEBUG == NULL)
 		priv->first_scan_timer_DEBUG = g_timer_new ();
 #endif	
-	
-	/* create the shared memory file */
-	if (priv->shared_mem_file == 0)
-	{
-		gchar *temp_file;
-		gint i = 0;
-		while (TRUE)
-		{
-			temp_file = g_strdup_printf ("/anjuta-%d_%ld%d.tags", getpid (),
-								 time (NULL), i++);
-			gchar *test;
-			test = g_strconcat (SHARED_MEMORY_PREFIX, temp_file, NULL);
-			if (g_file_test (test, G_FILE_TEST_EXISTS) == TRUE)
-			{
-				DEBUG_PRINT ("Temp file %s already exists... retrying", test);
-				g_free (test);
-				g_free (temp_file);
-				continue;
-			}
-			else
-			{
-				g_free (test);
-				break;
-			}
-		}
-
-		priv->shared_mem_str = temp_file;
-		
-		if ((priv->shared_mem_fd = 
-			 shm_open (temp_file, O_CREAT|O_RDWR, S_IRUSR|S_IWUSR)) < 0)
-		{
-			g_warning ("Error while trying to open a shared memory file. Be"
-					   "sure to have "SHARED_MEMORY_PREFIX" mounted with tmpfs");
-		}
-	
-		priv->shared_mem_file = fdopen (priv->shared_mem_fd, "a+b");
-
-		/* no need to free temp_file (alias shared_mem_str). It will be freed on plugin finalize */
-	}
 
 	/* Sort the files to have sources before headers */
 	g_ptr_array_sort (files_list, sdb_sort_files_list);
@@ -1576,9 +2175,9 @@ sdb_engine_scan_files_1 (SymbolDBEngine * dbe, const GPtrArray * files_list,
 		/* prepare an ojbect where to store some data for the async call */
 		sf_data = g_new0 (ScanFiles1Data, 1);
 		sf_data->dbe = dbe;
-		sf_data->files_list_len = files_list->len;
 		sf_data->partial_count = i;
 		sf_data->symbols_update = symbols_update;
+		sf_data->scan_id = scan_id;
 		
 		if (real_files_list != NULL)
 		{
@@ -1753,13 +2352,23 @@ sdb_engine_init (SymbolDBEngine * object)
 	 */
 	sdbe->priv->garbage_shared_mem_files = g_hash_table_new_full (g_str_hash, g_str_equal, 
 													  g_free, NULL);	
+
+	sdbe->priv->buffer_ranges = g_hash_table_new_full (g_str_hash, g_str_equal,
+											g_free, 
+											(GDestroyNotify)sdb_engine_buffer_range_free);
 	
-	sdbe->priv->ctags_launcher = NULL;
 	sdbe->priv->removed_launchers = NULL;
+	
+	/* one anjuta-tags worker per core */
+	sdbe->priv->ctags_workers_num = CLAMP (sysconf (_SC_NPROCESSORS_ONLN), 1,
+										   CTAGS_WORKERS_MAX);
+	sdbe->priv->binary_tags = TRUE;
+	sdbe->priv->bulk_population = TRUE;
 	sdbe->priv->shutting_down = FALSE;
 	sdbe->priv->is_first_population = FALSE;
 
 	sdbe->priv->symbols_scanned_count = 0;
+	sdbe->priv->bulk_symbols_count = 0;
 
 	/* set the ctags executable path to NULL */
 	sdbe->priv->ctags_path = NULL;
@@ -1772,16 +2381,14 @@ sdb_engine_init (SymbolDBEngine * object)
 	 * returned and emitted by scan-end.
 	 */
 	sdbe->priv->scan_process_id_sequence = sdbe->priv->current_scan_process_id = 1;
+	sdbe->priv->scan_files_pending = g_hash_table_new (g_direct_hash, 
+	                                                   g_direct_equal);
 	
-	/* the scan_aqueue? It will contain mainly 
-	 * ints that refer to the force_update status.
+	/* the thread pool for db population. Tags are parsed by the ctags workers
+	 * threads, but there must be just one writer.
 	 */
-	sdbe->priv->scan_aqueue = g_async_queue_new ();
-
-	/* the thread pool for tags scannning */
-	sdbe->priv->thread_pool = g_thread_pool_new (sdb_engine_ctags_output_thread,
-												 sdbe, THREADS_MAX_CONCURRENT,
-												 FALSE, NULL);
+	sdbe->priv->thread_pool = g_thread_pool_new (sdb_engine_ctags_writer_thread,
+												 sdbe, 1, FALSE, NULL);
 	
 	/* some signals queues */
 	sdbe->priv->signals_aqueue = g_async_queue_new ();
@@ -2048,6 +2655,60 @@ sdb_engine_init (SymbolDBEngine * object)
 	    			  WHERE project_name = ## /* name:'prjname' type:gchararray */) AND \
 	    	file_path = ## /* name:'filepath' type:gchararray */");
 	
+	/* -- buffer ranges -- */
+	STATIC_QUERY_POPULATE_INIT_NODE(sdbe->priv->static_query_list, 
+	 								PREP_QUERY_GET_TOP_SYMBOL_LINE_BEFORE,
+	 	"SELECT file_position FROM symbol WHERE \
+	    	file_defined_id = (SELECT file_id FROM file \
+	    						WHERE file_path = ## /* name:'filepath' type:gchararray */) AND \
+	    	scope_id <= 0 AND \
+	    	file_position <= ## /* name:'fileline' type:gint */ \
+	 	 ORDER BY file_position DESC LIMIT 1");
+
+	STATIC_QUERY_POPULATE_INIT_NODE(sdbe->priv->static_query_list, 
+	 								PREP_QUERY_GET_TOP_SYMBOL_LINE_AFTER,
+	 	"SELECT file_position FROM symbol WHERE \
+	    	file_defined_id = (SELECT file_id FROM file \
+	    						WHERE file_path = ## /* name:'filepath' type:gchararray */) AND \
+	    	scope_id <= 0 AND \
+	    	file_position > ## /* name:'fileline' type:gint */ \
+	 	 ORDER BY file_position ASC LIMIT 1");
+
+	STATIC_QUERY_POPULATE_INIT_NODE(sdbe->priv->static_query_list, 
+	 								PREP_QUERY_GET_SYMBOL_LINE_BEFORE,
+	 	"SELECT file_position FROM symbol WHERE \
+	    	file_defined_id = (SELECT file_id FROM file \
+	    						WHERE file_path = ## /* name:'filepath' type:gchararray */) AND \
+	    	file_position < ## /* name:'fileline' type:gint */ \
+	 	 ORDER BY file_position DESC LIMIT 1");
+
+	STATIC_QUERY_POPULATE_INIT_NODE(sdbe->priv->static_query_list, 
+	 								PREP_QUERY_GET_SYMBOLS_IN_RANGE,
+	 	"SELECT symbol_id, file_position, is_file_scope, signature, returntype, \
+	 			kind_id, access_kind_id, implementation_kind_id FROM symbol WHERE \
+	    	file_defined_id = (SELECT file_id FROM file \
+	    						WHERE file_path = ## /* name:'filepath' type:gchararray */) AND \
+	    	file_position >= ## /* name:'startline' type:gint */ AND \
+	    	(## /* name:'endline' type:gint */ < 0 OR \
+	    	 file_position <= ## /* name:'endline' type:gint */)");
+
+	STATIC_QUERY_POPULATE_INIT_NODE(sdbe->priv->static_query_list, 
+	 								PREP_QUERY_FLAG_SYMBOLS_OUT_OF_RANGE,
+	 	"UPDATE symbol SET update_flag = 1 WHERE \
+	    	file_defined_id = (SELECT file_id FROM file \
+	    						WHERE file_path = ## /* name:'filepath' type:gchararray */) AND \
+	    	(file_position < ## /* name:'startline' type:gint */ OR \
+	    	 (## /* name:'endline' type:gint */ >= 0 AND \
+	    	  file_position > ## /* name:'endline' type:gint */))");
+
+	STATIC_QUERY_POPULATE_INIT_NODE(sdbe->priv->static_query_list, 
+	 								PREP_QUERY_SHIFT_SYMBOLS_AFTER_LINE,
+	 	"UPDATE symbol SET \
+	 		file_position = file_position + ## /* name:'linesdelta' type:gint */ WHERE \
+	    	file_defined_id = (SELECT file_id FROM file \
+	    						WHERE file_path = ## /* name:'filepath' type:gchararray */) AND \
+	    	file_position > ## /* name:'endline' type:gint */");
+	
 	/* init cache hashtables */
 	sdb_engine_init_caches (sdbe);
 
@@ -2079,18 +2740,15 @@ sdb_engine_finalize (GObject * object)
 	g_signal_handler_disconnect (dbe, priv->waiting_scan_handler);
 	priv->waiting_scan_handler = 0;
 //*/
+	/* workers first: they feed the writer pool */
+	sdb_engine_ctags_workers_free (dbe);
+	
 	if (priv->thread_pool)
 	{
 		g_thread_pool_free (priv->thread_pool, TRUE, TRUE);
 		priv->thread_pool = NULL;
 	}
 	
-	if (priv->ctags_launcher)
-	{
-		g_object_unref (priv->ctags_launcher);
-		priv->ctags_launcher = NULL;
-	}		
-	
 	if (priv->removed_launchers)
 	{
 		g_list_foreach (priv->removed_launchers, 
@@ -2113,12 +2771,6 @@ sdb_engine_finalize (GObject * object)
 	
 	sdb_engine_free_cached_queries (dbe);
 	
-	if (priv->scan_aqueue)
-	{
-		g_async_queue_unref (priv->scan_aqueue);
-		priv->scan_aqueue = NULL;
-	}
-	
 	if (priv->updated_syms_id_aqueue)
 	{
 		g_async_queue_unref (priv->updated_syms_id_aqueue);
@@ -2143,19 +2795,6 @@ sdb_engine_finalize (GObject * object)
 		priv->waiting_scan_aqueue = NULL;
 	}
 	
-	if (priv->shared_mem_file) 
-	{
-		fclose (priv->shared_mem_file);
-		priv->shared_mem_file = NULL; 
-	}	
-	
-	if (priv->shared_mem_str)
-	{
-		shm_unlink (priv->shared_mem_str);
-		g_free (priv->shared_mem_str);
-		priv->shared_mem_str = NULL;
-	}
-	
 	if (priv->garbage_shared_mem_files)
 	{
 		g_hash_table_foreach (priv->garbage_shared_mem_files, 
@@ -2164,11 +2803,19 @@ sdb_engine_finalize (GObject * object)
 		/* destroy the hash table */
 		g_hash_table_destroy (priv->garbage_shared_mem_files);
 	}
+
+	if (priv->buffer_ranges)
+		g_hash_table_destroy (priv->buffer_ranges);
+	priv->buffer_ranges = NULL;
 	
 
 	if (priv->sym_type_conversion_hash)
 		g_hash_table_destroy (priv->sym_type_conversion_hash);
 	priv->sym_type_conversion_hash = NULL;
+
+	if (priv->scan_files_pending)
+		g_hash_table_destroy (priv->scan_files_pending);
+	priv->scan_files_pending = NULL;
 	
 	if (priv->signals_aqueue)
 		g_async_queue_unref (priv->signals_aqueue);
@@ -2279,6 +2926,41 @@ sdb_engine_class_init (SymbolDBEngineClass * klass)
 						g_cclosure_marshal_VOID__INT, G_TYPE_NONE, 
 						1,
 						G_TYPE_INT);	
+
+	/* The batched signals carry a GArray of gint symbol ids. They are emitted 
+	 * before the per symbol signals above, which are emitted only when a 
+	 * handler is connected to them. The symbols whose scope has been updated
+	 * are carried by symbols-updated too, symbol-scope-updated being their
+	 * only per symbol signal. */
+	signals[SYMBOLS_INSERTED]
+		= g_signal_new ("symbols-inserted",
+						G_OBJECT_CLASS_TYPE (object_class),
+						G_SIGNAL_RUN_LAST,
+						G_STRUCT_OFFSET (SymbolDBEngineClass, symbols_inserted),
+						NULL, NULL,
+						g_cclosure_marshal_VOID__BOXED, G_TYPE_NONE, 
+						1,
+						G_TYPE_ARRAY | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+	signals[SYMBOLS_UPDATED]
+		= g_signal_new ("symbols-updated",
+						G_OBJECT_CLASS_TYPE (object_class),
+						G_SIGNAL_RUN_LAST,
+						G_STRUCT_OFFSET (SymbolDBEngineClass, symbols_updated),
+						NULL, NULL,
+						g_cclosure_marshal_VOID__BOXED, G_TYPE_NONE, 
+						1,
+						G_TYPE_ARRAY | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+	signals[SYMBOLS_REMOVED]
+		= g_signal_new ("symbols-removed",
+						G_OBJECT_CLASS_TYPE (object_class),
+						G_SIGNAL_RUN_LAST,
+						G_STRUCT_OFFSET (SymbolDBEngineClass, symbols_removed),
+						NULL, NULL,
+						g_cclosure_marshal_VOID__BOXED, G_TYPE_NONE, 
+						1,
+						G_TYPE_ARRAY | G_SIGNAL_TYPE_STATIC_SCOPE);
 }   
 
 GType
@@ -2308,6 +2990,33 @@ sdb_engine_get_type (void)
 	return our_type;
 }
 
+static void
+sdb_engine_ctags_launchers_recreate (SymbolDBEngine *dbe)
+{
+	SymbolDBEnginePriv *priv;
+	gint i;
+
+	priv = dbe->priv;
+
+	/* are anjutalaunchers already created? */
+	for (i = 0; i < CTAGS_WORKERS_MAX; i++)
+	{
+		SdbCtagsWorker *worker = priv->ctags_workers[i];
+		AnjutaLauncher *tmp;
+
+		if (worker == NULL || worker->launcher == NULL)
+			continue;
+		
+		tmp = worker->launcher;
+
+		/* recreate it on the fly */
+		sdb_engine_ctags_launcher_create (worker);
+
+		/* keep the launcher alive to avoid crashes */
+		priv->removed_launchers = g_list_prepend (priv->removed_launchers, tmp);
+	}	
+}
+
 /**
  * symbol_db_engine_set_ctags_path:
  * @dbe: self
@@ -2343,64 +3052,136 @@ symbol_db_engine_set_ctags_path (SymbolDBEngine * dbe, const gchar * ctags_path)
 	/* free the old value */
 	g_free (priv->ctags_path);
 	
-	/* is anjutalauncher already created? */
-	if (priv->ctags_launcher != NULL)
-	{
-		AnjutaLauncher *tmp;
-		tmp = priv->ctags_launcher;
-
-		/* recreate it on the fly */
-		sdb_engine_ctags_launcher_create (dbe);
-
-		/* keep the launcher alive to avoid crashes */
-		priv->removed_launchers = g_list_prepend (priv->removed_launchers, tmp);
-	}	
-	
 	/* set the new one */
 	priv->ctags_path = g_strdup (ctags_path);	
+
+	sdb_engine_ctags_launchers_recreate (dbe);
+	
 	return TRUE;
 }
 
 /**
- * symbol_db_engine_new: 
- * @ctags_path Anjuta-tags executable. It is mandatory. No NULL value is accepted.
+ * symbol_db_engine_set_ctags_workers:
+ * @dbe: self
+ * @workers_num: number of anjuta-tags processes, between 1 and 
+ * CTAGS_WORKERS_MAX.
  * 
- * Create a new instance of an engine. 
- * Default name of database is ANJUTA_DB_FILE (see symbol-db-engine-priv.h)
+ * Set how many anjuta-tags processes share the files of a scan. The default is
+ * the number of online processors. It can be changed only when the engine is
+ * not scanning.
  *
- * Returns: a new SymbolDBEngine object.
- */
-SymbolDBEngine *
-symbol_db_engine_new (const gchar * ctags_path)
+ * Returns: TRUE if the set is successful.
+ */ 
+gboolean
+symbol_db_engine_set_ctags_workers (SymbolDBEngine * dbe, gint workers_num)
 {
-	SymbolDBEngine *sdbe;
 	SymbolDBEnginePriv *priv;
+
+	g_return_val_if_fail (dbe != NULL, FALSE);
+	g_return_val_if_fail (workers_num > 0, FALSE);
 	
-	g_return_val_if_fail (ctags_path != NULL, NULL);
-	sdbe = g_object_new (SYMBOL_TYPE_DB_ENGINE, NULL);
-	
-	priv = sdbe->priv;
-	priv->mutex = g_mutex_new ();
-	priv->anjuta_db_file = g_strdup (ANJUTA_DB_FILE);
+	priv = dbe->priv;
 
-	/* set the mandatory ctags_path */
-	if (!symbol_db_engine_set_ctags_path (sdbe, ctags_path))
-	{
-		return NULL;
-	}
-		
-	return sdbe;
+	if (symbol_db_engine_is_scanning (dbe) == TRUE)
+		return FALSE;
+	
+	/* exceeding workers are lazily created on next scan, the others are
+	 * just left idle */
+	priv->ctags_workers_num = MIN (workers_num, CTAGS_WORKERS_MAX);
+	return TRUE;
 }
 
 /**
- * symbol_db_engine_new_full:
- * @ctags_path: Anjuta-tags executable. It is mandatory. No NULL value is accepted.
- * @database_name: name of resulting db on disk.
+ * symbol_db_engine_set_binary_tags:
+ * @dbe: self
+ * @binary: TRUE to read the binary tag stream of anjuta-tags.
  * 
- * Similar to symbol_db_engine_new() but you can specify the name of resulting db.
- */
-SymbolDBEngine* 
-symbol_db_engine_new_full (const gchar * ctags_path, const gchar * database_name)
+ * Set whether anjuta-tags writes its tags as a binary stream parsed directly
+ * from the pipe, or as text parsed through a shared memory file. The default 
+ * is the binary stream, other ctags programs always write text. It can be 
+ * changed only when the engine is not scanning: the anjuta-tags processes
+ * already running are launched again with the new stream.
+ *
+ * Returns: TRUE if the set is successful.
+ */ 
+gboolean
+symbol_db_engine_set_binary_tags (SymbolDBEngine * dbe, gboolean binary)
+{
+	SymbolDBEnginePriv *priv;
+
+	g_return_val_if_fail (dbe != NULL, FALSE);
+	
+	priv = dbe->priv;
+
+	if (symbol_db_engine_is_scanning (dbe) == TRUE)
+		return FALSE;
+
+	if (priv->binary_tags == binary)
+		return TRUE;
+
+	/* the running workers switch on their next launch, now */
+	priv->binary_tags = binary;
+	sdb_engine_ctags_launchers_recreate (dbe);
+	return TRUE;
+}
+
+/**
+ * symbol_db_engine_set_bulk_population:
+ * @dbe: self
+ * @bulk: TRUE to write the first population through raw sqlite3 statements.
+ * 
+ * Set whether the symbols of the first population are written with multi-row
+ * sqlite3 inserts or through libgda like the later updates. The default is
+ * the bulk insertion, when symbol-db is built with sqlite3.
+ */ 
+void
+symbol_db_engine_set_bulk_population (SymbolDBEngine * dbe, gboolean bulk)
+{
+	g_return_if_fail (dbe != NULL);
+
+	dbe->priv->bulk_population = bulk;
+}
+
+/**
+ * symbol_db_engine_new: 
+ * @ctags_path Anjuta-tags executable. It is mandatory. No NULL value is accepted.
+ * 
+ * Create a new instance of an engine. 
+ * Default name of database is ANJUTA_DB_FILE (see symbol-db-engine-priv.h)
+ *
+ * Returns: a new SymbolDBEngine object.
+ */
+SymbolDBEngine *
+symbol_db_engine_new (const gchar * ctags_path)
+{
+	SymbolDBEngine *sdbe;
+	SymbolDBEnginePriv *priv;
+	
+	g_return_val_if_fail (ctags_path != NULL, NULL);
+	sdbe = g_object_new (SYMBOL_TYPE_DB_ENGINE, NULL);
+	
+	priv = sdbe->priv;
+	priv->mutex = g_mutex_new ();
+	priv->anjuta_db_file = g_strdup (ANJUTA_DB_FILE);
+
+	/* set the mandatory ctags_path */
+	if (!symbol_db_engine_set_ctags_path (sdbe, ctags_path))
+	{
+		return NULL;
+	}
+		
+	return sdbe;
+}
+
+/**
+ * symbol_db_engine_new_full:
+ * @ctags_path: Anjuta-tags executable. It is mandatory. No NULL value is accepted.
+ * @database_name: name of resulting db on disk.
+ * 
+ * Similar to symbol_db_engine_new() but you can specify the name of resulting db.
+ */
+SymbolDBEngine* 
+symbol_db_engine_new_full (const gchar * ctags_path, const gchar * database_name)
 {
 	SymbolDBEngine* dbe;
 	SymbolDBEnginePriv* priv;
@@ -2516,6 +3297,191 @@ symbol_db_engine_is_scanning (SymbolDBEngine *dbe)
 	return dbe->priv->is_scanning;
 }
 
+/**
+ * symbol_db_engine_has_name_index:
+ * @dbe: self
+ * 
+ * Check if the trigram index on symbol names is available. It's missing if the
+ * sqlite library hasn't been built with fts5 or is older than 3.34, which
+ * brought the trigram tokenizer.
+ * 
+ * Returns: TRUE if symbol_name_fts can be queried.
+ */
+gboolean
+symbol_db_engine_has_name_index (SymbolDBEngine *dbe)
+{
+	g_return_val_if_fail (SYMBOL_IS_DB_ENGINE (dbe), FALSE);
+	return dbe->priv->has_name_index;
+}
+
+static gboolean
+sdb_engine_detect_name_index (SymbolDBEngine *dbe)
+{
+	GdaDataModel *data_model;
+
+	/* fails if the table is missing, or if it has been created by a sqlite
+	 * with fts5 and the one in use lacks it */
+	data_model = sdb_engine_execute_select_sql (dbe, 
+						"SELECT rowid FROM symbol_name_fts LIMIT 1");
+	if (data_model == NULL)
+		return FALSE;
+
+	g_object_unref (data_model);
+	
+	return TRUE;
+}
+
+/*
+ * Statements creating symbol_name_fts, the trigram index on symbol names. It's
+ * an external content table, kept in sync by the triggers. The first statement
+ * fails if sqlite lacks fts5 or the trigram tokenizer (sqlite < 3.34): searches
+ * do without the index then.
+ */
+static const gchar *name_index_sql[] =
+{
+	"CREATE VIRTUAL TABLE symbol_name_fts USING fts5 (name, content = 'symbol', "
+	"content_rowid = 'symbol_id', tokenize = 'trigram')",
+	"CREATE TRIGGER symbol_name_fts_insert_trg AFTER INSERT ON symbol "
+	"FOR EACH ROW BEGIN "
+	"INSERT INTO symbol_name_fts (rowid, name) VALUES (new.symbol_id, new.name); "
+	"END",
+	"CREATE TRIGGER symbol_name_fts_delete_trg AFTER DELETE ON symbol "
+	"FOR EACH ROW BEGIN "
+	"INSERT INTO symbol_name_fts (symbol_name_fts, rowid, name) "
+	"VALUES ('delete', old.symbol_id, old.name); "
+	"END",
+	"CREATE TRIGGER symbol_name_fts_update_trg AFTER UPDATE OF name ON symbol "
+	"FOR EACH ROW BEGIN "
+	"INSERT INTO symbol_name_fts (symbol_name_fts, rowid, name) "
+	"VALUES ('delete', old.symbol_id, old.name); "
+	"INSERT INTO symbol_name_fts (rowid, name) VALUES (new.symbol_id, new.name); "
+	"END"
+};
+
+static void
+sdb_engine_drop_name_index (SymbolDBEngine *dbe)
+{
+	/* the triggers would make every write on symbol fail without the table */
+	sdb_engine_execute_non_select_sql (dbe, 
+				"DROP TRIGGER IF EXISTS symbol_name_fts_insert_trg");
+	sdb_engine_execute_non_select_sql (dbe, 
+				"DROP TRIGGER IF EXISTS symbol_name_fts_delete_trg");
+	sdb_engine_execute_non_select_sql (dbe, 
+				"DROP TRIGGER IF EXISTS symbol_name_fts_update_trg");
+	sdb_engine_execute_non_select_sql (dbe, 
+				"DROP TABLE IF EXISTS symbol_name_fts");
+}
+
+/**
+ * Creates symbol_name_fts and its triggers, if sqlite supports them.
+ * 
+ * @return TRUE if the index has been created.
+ */
+static gboolean
+sdb_engine_create_name_index (SymbolDBEngine *dbe)
+{
+	SymbolDBEnginePriv *priv;
+	GdaStatement *stmt;
+	GError *error = NULL;
+	gint i;
+
+	priv = dbe->priv;
+
+	sdb_engine_drop_name_index (dbe);
+	for (i = 0; i < G_N_ELEMENTS (name_index_sql); i++)
+	{
+		stmt = gda_sql_parser_parse_string (priv->sql_parser, 
+		                                    name_index_sql[i], NULL, &error);
+		if (stmt != NULL)
+		{
+			gda_connection_statement_execute_non_select (priv->db_connection, stmt, 
+			                                             NULL, NULL, &error);
+			g_object_unref (stmt);
+		}
+
+		if (error != NULL)
+		{
+			DEBUG_PRINT ("No trigram index on symbol names: %s", error->message);
+			g_error_free (error);
+			sdb_engine_drop_name_index (dbe);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* 
+ * Statements bringing a db from 373.0 up to SYMBOL_DB_VERSION without throwing
+ * its symbols away. Each one is run if the db is older than its version.
+ * They must be kept in sync with tables.sql. symbol_name_fts, added by 374.0,
+ * is created apart by sdb_engine_create_name_index ().
+ */
+static const struct {
+	gdouble version;
+	const gchar *sql;
+} upgrade_sql[] = 
+{
+	{ 375.0,
+		"CREATE INDEX symbol_idx_4 ON symbol (file_defined_id, file_position)" }
+};
+
+/**
+ * Upgrades a db of at least version 373.0 in place.
+ * 
+ * @return FALSE if the db has to be recreated.
+ */
+static gboolean
+sdb_engine_upgrade_in_place (SymbolDBEngine *dbe, gdouble version)
+{
+	SymbolDBEnginePriv *priv;
+	GdaStatement *stmt;
+	GError *error = NULL;
+	gint i;
+
+	priv = dbe->priv;
+	
+	gda_connection_begin_transaction (priv->db_connection, "upgradetrans",
+	                                  GDA_TRANSACTION_ISOLATION_SERIALIZABLE, NULL);
+
+	/* index the symbols already there */
+	if (version < 374.0 && sdb_engine_create_name_index (dbe) == TRUE)
+	{
+		sdb_engine_execute_non_select_sql (dbe, 
+					"INSERT INTO symbol_name_fts (symbol_name_fts) VALUES ('rebuild')");
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (upgrade_sql); i++)
+	{
+		if (version >= upgrade_sql[i].version)
+			continue;
+		
+		stmt = gda_sql_parser_parse_string (priv->sql_parser, 
+		                                    upgrade_sql[i].sql, NULL, &error);
+		if (stmt != NULL)
+		{
+			gda_connection_statement_execute_non_select (priv->db_connection, stmt, 
+			                                             NULL, NULL, &error);
+			g_object_unref (stmt);
+		}
+
+		if (error != NULL)
+		{
+			g_warning ("Could not upgrade db: %s: %s", upgrade_sql[i].sql, 
+			           error->message);
+			g_error_free (error);
+			gda_connection_rollback_transaction (priv->db_connection, 
+			                                     "upgradetrans", NULL);
+			return FALSE;
+		}
+	}
+
+	sdb_engine_execute_non_select_sql (dbe, 
+						"UPDATE version SET sdb_version = "SYMBOL_DB_VERSION);
+	gda_connection_commit_transaction (priv->db_connection, "upgradetrans", NULL);
+	return TRUE;
+}
+
 /**
  * Creates required tables for the database to work.
  * Sets is_first_population flag to TRUE.
@@ -2546,6 +3512,8 @@ sdb_engine_create_db_tables (SymbolDBEngine * dbe, const gchar * tables_sql_file
 
 	sdb_engine_execute_non_select_sql (dbe, contents);	
 	g_free (contents);
+
+	sdb_engine_create_name_index (dbe);
 	
 	/* set the current symbol db database version. This may help if new tables/fields
 	 * are added/removed in future versions.
@@ -2658,6 +3626,7 @@ symbol_db_engine_close_db (SymbolDBEngine *dbe)
 	priv = dbe->priv;
 
 	/* terminate threads, if ever they're running... */
+	sdb_engine_ctags_workers_free (dbe);
 	g_thread_pool_free (priv->thread_pool, TRUE, TRUE);
 	priv->thread_pool = NULL;
 	ret = sdb_engine_disconnect_from_db (dbe);
@@ -2671,9 +3640,8 @@ symbol_db_engine_close_db (SymbolDBEngine *dbe)
 	g_free (priv->project_directory);
 	priv->project_directory = NULL;	
 	
-	priv->thread_pool = g_thread_pool_new (sdb_engine_ctags_output_thread,
-										   dbe, THREADS_MAX_CONCURRENT,
-										   FALSE, NULL);
+	priv->thread_pool = g_thread_pool_new (sdb_engine_ctags_writer_thread,
+										   dbe, 1, FALSE, NULL);
 	g_signal_emit_by_name (dbe, "db-disconnected", NULL);
 	return ret;
 }
@@ -2730,7 +3698,14 @@ sdb_engine_check_db_version_and_upgrade (SymbolDBEngine *dbe,
 		version = 0;
 	}
 		
-	if (version < atof (SYMBOL_DB_VERSION))
+	if (version < atof (SYMBOL_DB_VERSION) && version >= 373.0 &&
+	    sdb_engine_upgrade_in_place (dbe, version) == TRUE)
+	{
+		/* only indexes were added since 373.0: no need to rescan */
+		DEBUG_PRINT	 ("Upgraded in place from version %f to "SYMBOL_DB_VERSION,
+		              version);
+	}
+	else if (version < atof (SYMBOL_DB_VERSION))
 	{
 		DEBUG_PRINT	 ("Upgrading from version %f to "SYMBOL_DB_VERSION, version);
 		
@@ -2853,6 +3828,10 @@ symbol_db_engine_open_db (SymbolDBEngine * dbe, const gchar * base_db_path,
 	}
 	
 	sdb_engine_set_defaults_db_parameters (dbe);
+	/* searches fall back to a scan of symbol without symbol_name_fts */
+	priv->has_name_index = sdb_engine_detect_name_index (dbe);
+	if (priv->has_name_index == FALSE)
+		sdb_engine_drop_name_index (dbe);
 
 	g_free (cnc_string);
 	g_free (db_file);
@@ -4974,31 +5953,638 @@ sdb_engine_add_new_symbol (SymbolDBEngine * dbe, const tagEntry * tag_entry,
 		if (nrows > 0)
 		{
 			table_id = symbol_id;
-						
-			g_async_queue_push (priv->updated_syms_id_aqueue, GINT_TO_POINTER(table_id));
+
+			if (priv->current_buffer_range == NULL ||
+			    sdb_engine_buffer_range_symbol_changed (priv->current_buffer_range,
+			                                            symbol_id, file_position,
+			                                            is_file_scope, signature,
+			                                            returntype, kind_id,
+			                                            access_kind_id,
+			                                            implementation_kind_id))
+			{
+				g_async_queue_push (priv->updated_syms_id_aqueue, 
+				                    GINT_TO_POINTER(table_id));
+			}
 		}
 		else 
 		{
 			table_id = -1;
 		}
 	}
-	
-	if (last_inserted)
-		g_object_unref (last_inserted);	
+	
+	if (last_inserted)
+		g_object_unref (last_inserted);	
+
+	/* post population phase */
+	
+	/* before returning the table_id we have to fill some infoz on temporary tables
+	 * so that in a second pass we can parse also the heritage and scope fields.
+	 */	
+	if (table_id > 0)
+		sdb_engine_add_new_tmp_heritage_scope (dbe, tag_entry, table_id);
+
+	g_free (type_regex);
+	
+	return table_id;
+}
+
+#ifdef HAVE_SQLITE3
+/*
+ * Bulk population.
+ *
+ * On first population there's no symbol to update, so the per-row libgda
+ * machinery (lookups, GdaHolders, GValues) can be skipped. All the symbols of
+ * a file are staged in a struct-of-arrays buffer, ids are resolved from the
+ * in-memory caches and rows are written through raw prepared sqlite3
+ * statements with multi-row VALUES on a separate connection to the same db.
+ */
+typedef struct _SdbBulkSymbols {
+	guint len;
+	GArray *entry_index;
+	GArray *file_defined_id;
+	GPtrArray *name;
+	GArray *file_position;
+	GArray *is_file_scope;
+	GPtrArray *signature;
+	GPtrArray *returntype;
+	GArray *scope_definition_id;	/* 0 stands for NULL */
+	GPtrArray *type_type;
+	GPtrArray *type_name;
+	GArray *kind_id;
+	GArray *access_kind_id;
+	GArray *implementation_kind_id;
+	GArray *symbol_id;				/* 0 until inserted */
+
+	/* extracted type qualifiers */
+	GStringChunk *strings;
+
+} SdbBulkSymbols;
+
+static const gchar *bulk_stmts_sql[BULK_STMT_COUNT] = {
+	NULL,	/* BULK_STMT_SYMBOL_NEW_MULTI: built at runtime */
+	NULL,	/* BULK_STMT_SYMBOL_NEW: built at runtime */
+	"INSERT INTO scope (scope_name) VALUES (?)",
+	"SELECT scope_id FROM scope WHERE scope_name = ? LIMIT 1",
+	"BEGIN IMMEDIATE",
+	"COMMIT",
+	"ROLLBACK"
+};
+
+static gchar *
+sdb_engine_bulk_symbol_insert_sql (gint rows)
+{
+	GString *sql;
+	gint i;
+
+	sql = g_string_new ("INSERT INTO symbol (file_defined_id, name, file_position, "
+						"is_file_scope, signature, returntype, scope_definition_id, "
+						"scope_id, type_type, type_name, kind_id, access_kind_id, "
+						"implementation_kind_id, update_flag) VALUES ");
+	for (i = 0; i < rows; i++)
+	{
+		g_string_append (sql, i == 0 ? "(?,?,?,?,?,?,?,?,?,?,?,?,?,?)" :
+										",(?,?,?,?,?,?,?,?,?,?,?,?,?,?)");
+	}
+	return g_string_free (sql, FALSE);
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ */
+static void
+sdb_engine_bulk_close (SymbolDBEngine *dbe)
+{
+	SymbolDBEnginePriv *priv;
+	gint i;
+
+	priv = dbe->priv;
+
+	if (priv->bulk_db == NULL)
+		return;
+
+	for (i = 0; i < BULK_STMT_COUNT; i++)
+	{
+		if (priv->bulk_stmts[i] != NULL)
+			sqlite3_finalize (priv->bulk_stmts[i]);
+		priv->bulk_stmts[i] = NULL;
+	}
+
+	sqlite3_close (priv->bulk_db);
+	priv->bulk_db = NULL;
+
+	if (priv->bulk_scope_cache)
+		g_hash_table_destroy (priv->bulk_scope_cache);
+	priv->bulk_scope_cache = NULL;
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * Lazily open the raw connection and prepare its statements.
+ */
+static gboolean
+sdb_engine_bulk_open (SymbolDBEngine *dbe)
+{
+	SymbolDBEnginePriv *priv;
+	gchar *db_file;
+	gint i;
+
+	priv = dbe->priv;
+
+	if (priv->bulk_db != NULL)
+		return TRUE;
+
+	db_file = g_strdup_printf ("%s/%s.db", priv->db_directory,
+							   priv->anjuta_db_file);
+
+	if (sqlite3_open (db_file, &priv->bulk_db) != SQLITE_OK)
+	{
+		g_warning ("Could not open %s for bulk insertion: %s", db_file,
+				   sqlite3_errmsg (priv->bulk_db));
+		g_free (db_file);
+		sqlite3_close (priv->bulk_db);
+		priv->bulk_db = NULL;
+		return FALSE;
+	}
+	g_free (db_file);
+
+	/* same settings as sdb_engine_set_defaults_db_parameters () */
+	sqlite3_exec (priv->bulk_db, "PRAGMA synchronous = OFF", NULL, NULL, NULL);
+	/* a memory journal, as a failed file has to be rolled back */
+	sqlite3_exec (priv->bulk_db, "PRAGMA journal_mode = MEMORY", NULL, NULL, NULL);
+	sqlite3_exec (priv->bulk_db, "PRAGMA temp_store = MEMORY", NULL, NULL, NULL);
+	sqlite3_exec (priv->bulk_db, "PRAGMA foreign_keys = OFF", NULL, NULL, NULL);
+	/* the main libgda connection may be reading meanwhile */
+	sqlite3_busy_timeout (priv->bulk_db, 5000);
+
+	for (i = 0; i < BULK_STMT_COUNT; i++)
+	{
+		gchar *sql;
+		gint res;
+
+		if (i == BULK_STMT_SYMBOL_NEW_MULTI)
+			sql = sdb_engine_bulk_symbol_insert_sql (BULK_SYMBOL_ROWS);
+		else if (i == BULK_STMT_SYMBOL_NEW)
+			sql = sdb_engine_bulk_symbol_insert_sql (1);
+		else
+			sql = g_strdup (bulk_stmts_sql[i]);
+
+		res = sqlite3_prepare_v2 (priv->bulk_db, sql, -1, &priv->bulk_stmts[i],
+								  NULL);
+		g_free (sql);
+
+		if (res != SQLITE_OK)
+		{
+			g_warning ("Could not prepare bulk statement %d: %s", i,
+					   sqlite3_errmsg (priv->bulk_db));
+			sdb_engine_bulk_close (dbe);
+			return FALSE;
+		}
+	}
+
+	/* the db has just been created, so everything about scopes is here */
+	priv->bulk_scope_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+													g_free, NULL);
+	return TRUE;
+}
+
+static GNUC_INLINE gint
+sdb_engine_bulk_step (SymbolDBEngine *dbe, bulk_stmt_type stmt_type)
+{
+	sqlite3_stmt *stmt = dbe->priv->bulk_stmts[stmt_type];
+	gint res;
+
+	res = sqlite3_step (stmt);
+	sqlite3_reset (stmt);
+	sqlite3_clear_bindings (stmt);
+
+	return res;
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * Same as sdb_engine_add_new_scope_definition () but through the raw
+ * connection and the scope cache. Returns -1 if the db can't be written.
+ */
+static gint
+sdb_engine_bulk_add_scope_definition (SymbolDBEngine *dbe,
+									  const tagEntry *tag_entry)
+{
+	SymbolDBEnginePriv *priv;
+	sqlite3_stmt *stmt;
+	gint table_id;
+	gint res;
+
+	priv = dbe->priv;
+
+	/* filter out 'variable' and 'member' kinds. They define no scope. */
+	if (g_strcmp0 (tag_entry->kind, "variable") == 0 ||
+		g_strcmp0 (tag_entry->kind, "member") == 0)
+	{
+		/* like the CASE of PREP_QUERY_SYMBOL_NEW: take an already existing
+		 * scope with the same name, if any */
+		return GPOINTER_TO_INT (g_hash_table_lookup (priv->bulk_scope_cache,
+													 tag_entry->name));
+	}
+
+	if ((table_id = sdb_engine_cache_lookup (priv->bulk_scope_cache,
+											 tag_entry->name)) != -1)
+	{
+		return table_id;
+	}
+
+	stmt = priv->bulk_stmts[BULK_STMT_SCOPE_NEW];
+	sqlite3_bind_text (stmt, 1, tag_entry->name, -1, SQLITE_STATIC);
+
+	res = sdb_engine_bulk_step (dbe, BULK_STMT_SCOPE_NEW);
+	if (res == SQLITE_DONE)
+	{
+		table_id = sqlite3_last_insert_rowid (priv->bulk_db);
+	}
+	else if (res != SQLITE_CONSTRAINT)
+	{
+		return -1;
+	}
+	else
+	{
+		/* try to get an already existing scope */
+		stmt = priv->bulk_stmts[BULK_STMT_GET_SCOPE_ID];
+		sqlite3_bind_text (stmt, 1, tag_entry->name, -1, SQLITE_STATIC);
+
+		table_id = 0;
+		if (sqlite3_step (stmt) == SQLITE_ROW)
+			table_id = sqlite3_column_int (stmt, 0);
+
+		sqlite3_reset (stmt);
+		sqlite3_clear_bindings (stmt);
+	}
+
+	if (table_id > 0)
+		sdb_engine_insert_cache (priv->bulk_scope_cache, tag_entry->name, table_id);
+
+	return table_id;
+}
+
+static SdbBulkSymbols *
+sdb_engine_bulk_symbols_new (guint reserved)
+{
+	SdbBulkSymbols *syms = g_slice_new0 (SdbBulkSymbols);
+
+	syms->entry_index = g_array_sized_new (FALSE, FALSE, sizeof (guint), reserved);
+	syms->file_defined_id = g_array_sized_new (FALSE, FALSE, sizeof (gint), reserved);
+	syms->name = g_ptr_array_sized_new (reserved);
+	syms->file_position = g_array_sized_new (FALSE, FALSE, sizeof (gint), reserved);
+	syms->is_file_scope = g_array_sized_new (FALSE, FALSE, sizeof (gint), reserved);
+	syms->signature = g_ptr_array_sized_new (reserved);
+	syms->returntype = g_ptr_array_sized_new (reserved);
+	syms->scope_definition_id = g_array_sized_new (FALSE, FALSE, sizeof (gint), reserved);
+	syms->type_type = g_ptr_array_sized_new (reserved);
+	syms->type_name = g_ptr_array_sized_new (reserved);
+	syms->kind_id = g_array_sized_new (FALSE, FALSE, sizeof (gint), reserved);
+	syms->access_kind_id = g_array_sized_new (FALSE, FALSE, sizeof (gint), reserved);
+	syms->implementation_kind_id = g_array_sized_new (FALSE, FALSE, sizeof (gint), reserved);
+	syms->symbol_id = g_array_sized_new (FALSE, FALSE, sizeof (gint), reserved);
+	syms->strings = g_string_chunk_new (1024);
+
+	return syms;
+}
+
+static void
+sdb_engine_bulk_symbols_free (SdbBulkSymbols *syms)
+{
+	g_array_free (syms->entry_index, TRUE);
+	g_array_free (syms->file_defined_id, TRUE);
+	g_ptr_array_free (syms->name, TRUE);
+	g_array_free (syms->file_position, TRUE);
+	g_array_free (syms->is_file_scope, TRUE);
+	g_ptr_array_free (syms->signature, TRUE);
+	g_ptr_array_free (syms->returntype, TRUE);
+	g_array_free (syms->scope_definition_id, TRUE);
+	g_ptr_array_free (syms->type_type, TRUE);
+	g_ptr_array_free (syms->type_name, TRUE);
+	g_array_free (syms->kind_id, TRUE);
+	g_array_free (syms->access_kind_id, TRUE);
+	g_array_free (syms->implementation_kind_id, TRUE);
+	g_array_free (syms->symbol_id, TRUE);
+	g_string_chunk_free (syms->strings);
+
+	g_slice_free (SdbBulkSymbols, syms);
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * Stage a tag, resolving all of its ids but the scope definition one, which
+ * needs the bulk transaction.
+ */
+static void
+sdb_engine_bulk_symbols_stage (SymbolDBEngine *dbe, SdbBulkSymbols *syms,
+							   const tagEntry *tag_entry, guint entry_index,
+							   gint file_defined_id)
+{
+	const gchar *type_name;
+	const gint zero = 0;
+	gint file_position, is_file_scope, kind_id, access_kind_id,
+		implementation_kind_id;
+
+	if (g_strcmp0 (tag_entry->kind, "member") == 0 ||
+	    g_strcmp0 (tag_entry->kind, "variable") == 0 ||
+	    g_strcmp0 (tag_entry->kind, "field") == 0)
+	{
+		gchar *type_regex;
+
+		type_regex = sdb_engine_extract_type_qualifier (tag_entry->address.pattern,
+		                                                tag_entry->name);
+		/* if the extractor failed we should fallback to the default one */
+		if (type_regex != NULL)
+			type_name = g_string_chunk_insert (syms->strings, type_regex);
+		else
+			type_name = tag_entry->name;
+		g_free (type_regex);
+	}
+	else
+	{
+		type_name = tag_entry->name;
+	}
+
+	file_position = tag_entry->address.lineNumber;
+	is_file_scope = tag_entry->fileScope;
+
+	/* these ones are served by the kind/access/implementation caches */
+	kind_id = sdb_engine_add_new_sym_kind (dbe, tag_entry);
+	access_kind_id = sdb_engine_add_new_sym_access (dbe, tag_entry);
+	implementation_kind_id = sdb_engine_add_new_sym_implementation (dbe, tag_entry);
+
+	g_array_append_val (syms->entry_index, entry_index);
+	g_array_append_val (syms->file_defined_id, file_defined_id);
+	g_ptr_array_add (syms->name, (gpointer) tag_entry->name);
+	g_array_append_val (syms->file_position, file_position);
+	g_array_append_val (syms->is_file_scope, is_file_scope);
+	g_ptr_array_add (syms->signature, (gpointer) tagsField (tag_entry, "signature"));
+	g_ptr_array_add (syms->returntype, (gpointer) tagsField (tag_entry, "returntype"));
+	g_ptr_array_add (syms->type_type, (gpointer) tag_entry->kind);
+	g_ptr_array_add (syms->type_name, (gpointer) type_name);
+	g_array_append_val (syms->kind_id, kind_id);
+	g_array_append_val (syms->access_kind_id, access_kind_id);
+	g_array_append_val (syms->implementation_kind_id, implementation_kind_id);
+	g_array_append_val (syms->symbol_id, zero);
+
+	syms->len++;
+}
+
+static GNUC_INLINE void
+sdb_engine_bulk_bind_text (sqlite3_stmt *stmt, gint col, const gchar *text)
+{
+	if (text == NULL)
+		sqlite3_bind_null (stmt, col);
+	else
+		sqlite3_bind_text (stmt, col, text, -1, SQLITE_STATIC);
+}
+
+/* bind the staged row at offset 'row' in the VALUES list of stmt */
+static void
+sdb_engine_bulk_bind_row (sqlite3_stmt *stmt, SdbBulkSymbols *syms, guint i,
+						  gint row)
+{
+	gint col = row * 14;
+	gint scope_definition_id;
+
+	sqlite3_bind_int (stmt, col + 1, g_array_index (syms->file_defined_id, gint, i));
+	sdb_engine_bulk_bind_text (stmt, col + 2, g_ptr_array_index (syms->name, i));
+	sqlite3_bind_int (stmt, col + 3, g_array_index (syms->file_position, gint, i));
+	sqlite3_bind_int (stmt, col + 4, g_array_index (syms->is_file_scope, gint, i));
+	sdb_engine_bulk_bind_text (stmt, col + 5, g_ptr_array_index (syms->signature, i));
+	sdb_engine_bulk_bind_text (stmt, col + 6, g_ptr_array_index (syms->returntype, i));
+
+	scope_definition_id = g_array_index (syms->scope_definition_id, gint, i);
+	if (scope_definition_id > 0)
+		sqlite3_bind_int (stmt, col + 7, scope_definition_id);
+	else
+		sqlite3_bind_null (stmt, col + 7);
+
+	/* scope_id will be parsed in the second pass */
+	sqlite3_bind_int (stmt, col + 8, 0);
+	sdb_engine_bulk_bind_text (stmt, col + 9, g_ptr_array_index (syms->type_type, i));
+	sdb_engine_bulk_bind_text (stmt, col + 10, g_ptr_array_index (syms->type_name, i));
+	sqlite3_bind_int (stmt, col + 11, g_array_index (syms->kind_id, gint, i));
+	sqlite3_bind_int (stmt, col + 12, g_array_index (syms->access_kind_id, gint, i));
+	sqlite3_bind_int (stmt, col + 13,
+					  g_array_index (syms->implementation_kind_id, gint, i));
+	/* update_flag: symbols are all new */
+	sqlite3_bind_int (stmt, col + 14, 0);
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * Fill the tmp heritage table map and queue the symbol-inserted id, as
+ * sdb_engine_add_new_symbol () does.
+ */
+static GNUC_INLINE void
+sdb_engine_bulk_symbol_inserted (SymbolDBEngine *dbe, SdbTagBatch *batch,
+								 SdbBulkSymbols *syms, guint i, gint table_id)
+{
+	const tagEntry *tag_entry;
+
+	tag_entry = &g_array_index (batch->entries, tagEntry,
+								g_array_index (syms->entry_index, guint, i));
+
+	g_async_queue_push (dbe->priv->inserted_syms_id_aqueue,
+						GINT_TO_POINTER (table_id));
+	sdb_engine_add_new_tmp_heritage_scope (dbe, tag_entry, table_id);
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * Write the staged symbols, BULK_SYMBOL_ROWS at a time. The AUTOINCREMENT ids
+ * given by a single statement on a single connection, which holds the write
+ * lock, are contiguous: the ids of a multi-row insert are derived from the
+ * last one.
+ * Returns FALSE if a row couldn't be written for any other reason than a
+ * duplicate, the bulk transaction has then to be rolled back.
+ */
+static gboolean
+sdb_engine_bulk_symbols_flush (SymbolDBEngine *dbe, SdbBulkSymbols *syms)
+{
+	SymbolDBEnginePriv *priv;
+	sqlite3_stmt *stmt;
+	gint res;
+	guint i, j;
+
+	priv = dbe->priv;
+
+	i = 0;
+	while (i < syms->len)
+	{
+		guint rows = MIN (BULK_SYMBOL_ROWS, syms->len - i);
+		gboolean multi_done = FALSE;
+
+		if (rows == BULK_SYMBOL_ROWS)
+		{
+			stmt = priv->bulk_stmts[BULK_STMT_SYMBOL_NEW_MULTI];
+			for (j = 0; j < rows; j++)
+				sdb_engine_bulk_bind_row (stmt, syms, i + j, j);
+
+			res = sdb_engine_bulk_step (dbe, BULK_STMT_SYMBOL_NEW_MULTI);
+			if (res == SQLITE_DONE)
+			{
+				gint first_id = sqlite3_last_insert_rowid (priv->bulk_db) - rows + 1;
+
+				for (j = 0; j < rows; j++)
+					g_array_index (syms->symbol_id, gint, i + j) = first_id + j;
+				multi_done = TRUE;
+			}
+			else if (res != SQLITE_CONSTRAINT)
+				return FALSE;
+			/* else a row violates the unique index: go on row by row, so
+			 * that only that one is skipped */
+		}
+
+		if (multi_done == FALSE)
+		{
+			stmt = priv->bulk_stmts[BULK_STMT_SYMBOL_NEW];
+			for (j = 0; j < rows; j++)
+			{
+				sdb_engine_bulk_bind_row (stmt, syms, i + j, 0);
+
+				res = sdb_engine_bulk_step (dbe, BULK_STMT_SYMBOL_NEW);
+				if (res == SQLITE_DONE)
+					g_array_index (syms->symbol_id, gint, i + j) =
+						sqlite3_last_insert_rowid (priv->bulk_db);
+				else if (res != SQLITE_CONSTRAINT)
+					return FALSE;
+			}
+		}
+
+		i += rows;
+	}
+
+	return TRUE;
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * Bulk counterpart of sdb_engine_populate_db_by_tags (). It's used only on
+ * first population, when no symbol has to be updated.
+ */
+static gboolean
+sdb_engine_bulk_populate_db_by_tags (SymbolDBEngine * dbe, SdbTagBatch *batch)
+{
+	SymbolDBEnginePriv *priv;
+	SdbBulkSymbols *syms;
+	gint file_defined_id_cache = 0;
+	const gchar *tag_entry_file_cache = NULL;
+	gchar *base_prj_path;
+	guint i;
+
+	priv = dbe->priv;
+
+	if (sdb_engine_bulk_open (dbe) == FALSE)
+		return FALSE;
+
+	base_prj_path = batch->real_file == NULL ? priv->project_directory : NULL;
+	syms = sdb_engine_bulk_symbols_new (batch->entries->len);
+
+	/* resolve ids out of the bulk transaction: cache misses go through the
+	 * main connection */
+	for (i = 0; i < batch->entries->len; i++)
+	{
+		tagEntry *tag_entry = &g_array_index (batch->entries, tagEntry, i);
+		gint file_defined_id = 0;
+
+		if (file_defined_id_cache > 0 &&
+		    g_str_equal (tag_entry->file, tag_entry_file_cache))
+		{
+			file_defined_id = file_defined_id_cache;
+		}
+		else
+		{
+			file_defined_id = sdb_engine_get_file_defined_id (dbe,
+															  base_prj_path,
+															  batch->real_file,
+															  tag_entry);
+			file_defined_id_cache = file_defined_id;
+			tag_entry_file_cache = tag_entry->file;
+		}
+
+		sdb_engine_bulk_symbols_stage (dbe, syms, tag_entry, i, file_defined_id);
+	}
+
+	/* the db is busy, e.g. the main connection has written symbols */
+	if (sdb_engine_bulk_step (dbe, BULK_STMT_BEGIN) != SQLITE_DONE)
+	{
+		DEBUG_PRINT ("Bulk begin failed: %s", sqlite3_errmsg (priv->bulk_db));
+		sdb_engine_bulk_symbols_free (syms);
+		return FALSE;
+	}
+
+	for (i = 0; i < syms->len; i++)
+	{
+		const tagEntry *tag_entry;
+		gint scope_definition_id;
+
+		tag_entry = &g_array_index (batch->entries, tagEntry,
+									g_array_index (syms->entry_index, guint, i));
+		scope_definition_id = sdb_engine_bulk_add_scope_definition (dbe, tag_entry);
+		if (scope_definition_id < 0)
+			break;
+		g_array_append_val (syms->scope_definition_id, scope_definition_id);
+	}
+
+	if (i < syms->len ||
+	    sdb_engine_bulk_symbols_flush (dbe, syms) == FALSE ||
+	    sdb_engine_bulk_step (dbe, BULK_STMT_COMMIT) != SQLITE_DONE)
+	{
+		/* nothing of the file is kept, it's written again by the caller */
+		g_warning ("Bulk insertion failed, falling back: %s",
+				   sqlite3_errmsg (priv->bulk_db));
+		sdb_engine_bulk_step (dbe, BULK_STMT_ROLLBACK);
+		g_hash_table_remove_all (priv->bulk_scope_cache);
+		sdb_engine_bulk_symbols_free (syms);
+		return FALSE;
+	}
+
+	/* the ids are published only once they are committed */
+	for (i = 0; i < syms->len; i++)
+	{
+		gint table_id = g_array_index (syms->symbol_id, gint, i);
+
+		if (table_id > 0)
+			sdb_engine_bulk_symbol_inserted (dbe, batch, syms, i, table_id);
+	}
 
-	/* post population phase */
-	
-	/* before returning the table_id we have to fill some infoz on temporary tables
-	 * so that in a second pass we can parse also the heritage and scope fields.
-	 */	
-	if (table_id > 0)
-		sdb_engine_add_new_tmp_heritage_scope (dbe, tag_entry, table_id);
+	priv->bulk_symbols_count += syms->len;
+	sdb_engine_bulk_symbols_free (syms);
 
-	g_free (type_regex);
-	
-	return table_id;
+	/* notify listeners that another file has been scanned */
+	DBESignal *dbesig = g_slice_new0 (DBESignal);
+	dbesig->value = GINT_TO_POINTER (SINGLE_FILE_SCAN_END +1);
+	dbesig->process_id = priv->current_scan_process_id;
+
+	g_async_queue_push (priv->signals_aqueue, dbesig);
+
+	return TRUE;
+}
+
+#else
+
+/* without sqlite3, the first population goes through libgda too */
+static gboolean
+sdb_engine_bulk_populate_db_by_tags (SymbolDBEngine * dbe, SdbTagBatch *batch)
+{
+	return FALSE;
+}
+
+static void
+sdb_engine_bulk_close (SymbolDBEngine *dbe)
+{
 }
 
+#endif /* HAVE_SQLITE3 */
+
 /**
  * ### Thread note: this function inherits the mutex lock ### 
  *
@@ -5010,6 +6596,7 @@ sdb_engine_detects_removed_ids (SymbolDBEngine *dbe)
 	const GdaStatement *stmt1, *stmt2;
 	GdaDataModel *data_model;
 	SymbolDBEnginePriv *priv;
+	GArray *ids;
 	gint i, num_rows;	
 		
 	priv = dbe->priv;
@@ -5046,27 +6633,29 @@ sdb_engine_detects_removed_ids (SymbolDBEngine *dbe)
 	}
 
 	/* get and parse the results. */
+	ids = NULL;
 	for (i = 0; i < num_rows; i++) 
 	{
 		const GValue *val;
 		gint tmp;
 		val = gda_data_model_get_value_at (data_model, 0, i, NULL);
 		tmp = g_value_get_int (val);
-		DBESignal *dbesig1;
-		DBESignal *dbesig2;
 
-		dbesig1 = g_slice_new (DBESignal);
-		dbesig1->value = GINT_TO_POINTER (SYMBOL_REMOVED + 1);
-		dbesig1->process_id = priv->current_scan_process_id;
+		if (ids == NULL)
+			ids = g_array_sized_new (FALSE, FALSE, sizeof (gint), 
+			                         MIN (num_rows - i, SYMBOLS_SIGNAL_IDS));
+		g_array_append_val (ids, tmp);
 
-		dbesig2 = g_slice_new (DBESignal);
-		dbesig2->value = GINT_TO_POINTER (tmp);
-		dbesig2->process_id = priv->current_scan_process_id;
-		
-		g_async_queue_push (priv->signals_aqueue, dbesig1);
-		g_async_queue_push (priv->signals_aqueue, dbesig2);
+		if (ids->len == SYMBOLS_SIGNAL_IDS)
+		{
+			sdb_engine_queue_symbols_signal (dbe, SYMBOL_REMOVED, ids);
+			ids = NULL;
+		}
 	}
 
+	if (ids != NULL)
+		sdb_engine_queue_symbols_signal (dbe, SYMBOL_REMOVED, ids);
+
 	g_object_unref (data_model);
 	
 	/* let's clean the tmp_table */
@@ -5708,6 +7297,71 @@ on_scan_update_buffer_end (SymbolDBEngine * dbe, gint process_id, gpointer data)
 	data = files_to_scan = NULL;
 }
 
+/**
+ * Writes a buffer to a shared memory file named after relative_path, so that
+ * ctags sees the right language.
+ * 
+ * Returns: the path of the file, to be freed, or NULL on error.
+ */
+static gchar *
+sdb_engine_buffer_to_shared_mem (SymbolDBEngine *dbe, const gchar *relative_path,
+                                 const gchar *buffer, gsize buffer_size)
+{
+	SymbolDBEnginePriv *priv;
+	FILE *buffer_mem_file;
+	gint buffer_mem_fd;
+	gchar *shared_temp_file;
+	gchar *base_filename;
+	gchar *temp_file;
+
+	priv = dbe->priv;
+	
+	/* it's ok to have just the base filename to create the
+	 * target buffer one */
+	base_filename = g_filename_display_basename (relative_path);
+	
+	shared_temp_file = g_strdup_printf ("/anjuta-%d-%ld-%s", getpid (),
+					 time (NULL), base_filename);
+	g_free (base_filename);
+	
+	if ((buffer_mem_fd = 
+		 shm_open (shared_temp_file, O_CREAT|O_RDWR, S_IRUSR|S_IWUSR)) < 0)
+	{
+		g_warning ("Error while trying to open a shared memory file. Be"
+				   "sure to have "SHARED_MEMORY_PREFIX" mounted with tmpfs");
+		g_free (shared_temp_file);
+		return NULL;
+	}
+
+	buffer_mem_file = fdopen (buffer_mem_fd, "w+b");
+	
+	/* the file may be reused within the same second */
+	ftruncate (buffer_mem_fd, 0);
+	fwrite (buffer, sizeof(gchar), buffer_size, buffer_mem_file);
+	fflush (buffer_mem_file);
+	fclose (buffer_mem_file);
+	
+	temp_file = g_strdup_printf (SHARED_MEMORY_PREFIX"%s", shared_temp_file);
+	
+	/* check if we already have an entry stored in the hash table, else
+	 * insert it 
+	 */		
+	if (g_hash_table_lookup (priv->garbage_shared_mem_files, shared_temp_file) 
+		== NULL)
+	{
+		DEBUG_PRINT ("inserting into garbage hash table %s", shared_temp_file);
+		g_hash_table_insert (priv->garbage_shared_mem_files, shared_temp_file, 
+							 NULL);
+	}
+	else 
+	{
+		/* the item is already stored. Just free it here. */
+		g_free (shared_temp_file);
+	}
+
+	return temp_file;
+}
+
 /**
  * symbol_db_engine_update_buffer_symbols:
  * @dbe: self
@@ -5755,12 +7409,9 @@ symbol_db_engine_update_buffer_symbols (SymbolDBEngine * dbe, const gchar *proje
 	{
 		const gchar *relative_path;
 		const gchar *curr_abs_file;
-		FILE *buffer_mem_file;
 		const gchar *temp_buffer;
-		gint buffer_mem_fd;
 		gint temp_size;
 		gchar *shared_temp_file;
-		gchar *base_filename;
 		
 		curr_abs_file = g_ptr_array_index (real_files_list, i);
 		/* check if the file exists in db. We will not scan buffers for files
@@ -5781,50 +7432,16 @@ symbol_db_engine_update_buffer_symbols (SymbolDBEngine * dbe, const gchar *proje
 		}
 		g_ptr_array_add (real_files_on_db, (gpointer) relative_path);
 
-		/* it's ok to have just the base filename to create the
-		 * target buffer one */
-		base_filename = g_filename_display_basename (relative_path);
-		
-		shared_temp_file = g_strdup_printf ("/anjuta-%d-%ld-%s", getpid (),
-						 time (NULL), base_filename);
-		g_free (base_filename);
-		
-		if ((buffer_mem_fd = 
-			 shm_open (shared_temp_file, O_CREAT|O_RDWR, S_IRUSR|S_IWUSR)) < 0)
-		{
-			g_warning ("Error while trying to open a shared memory file. Be"
-					   "sure to have "SHARED_MEMORY_PREFIX" mounted with tmpfs");
-			return -1;
-		}
-	
-		buffer_mem_file = fdopen (buffer_mem_fd, "w+b");
-		
 		temp_buffer = g_ptr_array_index (text_buffers, i);
 		temp_size = GPOINTER_TO_INT(g_ptr_array_index (buffer_sizes, i));
-		
-		fwrite (temp_buffer, sizeof(gchar), temp_size, buffer_mem_file);
-		fflush (buffer_mem_file);
-		fclose (buffer_mem_file);
+
+		if ((shared_temp_file = sdb_engine_buffer_to_shared_mem (dbe, relative_path,
+		                                                         temp_buffer,
+		                                                         temp_size)) == NULL)
+			return -1;
 		
 		/* add the temp file to the array. */
-		g_ptr_array_add (temp_files, g_strdup_printf (SHARED_MEMORY_PREFIX"%s", 
-													  shared_temp_file));
-		
-		/* check if we already have an entry stored in the hash table, else
-		 * insert it 
-		 */		
-		if (g_hash_table_lookup (priv->garbage_shared_mem_files, shared_temp_file) 
-			== NULL)
-		{
-			DEBUG_PRINT ("inserting into garbage hash table %s", shared_temp_file);
-			g_hash_table_insert (priv->garbage_shared_mem_files, shared_temp_file, 
-								 NULL);
-		}
-		else 
-		{
-			/* the item is already stored. Just free it here. */
-			g_free (shared_temp_file);
-		}
+		g_ptr_array_add (temp_files, shared_temp_file);
 	}
 
 	/* in case we didn't have any good buffer to scan...*/
@@ -5855,6 +7472,382 @@ symbol_db_engine_update_buffer_symbols (SymbolDBEngine * dbe, const gchar *proje
 	return ret_id;
 }
 
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * Sets the parameters of the buffer ranges queries which are there.
+ */
+static void
+sdb_engine_set_buffer_range_params (GdaSet *plist, const gchar *file_on_db,
+                                    gint start_line, gint end_line, 
+                                    gint lines_delta)
+{
+	GdaHolder *param;
+	GValue v = {0};
+
+	if ((param = gda_set_get_holder (plist, "filepath")) != NULL)
+	{
+		SDB_PARAM_SET_STRING (param, file_on_db);
+	}
+	if ((param = gda_set_get_holder (plist, "fileline")) != NULL)
+	{
+		SDB_PARAM_SET_INT (param, start_line);
+	}
+	if ((param = gda_set_get_holder (plist, "startline")) != NULL)
+	{
+		SDB_PARAM_SET_INT (param, start_line);
+	}
+	if ((param = gda_set_get_holder (plist, "endline")) != NULL)
+	{
+		SDB_PARAM_SET_INT (param, end_line);
+	}
+	if ((param = gda_set_get_holder (plist, "linesdelta")) != NULL)
+	{
+		SDB_PARAM_SET_INT (param, lines_delta);
+	}
+}
+
+/**
+ * ### Thread note: this function inherits the mutex lock ###
+ *
+ * Runs one of the buffer ranges queries. For selects the data model is 
+ * returned, otherwise NULL.
+ */
+static GdaDataModel *
+sdb_engine_execute_buffer_range_query (SymbolDBEngine *dbe, static_query_type qtype,
+                                       const gchar *file_on_db, gint start_line,
+                                       gint end_line, gint lines_delta)
+{
+	const GdaStatement *stmt;
+	const GdaSet *plist;
+	GdaDataModel *data_model = NULL;
+	SymbolDBEnginePriv *priv;
+
+	priv = dbe->priv;
+	
+	if ((stmt = sdb_engine_get_statement_by_query_id (dbe, qtype)) == NULL)
+	{
+		g_warning ("query is null");
+		return NULL;
+	}
+	plist = sdb_engine_get_query_parameters_list (dbe, qtype);
+	sdb_engine_set_buffer_range_params ((GdaSet *)plist, file_on_db, start_line,
+	                                    end_line, lines_delta);
+
+	if (gda_statement_get_statement_type ((GdaStatement *)stmt) == 
+	    GDA_SQL_STATEMENT_SELECT)
+	{
+		data_model = gda_connection_statement_execute_select (priv->db_connection, 
+		                                                      (GdaStatement *)stmt, 
+		                                                      (GdaSet *)plist, NULL);
+	}
+	else
+	{
+		gda_connection_statement_execute_non_select (priv->db_connection, 
+		                                             (GdaStatement *)stmt,
+		                                             (GdaSet *)plist, NULL, NULL);
+	}
+	return data_model;
+}
+
+/* ### Thread note: this function inherits the mutex lock ### */
+static gint
+sdb_engine_get_buffer_range_line (SymbolDBEngine *dbe, static_query_type qtype,
+                                  const gchar *file_on_db, gint line)
+{
+	GdaDataModel *data_model;
+	const GValue *value;
+	gint found_line = -1;
+
+	data_model = sdb_engine_execute_buffer_range_query (dbe, qtype, file_on_db,
+	                                                    line, 0, 0);
+	if (data_model == NULL)
+		return -1;
+	
+	if (gda_data_model_get_n_rows (data_model) > 0)
+	{
+		value = gda_data_model_get_value_at (data_model, 0, 0, NULL);
+		if (value != NULL && G_VALUE_HOLDS_INT (value))
+			found_line = g_value_get_int (value);
+	}
+	g_object_unref (data_model);
+	
+	return found_line;
+}
+
+static gint
+sdb_engine_get_model_int (GdaDataModel *data_model, gint col, gint row)
+{
+	const GValue *value = gda_data_model_get_value_at (data_model, col, row, NULL);
+	return value != NULL && G_VALUE_HOLDS_INT (value) ? g_value_get_int (value) : 0;
+}
+
+static gchar *
+sdb_engine_get_model_string (GdaDataModel *data_model, gint col, gint row)
+{
+	const GValue *value = gda_data_model_get_value_at (data_model, col, row, NULL);
+	return value != NULL && G_VALUE_HOLDS_STRING (value) ? 
+		g_value_dup_string (value) : NULL;
+}
+
+/**
+ * symbol_db_engine_get_buffer_scan_range:
+ * @dbe: self
+ * @real_file: full path on disk of the file the buffer belongs to.
+ * @first_line: first changed line of the buffer.
+ * @last_line: last changed line of the buffer.
+ * @lines_delta: lines added (or removed, if negative) to the buffer since its
+ * 				symbols were last updated. All of the changes must be 
+ * 				between @first_line and @last_line.
+ * @start_line: (out): line of the top level declaration enclosing @first_line.
+ * @end_line: (out): last line before the top level declaration following 
+ * 				@last_line, or -1 for the end of the buffer.
+ * @floor_line: (out): line after the last symbol before @start_line. Lines
+ * 				between @floor_line and @start_line don't define symbols, 
+ * 				e.g. return types or comments of @start_line declaration.
+ * 
+ * Gets the lines to rescan with symbol_db_engine_update_buffer_range ()
+ * to update the symbols of changed lines. Lines are counted from 1, all of 
+ * them refer to the buffer.
+ * ~~~ Thread note: this function locks the mutex ~~~
+ * 
+ * Returns: FALSE if the file has no symbols in db.
+ */
+gboolean
+symbol_db_engine_get_buffer_scan_range (SymbolDBEngine *dbe, 
+                                        const gchar *real_file,
+                                        gint first_line, gint last_line, 
+                                        gint lines_delta,
+                                        gint *start_line, gint *end_line,
+                                        gint *floor_line)
+{
+	SymbolDBEnginePriv *priv;
+	const gchar *relative_path;
+	gint line;
+
+	g_return_val_if_fail (SYMBOL_IS_DB_ENGINE (dbe), FALSE);
+	g_return_val_if_fail (real_file != NULL, FALSE);
+	g_return_val_if_fail (first_line > 0 && last_line >= first_line, FALSE);
+	
+	priv = dbe->priv;
+	
+	relative_path = symbol_db_util_get_file_db_path (dbe, real_file);
+	if (relative_path == NULL)
+		return FALSE;
+
+	SDB_LOCK(priv);
+	
+	/* lines before first_line haven't moved: db and buffer agree on them */
+	line = sdb_engine_get_buffer_range_line (dbe, 
+	                                         PREP_QUERY_GET_TOP_SYMBOL_LINE_BEFORE,
+	                                         relative_path, first_line);
+	*start_line = line > 0 ? line : 1;
+
+	line = sdb_engine_get_buffer_range_line (dbe, 
+	                                         PREP_QUERY_GET_SYMBOL_LINE_BEFORE,
+	                                         relative_path, *start_line);
+	*floor_line = line > 0 ? line + 1 : 1;
+
+	/* the following lines are still where they were on db */
+	line = sdb_engine_get_buffer_range_line (dbe, 
+	                                         PREP_QUERY_GET_TOP_SYMBOL_LINE_AFTER,
+	                                         relative_path, last_line - lines_delta);
+	*end_line = line > 0 ? line - 1 + lines_delta : -1;
+	
+	SDB_UNLOCK(priv);
+
+	return TRUE;
+}
+
+static void
+on_scan_update_buffer_range_end (SymbolDBEngine * dbe, gint process_id, 
+                                 gpointer data)
+{
+	SymbolDBEnginePriv *priv;
+	SdbBufferRange *range;
+	gchar *relative_path = data;
+
+	priv = dbe->priv;
+
+	SDB_LOCK(priv);
+	range = g_hash_table_lookup (priv->buffer_ranges, relative_path);
+	SDB_UNLOCK(priv);
+	
+	/* not our scan */
+	if (range == NULL || range->scan_id != process_id)
+		return;
+	
+	/* symbols out of the range were flagged, so only the ones in the range 
+	 * which weren't found again are removed */
+	if (sdb_engine_update_file (dbe, relative_path) == FALSE)
+		g_warning ("Error processing file %s", relative_path);
+
+	SDB_LOCK(priv);
+	g_hash_table_remove (priv->buffer_ranges, relative_path);
+	SDB_UNLOCK(priv);
+	
+	g_signal_handlers_disconnect_by_func (dbe, on_scan_update_buffer_range_end,
+										  relative_path);
+	g_free (relative_path);
+}
+
+/**
+ * symbol_db_engine_update_buffer_range:
+ * @dbe: self
+ * @project: project name
+ * @real_file: full path on disk of the file the buffer belongs to.
+ * @text_buffer: the text of the buffer from @start_line to @end_line.
+ * @buffer_size: size of @text_buffer.
+ * @start_line: first line of @text_buffer in the buffer.
+ * @end_line: last line of @text_buffer in the buffer, or -1 if @text_buffer
+ * 				reaches the end of the buffer.
+ * @lines_delta: lines added (or removed, if negative) to the buffer since its
+ * 				symbols were last updated.
+ * 
+ * Updates the symbols of some lines of a buffer, usually the ones given by
+ * symbol_db_engine_get_buffer_scan_range (). Symbols out of the range are 
+ * only moved by @lines_delta if they follow it: no signal is emitted for them.
+ * In the range only the symbols really inserted, updated or removed are 
+ * signaled.
+ * 
+ * Returns: scan process id if the scan has been started, -1 on error. In the 
+ * latter case symbol_db_engine_update_buffer_symbols () should be used.
+ */
+gint
+symbol_db_engine_update_buffer_range (SymbolDBEngine *dbe, const gchar *project,
+                                      const gchar *real_file,
+                                      const gchar *text_buffer, gsize buffer_size,
+                                      gint start_line, gint end_line, 
+                                      gint lines_delta)
+{
+	SymbolDBEnginePriv *priv;
+	SdbBufferRange *range;
+	GdaDataModel *data_model;
+	GPtrArray *temp_files;
+	GPtrArray *real_files_on_db;
+	gchar *relative_path;
+	gchar *shared_temp_file;
+	gint db_end_line;
+	gint scan_id;
+	gint i;
+
+	g_return_val_if_fail (SYMBOL_IS_DB_ENGINE (dbe), -1);
+	g_return_val_if_fail (project != NULL, -1);
+	g_return_val_if_fail (real_file != NULL, -1);
+	g_return_val_if_fail (text_buffer != NULL, -1);
+	g_return_val_if_fail (start_line > 0, -1);
+	
+	priv = dbe->priv;
+	g_return_val_if_fail (priv->db_connection != NULL, -1);
+
+	if (symbol_db_engine_file_exists (dbe, real_file) == FALSE)
+		return -1;
+	
+	relative_path = g_strdup (symbol_db_util_get_file_db_path (dbe, real_file));
+	if (relative_path == NULL)
+		return -1;
+
+	/* end of the range as it is on db */
+	db_end_line = end_line < 0 ? -1 : end_line - lines_delta;
+	scan_id = sdb_engine_get_unique_scan_id (dbe);
+	
+	SDB_LOCK(priv);
+
+	/* one range at a time per file */
+	if (g_hash_table_lookup (priv->buffer_ranges, relative_path) != NULL)
+	{
+		SDB_UNLOCK(priv);
+		g_free (relative_path);
+		return -1;
+	}
+
+	range = g_slice_new0 (SdbBufferRange);
+	range->line_offset = start_line - 1;
+	range->snapshot = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+									(GDestroyNotify)sdb_engine_symbol_snapshot_free);
+	
+	data_model = sdb_engine_execute_buffer_range_query (dbe, 
+	                                                    PREP_QUERY_GET_SYMBOLS_IN_RANGE,
+	                                                    relative_path, start_line,
+	                                                    db_end_line, 0);
+	for (i = 0; data_model != NULL && i < gda_data_model_get_n_rows (data_model); i++)
+	{
+		SdbSymbolSnapshot *snapshot = g_slice_new0 (SdbSymbolSnapshot);
+
+		snapshot->file_position = sdb_engine_get_model_int (data_model, 1, i);
+		snapshot->is_file_scope = sdb_engine_get_model_int (data_model, 2, i);
+		snapshot->signature = sdb_engine_get_model_string (data_model, 3, i);
+		snapshot->returntype = sdb_engine_get_model_string (data_model, 4, i);
+		snapshot->kind_id = sdb_engine_get_model_int (data_model, 5, i);
+		snapshot->access_kind_id = sdb_engine_get_model_int (data_model, 6, i);
+		snapshot->implementation_kind_id = sdb_engine_get_model_int (data_model, 7, i);
+
+		g_hash_table_insert (range->snapshot, 
+		                     GINT_TO_POINTER (sdb_engine_get_model_int (data_model, 0, i)),
+		                     snapshot);
+	}
+	if (data_model != NULL)
+		g_object_unref (data_model);
+
+	/* symbols out of the range are kept as they are... */
+	sdb_engine_execute_buffer_range_query (dbe, PREP_QUERY_FLAG_SYMBOLS_OUT_OF_RANGE,
+	                                       relative_path, start_line, db_end_line, 0);
+	
+	/* ...but the following ones may have moved */
+	if (lines_delta != 0 && db_end_line >= 0)
+		sdb_engine_execute_buffer_range_query (dbe, PREP_QUERY_SHIFT_SYMBOLS_AFTER_LINE,
+		                                       relative_path, start_line, 
+		                                       db_end_line, lines_delta);
+
+	range->scan_id = scan_id;
+	g_hash_table_insert (priv->buffer_ranges, g_strdup (relative_path), range);
+	
+	SDB_UNLOCK(priv);
+
+	shared_temp_file = sdb_engine_buffer_to_shared_mem (dbe, relative_path, 
+	                                                    text_buffer, buffer_size);
+
+	temp_files = g_ptr_array_new_with_free_func (g_free);
+	real_files_on_db = g_ptr_array_new_with_free_func (g_free);
+	
+	if (shared_temp_file != NULL)
+	{
+		g_ptr_array_add (temp_files, shared_temp_file);
+		g_ptr_array_add (real_files_on_db, g_strdup (relative_path));
+	
+		/* relative_path will be freed by the callback */
+		g_signal_connect (G_OBJECT (dbe), "scan-end",
+		                  G_CALLBACK (on_scan_update_buffer_range_end), 
+		                  relative_path);
+	}
+	
+	if (shared_temp_file == NULL ||
+	    sdb_engine_scan_files_async (dbe, temp_files, real_files_on_db, TRUE, 
+	                                 scan_id) == FALSE)
+	{
+		/* put the flags back. The caller will do a full update, which fixes
+		 * the lines too */
+		SDB_LOCK(priv);
+		sdb_engine_execute_buffer_range_query (dbe, 
+		                                       PREP_QUERY_RESET_UPDATE_FLAG_SYMBOLS,
+		                                       relative_path, 0, 0, 0);
+		g_hash_table_remove (priv->buffer_ranges, relative_path);
+		SDB_UNLOCK(priv);
+
+		if (shared_temp_file != NULL)
+			g_signal_handlers_disconnect_by_func (dbe, 
+			                                      on_scan_update_buffer_range_end,
+			                                      relative_path);
+		g_free (relative_path);
+		scan_id = -1;
+	}
+
+	g_ptr_array_unref (temp_files);
+	g_ptr_array_unref (real_files_on_db);
+	
+	return scan_id;
+}
+
 /**
  * symbol_db_engine_get_files_for_project:
  * @dbe: self
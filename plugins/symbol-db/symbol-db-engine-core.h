@@ -60,6 +60,9 @@ struct _SymbolDBEngineClass
 	void (* symbol_updated)  		(gint symbol_id);
 	void (* symbol_scope_updated)  	(gint symbol_id);	
 	void (* symbol_removed)  		(gint symbol_id);
+	void (* symbols_inserted) 		(GArray *symbols_ids);
+	void (* symbols_updated)  		(GArray *symbols_ids);
+	void (* symbols_removed)  		(GArray *symbols_ids);
 };
 
 struct _SymbolDBEngine
@@ -90,6 +93,15 @@ symbol_db_engine_new_full (const gchar * ctags_path, const gchar * database_name
 gboolean
 symbol_db_engine_set_ctags_path (SymbolDBEngine *dbe, const gchar * ctags_path);
 
+gboolean
+symbol_db_engine_set_ctags_workers (SymbolDBEngine *dbe, gint workers_num);
+
+gboolean
+symbol_db_engine_set_binary_tags (SymbolDBEngine *dbe, gboolean binary);
+
+void
+symbol_db_engine_set_bulk_population (SymbolDBEngine *dbe, gboolean bulk);
+
 
 SymbolDBEngineOpenStatus
 symbol_db_engine_open_db (SymbolDBEngine *dbe, const gchar* base_db_path,
@@ -105,6 +117,9 @@ symbol_db_engine_is_connected (SymbolDBEngine * dbe);
 gboolean
 symbol_db_engine_is_scanning (SymbolDBEngine *dbe);
 
+gboolean
+symbol_db_engine_has_name_index (SymbolDBEngine *dbe);
+
 
 gchar *
 symbol_db_engine_get_cnc_string (SymbolDBEngine * dbe);
@@ -169,6 +184,21 @@ symbol_db_engine_update_buffer_symbols (SymbolDBEngine * dbe, const gchar * proj
 										const GPtrArray * text_buffers,
 										const GPtrArray * buffer_sizes);
 
+gboolean
+symbol_db_engine_get_buffer_scan_range (SymbolDBEngine *dbe, 
+                                        const gchar *real_file,
+                                        gint first_line, gint last_line, 
+                                        gint lines_delta,
+                                        gint *start_line, gint *end_line,
+                                        gint *floor_line);
+
+gint
+symbol_db_engine_update_buffer_range (SymbolDBEngine *dbe, const gchar *project,
+                                      const gchar *real_file,
+                                      const gchar *text_buffer, gsize buffer_size,
+                                      gint start_line, gint end_line, 
+                                      gint lines_delta);
+
 GdaDataModel*
 symbol_db_engine_get_files_for_project (SymbolDBEngine *dbe);
 
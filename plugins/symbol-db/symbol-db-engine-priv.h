@@ -30,15 +30,24 @@
 #include <libanjuta/anjuta-launcher.h>
 #include <libgda/libgda.h>
 #include <sql-parser/gda-sql-parser.h>
+#ifdef HAVE_SQLITE3
+#include <sqlite3.h>
+#else
+/* the layout of the engine doesn't depend on the sqlite3 bulk path */
+typedef struct sqlite3 sqlite3;
+typedef struct sqlite3_stmt sqlite3_stmt;
+#endif
 
 #include <libanjuta/interfaces/ianjuta-symbol-manager.h>
 #include <libanjuta/interfaces/ianjuta-symbol.h>
 
+#include "symbol-db-engine-core.h"
+
 /* file should be specified without the ".db" extension. */
 #define ANJUTA_DB_FILE	".anjuta_sym_db"
 
 /* if tables.sql changes or general db structure changes modify also the value here */
-#define SYMBOL_DB_VERSION	"373.0"
+#define SYMBOL_DB_VERSION	"375.0"
 
 #define TABLES_SQL			PACKAGE_DATA_DIR"/tables.sql"
 
@@ -46,11 +55,20 @@
 
 #define SHARED_MEMORY_PREFIX			SYMBOL_DB_SHM
 
-#define THREADS_MAX_CONCURRENT			2
 #define TRIGGER_SIGNALS_DELAY			100
 
+/* upper bound for the anjuta-tags processes spawned for a single scan */
+#define CTAGS_WORKERS_MAX				8
+
 #define BATCH_SYMBOL_NUMBER				15000
 
+/* ids carried by a single symbols-inserted/updated/removed signal */
+#define SYMBOLS_SIGNAL_IDS				4096
+
+/* rows inserted by a single multi-row VALUES statement in the bulk path.
+ * Keep BULK_SYMBOL_ROWS * 14 below SQLITE_MAX_VARIABLE_NUMBER (999) */
+#define BULK_SYMBOL_ROWS				64
+
 #define SDB_QUERY_SEARCH_HEADER \
 	GValue v = {0}; \
 	SymbolDBQueryPriv *priv; \
@@ -137,10 +155,30 @@ typedef enum
 	PREP_QUERY_GET_REMOVED_IDS,
 	PREP_QUERY_TMP_REMOVED_DELETE_ALL,
 	PREP_QUERY_REMOVE_FILE_BY_PROJECT_NAME,
+	PREP_QUERY_GET_TOP_SYMBOL_LINE_BEFORE,
+	PREP_QUERY_GET_TOP_SYMBOL_LINE_AFTER,
+	PREP_QUERY_GET_SYMBOL_LINE_BEFORE,
+	PREP_QUERY_GET_SYMBOLS_IN_RANGE,
+	PREP_QUERY_FLAG_SYMBOLS_OUT_OF_RANGE,
+	PREP_QUERY_SHIFT_SYMBOLS_AFTER_LINE,
 	PREP_QUERY_COUNT
 		
 } static_query_type;
 
+/* raw sqlite3 statements used to populate the db the first time */
+typedef enum
+{
+	BULK_STMT_SYMBOL_NEW_MULTI = 0,
+	BULK_STMT_SYMBOL_NEW,
+	BULK_STMT_SCOPE_NEW,
+	BULK_STMT_GET_SCOPE_ID,
+	BULK_STMT_BEGIN,
+	BULK_STMT_COMMIT,
+	BULK_STMT_ROLLBACK,
+	BULK_STMT_COUNT
+
+} bulk_stmt_type;
+
 typedef struct _static_query_node
 {
 	static_query_type query_id;
@@ -160,6 +198,59 @@ typedef struct _DBESignal
 	
 } DBESignal;
 
+/* 
+ * An anjuta-tags child together with its own shared memory file and marker
+ * stream, or its binary tag stream. Output chunks are parsed on a dedicated
+ * exclusive thread so that the order of the stream is kept, while different
+ * workers parse in parallel.
+ */
+typedef struct _SdbCtagsWorker
+{
+	SymbolDBEngine *dbe;
+	AnjutaLauncher *launcher;
+	GThreadPool *output_pool;
+	GAsyncQueue *scan_aqueue;
+	/* chunks pushed to output_pool and not parsed yet */
+	volatile gint chunks_pending;
+	
+	gchar *shared_mem_str;
+	FILE *shared_mem_file;
+	gint shared_mem_fd;
+
+	/* binary tag stream, used only by the output thread */
+	gboolean binary;
+	GByteArray *stream;
+	struct _SdbTagBatch *batch;
+	
+} SdbCtagsWorker;
+
+/*
+ * What a symbol looked like before a buffer range was rescanned: symbols
+ * that come out the same aren't signaled as updated.
+ */
+typedef struct _SdbSymbolSnapshot
+{
+	gint file_position;
+	gint is_file_scope;
+	gchar *signature;
+	gchar *returntype;
+	gint kind_id;
+	gint access_kind_id;
+	gint implementation_kind_id;
+	
+} SdbSymbolSnapshot;
+
+/* A pending rescan of some lines of a buffer */
+typedef struct _SdbBufferRange
+{
+	gint scan_id;
+	/* added to the line numbers given by ctags on the buffer slice */
+	gint line_offset;
+	/* symbol_id -> SdbSymbolSnapshot of the symbols in the range */
+	GHashTable *snapshot;
+	
+} SdbBufferRange;
+
 /* the SymbolDBEngine Private structure */
 struct _SymbolDBEnginePriv
 {
@@ -177,20 +268,25 @@ struct _SymbolDBEnginePriv
 	gint scan_process_id_sequence;
 	gint current_scan_process_id;
 	
-	GAsyncQueue *scan_aqueue;	
 	GAsyncQueue *updated_syms_id_aqueue;
 	GAsyncQueue *updated_scope_syms_id_aqueue;
 	GAsyncQueue *inserted_syms_id_aqueue;
 	gboolean is_scanning;
 	
-	gchar *shared_mem_str;
-	FILE *shared_mem_file;
-	gint shared_mem_fd;
-	AnjutaLauncher *ctags_launcher;
+	SdbCtagsWorker *ctags_workers[CTAGS_WORKERS_MAX];
+	gint ctags_workers_num;
+	gboolean binary_tags;
+	gboolean bulk_population;
+	gint scan_workers_active;
+	/* scan id -> files not written yet. Guarded by the mutex */
+	GHashTable *scan_files_pending;
 	GList *removed_launchers;
 	gboolean shutting_down;
 	gboolean is_first_population;
 	gsize symbols_scanned_count;
+	
+	/* symbol_name_fts is there. It isn't with sqlite builds lacking fts5 */
+	gboolean has_name_index;
 
 	GAsyncQueue *waiting_scan_aqueue;
 	gulong waiting_scan_handler;
@@ -199,6 +295,7 @@ struct _SymbolDBEnginePriv
 	GMutex* mutex;
 	GAsyncQueue* signals_aqueue;
 	
+	/* serializes all db writes of a scan: it has only one thread */
 	GThreadPool *thread_pool;	
 	gint timeout_trigger_handler;	
 	gint trigger_closure_retries;
@@ -216,6 +313,20 @@ struct _SymbolDBEnginePriv
 
 	/* Table maps */
 	GQueue *tmp_heritage_tablemap;
+
+	/* file path on db -> SdbBufferRange */
+	GHashTable *buffer_ranges;
+	/* the range of the batch being populated, if any */
+	SdbBufferRange *current_buffer_range;
+
+	/* Bulk population: a raw sqlite3 connection used only by the writer
+	 * thread while is_first_population is set */
+	sqlite3 *bulk_db;
+	sqlite3_stmt *bulk_stmts[BULK_STMT_COUNT];
+	GHashTable *bulk_scope_cache;
+	/* symbols written by the bulk path in the current scan. Kept apart from
+	 * symbols_scanned_count, which paces the symboltrans transactions */
+	gsize bulk_symbols_count;
 	
 	static_query_node *static_query_list[PREP_QUERY_COUNT]; 
 
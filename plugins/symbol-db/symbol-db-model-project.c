@@ -361,6 +361,9 @@ sdb_model_project_set_property (GObject *object, guint prop_id,
 			g_signal_handlers_disconnect_by_func (priv->dbe,
 				              G_CALLBACK (symbol_db_model_thaw),
 				              object);
+			g_signal_handlers_disconnect_by_func (priv->dbe,
+				              G_CALLBACK (symbol_db_model_changed),
+				              object);
 		}
 		priv->dbe = g_value_dup_object (value);
 		g_object_weak_ref (G_OBJECT (priv->dbe),
@@ -376,6 +379,13 @@ sdb_model_project_set_property (GObject *object, guint prop_id,
 		                          G_CALLBACK (symbol_db_model_freeze), object);
 		g_signal_connect_swapped (priv->dbe, "scan-end",
 		                          G_CALLBACK (symbol_db_model_thaw), object);
+		/* a scan which changes no symbol doesn't reload the model */
+		g_signal_connect_swapped (priv->dbe, "symbols-inserted",
+		                          G_CALLBACK (symbol_db_model_changed), object);
+		g_signal_connect_swapped (priv->dbe, "symbols-updated",
+		                          G_CALLBACK (symbol_db_model_changed), object);
+		g_signal_connect_swapped (priv->dbe, "symbols-removed",
+		                          G_CALLBACK (symbol_db_model_changed), object);
 		
 		symbol_db_model_update (SYMBOL_DB_MODEL (object));
 		break;
@@ -433,6 +443,9 @@ sdb_model_project_finalize (GObject *object)
 		g_signal_handlers_disconnect_by_func (priv->dbe,
 		                  G_CALLBACK (symbol_db_model_thaw),
 		                  object);
+		g_signal_handlers_disconnect_by_func (priv->dbe,
+		                  G_CALLBACK (symbol_db_model_changed),
+		                  object);
 	}
 
 	if (priv->stmt)
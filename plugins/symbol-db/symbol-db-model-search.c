@@ -19,9 +19,10 @@
 
 #include <libanjuta/anjuta-debug.h>
 #include "symbol-db-engine.h"
+#include "symbol-db-query.h"
 #include "symbol-db-model-search.h"
 
-#define SDB_MODEL_SEARCH_SQL " \
+#define SDB_MODEL_SEARCH_SQL_HEAD " \
 	SELECT \
 		symbol.symbol_id, \
 		symbol.name, \
@@ -38,19 +39,40 @@
 	LEFT JOIN file ON symbol.file_defined_id = file.file_id \
 	LEFT JOIN sym_access ON symbol.access_kind_id = sym_access.access_kind_id \
 	LEFT JOIN sym_kind ON symbol.kind_id = sym_kind.sym_kind_id \
-	WHERE symbol.name LIKE ## /* name:'pattern' type:gchararray */ \
+	"
+
+#define SDB_MODEL_SEARCH_SQL_TAIL " \
 	ORDER BY symbol.name \
 	LIMIT ## /* name:'limit' type:gint */ \
 	OFFSET ## /* name:'offset' type:gint */ \
 	"
 
+#define SDB_MODEL_SEARCH_SQL \
+	SDB_MODEL_SEARCH_SQL_HEAD \
+	"WHERE symbol.name LIKE ## /* name:'pattern' type:gchararray */ " \
+	SDB_MODEL_SEARCH_SQL_TAIL
+
+/* the trigram index narrows the candidates, LIKE keeps its semantics */
+#define SDB_MODEL_SEARCH_INDEXED_SQL \
+	SDB_MODEL_SEARCH_SQL_HEAD \
+	"WHERE symbol.symbol_id IN \
+	( \
+		SELECT rowid \
+		FROM symbol_name_fts \
+		WHERE symbol_name_fts MATCH ## /* name:'match' type:gchararray */ \
+	) \
+	AND symbol.name LIKE ## /* name:'pattern' type:gchararray */ " \
+	SDB_MODEL_SEARCH_SQL_TAIL
+
 struct _SymbolDBModelSearchPriv
 {
 	gchar *search_pattern;
+	gchar *search_match;	/* NULL if too short for the name index */
 	guint refresh_queue_id;
+	gboolean indexed;
 	GdaStatement *stmt;
 	GdaSet *params;
-	GdaHolder *param_pattern, *param_limit, *param_offset;
+	GdaHolder *param_pattern, *param_match, *param_limit, *param_offset;
 };
 
 enum
@@ -71,10 +93,20 @@ sdb_model_search_update_sql_stmt (SymbolDBModel *model)
 	g_return_if_fail (SYMBOL_DB_IS_MODEL_SEARCH (model));
 	priv = SYMBOL_DB_MODEL_SEARCH (model)->priv;
 	
+	if (priv->stmt)
+	{
+		g_object_unref (priv->stmt);
+		g_object_unref (priv->params);
+	}
+
 	g_object_get (model, "symbol-db-engine", &dbe, NULL);
-	priv->stmt = symbol_db_engine_get_statement (dbe, SDB_MODEL_SEARCH_SQL);
+	priv->stmt = symbol_db_engine_get_statement (dbe, priv->indexed ?
+	                                             SDB_MODEL_SEARCH_INDEXED_SQL :
+	                                             SDB_MODEL_SEARCH_SQL);
 	gda_statement_get_parameters (priv->stmt, &priv->params, NULL);
 	priv->param_pattern = gda_set_get_holder (priv->params, "pattern");
+	priv->param_match = priv->indexed ?
+		gda_set_get_holder (priv->params, "match") : NULL;
 	priv->param_limit = gda_set_get_holder (priv->params, "limit");
 	priv->param_offset = gda_set_get_holder (priv->params, "offset");
 }
@@ -88,6 +120,7 @@ sdb_model_search_get_children (SymbolDBModel *model, gint tree_level,
 	SymbolDBModelSearchPriv *priv;
 	GValue ival = {0};
 	GValue sval = {0};
+	gboolean indexed;
 
 	g_return_val_if_fail (SYMBOL_DB_IS_MODEL_SEARCH (model), 0);
 	priv = SYMBOL_DB_MODEL_SEARCH (model)->priv;
@@ -104,8 +137,14 @@ sdb_model_search_get_children (SymbolDBModel *model, gint tree_level,
 	if (!dbe || !symbol_db_engine_is_connected (dbe) || !priv->search_pattern)
 		return NULL;
 
-	if (!priv->stmt)
+	/* the statement changes whether the index can be used or not */
+	indexed = priv->search_match != NULL &&
+		symbol_db_engine_has_name_index (dbe);
+	if (!priv->stmt || indexed != priv->indexed)
+	{
+		priv->indexed = indexed;
 		sdb_model_search_update_sql_stmt (model);
+	}
 	
 	/* Initialize parameters */
 	g_value_init (&ival, G_TYPE_INT);
@@ -116,6 +155,11 @@ sdb_model_search_get_children (SymbolDBModel *model, gint tree_level,
 	gda_holder_set_value (priv->param_offset, &ival, NULL);
 	g_value_set_static_string (&sval, priv->search_pattern);
 	gda_holder_set_value (priv->param_pattern, &sval, NULL);
+	if (priv->indexed)
+	{
+		g_value_set_static_string (&sval, priv->search_match);
+		gda_holder_set_value (priv->param_match, &sval, NULL);
+	}
 	g_value_reset (&sval);
 
 	return symbol_db_engine_execute_select (dbe, priv->stmt, priv->params);
@@ -175,6 +219,9 @@ sdb_model_search_set_property (GObject *object, guint prop_id,
 		old_pattern = priv->search_pattern;
 		priv->search_pattern = g_strdup_printf ("%%%s%%",
 		                                        g_value_get_string (value));
+		g_free (priv->search_match);
+		priv->search_match =
+			symbol_db_query_build_text_match (g_value_get_string (value));
 		if (g_strcmp0 (old_pattern, priv->search_pattern) != 0)
 		{
 			if (priv->refresh_queue_id)
@@ -218,6 +265,7 @@ sdb_model_search_finalize (GObject *object)
 	g_return_if_fail (SYMBOL_DB_IS_MODEL_SEARCH (object));
 	priv = SYMBOL_DB_MODEL_SEARCH (object)->priv;
 	g_free (priv->search_pattern);
+	g_free (priv->search_match);
 	if (priv->stmt)
 	{
 		g_object_unref (priv->stmt);
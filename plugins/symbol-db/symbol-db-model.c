@@ -71,6 +71,11 @@ struct _SymbolDBModelNode {
 	 * view at all and instead use empty data for the duration of freeze.
 	 */
 	gint freeze_count;
+
+	/* Backend data has changed during the freeze, or the frozen model had to
+	 * refuse a fetch: the model is updated when thawed only in this case.
+	 */
+	gboolean changed;
 	
 	gint n_columns;      /* Number of columns in the model */
 	GType *column_types; /* Type of each column in the model */
@@ -512,10 +517,14 @@ sdb_model_page_fault (SymbolDBModel *model,
 	if (page_found)
 		return page_found;
 
-	/* If model is frozen, can't fetch data from backend */
+	/* If model is frozen, can't fetch data from backend. The empty rows
+	 * are filled when thawed */
 	priv = model->priv;
 	if (priv->freeze_count > 0)
+	{
+		priv->changed = TRUE;
 		return NULL;
+	}
 	
 	/* New page to cover current child_offset */
 	page = g_slice_new0 (SymbolDBModelPage);
@@ -1003,9 +1012,13 @@ sdb_model_ensure_node_children (SymbolDBModel *model,
 
 	priv = model->priv;
 
-	/* Can not ensure if model is frozen */
+	/* Can not ensure if model is frozen. The children are ensured when
+	 * thawed */
 	if (priv->freeze_count > 0)
+	{
+		priv->changed = TRUE;
 		return;
+	}
 	
 	/* Initialize children array and count */
 	old_has_child = node->has_child;
@@ -1471,9 +1484,29 @@ symbol_db_model_update (SymbolDBModel *model)
 
 	priv = model->priv;
 
+	/* Nodes updated while frozen are empty until thawed */
+	if (priv->freeze_count > 0)
+		priv->changed = TRUE;
+	
 	sdb_model_update_node_children (model, priv->root, FALSE);
 }
 
+/* Backend data has changed. Update the model now, or when thawed */
+void
+symbol_db_model_changed (SymbolDBModel *model)
+{
+	SymbolDBModelPriv *priv;
+
+	g_return_if_fail (SYMBOL_DB_IS_MODEL (model));
+
+	priv = model->priv;
+
+	if (priv->freeze_count > 0)
+		priv->changed = TRUE;
+	else
+		symbol_db_model_update (model);
+}
+
 void
 symbol_db_model_freeze (SymbolDBModel *model)
 {
@@ -1497,6 +1530,9 @@ symbol_db_model_thaw (SymbolDBModel *model)
 	if (priv->freeze_count > 0)
 		priv->freeze_count--;
 	
-	if (priv->freeze_count <= 0)
+	if (priv->freeze_count <= 0 && priv->changed)
+	{
+		priv->changed = FALSE;
 		symbol_db_model_update (model);
+	}
 }
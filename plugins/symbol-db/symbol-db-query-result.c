@@ -484,17 +484,57 @@ isymbol_iter_get_length (IAnjutaIterable *iterable, GError **err)
 	return gda_data_model_get_n_rows (result->priv->data_model);
 }
 
-static IAnjutaIterable *
-isymbol_iter_clone (IAnjutaIterable *iter, GError **e)
+static void
+isymbol_iter_assign (IAnjutaIterable *iter, IAnjutaIterable *src_iter, GError **e)
 {
-	DEBUG_PRINT ("%s", "isymbol_iter_clone  () UNIMPLEMENTED");
-	return NULL;
+	SymbolDBQueryResult *result;
+	SymbolDBQueryResult *src;
+	gint row;
+
+	g_return_if_fail (SYMBOL_DB_IS_QUERY_RESULT (iter));
+	g_return_if_fail (SYMBOL_DB_IS_QUERY_RESULT (src_iter));
+	result = SYMBOL_DB_QUERY_RESULT (iter);
+	src = SYMBOL_DB_QUERY_RESULT (src_iter);
+
+	/* Only cursors on the same result set can be assigned */
+	g_return_if_fail (result->priv->data_model == src->priv->data_model);
+
+	row = gda_data_model_iter_get_row (src->priv->iter);
+	if (row >= 0)
+		gda_data_model_iter_move_to_row (result->priv->iter, row);
 }
 
-static void
-isymbol_iter_assign (IAnjutaIterable *iter, IAnjutaIterable *src_iter, GError **e)
+static IAnjutaIterable *
+isymbol_iter_clone (IAnjutaIterable *iter, GError **e)
 {
-	DEBUG_PRINT ("%s", "isymbol_iter_assign () UNIMPLEMENTED");
+	SymbolDBQueryResult *result;
+	SymbolDBQueryResult *clone;
+	IAnjutaSymbolField *fields_order;
+	gint i, n_fields;
+
+	g_return_val_if_fail (SYMBOL_DB_IS_QUERY_RESULT (iter), NULL);
+	result = SYMBOL_DB_QUERY_RESULT (iter);
+
+	/* Rebuild the fields order from the column map, the clone shares the
+	 * data model but gets its own cursor on it */
+	n_fields = 0;
+	for (i = 0; i < IANJUTA_SYMBOL_FIELD_END; i++)
+		if (result->priv->col_map[i] >= 0)
+			n_fields++;
+	fields_order = g_new (IAnjutaSymbolField, n_fields + 1);
+	for (i = 0; i < IANJUTA_SYMBOL_FIELD_END; i++)
+		if (result->priv->col_map[i] >= 0)
+			fields_order[result->priv->col_map[i]] = i;
+	fields_order[n_fields] = IANJUTA_SYMBOL_FIELD_END;
+
+	clone = symbol_db_query_result_new (g_object_ref (result->priv->data_model),
+	                                    fields_order,
+	                                    result->priv->sym_type_conversion_hash,
+	                                    result->priv->project_root);
+	g_free (fields_order);
+
+	isymbol_iter_assign (IANJUTA_ITERABLE (clone), iter, NULL);
+	return IANJUTA_ITERABLE (clone);
 }
 
 static void
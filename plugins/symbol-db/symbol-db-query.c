@@ -20,6 +20,7 @@
 
 #include <limits.h>
 #include <stdarg.h>
+#include <string.h>
 #include <libgda/gda-statement.h>
 #include <libanjuta/anjuta-debug.h>
 #include <libanjuta/interfaces/ianjuta-symbol-query.h>
@@ -72,6 +73,10 @@ struct _SymbolDBQueryPriv {
 	GdaSet *params;
 	GdaHolder *param_pattern, *param_file_path, *param_limit, *param_offset;
 	GdaHolder *param_file_line, *param_id;
+	GdaHolder *param_text, *param_match, *param_glob, *param_hump, *param_iglob;
+
+	/* SEARCH_TEXT statement goes through symbol_name_fts */
+	gboolean text_indexed;
 
 	/* Aync results */
 	gboolean query_queued;
@@ -428,6 +433,26 @@ sdb_query_update (SymbolDBQuery *query)
 				)) ";
 			g_object_set (query, "limit", 1, NULL);
 			break;
+		case IANJUTA_SYMBOL_QUERY_SEARCH_TEXT:
+			/* the trigram index only narrows the candidates: the globs
+			 * decide about case and camel-humps */
+			if (priv->text_indexed)
+				condition =
+					"(symbol.symbol_id IN \
+					( \
+						SELECT rowid \
+						FROM symbol_name_fts \
+						WHERE symbol_name_fts MATCH ## /* name:'match' type:gchararray */ \
+					) \
+					AND (symbol.name GLOB ## /* name:'glob' type:gchararray */ \
+					OR symbol.name GLOB ## /* name:'hump' type:gchararray */ \
+					OR lower (symbol.name) GLOB ## /* name:'iglob' type:gchararray */)) ";
+			else
+				condition =
+					"(symbol.name GLOB ## /* name:'glob' type:gchararray */ \
+					OR symbol.name GLOB ## /* name:'hump' type:gchararray */ \
+					OR lower (symbol.name) GLOB ## /* name:'iglob' type:gchararray */) ";
+			break;
 		case IANJUTA_SYMBOL_QUERY_SEARCH_PARENT_SCOPE_FILE:
 			condition =
 				"(symbol.scope_definition_id IN \
@@ -479,6 +504,13 @@ sdb_query_update (SymbolDBQuery *query)
 	/* Order by clause */
 	if (priv->order_by != IANJUTA_SYMBOL_FIELD_END)
 		g_string_append_printf (sql, "ORDER BY %s ", field_specs[priv->order_by].column);
+	else if (priv->name == IANJUTA_SYMBOL_QUERY_SEARCH_TEXT)
+		g_string_append (sql, 
+			"ORDER BY CASE \
+				WHEN lower (symbol.name) = ## /* name:'text' type:gchararray */ THEN 0 \
+				WHEN instr (lower (symbol.name), ## /* name:'text' type:gchararray */) = 1 THEN 1 \
+				WHEN instr (lower (symbol.name), ## /* name:'text' type:gchararray */) > 1 THEN 2 \
+				ELSE 3 END, length (symbol.name), symbol.name ");
 	
 	/* Add tail of the SQL statement */
 	g_string_append (sql, "LIMIT ## /* name:'limit' type:gint */ ");
@@ -764,6 +796,21 @@ sdb_query_init (SymbolDBQuery *query)
 	param = priv->param_file_line = gda_holder_new_int ("fileline", 0);
 	param_holders = g_slist_prepend (param_holders, param);
 
+	param = priv->param_text = gda_holder_new_string ("text", "");
+	param_holders = g_slist_prepend (param_holders, param);
+
+	param = priv->param_match = gda_holder_new_string ("match", "");
+	param_holders = g_slist_prepend (param_holders, param);
+
+	param = priv->param_glob = gda_holder_new_string ("glob", "");
+	param_holders = g_slist_prepend (param_holders, param);
+
+	param = priv->param_hump = gda_holder_new_string ("hump", "");
+	param_holders = g_slist_prepend (param_holders, param);
+
+	param = priv->param_iglob = gda_holder_new_string ("iglob", "");
+	param_holders = g_slist_prepend (param_holders, param);
+
 	priv->params = gda_set_new (param_holders);
 	g_slist_free (param_holders);
 
@@ -1307,6 +1354,221 @@ sdb_query_search_parent_scope_file (IAnjutaSymbolQuery *query, IAnjutaSymbol *sy
 	return sdb_query_execute (SYMBOL_DB_QUERY (query));
 }
 
+/* Appends @len bytes of @str escaping GLOB wildcards */
+static void
+sdb_query_append_glob_escaped (GString *glob, const gchar *str, gssize len)
+{
+	const gchar *end = str + len;
+
+	for (; str < end; str++)
+	{
+		switch (*str)
+		{
+			case '*':
+			case '?':
+			case '[':
+				g_string_append_c (glob, '[');
+				g_string_append_c (glob, *str);
+				g_string_append_c (glob, ']');
+				break;
+			default:
+				g_string_append_c (glob, *str);
+		}
+	}
+}
+
+/* Appends @len bytes of @str as a fts5 phrase, if it's long enough to give 
+ * at least one trigram. Returns FALSE otherwise. */
+static gboolean
+sdb_query_append_fts_phrase (GString *match, const gchar *str, gssize len)
+{
+	const gchar *end = str + len;
+
+	if (g_utf8_strlen (str, len) < 3)
+		return FALSE;
+	
+	g_string_append_c (match, '"');
+	for (; str < end; str++)
+	{
+		if (*str == '"')
+			g_string_append_c (match, '"');
+		g_string_append_c (match, *str);
+	}
+	g_string_append_c (match, '"');
+
+	return TRUE;
+}
+
+/**
+ * sdb_query_build_text_patterns:
+ * @text: The searched text.
+ * @match: Return location for the symbol_name_fts match expression, NULL if 
+ *   the text is too short for the trigram index.
+ * @glob: Return location for the case sensitive substring pattern.
+ * @hump: Return location for the camel-hump pattern.
+ * @iglob: Return location for the case insensitive substring pattern.
+ * 
+ * Lower case @text matches case insensitively, otherwise case sensitively
+ * and as camel-humps: "GtkTV" is split on upper case letters and matches 
+ * "Gtk*T*V*". Patterns not in use are set to "" which matches no symbol.
+ */
+static void
+sdb_query_build_text_patterns (const gchar *text, gchar **match, gchar **glob,
+                               gchar **hump, gchar **iglob)
+{
+	GString *substring_glob;
+	GString *hump_glob;
+	GString *hump_match;
+	GString *match_str;
+	const gchar *p;
+	const gchar *segment;
+	gboolean has_upper = FALSE;
+	gint n_segments = 0;
+	gint n_phrases = 0;
+	gssize len = strlen (text);
+	
+	for (p = text; *p != '\0'; p = g_utf8_next_char (p))
+	{
+		if (g_unichar_isupper (g_utf8_get_char (p)))
+		{
+			has_upper = TRUE;
+			break;
+		}
+	}
+
+	substring_glob = g_string_new ("*");
+	sdb_query_append_glob_escaped (substring_glob, text, len);
+	g_string_append_c (substring_glob, '*');
+
+	match_str = g_string_new (NULL);
+	if (!sdb_query_append_fts_phrase (match_str, text, len))
+	{
+		g_string_free (match_str, TRUE);
+		match_str = NULL;
+	}
+	
+	if (!has_upper)
+	{
+		*glob = g_strdup ("");
+		*hump = g_strdup ("");
+		*iglob = g_string_free (substring_glob, FALSE);
+		*match = match_str ? g_string_free (match_str, FALSE) : NULL;
+		return;
+	}
+
+	*glob = g_string_free (substring_glob, FALSE);
+	*iglob = g_strdup ("");
+	
+	/* camel-humps: a new segment starts at each upper case letter */
+	hump_glob = g_string_new (NULL);
+	hump_match = g_string_new (NULL);
+	segment = text;
+	for (p = g_utf8_next_char (text); ; p = g_utf8_next_char (p))
+	{
+		if (*p != '\0' && !g_unichar_isupper (g_utf8_get_char (p)))
+			continue;
+
+		sdb_query_append_glob_escaped (hump_glob, segment, p - segment);
+		g_string_append_c (hump_glob, '*');
+		n_segments++;
+
+		if (g_utf8_strlen (segment, p - segment) >= 3)
+		{
+			if (n_phrases++ > 0)
+				g_string_append (hump_match, " AND ");
+			sdb_query_append_fts_phrase (hump_match, segment, p - segment);
+		}
+
+		if (*p == '\0')
+			break;
+		segment = p;
+	}
+
+	if (n_segments < 2)
+	{
+		/* "Gtk*" is a prefix match: the substring glob already covers it */
+		*hump = g_strdup ("");
+		*match = match_str ? g_string_free (match_str, FALSE) : NULL;
+	}
+	else
+	{
+		*hump = g_strdup (hump_glob->str);
+		if (match_str != NULL && n_phrases > 0)
+		{
+			g_string_append_printf (match_str, " OR (%s)", hump_match->str);
+			*match = g_string_free (match_str, FALSE);
+		}
+		else
+		{
+			/* one of the alternatives can't use the index */
+			if (match_str != NULL)
+				g_string_free (match_str, TRUE);
+			*match = NULL;
+		}
+	}
+	
+	g_string_free (hump_glob, TRUE);
+	g_string_free (hump_match, TRUE);
+}
+
+/**
+ * symbol_db_query_build_text_match:
+ * @text: The searched text, may be NULL.
+ * 
+ * Returns: The symbol_name_fts match expression finding the symbols that
+ * contain @text, case insensitively. NULL if @text is too short for the
+ * trigram index.
+ */
+gchar *
+symbol_db_query_build_text_match (const gchar *text)
+{
+	GString *match;
+
+	if (text == NULL)
+		return NULL;
+
+	match = g_string_new (NULL);
+	if (!sdb_query_append_fts_phrase (match, text, strlen (text)))
+	{
+		g_string_free (match, TRUE);
+		return NULL;
+	}
+
+	return g_string_free (match, FALSE);
+}
+
+static IAnjutaIterable*
+sdb_query_search_text (IAnjutaSymbolQuery *query, const gchar *text,
+                       GError **error)
+{
+	gchar *match, *glob, *hump, *iglob;
+	gboolean indexed;
+	SDB_QUERY_SEARCH_HEADER;
+	g_return_val_if_fail (text != NULL, NULL);
+	g_return_val_if_fail (priv->name == IANJUTA_SYMBOL_QUERY_SEARCH_TEXT, NULL);
+
+	sdb_query_build_text_patterns (text, &match, &glob, &hump, &iglob);
+
+	/* the statement changes whether the index can be used or not */
+	indexed = match != NULL && 
+		symbol_db_engine_has_name_index (priv->dbe_selected);
+	if (indexed != priv->text_indexed)
+	{
+		priv->text_indexed = indexed;
+		sdb_query_reset (SYMBOL_DB_QUERY (query));
+	}
+
+	if (match != NULL)
+	{
+		SDB_PARAM_TAKE_STRING (priv->param_match, match);
+	}
+	SDB_PARAM_TAKE_STRING (priv->param_glob, glob);
+	SDB_PARAM_TAKE_STRING (priv->param_hump, hump);
+	SDB_PARAM_TAKE_STRING (priv->param_iglob, iglob);
+	SDB_PARAM_TAKE_STRING (priv->param_text, g_utf8_strdown (text, -1));
+	return sdb_query_execute (SYMBOL_DB_QUERY (query));
+}
+
 static void
 ianjuta_symbol_query_iface_init (IAnjutaSymbolQueryIface *iface)
 {
@@ -1329,6 +1591,7 @@ ianjuta_symbol_query_iface_init (IAnjutaSymbolQueryIface *iface)
 	iface->search_scope = sdb_query_search_scope;
 	iface->search_parent_scope = sdb_query_search_parent_scope;
 	iface->search_parent_scope_file = sdb_query_search_parent_scope_file;
+	iface->search_text = sdb_query_search_text;
 }
 
 SymbolDBQuery *
@@ -54,6 +54,7 @@ SymbolDBQuery* symbol_db_query_new (SymbolDBEngine *system_db_engine,
                                     IAnjutaSymbolQueryName name,
                                     IAnjutaSymbolQueryDb db,
                                 	GHashTable *session_packages);
+gchar *symbol_db_query_build_text_match (const gchar *text);
 
 G_END_DECLS
 
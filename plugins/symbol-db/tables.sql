@@ -97,6 +97,13 @@ CREATE INDEX symbol_idx_2 ON symbol (scope_id);
 DROP INDEX IF EXISTS symbol_idx_3;
 CREATE INDEX symbol_idx_3 ON symbol (type_type, type_name);
 
+-- per file line ranges, e.g. for buffer updates.
+DROP INDEX IF EXISTS symbol_idx_4;
+CREATE INDEX symbol_idx_4 ON symbol (file_defined_id, file_position);
+
+-- the trigram index on symbol names, symbol_name_fts, and its triggers are
+-- created by sdb_engine_create_name_index (): sqlite may lack fts5 or the
+-- trigram tokenizer.
 
 DROP TRIGGER IF EXISTS delete_file_trg;
 CREATE TRIGGER delete_file_trg BEFORE DELETE ON file